@@ -1,5 +1,9 @@
+import bisect
+import hashlib
 from operator import attrgetter
 
+import LCEngine
+
 from Code import TrListas
 from Code import Util
 
@@ -36,7 +40,9 @@ class ListaAperturasStd:
         self.hijos = []
         ficheroPers = configuracion.ficheroPersAperturas
         self.lee(ficheroPers, siEntrenar)
-        self.lia1h8 = self.dic.keys()
+        self.lia1h8 = sorted(self.dic.keys())
+        self.ficheroECO = configuracion.ficheroAperturasECO
+        self.signatureECO = None
 
         if siBasic:
             for bl in self.dic.itervalues():
@@ -126,47 +132,44 @@ class ListaAperturasStd:
             if n <= 0:
                 self.hijos.append(bloque)
 
+    def preparaECO(self):
+        # Tabla posicion -> apertura en LCEngine, se crea solo al clasificar, se guarda en disco y solo se rehace
+        # si cambia la lista de aperturas
+        if self.signatureECO is None:
+            self.signatureECO = hashlib.md5("\n".join(self.lia1h8)).hexdigest()
+        if LCEngine.ecoSignature() == self.signatureECO:
+            return
+        dt = Util.recuperaVar(self.ficheroECO)
+        if not dt or dt.get("SIGNATURE") != self.signatureECO:
+            dicPos, setCont, maxPly = LCEngine.ecoBuild(self.lia1h8)
+            dt = {"SIGNATURE": self.signatureECO, "POS": dicPos, "CONT": setCont, "MAXPLY": maxPly}
+            Util.guardaVar(self.ficheroECO, dt)
+        LCEngine.ecoSet(self.signatureECO, dt["POS"], dt["CONT"], dt["MAXPLY"])
+
+    def clasifica(self, liMoves):
+        # Apertura mas profunda alcanzada por liMoves (a1h8), aunque sea por transposicion,
+        # numero de movimientos hasta ella y si aun se puede llegar a otra
+        self.preparaECO()
+        a1h8, nply, siPendiente = LCEngine.ecoClassify(" ".join(liMoves))
+        if a1h8 is None:
+            return None, 0, siPendiente
+        # si se ha llegado con el mismo orden de jugadas que alguna apertura, esa
+        apertura = self.dic.get(" ".join(liMoves[:nply]), self.dic[a1h8])
+        return apertura, nply, siPendiente
+
     def asignaApertura(self, partida):
         partida.apertura = None
         if not partida.siFenInicial():
             partida.pendienteApertura = False
             return
-        partida.pendienteApertura = True
-        a1h8 = ""
+        liMoves = [jg.movimiento() for jg in partida.liJugadas]
+        partida.apertura, nply, partida.pendienteApertura = self.clasifica(liMoves)
         for nj, jg in enumerate(partida.liJugadas):
-            if jg.siApertura:
-                jg.siApertura = False
-            a1h8 += jg.movimiento()
-            if a1h8 in self.dic:
-                partida.apertura = self.dic[a1h8]
-                for nP in range(nj + 1):
-                    partida.jugada(nP).siApertura = True
-                noHayMas = True
-                for k in self.dic:
-                    if k.startswith(a1h8) and k != a1h8:
-                        noHayMas = False
-                        break
-                if noHayMas:
-                    partida.pendienteApertura = False  # la ponemos como definitiva
-                    return
-            a1h8 += " "
-        # Hay alguna posible ?
-        a1h8 = a1h8.strip()
-        for k in self.dic:
-            if k.startswith(a1h8):
-                return  # volvemos con la apertura pendiente aun
-        partida.pendienteApertura = False  # No hay ninguna aplicable
+            jg.siApertura = nj < nply
 
     def asignaAperturaListaMoves(self, liMoves):  # PGO
-        opening = ""
-
-        a1h8 = ""
-        for mv in liMoves:
-            a1h8 += " " + mv.pv()
-            a1h8 = a1h8.strip()
-            if a1h8 in self.dic:
-                opening = self.dic[a1h8]
-        return opening
+        opening, nply, siPendiente = self.clasifica([mv.pv() for mv in liMoves])
+        return opening if opening else ""
 
     def listaAperturasPosibles(self, partida, siTodas=False):
         a1h8 = ""
@@ -175,16 +178,19 @@ class ListaAperturasStd:
         a1h8 = a1h8[1:]
         li = []
 
-        # Las ordenamos para que esten antes las principales que las variantes
-        lik = self.dic.keys()
-        lik.sort()
+        # Estan ordenadas para que esten antes las principales que las variantes,
+        # las que empiezan por a1h8 estan seguidas a partir de la primera mayor o igual
+        lik = self.lia1h8
 
         siBasic = len(partida) == 0
         if siTodas:
             siBasic = False
 
-        for k in lik:
-            if k.startswith(a1h8) and len(k) > len(a1h8):
+        for pos in range(bisect.bisect_left(lik, a1h8), len(lik)):
+            k = lik[pos]
+            if not k.startswith(a1h8):
+                break
+            if len(k) > len(a1h8):
                 # Comprobamos que no sea una variante de las a_adidas, no nos interesan para mostrar opciones al usuario
                 siMas = True
                 for ap in li:
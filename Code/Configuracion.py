@@ -232,6 +232,7 @@ class Configuracion:
         self.ficheroEntAperturas = "%s/entaperturas.pkd" % self.carpeta
         self.ficheroEntAperturasPar = "%s/entaperturaspar.pkd" % self.carpeta
         self.ficheroPersAperturas = "%s/persaperturas.pkd" % self.carpeta
+        self.ficheroAperturasECO = "%s/aperturas.eco" % self.carpeta
         self.ficheroAnalisis = "%s/paranalisis.pkd" % self.carpeta
         self.ficheroDailyTest = "%s/nivel.pkd" % self.carpeta
         self.ficheroTemas = "%s/themes.pkd" % self.carpeta
@@ -6,6 +6,11 @@ FEN_INICIAL = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1"
 
 
 class ControlPosicion:
+    # Position de LCEngine que sigue a esta posicion y estado con el que se dejo, al reproducir una partida se pasa
+    # de cada posicion a su copia y se mueve sobre ella, sin volver a crearla desde el fen en cada jugada
+    lcePos = None
+    lceEstado = None
+
     def __init__(self):
         self.liExtras = []
 
@@ -47,6 +52,9 @@ class ControlPosicion:
         p.siBlancas = self.siBlancas
         p.jugadas = self.jugadas
         p.movPeonCap = self.movPeonCap
+        # la Position pasa a la copia, que es la que se va a mover
+        p.lcePos, p.lceEstado = self.lcePos, self.lceEstado
+        self.lcePos = self.lceEstado = None
         return p
 
     def legal(self):
@@ -198,11 +206,24 @@ class ControlPosicion:
         return self.mover(pv[:2], pv[2:4], pv[4:])
 
     def mover(self, desdeA1H8, hastaA1H8, coronacion=""):
-        self.setLCE()
+        siBien, liExtras, mv = self.moverInfo(desdeA1H8, hastaA1H8, coronacion)
+        return siBien, liExtras
+
+    def estadoLCE(self):
+        return self.siBlancas, self.enroques, self.alPaso, self.movPeonCap, self.jugadas, self.casillas
 
-        mv = LCEngine.moveExPV(desdeA1H8, hastaA1H8, coronacion)
+    def posicionLCE(self):
+        # Se vuelve a crear si no hay o si la posicion se ha cambiado desde fuera despues de mover
+        if self.lcePos is None or self.lceEstado != self.estadoLCE():
+            self.lcePos = LCEngine.Position(self.fen())
+        return self.lcePos
+
+    def moverInfo(self, desdeA1H8, hastaA1H8, coronacion=""):
+        lcePos = self.posicionLCE()
+
+        mv = lcePos.push(desdeA1H8, hastaA1H8, coronacion)
         if not mv:
-            return False, "Error"
+            return False, "Error", None
 
         self.liExtras = []
 
@@ -233,9 +254,25 @@ class ControlPosicion:
             capt = self.alPaso.replace("6", "5").replace("3", "4")
             self.liExtras.append(("b", capt))
 
-        self.leeFen(LCEngine.getFen())  # despues de liExtras, por si enpassant
+        self.leePosicionLCE(lcePos)  # despues de liExtras, por si enpassant
+
+        return True, self.liExtras, mv
+
+    def leePosicionLCE(self, lcePos):
+        self.casillas = lcePos.squares
+        self.siBlancas = lcePos.whiteToMove
+        self.enroques = lcePos.castling
+        self.alPaso = lcePos.ep
+        self.movPeonCap = lcePos.fifty
+        self.jugadas = lcePos.fullmove
+        if self.jugadas < 1:
+            self.jugadas = 1
+
+        self.legal()
 
-        return True, self.liExtras
+        # con copia de casillas, hay pantallas que las cambian en su sitio
+        self.lcePos = lcePos
+        self.lceEstado = self.estadoLCE()[:-1] + (self.casillas.copy(),)
 
     def tablero(self):
         resp = "   " + "+---" * 8 + "+" + "\n"
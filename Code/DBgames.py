@@ -15,6 +15,9 @@ posA1 = LCEngine.posA1
 a1Pos = LCEngine.a1Pos
 pv2xpv = LCEngine.pv2xpv
 xpv2pv = LCEngine.xpv2pv
+pv2ipv = LCEngine.pv2ipv
+ipv2pv = LCEngine.ipv2pv
+ipv2game = LCEngine.ipv2game
 PGNreader = LCEngine.PGNreader
 setFen = LCEngine.setFen
 makeMove = LCEngine.makeMove
@@ -463,11 +466,11 @@ class DBgames:
             if pv:
                 li = []
                 for unpv in pv:
-                    xpv = pv2xpv(unpv)
+                    xpv = self.pv2xpv(unpv)
                     li.append('XPV GLOB "%s*"' % xpv)
                 condicion = "(%s)" % (" OR ".join(li),)
         elif pv:
-            xpv = pv2xpv(pv)
+            xpv = self.pv2xpv(pv)
             condicion = 'XPV GLOB "%s*"' % xpv if xpv else ""
         if condicionAdicional:
             if condicion:
@@ -513,8 +516,26 @@ class DBgames:
                 sql += "%s BLOB,"% field
             sql = sql[:-1] + " );"
             cursor.execute(sql)
+            # Las nuevas guardan las partidas con el codigo compacto de LCEngine (un caracter por jugada)
+            cursor.execute("CREATE TABLE CONFIG( KEY TEXT PRIMARY KEY, VALUE TEXT );")
+            cursor.execute("INSERT INTO CONFIG( KEY, VALUE ) VALUES( ?, ? );", ("XPV", "IPV"))
+            self._conexion.commit()
             cursor.close()
 
+        cursor = self._conexion.cursor()
+        cursor.execute("pragma table_info(CONFIG)")
+        if cursor.fetchall():
+            cursor.execute("SELECT VALUE FROM CONFIG WHERE KEY= ?", ("XPV",))
+            raw = cursor.fetchone()
+            self.siIPV = raw is not None and raw[0] == "IPV"
+        else:
+            self.siIPV = False
+        cursor.close()
+        if self.siIPV:
+            self.pv2xpv, self.xpv2pv = pv2ipv, ipv2pv
+        else:
+            self.pv2xpv, self.xpv2pv = pv2xpv, xpv2pv
+
     def close(self):
         if self._conexion:
             self._cursor.close()
@@ -541,7 +562,7 @@ class DBgames:
 
     def damePV(self, fila):
         xpv = self.field(fila, "XPV")
-        return xpv2pv(xpv)
+        return self.xpv2pv(xpv)
 
     def ponOrden(self, liOrden):
         li = ["%s %s" % (campo, tipo) for campo, tipo in liOrden]
@@ -702,7 +723,13 @@ class DBgames:
                 li = self._cursor.fetchmany(chunk)
                 if li:
                     for XPV, RESULT in li:
-                        pv = xpv2pv(XPV)
+                        if self.siIPV:
+                            pv, liSAN, liFens = ipv2game(XPV, self.depthStat())
+                            if liFens:  # las posiciones salen ya de LCEngine al decodificar
+                                self.dbSTAT.append_fen(pv, RESULT, liFens)
+                                continue
+                        else:
+                            pv = self.xpv2pv(XPV)
                         self.dbSTAT.append(pv, RESULT)
                     nli = len(li)
                     if nli < chunk:
@@ -751,7 +778,7 @@ class DBgames:
                         if fen and fen != ControlPosicion.FEN_INICIAL:
                             erroneos += 1
                         else:
-                            xpv = pv2xpv(pv)
+                            xpv = self.pv2xpv(pv)
                             if xpv in stRegs:
                                 dup = True
                             else:
@@ -839,13 +866,16 @@ class DBgames:
             raw = db.leeAllRecno(recno)
 
             xpv = raw["XPV"]
+            if db.siIPV != self.siIPV:
+                pv = db.xpv2pv(xpv)
+                xpv = self.pv2xpv(pv)
             cursor.execute("SELECT COUNT(*) FROM games WHERE XPV = ?", (xpv,))
             num = cursor.fetchone()[0]
             dup = num > 0
             if dup:
                 duplicados += 1
             else:
-                pv = xpv2pv(xpv)
+                pv = self.xpv2pv(xpv)
                 reg = (xpv, raw["EVENT"], raw["SITE"], raw["DATE"], raw["WHITE"], raw["BLACK"], raw["RESULT"], raw["ECO"], raw["WHITEELO"],
                        raw["BLACKELO"], raw["PGN"], raw["PLIES"])
                 self.dbSTAT.append(pv, raw["RESULT"])
@@ -909,7 +939,7 @@ class DBgames:
                 p.restore(xpgn["FULLGAME"])
                 return p
 
-        p.leerPV(xpv2pv(raw["XPV"]))
+        p.leerPV(self.xpv2pv(raw["XPV"]))
         rots = ["Event", "Site", "Date", "Round", "White", "Black", "Result",
                 "WhiteTitle", "BlackTitle", "WhiteElo", "BlackElo", "WhiteUSCF", "BlackUSCF", "WhiteNA", "BlackNA",
                 "WhiteType", "BlackType", "EventDate", "EventSponsor", "ECO", "UTCTime", "UTCDate", "TimeControl",
@@ -947,7 +977,7 @@ class DBgames:
 
         p = Partida.PartidaCompleta()
 
-        p.leerPV(xpv2pv(raw["XPV"]))
+        p.leerPV(self.xpv2pv(raw["XPV"]))
         rots = ["Event", "Site", "Date", "Round", "White", "Black", "Result",
                 "WhiteTitle", "BlackTitle", "WhiteElo", "BlackElo", "WhiteUSCF", "BlackUSCF", "WhiteNA", "BlackNA",
                 "WhiteType", "BlackType", "EventDate", "EventSponsor", "ECO", "UTCTime", "UTCDate", "TimeControl",
@@ -998,7 +1028,7 @@ class DBgames:
             liData.append(xpgn)
 
         pvNue = partidaCompleta.pv()
-        xpv = pv2xpv(pvNue)
+        xpv = self.pv2xpv(pvNue)
         if xpv != reg_ant["XPV"]:
             self._cursor.execute("SELECT COUNT(*) FROM games WHERE XPV = ?", (xpv,))
             num = self._cursor.fetchone()[0]
@@ -1014,7 +1044,7 @@ class DBgames:
         sql = "UPDATE games SET %s WHERE ROWID = %d" % (fields, rowid)
         self._cursor.execute(sql, liData)
         self._conexion.commit()
-        pvAnt = xpv2pv(reg_ant["XPV"])
+        pvAnt = self.xpv2pv(reg_ant["XPV"])
         resNue = dTags.get("RESULT", "*")
         self.dbSTAT.append(pvAnt, resAnt, -1)
         self.dbSTAT.append(pvNue, resNue, +1)
@@ -1025,7 +1055,7 @@ class DBgames:
 
     def inserta(self, partidaCompleta):
         pv = partidaCompleta.pv()
-        xpv = pv2xpv(pv)
+        xpv = self.pv2xpv(pv)
         self._cursor.execute("SELECT COUNT(*) FROM games WHERE XPV = ?", (xpv,))
         num = self._cursor.fetchone()[0]
         if num > 0:
@@ -5,6 +5,8 @@ import time
 
 import psutil
 
+import LCEngine
+
 from Code import VarGen
 from Code.Constantes import *
 
@@ -42,25 +44,25 @@ else:
     PRIORITY_LOW, PRIORITY_VERYLOW   = psutil.BELOW_NORMAL_PRIORITY_CLASS, psutil.IDLE_PRIORITY_CLASS
     PRIORITY_HIGH, PRIORITY_VERYHIGH = psutil.ABOVE_NORMAL_PRIORITY_CLASS, psutil.HIGH_PRIORITY_CLASS
 
-import subprocess
-import threading
-import collections
 
 
 class Engine(object):
+    # El motor lo lleva LCEngine.EngineSession: lee la salida en un thread de C y de las lineas info
+    # solo pasa las ultimas, ya analizadas, con get_output junto al resto de lineas y en el orden en que han llegado
     def __init__(self, exe, priority, args):
         self.pid = None
         self.exe = os.path.abspath(exe)
         self.direxe = os.path.dirname(exe)
         self.priority = priority
         self.working = True
-        self.liBuffer = []
         self.starting = True
-        self.args = [os.path.basename(self.exe), ]
+        self.session = None
+        self.args = [os.path.basename(self.exe) if VarGen.isWindows else self.exe, ]
         if args:
             self.args.extend(args)
 
         if VarGen.isLinux and VarGen.isWine and self.exe.lower().endswith(".exe"):
+            self.args[0] = os.path.basename(self.exe)
             self.args.insert(0, "/usr/bin/wine")
 
     def cerrar(self):
@@ -68,80 +70,41 @@ class Engine(object):
 
     def put_line(self, line):
         assert xpr("put>>> %s\n" % line)
-        self.stdin_lock.acquire()
-        self.stdin.write(line + "\n")
-        self.stdin_lock.release()
+        self.session.putLine(line)
 
     def get_lines(self):
-        self.stdout_lock.acquire()
-        li = self.liBuffer
-        self.liBuffer = []
-        self.stdout_lock.release()
+        li = self.session.getLines()
+        assert xprli(li)
+        return li
+
+    def get_output(self):
+        li = self.session.getOutput()
         assert xprli(li)
         return li
 
     def hay_datos(self):
-        return len(self.liBuffer) > 0
+        return self.session.pending() > 0
 
     def reset(self):
-        self.get_lines()
+        self.session.reset()
 
-    def xstdout_thread(self, stdout, lock):
-        try:
-            while self.working:
-                line = stdout.readline()
-                if not line:
-                    break
-                lock.acquire()
-                self.liBuffer.append(line)
-                lock.release()
-        except:
-            pass
-        finally:
-            stdout.close()
+    def coalesce(self, siCoalesce):
+        self.session.coalesce(siCoalesce)
 
     def start(self):
-        if VarGen.isWindows:
-            startupinfo = subprocess.STARTUPINFO()
-            startupinfo.dwFlags |= subprocess.STARTF_USESHOWWINDOW
-            startupinfo.wShowWindow = subprocess.SW_HIDE
-        else:
-            startupinfo = None
         curdir = os.path.abspath(os.curdir)  # problem with "." as curdir
         os.chdir(self.direxe)  # to fix problems with non ascii folders
-        self.process = subprocess.Popen(self.args, stdout=subprocess.PIPE, stdin=subprocess.PIPE,
-                                         startupinfo=startupinfo, shell=False)
-        os.chdir(curdir)
-
-        self.pid = self.process.pid
-        if self.priority != PRIORITY_NORMAL:
-            p = psutil.Process(self.pid)
-            p.nice(self.priority)
-
-        self.stdout_lock = threading.Lock()
-        self.stdout_queue = collections.deque()
-        stdout_thread = threading.Thread(target=self.xstdout_thread, args=(self.process.stdout, self.stdout_lock))
-        stdout_thread.daemon = True
-        stdout_thread.start()
-
-        self.stdin = self.process.stdin
-        self.stdin_lock = threading.Lock()
+        try:
+            self.session = LCEngine.EngineSession(self.args, self.direxe, self.priority)
+        finally:
+            os.chdir(curdir)
 
+        self.pid = self.session.pid
         self.starting = False
 
     def close(self):
         self.working = False
         if self.pid:
-            if self.process.poll() is None:
-                self.put_line("quit")
-                wtime = 40  # wait for it, wait for it...
-                while self.process.poll() is None and wtime > 0:
-                    time.sleep(0.05)
-                    wtime -= 1
-
-                if self.process.poll() is None:  # nope, no luck
-                    sys.stderr.write("INFO: the engine %s won't close properly.\n" % self.exe)
-                    self.process.kill()
-                    self.process.terminate()
-
+            if not self.session.close():
+                sys.stderr.write("INFO: the engine %s won't close properly.\n" % self.exe)
             self.pid = None
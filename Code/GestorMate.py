@@ -1,5 +1,7 @@
 import time
 
+import LCEngine
+
 from Code import TrListas
 from Code import ControlPosicion
 from Code import Gestor
@@ -388,16 +390,37 @@ class GestorMate(Gestor.Gestor):
             fen, pv = self.controlMate.repiteFenPV()
 
         else:
-            rm = self.xrival.juega()
-            if rm.mate != self.mate - self.numMov:
+            mate, liMoves = LCEngine.mateSolve(self.partida.ultPosicion.fen(), self.mate - self.numMov, 5000)
+            if mate == -1:  # sin tiempo, el motor
+                rm = self.xrival.juega()
+                mate, liMoves = rm.mate, [rm.movimiento()]
+            if mate != self.mate - self.numMov:
                 self.repiteMate(False, False)
                 self.ayudaMate()
                 return
 
-            pv = rm.pv.split(" ")[0]
+            pv = liMoves[0]
 
         self.tablero.creaFlechaMov(pv[:2], pv[2:4], "2")
 
+    def defensaMate(self):
+        # La respuesta que mas retrasa el mate, None si el resolvedor de LCEngine se queda sin tiempo
+        fen = self.partida.ultPosicion.fen()
+        LCEngine.setFen(fen)
+        liMoves = [infoMove.movimiento() for infoMove in LCEngine.getExMoves()]
+        mejor, mejorMate = None, 0
+        for move in liMoves:
+            LCEngine.setFen(fen)
+            LCEngine.makeMove(move)
+            mate, liMates = LCEngine.mateSolve(LCEngine.getFen(), self.mate - self.numMov, 2000)
+            if mate == -1:
+                return None
+            if mate == 0:  # sin mate en las jugadas que quedan
+                return move
+            if mate > mejorMate:
+                mejor, mejorMate = move, mate
+        return mejor
+
     def iniciaPosicion(self, fen):
 
         cp = ControlPosicion.ControlPosicion()
@@ -457,11 +480,14 @@ class GestorMate(Gestor.Gestor):
             self.repiteMate(True, True)
             return
 
-        # Juega rival con depth 3
-        rm = self.xrival.juega()
-        desde = rm.desde
-        hasta = rm.hasta
-        coronacion = rm.coronacion
+        move = self.defensaMate()
+        if move:
+            desde, hasta, coronacion = move[:2], move[2:4], move[4:]
+        else:
+            rm = self.xrival.juega()
+            desde = rm.desde
+            hasta = rm.hasta
+            coronacion = rm.coronacion
 
         siBien, mens, jg = Jugada.dameJugada(self.partida.ultPosicion, desde, hasta, coronacion)
         self.partida.ultPosicion = jg.posicion
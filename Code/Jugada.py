@@ -12,7 +12,7 @@ class Jugada:
         self.analisis = None
         self.criticaDirecta = ""
 
-    def ponDatos(self, posicionBase, posicion, desde, hasta, coronacion):
+    def ponDatos(self, posicionBase, posicion, desde, hasta, coronacion, infoMove=None):
         self.posicionBase = posicionBase
         self.posicion = posicion
         self.siApertura = False
@@ -20,7 +20,10 @@ class Jugada:
         self.desde = desde
         self.hasta = hasta
         self.coronacion = coronacion if coronacion else ""
-        self.siJaque = self.posicion.siJaque()
+        if infoMove:  # ya calculado al mover, sin volver a cargar las posiciones en LCEngine
+            self.siJaque = infoMove.jaque() or infoMove.mate()
+        else:
+            self.siJaque = self.posicion.siJaque()
         self.siJaqueMate = False  # Se determina a posteriori con el motor
         self.siAhogado = False  # Se determina a posteriori con el motor
         self.siTablasRepeticion = False  # Se determina a posteriori con el motor
@@ -29,7 +32,7 @@ class Jugada:
         self.siTablasFaltaMaterial = False
         self.siAbandono = NOABANDONO
         self.siDesconocido = False  # Si ha sido una terminacion de partida, por causas desconocidas
-        self.pgnBase = posicionBase.pgn(desde, hasta, coronacion)
+        self.pgnBase = infoMove.san() if infoMove else posicionBase.pgn(desde, hasta, coronacion)
         self.liMovs = [("b", hasta), ("m", desde, hasta)]
         if self.posicion.liExtras:
             self.liMovs.extend(self.posicion.liExtras)
@@ -373,10 +376,10 @@ class Jugada:
 
 def dameJugada(posicionBase, desde, hasta, coronacion):
     posicion = posicionBase.copia()
-    siBien, mensError = posicion.mover(desde, hasta, coronacion)
+    siBien, mensError, infoMove = posicion.moverInfo(desde, hasta, coronacion)
     if siBien:
         jg = Jugada()
-        jg.ponDatos(posicionBase, posicion, desde, hasta, coronacion)
+        jg.ponDatos(posicionBase, posicion, desde, hasta, coronacion, infoMove)
         return True, None, jg
     else:
         return False, mensError, None
@@ -15,6 +15,9 @@ else:
     startfile = os.startfile
 isWindows = not isLinux
 
+# LCEngine.VERSION que necesita Code, se sube al anadir o cambiar lo que se usa de LCEngine
+LCENGINE_VERSION = 1
+
 dgt = None
 dgtDispatch = None
 
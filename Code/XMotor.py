@@ -75,9 +75,27 @@ class XMotor:
         self.engine.put_line(line)
 
     def reset(self):
-        self.get_lines()
+        self.engine.reset()
+        self.engine.coalesce(True)
         self.mrm = XMotorRespuesta.MRespuestaMotor(self.nombre, self.is_white)
 
+    def save_lines(self):
+        # el mrm necesita todas las lineas info, tal cual
+        self.engine.coalesce(False)
+        self.mrm.save_lines()
+
+    def lee_mrm(self):
+        # las lineas info llegan ya analizadas (tuplas), solo la ultima de cada multipv y profundidad, en orden con
+        # el resto, asi la ultima info se trata antes que el bestmove
+        li = []
+        for x in self.engine.get_output():
+            if type(x) == tuple:
+                self.mrm.dispatchInfo(*x)
+            else:
+                self.mrm.dispatch(x)
+                li.append(x)
+        return li
+
     def dispatch(self):
         QtCore.QCoreApplication.processEvents(QtCore.QEventLoop.ExcludeUserInputEvents)
         if self.guiDispatch:
@@ -92,16 +110,20 @@ class XMotor:
                 return False
         return True
 
-    def wait_mrm(self, seektxt, msStop):
+    def wait_mrm(self, seektxt, msStop, seekdepth=0):
         iniTiempo = time.time()
         stop = False
         while True:
             if self.engine.hay_datos():
-                for line in self.get_lines():
-                    self.mrm.dispatch(line)
-                    if seektxt in line:
+                for line in self.lee_mrm():
+                    if seektxt and seektxt in line:
                         self.dispatch()
                         return True
+                if seekdepth:
+                    for rm in self.mrm.dicMultiPV.itervalues():
+                        if rm.depth >= seekdepth:
+                            self.dispatch()
+                            return True
 
             queda = msStop - int((time.time() - iniTiempo) * 1000)
             if queda <= 0:
@@ -137,7 +159,7 @@ class XMotor:
                 self.put_line("stop")
                 msStop += 2000
                 stop = True
-            if not self.engine.hay_datos():
+            if not lt:
                 time.sleep(0.090)
 
     def wait_txt(self, seektxt, msStop):
@@ -151,7 +173,7 @@ class XMotor:
             queda = msStop - int((time.time() - iniTiempo) * 1000)
             if queda <= 0:
                 return False
-            if not self.engine.hay_datos():
+            if not lt:
                 time.sleep(0.090)
 
     def work_ok(self, orden):
@@ -165,10 +187,10 @@ class XMotor:
         self.put_line(orden)
         self.wait_mrm("bestmove", msmax_time)
 
-    def work_infinite(self, busca, msmax_time):
+    def work_infinite(self, seekdepth, msmax_time):
         self.reset()
         self.put_line("go infinite")
-        self.wait_mrm(busca, msmax_time)
+        self.wait_mrm(None, msmax_time, seekdepth)
 
     def seek_bestmove(self, max_time, max_depth, is_savelines):
         env = "go"
@@ -185,7 +207,7 @@ class XMotor:
 
         self.reset()
         if is_savelines:
-            self.mrm.save_lines()
+            self.save_lines()
         self.mrm.setTimeDepth(max_time, max_depth)
 
         self.work_bestmove(env, ms_time)
@@ -196,19 +218,19 @@ class XMotor:
 
     def seek_infinite(self, max_depth, max_time):
         if max_depth:
-            busca = " depth %d " % (max_depth + 1,)
+            seekdepth = max_depth + 1
 
             max_time = max_depth * 2000
             if max_depth > 9:
                 max_time += (max_depth - 9) * 20000
         else:
-            busca = " @@ "  # que no busque nada
+            seekdepth = 0  # que no busque nada
             max_depth = None
 
         self.reset()
         self.mrm.setTimeDepth(max_time, max_depth)
 
-        self.work_infinite(busca, max_time)
+        self.work_infinite(seekdepth, max_time)
 
         self.mrm.ordena()
         return self.mrm
@@ -251,8 +273,7 @@ class XMotor:
     def ac_lee(self):
         if self.lockAC:
             return
-        for line in self.get_lines():
-            self.mrm.dispatch(line)
+        self.lee_mrm()
 
     def ac_estado(self):
         self.ac_lee()
@@ -293,11 +314,10 @@ class XMotor:
         self.set_game_position(partida, njg)
         self.reset()
         if is_savelines:
-            self.mrm.save_lines()
+            self.save_lines()
         self.put_line("go infinite")
         def lee():
-            for line in self.get_lines():
-                self.mrm.dispatch(line)
+            self.lee_mrm()
             self.mrm.ordena()
             return self.mrm.mejorMov()
         ok_time = False if ktime else True
@@ -279,6 +279,69 @@ class MRespuestaMotor:
         if self.saveLines:
             self.lines.append(linea)
 
+    def dispatchInfo(self, multipv, depth, seldepth, tm, nodes, nps, cp, mate, pv):
+        # Linea info ya analizada por LCEngine.EngineSession, con None en lo que no ha enviado el motor,
+        # igual que miraPV si tiene pv y que miraScore si no
+        if pv:
+            if nodes == 0 and mate is None:  # Toga en multipv, envia 0 si no tiene nada que contar
+                return
+            if mate == 0:
+                return
+
+        kMulti = str(multipv) if multipv is not None else "1"
+        if multipv is None and self.dicMultiPV:
+            kMulti = self.dicMultiPV.keys()[0]
+        if kMulti not in self.dicMultiPV:
+            self.dicMultiPV[kMulti] = RespuestaMotor(self.nombre, self.siBlancas)
+
+        rm = self.dicMultiPV[kMulti]
+        rm.sinInicializar = False
+
+        if depth is not None:
+            if self.maxProfundidad:
+                if rm.desde:  # Es decir que ya tenemos datos (rm.pv al principio = a1a1
+                    if (depth > self.maxProfundidad) and (depth > rm.depth):
+                        return
+            rm.depth = depth
+        else:
+            depth = 0
+
+        if tm is not None:
+            rm.time = tm
+
+        if pv:
+            if nodes is not None:
+                rm.nodes = nodes
+            if nps is not None:
+                rm.nps = nps
+            if seldepth is not None:
+                rm.seldepth = seldepth
+
+        if cp is not None:
+            rm.puntos = cp
+            rm.mate = 0
+            rm.sinMovimientos = False
+        elif mate is not None:
+            rm.puntos = 0
+            rm.mate = mate
+            if pv:
+                rm.sinMovimientos = False
+            elif not mate:  # stockfish mate 0
+                rm.mate = -1
+
+        if pv:
+            x = pv.find(" ")
+            pv1 = pv[:x] if x >= 0 else pv
+            rm.pv = pv
+            rm.desde = pv1[:2]
+            rm.hasta = pv1[2:4]
+            rm.coronacion = pv1[4].lower() if len(pv1) == 5 else ""
+
+            if depth:
+                if depth not in self.dicDepth:
+                    self.dicDepth[depth] = {}
+                self.dicDepth[depth][rm.movimiento()] = rm.puntosABS_5()
+
     def dispatchPV(self, pv):
         self.dispatch("info depth 1 score cp 0 time 1 pv %s" % pv)
         self.dispatch("bestmove %s" % pv)
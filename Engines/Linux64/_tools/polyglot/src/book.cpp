@@ -8,6 +8,20 @@
 #include <cstdlib>
 #include <cstring>
 
+#ifndef _WIN32
+#include <fcntl.h>
+#include <glob.h>
+#include <signal.h>
+#include <sys/types.h>
+#include <unistd.h>
+#else
+#include <windows.h>
+#include <fcntl.h>
+#include <io.h>
+#include <process.h>
+#include <sys/stat.h>
+#endif
+
 #include "board.h"
 #include "book.h"
 #include "move.h"
@@ -25,17 +39,46 @@ struct entry_t {
    uint16 sum;
 };
 
+struct learn_t {
+   uint64 key;
+   uint16 move;
+   uint16 result;
+};
+
+// constants
+
+static const int LearnSize = 12; // bytes per journal record
+
+static const int BookReplaceRetries = 20; // Windows, see book_replace()
+static const int BookReplaceWait = 100; // ms
+
 // variables
 
 static FILE * BookFile;
 static int BookSize;
 
+static char BookName[256];
+
+static FILE * LearnFile;
+static char LearnName[256+32];
+
 // prototypes
 
 static int    find_pos      (uint64 key);
 
+static bool   book_compact  (bool wait);
+static bool   book_replace  (const char tmp_name[]);
+static char * * journal_orphans (int * num);
+static void   journal_free  (char * * names, int num);
+static bool   process_alive (int pid);
+static int    learn_read    (const char file_name[], learn_t * * list, int * size, int * alloc);
+static int    learn_compare (const void * a, const void * b);
+
+static int    lock_acquire  (bool wait);
+static void   lock_release  (int fd);
+
 static void   read_entry    (entry_t * entry, int n);
-static void   write_entry   (const entry_t * entry, int n);
+static bool   write_entry   (FILE * file, const entry_t * entry);
 
 static uint64 read_integer  (FILE * file, int size);
 static void   write_integer (FILE * file, int size, uint64 n);
@@ -48,6 +91,11 @@ void book_clear() {
 
    BookFile = NULL;
    BookSize = 0;
+
+   BookName[0] = '\0';
+
+   LearnFile = NULL;
+   LearnName[0] = '\0';
 }
 
 // book_open()
@@ -56,7 +104,9 @@ int book_open(const char file_name[]) {
 
    ASSERT(file_name!=NULL);
 
-   BookFile = fopen(file_name,"rb+");
+   // learning never writes into the open book, see book_compact()
+
+   BookFile = fopen(file_name,"rb");
    if (BookFile == NULL){
 	   printf("tellusererror can't open book \"%s\": %s\n",file_name,strerror(errno));
 	   //my_fatal("book_open(): can't open file \"%s\": %s\n",file_name,strerror(errno));
@@ -74,6 +124,16 @@ int book_open(const char file_name[]) {
 	   return 1;
 	   //my_fatal("book_open(): empty file\n");
    }
+
+   strncpy(BookName,file_name,sizeof(BookName)-1);
+   BookName[sizeof(BookName)-1] = '\0';
+
+#ifndef _WIN32
+   sprintf(LearnName,"%s.%d.lrn",BookName,int(getpid()));
+#else
+   sprintf(LearnName,"%s.%d.lrn",BookName,int(_getpid()));
+#endif
+
    return 0;
 }
 
@@ -81,9 +141,21 @@ int book_open(const char file_name[]) {
 
 void book_close() {
 
-   if (fclose(BookFile) == EOF) {
-      my_fatal("book_close(): fclose(): %s\n",strerror(errno));
+   if (BookFile == NULL) return;
+
+   // fold the journals into the book, the only place where the book is rewritten;
+   // if it can't be done now ours stays on disk and a later compaction takes it
+
+   book_compact(true);
+
+   if (LearnFile != NULL) {
+      fclose(LearnFile);
+      LearnFile = NULL;
    }
+
+   if (BookFile != NULL) fclose(BookFile);
+
+   BookFile = NULL;
 }
 
 // is_in_book()
@@ -204,39 +276,469 @@ void book_disp(const board_t * board) {
 
 void book_learn_move(const board_t * board, int move, int result) {
 
-   int pos;
-   entry_t entry[1];
-
    ASSERT(board!=NULL);
    ASSERT(move_is_ok(move));
    ASSERT(result>=-1&&result<=+1);
 
    ASSERT(move_is_legal(move,board));
 
-   for (pos = find_pos(board->key); pos < BookSize; pos++) {
+   // append to this process' journal, the book itself is updated by book_compact()
 
-      read_entry(entry,pos);
-      if (entry->key != board->key) break;
+   if (LearnFile == NULL) {
+      LearnFile = fopen(LearnName,"ab");
+      if (LearnFile == NULL) {
+         my_log("POLYGLOT can't open learn journal \"%s\": %s\n",LearnName,strerror(errno));
+         return;
+      }
+   }
+
+   write_integer(LearnFile,8,board->key);
+   write_integer(LearnFile,2,uint16(move));
+   write_integer(LearnFile,2,uint16(result+1));
+}
+
+// book_flush()
+
+void book_flush() {
+
+   if (LearnFile == NULL) return;
+
+   // only the records of the last game reach the disk here, the book itself
+   // is rewritten by book_compact() when the book is closed
+
+   if (fflush(LearnFile) == EOF) {
+      my_fatal("book_flush(): fflush(): %s\n",strerror(errno));
+   }
+}
+
+// book_compact()
+
+static bool book_compact(bool wait) {
+
+   int lock;
+   learn_t * list;
+   int size, alloc;
+   char * * orphans;
+   int orphan_num;
+   char tmp_name[256+32];
+   FILE * in;
+   FILE * out;
+   int book_size;
+   int pos, i, j, f;
+   entry_t entry[1];
+   bool ok;
 
-      if (entry->move == move) {
+   ASSERT(BookFile!=NULL);
 
-         entry->n++;
-         entry->sum += (uint16)(result+1);
+   lock = lock_acquire(wait);
+   if (lock == -1) return false;
 
-         write_entry(entry,pos);
+   // collect journals: ours, plus those left behind by processes that died before compacting
 
-         break;
+   list = NULL;
+   size = 0;
+   alloc = 0;
+
+   if (LearnFile != NULL) {
+      fflush(LearnFile);
+      learn_read(LearnName,&list,&size,&alloc);
+   }
+
+   orphans = journal_orphans(&orphan_num);
+
+   for (f = 0; f < orphan_num; f++) {
+      learn_read(orphans[f],&list,&size,&alloc);
+   }
+
+   if (size == 0) {
+      journal_free(orphans,orphan_num);
+      lock_release(lock);
+      return true;
+   }
+
+   qsort(list,size,sizeof(list[0]),learn_compare);
+
+   // from here on a failure keeps every journal, nothing learnt is lost:
+   // a later compaction of this book folds them in
+
+   in = NULL;
+   ok = false;
+
+   strcpy(tmp_name,LearnName);
+   strcpy(tmp_name+strlen(tmp_name)-4,".tmp");
+
+   // one sequential pass over the book, both sides sorted by key
+
+   in = fopen(BookName,"rb");
+   if (in == NULL) {
+      my_log("POLYGLOT can't open book \"%s\": %s\n",BookName,strerror(errno));
+      goto done;
+   }
+
+   if (fseek(in,0,SEEK_END) == -1) my_fatal("book_compact(): fseek(): %s\n",strerror(errno));
+   book_size = ftell(in) / 16;
+   if (fseek(in,0,SEEK_SET) == -1) my_fatal("book_compact(): fseek(): %s\n",strerror(errno));
+
+   out = fopen(tmp_name,"wb");
+   if (out == NULL) { // read-only book directory...
+      my_log("POLYGLOT can't create \"%s\", learning kept in the journals: %s\n",tmp_name,strerror(errno));
+      goto done;
+   }
+
+   i = 0;
+
+   for (pos = 0; pos < book_size; pos++) {
+
+      entry->key   = read_integer(in,8);
+      entry->move  = (uint16)read_integer(in,2);
+      entry->count = (uint16)read_integer(in,2);
+      entry->n     = (uint16)read_integer(in,2);
+      entry->sum   = (uint16)read_integer(in,2);
+
+      while (i < size && list[i].key < entry->key) i++;
+
+      for (j = i; j < size && list[j].key == entry->key; j++) {
+         if (list[j].move == entry->move) {
+            entry->n++;
+            entry->sum += list[j].result;
+         }
       }
+
+      if (!write_entry(out,entry)) break;
    }
+
+   fclose(in);
+   in = NULL;
+
+   if (pos < book_size || fflush(out) == EOF) {
+      my_log("POLYGLOT can't write \"%s\", learning kept in the journals: %s\n",tmp_name,strerror(errno));
+      fclose(out);
+      remove(tmp_name);
+      goto done;
+   }
+#ifndef _WIN32
+   fsync(fileno(out));
+#endif
+   if (fclose(out) == EOF) {
+      my_log("POLYGLOT can't write \"%s\", learning kept in the journals: %s\n",tmp_name,strerror(errno));
+      remove(tmp_name);
+      goto done;
+   }
+
+   // readers keep a consistent view: either the old book or the new one, never a mix
+
+   if (!book_replace(tmp_name)) {
+      remove(tmp_name);
+      goto done;
+   }
+
+   ok = true;
+
+   // the journals are folded in, drop them
+
+   if (LearnFile != NULL) {
+      fclose(LearnFile);
+      LearnFile = NULL;
+      remove(LearnName);
+   }
+
+   for (f = 0; f < orphan_num; f++) {
+      remove(orphans[f]);
+   }
+
+done:
+
+   if (in != NULL) fclose(in);
+
+   journal_free(orphans,orphan_num);
+   my_free(list);
+
+   // switch our own handle to the new book (or back to the old one, see book_replace())
+
+   if (BookFile == NULL) {
+      BookFile = fopen(BookName,"rb");
+      if (BookFile == NULL) my_log("POLYGLOT can't open book \"%s\": %s\n",BookName,strerror(errno));
+   } else if (ok) {
+      fclose(BookFile);
+      BookFile = fopen(BookName,"rb");
+      if (BookFile == NULL) my_log("POLYGLOT can't open book \"%s\": %s\n",BookName,strerror(errno));
+   }
+
+   lock_release(lock);
+
+   return ok;
 }
 
-// book_flush()
+// book_replace()
 
-void book_flush() {
+static bool book_replace(const char tmp_name[]) {
 
-   if (fflush(BookFile) == EOF) {
-      my_fatal("book_flush(): fflush(): %s\n",strerror(errno));
+#ifndef _WIN32
+
+   if (rename(tmp_name,BookName) == -1) {
+      my_log("POLYGLOT can't replace book \"%s\": %s\n",BookName,strerror(errno));
+      return false;
+   }
+
+   return true;
+
+#else
+
+   int retry;
+   DWORD error;
+
+   // an open file can't be replaced on Windows, not even by ourselves;
+   // another polyglot reading the book (a tournament) may close it soon
+
+   fclose(BookFile);
+   BookFile = NULL;
+
+   for (retry = 0; ; retry++) {
+      if (MoveFileExA(tmp_name,BookName,MOVEFILE_REPLACE_EXISTING|MOVEFILE_WRITE_THROUGH)) return true;
+      error = GetLastError();
+      if ((error != ERROR_SHARING_VIOLATION && error != ERROR_ACCESS_DENIED) || retry == BookReplaceRetries) break;
+      Sleep(BookReplaceWait);
+   }
+
+   // still busy: the journals stay for whoever closes the book last
+
+   my_log("POLYGLOT can't replace book \"%s\": error %d\n",BookName,int(error));
+
+   return false;
+
+#endif
+}
+
+// journal_orphans()
+
+static char * * journal_orphans(int * num) {
+
+   char * * names;
+   int alloc;
+   char name[256+32];
+   int pid;
+#ifndef _WIN32
+   glob_t files[1];
+   char pattern[256+8];
+   size_t f;
+#else
+   WIN32_FIND_DATAA data[1];
+   HANDLE find;
+   char pattern[256+8];
+   const char * base;
+#endif
+
+   ASSERT(num!=NULL);
+
+   // journals <book>.<pid>.lrn of other processes that are not running anymore
+
+   names = NULL;
+   alloc = 0;
+   *num = 0;
+
+#ifndef _WIN32
+
+   sprintf(pattern,"%s.*.lrn",BookName);
+   if (glob(pattern,0,NULL,files) != 0) return NULL;
+
+   for (f = 0; f < files->gl_pathc; f++) {
+      if (strlen(files->gl_pathv[f]) >= sizeof(name)) continue;
+      strcpy(name,files->gl_pathv[f]);
+#else
+
+   base = BookName + strlen(BookName);
+   while (base > BookName && base[-1] != '/' && base[-1] != '\\' && base[-1] != ':') base--;
+
+   sprintf(pattern,"%s.*.lrn",BookName);
+   find = FindFirstFileA(pattern,data);
+   if (find == INVALID_HANDLE_VALUE) return NULL;
+
+   do {
+      // the found name has no folder and may differ in case from BookName
+      if (strlen(data->cFileName) < strlen(base)) continue;
+      if (strlen(BookName) + strlen(data->cFileName+strlen(base)) >= sizeof(name)) continue;
+      sprintf(name,"%s%s",BookName,data->cFileName+strlen(base));
+#endif
+
+      if (my_string_equal(name,LearnName)) continue;
+      if (sscanf(name+strlen(BookName),".%d.lrn",&pid) != 1) continue;
+      if (process_alive(pid)) continue;
+
+      if (*num == alloc) {
+         if (names == NULL) {
+            alloc = 8;
+            names = (char * *) my_malloc(alloc*sizeof(names[0]));
+         } else {
+            alloc *= 2;
+            names = (char * *) my_realloc(names,alloc*sizeof(names[0]));
+         }
+      }
+      names[(*num)++] = my_strdup(name);
+
+#ifndef _WIN32
+   }
+
+   globfree(files);
+#else
+   } while (FindNextFileA(find,data));
+
+   FindClose(find);
+#endif
+
+   return names;
+}
+
+// journal_free()
+
+static void journal_free(char * * names, int num) {
+
+   int i;
+
+   for (i = 0; i < num; i++) my_free(names[i]);
+   if (names != NULL) my_free(names);
+}
+
+// process_alive()
+
+static bool process_alive(int pid) {
+
+#ifndef _WIN32
+
+   return kill(pid,0) == 0 || errno != ESRCH;
+
+#else
+
+   HANDLE process;
+   bool alive;
+
+   process = OpenProcess(SYNCHRONIZE,FALSE,DWORD(pid));
+   if (process == NULL) return GetLastError() != ERROR_INVALID_PARAMETER; // no such process
+
+   alive = WaitForSingleObject(process,0) == WAIT_TIMEOUT;
+   CloseHandle(process);
+
+   return alive;
+
+#endif
+}
+
+// learn_read()
+
+static int learn_read(const char file_name[], learn_t * * list, int * size, int * alloc) {
+
+   FILE * file;
+   int n, i;
+   learn_t * learn;
+
+   ASSERT(file_name!=NULL);
+   ASSERT(list!=NULL);
+
+   file = fopen(file_name,"rb");
+   if (file == NULL) return 0;
+
+   fseek(file,0,SEEK_END);
+   n = ftell(file) / LearnSize; // a record cut short by a crash is ignored
+   fseek(file,0,SEEK_SET);
+
+   if (*size + n > *alloc) {
+      *alloc = *size + n;
+      *list = (learn_t *) my_realloc(*list,*alloc*sizeof(learn_t));
+   }
+
+   for (i = 0; i < n; i++) {
+      learn = &(*list)[*size+i];
+      learn->key    = read_integer(file,8);
+      learn->move   = (uint16)read_integer(file,2);
+      learn->result = (uint16)read_integer(file,2);
+      if (learn->result > 2) learn->result = 1;
+   }
+
+   *size += n;
+
+   fclose(file);
+
+   return n;
+}
+
+// learn_compare()
+
+static int learn_compare(const void * a, const void * b) {
+
+   const learn_t * la = (const learn_t *) a;
+   const learn_t * lb = (const learn_t *) b;
+
+   if (la->key < lb->key) return -1;
+   if (la->key > lb->key) return +1;
+
+   return int(la->move) - int(lb->move);
+}
+
+// lock_acquire()
+
+static int lock_acquire(bool wait) {
+
+#ifndef _WIN32
+
+   char file_name[256+8];
+   int fd;
+   struct flock fl[1];
+
+   sprintf(file_name,"%s.lck",BookName);
+
+   fd = open(file_name,O_RDWR|O_CREAT,0644);
+   if (fd == -1) {
+      my_log("POLYGLOT can't open book lock \"%s\": %s\n",file_name,strerror(errno));
+      return -1;
+   }
+
+   fl->l_type = F_WRLCK;
+   fl->l_whence = SEEK_SET;
+   fl->l_start = 0;
+   fl->l_len = 0;
+
+   while (fcntl(fd,wait?F_SETLKW:F_SETLK,fl) == -1) {
+      if (wait && errno == EINTR) continue;
+      close(fd);
+      return -1;
+   }
+
+   return fd;
+
+#else
+
+   char file_name[256+8];
+   int fd;
+   OVERLAPPED ov[1];
+
+   sprintf(file_name,"%s.lck",BookName);
+
+   fd = _open(file_name,_O_RDWR|_O_CREAT|_O_BINARY,_S_IREAD|_S_IWRITE);
+   if (fd == -1) {
+      my_log("POLYGLOT can't open book lock \"%s\": %s\n",file_name,strerror(errno));
+      return -1;
+   }
+
+   memset(ov,0,sizeof(ov));
+
+   if (!LockFileEx((HANDLE)_get_osfhandle(fd),LOCKFILE_EXCLUSIVE_LOCK|(wait?0:LOCKFILE_FAIL_IMMEDIATELY),0,1,0,ov)) {
+      _close(fd);
+      return -1;
    }
+
+   return fd;
+
+#endif
+}
+
+// lock_release()
+
+static void lock_release(int fd) {
+
+#ifndef _WIN32
+   close(fd); // drops the fcntl() lock
+#else
+   _close(fd); // closing the handle drops the LockFileEx() lock
+#endif
 }
 
 // find_pos()
@@ -294,20 +796,25 @@ static void read_entry(entry_t * entry, int n) {
 
 // write_entry()
 
-static void write_entry(const entry_t * entry, int n) {
+static bool write_entry(FILE * file, const entry_t * entry) {
 
-   ASSERT(entry!=NULL);
-   ASSERT(n>=0&&n<BookSize);
+   unsigned char buffer[16];
+   int i;
 
-   if (fseek(BookFile,n*16,SEEK_SET) == -1) {
-      my_fatal("write_entry(): fseek(): %s\n",strerror(errno));
-   }
+   ASSERT(file!=NULL);
+   ASSERT(entry!=NULL);
 
-   write_integer(BookFile,8,entry->key);
-   write_integer(BookFile,2,entry->move);
-   write_integer(BookFile,2,entry->count);
-   write_integer(BookFile,2,entry->n);
-   write_integer(BookFile,2,entry->sum);
+   for (i = 0; i < 8; i++) buffer[i] = (unsigned char) (entry->key >> ((7-i)*8));
+   buffer[8]  = (unsigned char) (entry->move >> 8);
+   buffer[9]  = (unsigned char) entry->move;
+   buffer[10] = (unsigned char) (entry->count >> 8);
+   buffer[11] = (unsigned char) entry->count;
+   buffer[12] = (unsigned char) (entry->n >> 8);
+   buffer[13] = (unsigned char) entry->n;
+   buffer[14] = (unsigned char) (entry->sum >> 8);
+   buffer[15] = (unsigned char) entry->sum;
+
+   return fwrite(buffer,1,16,file) == 16;
 }
 
 // read_integer()
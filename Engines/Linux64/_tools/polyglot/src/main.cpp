@@ -418,6 +418,8 @@ void quit() {
 
 	my_log("POLYGLOT *** QUIT ***\n");
 
+	book_close(); // folds pending learning into the book
+
 	if (Init) {
 
 		stop_search();
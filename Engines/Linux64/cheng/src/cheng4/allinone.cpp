@@ -41,7 +41,9 @@ or as public domain (where applicable)
 #include "history.cpp"
 #include "kpk.cpp"
 #include "magic.cpp"
+#ifndef CHENG_LIBRARY
 #include "main.cpp"
+#endif
 #include "move.cpp"
 #include "movegen.cpp"
 #include "protocol.cpp"
@@ -56,3 +58,6 @@ or as public domain (where applicable)
 #include "version.cpp"
 #include "zobrist.cpp"
 #include "epd.cpp"
+#ifdef CHENG_LIBRARY
+#include "capi.cpp"
+#endif
@@ -0,0 +1,226 @@
+/*
+You can use this program under the terms of either the following zlib-compatible license
+or as public domain (where applicable)
+
+  Copyright (C) 2012-2015 Martin Sedlak
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgement in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "capi.h"
+#include "engine.h"
+
+using namespace cheng4;
+
+struct cheng_engine
+{
+	Engine engine;
+	Event done;					// set when bestmove arrives
+	cheng_callback callback;
+	void *param;
+	uint multiPV;
+	Move best, ponder;
+
+	cheng_engine( size_t megs ) : engine( megs ), done( 1 ), callback( 0 ), param( 0 ),
+		multiPV( 1 ), best( mcNone ), ponder( mcNone )
+	{
+	}
+};
+
+// convert to from + to*64 + promo*4096 (a1 = 0), castling as king move
+static int moveNumber( Move m )
+{
+	if ( m == mcNone || m == mcNull )
+		return -1;
+	char buf[16];
+	*MovePack::toUCI( buf, m, 0 ) = 0;
+	int from = (buf[0] - 'a') + (buf[1] - '1')*8;
+	int to = (buf[2] - 'a') + (buf[3] - '1')*8;
+	int promo = 0;
+	switch( buf[4] )
+	{
+	case 'q':
+		promo = 1;
+		break;
+	case 'r':
+		promo = 2;
+		break;
+	case 'b':
+		promo = 3;
+		break;
+	case 'n':
+		promo = 4;
+		break;
+	}
+	return from + to*64 + promo*4096;
+}
+
+static void apiCallback( const SearchInfo &si, void *param )
+{
+	cheng_engine *eng = static_cast< cheng_engine * >( param );
+	if ( (si.flags & sifPV) && eng->callback )
+	{
+		int pv[ maxPV ];
+		uint count = si.pvCount < (uint)maxPV ? si.pvCount : (uint)maxPV;
+		for ( uint i=0; i<count; i++ )
+			pv[i] = moveNumber( si.pv[i] );
+
+		cheng_info info;
+		memset( &info, 0, sizeof(info) );
+		if ( si.flags & sifDepth )
+			info.depth = si.depth;
+		if ( si.flags & sifSelDepth )
+			info.seldepth = si.selDepth;
+		if ( ScorePack::isMate( si.pvScore ) )
+			info.mate = si.pvScore >= 0 ? (scInfinity - si.pvScore)/2 + 1 : (-scInfinity - si.pvScore + 1)/2 - 1;
+		else
+			info.score = si.pvScore;
+		info.bound = si.pvBound == btLower ? 1 : si.pvBound == btUpper ? 2 : 0;
+		info.multipv = (int)si.pvIndex;
+		if ( si.flags & sifNodes )
+			info.nodes = si.nodes;
+		if ( si.flags & sifTime )
+			info.time = (int)si.time;
+		if ( si.flags & sifHashFull )
+			info.hashfull = (int)si.hashFull;
+		info.pvlen = (int)count;
+		info.pv = pv;
+		eng->callback( &info, eng->param );
+	}
+	if ( si.flags & sifBestMove )
+	{
+		eng->best = si.bestMove;
+		eng->ponder = (si.flags & sifPonderMove) ? si.ponderMove : mcNone;
+		eng->done.signal();
+	}
+}
+
+cheng_engine *cheng_new( unsigned hashMegs )
+{
+	static bool initDone = 0;
+	if ( !initDone )
+	{
+		Engine::init();
+		initDone = 1;
+	}
+	cheng_engine *eng = new cheng_engine( hashMegs ? hashMegs : 4 );
+	eng->engine.setUCIMode( 1 );
+	eng->engine.setOwnBook( 0 );
+	eng->engine.setCallback( apiCallback, eng );
+	eng->engine.run();
+	return eng;
+}
+
+void cheng_free( cheng_engine *eng )
+{
+	delete eng;
+}
+
+int cheng_set_fen( cheng_engine *eng, const char *fen )
+{
+	Board b;
+	if ( !b.fromFEN( fen ) )
+		return 1;
+	eng->engine.setBoard( b );
+	return 0;
+}
+
+int cheng_do_move( cheng_engine *eng, const char *move )
+{
+	const char *c = move;
+	Move m = eng->engine.board().fromUCI( c );
+	if ( m == mcNone )
+		return 1;
+	return !eng->engine.doMove( m );
+}
+
+int cheng_set_hash( cheng_engine *eng, unsigned megs )
+{
+	return !eng->engine.setHash( megs );
+}
+
+void cheng_clear_hash( cheng_engine *eng )
+{
+	eng->engine.clearHash();
+}
+
+void cheng_set_threads( cheng_engine *eng, unsigned threads )
+{
+	eng->engine.setThreads( threads );
+}
+
+void cheng_set_multipv( cheng_engine *eng, unsigned multipv )
+{
+	eng->multiPV = multipv < 1 ? 1 : multipv > 256 ? 256 : multipv;
+	eng->engine.setMultiPV( eng->multiPV );
+}
+
+void cheng_set_own_book( cheng_engine *eng, int ownBook )
+{
+	eng->engine.setOwnBook( ownBook != 0 );
+}
+
+int cheng_search( cheng_engine *eng, int depth, int movetime, unsigned long long nodes,
+	cheng_callback cbk, void *param, int *ponder )
+{
+	// no legal move: the engine would answer with the best move of the previous search
+	MoveGen mg( eng->engine.board() );
+	if ( mg.next() == mcNone )
+	{
+		if ( cbk )
+		{
+			cheng_info info;
+			memset( &info, 0, sizeof(info) );
+			info.score = eng->engine.board().inCheck() ? CHENG_MATED : 0;
+			cbk( &info, param );
+		}
+		if ( ponder )
+			*ponder = -1;
+		return -1;
+	}
+
+	SearchMode sm;
+	sm.reset();
+	sm.multiPV = eng->multiPV;
+	if ( depth > 0 )
+		sm.maxDepth = (Depth)(depth < maxDepth ? depth : maxDepth);
+	if ( movetime > 0 )
+	{
+		sm.absLimit = sm.maxTime = (i32)movetime;
+		sm.fixedTime = 1;
+	}
+	if ( nodes )
+		sm.maxNodes = (NodeCount)nodes;
+
+	eng->callback = cbk;
+	eng->param = param;
+	eng->best = eng->ponder = mcNone;
+	eng->done.reset();
+	eng->engine.startSearch( sm );
+	eng->done.wait();
+	eng->callback = 0;
+	eng->param = 0;
+
+	if ( ponder )
+		*ponder = moveNumber( eng->ponder );
+	return moveNumber( eng->best );
+}
+
+void cheng_stop( cheng_engine *eng )
+{
+	eng->engine.requestStop();
+}
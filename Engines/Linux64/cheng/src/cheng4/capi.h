@@ -0,0 +1,90 @@
+/*
+You can use this program under the terms of either the following zlib-compatible license
+or as public domain (where applicable)
+
+  Copyright (C) 2012-2015 Martin Sedlak
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgement in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+#pragma once
+
+// plain C interface for embedding the engine in-process (shared library build)
+// moves are numbers: from + to*64 + promo*4096, squares a1 = 0 .. h8 = 63,
+// promo 0 = none, 1 = queen, 2 = rook, 3 = bishop, 4 = knight
+
+#ifdef _WIN32
+#	define CHENG_API __declspec(dllexport)
+#else
+#	define CHENG_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+typedef struct cheng_engine cheng_engine;
+
+typedef struct
+{
+	int depth;					// nominal depth
+	int seldepth;				// selective depth
+	int score;					// centipawns, side to move
+	int mate;					// nonzero: mate in n moves (negative if being mated)
+	int bound;					// 0 = exact, 1 = lower, 2 = upper
+	int multipv;				// zero-based multipv index
+	unsigned long long nodes;	// nodes searched so far
+	int time;					// msec searched so far
+	int hashfull;				// permill
+	int pvlen;					// number of moves in pv
+	const int *pv;				// valid only during the callback
+} cheng_info;
+
+// score of the single info sent when the side to move is checkmated (0 if stalemated)
+#define CHENG_MATED (-32767)
+
+typedef void (*cheng_callback)( const cheng_info *info, void *param );
+
+// create engine with hashMegs hashtable, own book disabled
+CHENG_API cheng_engine *cheng_new( unsigned hashMegs );
+CHENG_API void cheng_free( cheng_engine *eng );
+
+// returns 0 if ok
+CHENG_API int cheng_set_fen( cheng_engine *eng, const char *fen );
+// UCI move (e2e4, e7e8q); returns 0 if ok, nonzero if illegal
+CHENG_API int cheng_do_move( cheng_engine *eng, const char *move );
+
+CHENG_API int cheng_set_hash( cheng_engine *eng, unsigned megs );
+CHENG_API void cheng_clear_hash( cheng_engine *eng );
+CHENG_API void cheng_set_threads( cheng_engine *eng, unsigned threads );
+CHENG_API void cheng_set_multipv( cheng_engine *eng, unsigned multipv );
+CHENG_API void cheng_set_own_book( cheng_engine *eng, int ownBook );
+
+// search until one of the limits is reached (0 = no limit) or cheng_stop is called
+// callback (may be null) is called from the search thread for each pv
+// returns best move or -1 if none; ponder move stored in *ponder if not null
+// with no legal move it returns -1 at once, after a single callback with an empty pv
+CHENG_API int cheng_search( cheng_engine *eng, int depth, int movetime, unsigned long long nodes,
+	cheng_callback cbk, void *param, int *ponder );
+
+// stop search (from another thread or from the callback), cheng_search returns the best move so far
+CHENG_API void cheng_stop( cheng_engine *eng );
+
+#ifdef __cplusplus
+}
+#endif
@@ -210,6 +210,12 @@ void Engine::abortSearch()
 	}
 }
 
+void Engine::requestStop()
+{
+	if ( mainThread->searching )
+		mainThread->search.abort();
+}
+
 void Engine::setBoard( const Board &b )
 {
 	abortSearch();
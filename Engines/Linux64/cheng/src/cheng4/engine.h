@@ -117,6 +117,10 @@ public:
 	// does NOT output bestmove
 	void abortSearch();
 
+	// request stop without waiting for the search to finish
+	// (safe to call from search callback)
+	void requestStop();
+
 	// set board
 	void setBoard( const Board &b );
 
@@ -0,0 +1 @@
+g++ -s -Wall -Wpedantic -W -O4 -std=c++0x -fPIC -shared -fvisibility=hidden -fno-stack-protector -fomit-frame-pointer -fno-rtti -fno-exceptions -fexpensive-optimizations -DNDEBUG -DCHENG_LIBRARY -U_FORTIFY_SOURCE allinone.cpp -o libcheng4.so -lpthread
@@ -0,0 +1,124 @@
+cimport cython
+
+
+cdef extern from "Python.h":
+    void PyEval_InitThreads()
+
+cdef extern from "capi.h":
+    ctypedef struct cheng_engine:
+        pass
+
+    ctypedef struct cheng_info:
+        int depth
+        int seldepth
+        int score
+        int mate
+        int bound
+        int multipv
+        unsigned long long nodes
+        int time
+        int hashfull
+        int pvlen
+        const int *pv
+
+    ctypedef void (*cheng_callback)(const cheng_info *info, void *param)
+
+    cheng_engine *cheng_new(unsigned hashMegs)
+    void cheng_free(cheng_engine *eng)
+    int cheng_set_fen(cheng_engine *eng, const char *fen)
+    int cheng_do_move(cheng_engine *eng, const char *move)
+    int cheng_set_hash(cheng_engine *eng, unsigned megs)
+    void cheng_clear_hash(cheng_engine *eng)
+    void cheng_set_threads(cheng_engine *eng, unsigned threads)
+    void cheng_set_multipv(cheng_engine *eng, unsigned multipv)
+    void cheng_set_own_book(cheng_engine *eng, int ownBook)
+    int cheng_search(cheng_engine *eng, int depth, int movetime, unsigned long long nodes,
+                     cheng_callback cbk, void *param, int *ponder) nogil
+    void cheng_stop(cheng_engine *eng) nogil
+
+PyEval_InitThreads()
+
+
+cdef void infoCallback(const cheng_info *info, void *param) with gil:
+    cdef Engine self = <Engine>param
+    if self.error is not None:
+        return
+    d = {
+        "depth": info.depth,
+        "seldepth": info.seldepth,
+        "score": info.score,
+        "mate": info.mate,
+        "bound": info.bound,
+        "multipv": info.multipv + 1,
+        "nodes": info.nodes,
+        "time": info.time,
+        "hashfull": info.hashfull,
+        "pv": [info.pv[x] for x in range(info.pvlen)],
+    }
+    try:
+        self.callback(d)
+    except BaseException as e:
+        # can't raise across the engine thread, stop and re-raise in search()
+        self.error = e
+        cheng_stop(self.eng)
+
+
+cdef class Engine:
+    """ Cheng4 running in-process, moves are numbers as in LCEngine.move2num """
+    cdef cheng_engine *eng
+    cdef object callback
+    cdef object error
+
+    def __cinit__(self, hashMegs=16):
+        self.eng = cheng_new(hashMegs)
+        self.callback = None
+        self.error = None
+
+    def __dealloc__(self):
+        if self.eng:
+            cheng_free(self.eng)
+
+    def set_fen(self, fen):
+        return cheng_set_fen(self.eng, fen) == 0
+
+    def do_move(self, a1h8q):
+        return cheng_do_move(self.eng, a1h8q) == 0
+
+    def set_hash(self, megs):
+        return cheng_set_hash(self.eng, megs) == 0
+
+    def clear_hash(self):
+        cheng_clear_hash(self.eng)
+
+    def set_threads(self, threads):
+        cheng_set_threads(self.eng, threads)
+
+    def set_multipv(self, multipv):
+        cheng_set_multipv(self.eng, multipv)
+
+    def set_own_book(self, ownBook):
+        cheng_set_own_book(self.eng, 1 if ownBook else 0)
+
+    def stop(self):
+        """ can be called from another python thread or from the callback """
+        with nogil:
+            cheng_stop(self.eng)
+
+    def search(self, depth=0, movetime=0, nodes=0, callback=None):
+        """ callback(dict) receives depth, seldepth, score, mate, bound, multipv, nodes, time,
+            hashfull and pv (list of move numbers) for each pv
+            returns (best, ponder), -1 if there is no move """
+        cdef int cdepth = depth, ctime = movetime, best, ponder = -1
+        cdef unsigned long long cnodes = nodes
+        cdef cheng_callback cbk = NULL
+        self.callback = callback
+        self.error = None
+        if callback is not None:
+            cbk = <cheng_callback>infoCallback
+        with nogil:
+            best = cheng_search(self.eng, cdepth, ctime, cnodes, cbk, <void *>self, &ponder)
+        self.callback = None
+        if self.error is not None:
+            e, self.error = self.error, None
+            raise e
+        return best, ponder
@@ -0,0 +1,8 @@
+from distutils.core import setup
+from distutils.extension import Extension
+
+from Cython.Build import cythonize
+
+setup(
+    ext_modules = cythonize([Extension("Cheng4", ["Cheng4.pyx"], include_dirs=["../cheng4"], libraries=["cheng4"])])
+)
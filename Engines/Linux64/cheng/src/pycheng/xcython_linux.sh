@@ -0,0 +1,20 @@
+#!/usr/bin/env bash
+rm Cheng4.so
+
+(cd ../cheng4 && sh make_linux_lib.sh && mv libcheng4.so ../pycheng)
+
+x=$(pwd)
+export LIBRARY_PATH=$x
+export LD_LIBRARY_PATH=$x
+export PATH=$x:$PATH
+python ./setup.py build_ext --inplace --verbose
+
+
+if uname -m | grep 64
+then
+	folder=64
+else
+	folder=32
+fi
+cp Cheng4.so ../../../../Linux$folder/_tools
+cp libcheng4.so ../../../../Linux$folder/_tools
@@ -0,0 +1,310 @@
+/*
+ * DiscoCheck, an UCI chess engine. Copyright (C) 2011-2013 Lucas Braesch.
+ *
+ * DiscoCheck is free software: you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * DiscoCheck is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+ * even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program. If not,
+ * see <http://www.gnu.org/licenses/>.
+*/
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <vector>
+#include "epd.h"
+#include "movegen.h"
+#include "uci.h"
+
+using namespace std::chrono;
+
+namespace {
+
+struct Position {
+	std::string fen, id;
+	std::vector<std::string> bm, am;	// best moves and avoid moves (SAN)
+	std::vector<std::pair<std::string, int>> points;	// STS points per move (c0 opcode)
+
+	// search result
+	bool done;
+	std::string san;
+	uci::info ui;
+	uint64_t nodes;
+	int time;
+};
+
+std::string strip_san(std::string san)
+// remove check, mate and annotation symbols, and the '=' of promotions ("e8=Q+!" -> "e8Q")
+{
+	std::string s;
+	for (char c : san)
+		if (c != '+' && c != '#' && c != '!' && c != '?' && c != '=')
+			s += c;
+	return s;
+}
+
+std::string move_to_san(const board::Board& B, move::move_t m)
+{
+	const int fsq = m.fsq(), tsq = m.tsq(), piece = B.get_piece_on(fsq);
+	std::string s;
+
+	if (m.flag() == move::CASTLING)
+		s = file(tsq) > file(fsq) ? "O-O" : "O-O-O";
+	else {
+		const bool capture = B.get_piece_on(tsq) != NO_PIECE || m.flag() == move::EN_PASSANT;
+
+		if (piece == PAWN) {
+			if (capture)
+				s += char(file(fsq) + 'a');
+		} else {
+			s += board::PieceLabel[WHITE][piece];
+
+			// disambiguation: file if sufficient, otherwise rank, otherwise both
+			move::move_t mlist[MAX_MOVES];
+			move::move_t *end = movegen::gen_moves(B, mlist);
+			bool ambiguous = false, same_file = false, same_rank = false;
+
+			for (move::move_t *it = mlist; it < end; ++it)
+				if (it->tsq() == tsq && it->fsq() != fsq && B.get_piece_on(it->fsq()) == piece) {
+					ambiguous = true;
+					same_file |= file(it->fsq()) == file(fsq);
+					same_rank |= rank(it->fsq()) == rank(fsq);
+				}
+
+			if (ambiguous && (!same_file || same_rank))
+				s += char(file(fsq) + 'a');
+			if (ambiguous && same_file)
+				s += char(rank(fsq) + '1');
+		}
+
+		if (capture)
+			s += 'x';
+		s += char(file(tsq) + 'a');
+		s += char(rank(tsq) + '1');
+
+		if (m.flag() == move::PROMOTION) {
+			s += '=';
+			s += board::PieceLabel[WHITE][m.prom()];
+		}
+	}
+
+	if (move::is_check(B, m))
+		s += '+';
+
+	return s;
+}
+
+bool parse_epd(const std::string& line, Position& p)
+// Format: 4 FEN fields (no move counters), followed by operations "opcode operand...;"
+{
+	std::istringstream is(line);
+	std::string token;
+
+	for (int i = 0; i < 4; ++i) {
+		if (!(is >> token))
+			return false;
+		p.fen += token + ' ';
+	}
+
+	// split operations on ';', except within quoted strings
+	std::string ops, op;
+	std::getline(is, ops);
+	std::vector<std::string> op_list;
+	bool quoted = false;
+
+	for (char c : ops) {
+		if (c == '"')
+			quoted = !quoted;
+		else if (c == ';' && !quoted) {
+			op_list.push_back(op);
+			op.clear();
+		} else
+			op += c;
+	}
+	op_list.push_back(op);
+
+	for (const std::string& o : op_list) {
+		std::istringstream os(o);
+		std::string opcode;
+		if (!(os >> opcode))
+			continue;
+
+		if (opcode == "id") {
+			std::getline(os >> std::ws, p.id);
+		} else if (opcode == "bm" || opcode == "am") {
+			while (os >> token)
+				(opcode == "bm" ? p.bm : p.am).push_back(strip_san(token));
+		} else if (opcode == "c0") {
+			// STS points: "f5=10, Be5+=2, Bf2=3". Other c0 comments are ignored.
+			while (std::getline(os >> std::ws, token, ',')) {
+				const size_t eq = token.rfind('=');
+				int pts;
+				if (eq != std::string::npos && eq > 0 && eq + 1 < token.size()
+						&& std::istringstream(token.substr(eq + 1)) >> pts)
+					p.points.push_back(std::make_pair(strip_san(token.substr(0, eq)), pts));
+			}
+		}
+	}
+
+	if (p.id.empty())
+		p.id = p.fen.substr(0, p.fen.size() - 1);
+	p.done = false;
+
+	return true;
+}
+
+void print_score(std::ostream& ostrm, int score)
+{
+	if (score >= MATE - MAX_PLY)
+		ostrm << "mate " << (MATE - score + 1) / 2;
+	else if (score <= -MATE + MAX_PLY)
+		ostrm << "mate " << -(score + MATE + 1) / 2;
+	else
+		ostrm << "cp " << score;
+}
+
+struct Summary {
+	int solved, tested, points, max_points;
+	uint64_t nodes;
+};
+
+void print_result(const Position& p, Summary& sum)
+{
+	std::cout << p.id << '\t' << p.san << "\tscore ";
+	print_score(std::cout, p.ui.score);
+	std::cout << "\tdepth " << p.ui.depth << "\tnodes " << p.nodes << "\ttime " << p.time;
+
+	const std::string san = strip_san(p.san);
+
+	if (!p.bm.empty() || !p.am.empty()) {
+		const bool ok = (p.bm.empty() || std::find(p.bm.begin(), p.bm.end(), san) != p.bm.end())
+			&& std::find(p.am.begin(), p.am.end(), san) == p.am.end();
+		std::cout << (ok ? "\tok" : "\tfail");
+		sum.solved += ok;
+		++sum.tested;
+	}
+
+	if (!p.points.empty()) {
+		int pts = 0, max_pts = 0;
+		for (auto& mp : p.points) {
+			if (mp.first == san)
+				pts = mp.second;
+			max_pts = std::max(max_pts, mp.second);
+		}
+		std::cout << "\tpoints " << pts;
+		sum.points += pts;
+		sum.max_points += max_pts;
+	}
+
+	std::cout << std::endl;
+	sum.nodes += p.nodes;
+}
+
+class Batch {
+public:
+	Batch(std::vector<Position>& _pos, const search::Limits& _sl)
+		: pos(_pos), sl(_sl), next(0), printed(0), sum() {}
+
+	void worker(TTable *tt);
+
+	const Summary& get_summary() const {
+		return sum;
+	}
+
+private:
+	std::vector<Position>& pos;
+	const search::Limits& sl;
+
+	std::atomic<size_t> next;	// next position to search
+	std::mutex mtx;				// protects printed and sum
+	size_t printed;				// results are printed in the order of the EPD file
+	Summary sum;
+};
+
+void Batch::worker(TTable *tt)
+{
+	search::ThreadTT = tt;
+	board::Board B;
+
+	for (size_t i; (i = next++) < pos.size(); ) {
+		Position& p = pos[i];
+		p.ui.clear();
+
+		auto start = high_resolution_clock::now();
+		B.set_fen(p.fen);
+		const move::move_t m = search::bestmove(B, sl, &p.ui).first;
+		p.time = duration_cast<milliseconds>(high_resolution_clock::now() - start).count();
+		p.nodes = search::node_count;
+
+		// an aborted search does not unwind B: reset it before writing the move in SAN
+		B.set_fen(p.fen);
+		p.san = m ? move_to_san(B, m) : "(none)";
+
+		std::lock_guard<std::mutex> lock(mtx);
+		p.done = true;
+		while (printed < pos.size() && pos[printed].done)
+			print_result(pos[printed++], sum);
+	}
+}
+
+}	// namespace
+
+void epd(const std::string& file_name, search::Limits sl, int threads, int hash, bool shared_tt)
+{
+	std::ifstream f(file_name);
+	if (!f.is_open()) {
+		std::cerr << "cannot open " << file_name << std::endl;
+		return;
+	}
+
+	std::vector<Position> pos;
+	std::string line;
+	while (std::getline(f, line)) {
+		Position p;
+		if (parse_epd(line, p))
+			pos.push_back(p);
+	}
+
+	threads = std::max(threads, 1);
+	sl.quiet = true;
+
+	// one TT per searcher, or all searchers share the global TT
+	std::vector<std::unique_ptr<TTable>> tables;
+	if (shared_tt) {
+		search::TT.alloc((uint64_t)hash << 20);
+		search::clear_state();
+	} else
+		for (int i = 0; i < threads; ++i) {
+			tables.emplace_back(new TTable());
+			tables.back()->alloc((uint64_t)hash << 20);
+		}
+
+	Batch batch(pos, sl);
+	std::vector<std::thread> searchers;
+
+	auto start = high_resolution_clock::now();
+	for (int i = 0; i < threads; ++i)
+		searchers.emplace_back(&Batch::worker, &batch, shared_tt ? &search::TT : tables[i].get());
+	for (auto& t : searchers)
+		t.join();
+	int64_t elapsed_usec = duration_cast<microseconds>(high_resolution_clock::now() - start).count();
+
+	const Summary& sum = batch.get_summary();
+	std::cout << "positions = " << pos.size() << std::endl;
+	if (sum.tested)
+		std::cout << "solved = " << sum.solved << '/' << sum.tested << std::endl;
+	if (sum.max_points)
+		std::cout << "points = " << sum.points << '/' << sum.max_points << std::endl;
+	std::cout << "nodes = " << sum.nodes << std::endl;
+	std::cout << "time (ms) = " << elapsed_usec / 1000 << std::endl;
+	std::cout << "kn/s = " << sum.nodes / (double)std::max<int64_t>(elapsed_usec, 1) * 1e3 << std::endl;
+}
@@ -0,0 +1,24 @@
+/*
+ * DiscoCheck, an UCI chess engine. Copyright (C) 2011-2013 Lucas Braesch.
+ *
+ * DiscoCheck is free software: you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * DiscoCheck is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+ * even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program. If not,
+ * see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+#include <string>
+#include "search.h"
+
+/* Searches all positions of an EPD file (eg. a STS suite) with the limits sl, and prints one result
+ * line per position (best move, score, nodes), followed by a summary. Positions are distributed over
+ * 'threads' independent searchers, which either share the global TT, or each use their own TT. The
+ * hash size (MB) is per TT. */
+extern void epd(const std::string& file_name, search::Limits sl, int threads, int hash,
+				bool shared_tt);
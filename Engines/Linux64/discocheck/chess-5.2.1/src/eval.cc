@@ -49,7 +49,7 @@ private:
 	Entry buf[count];
 };
 
-PawnCache PC;
+thread_local PawnCache PC;	// one per searcher thread
 
 // Known draws (with recognizer function)
 static const Key KPK  = 0x110000000001ULL;
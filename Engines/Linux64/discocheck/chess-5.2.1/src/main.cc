@@ -12,11 +12,13 @@
  * You should have received a copy of the GNU General Public License along with this program. If not,
  * see <http://www.gnu.org/licenses/>.
 */
+#include <sstream>
 #include "test.h"
 #include "psq.h"
 #include "eval.h"
 #include "search.h"
 #include "uci.h"
+#include "epd.h"
 
 uint64_t dbg_cnt1 = 0, dbg_cnt2 = 0;
 
@@ -36,6 +38,33 @@ int main (int argc, char **argv)
 
 		if (dbg_cnt1 || dbg_cnt2)
 			std::cout << dbg_cnt1 << '\n' << dbg_cnt2 << std::endl;
+	} else if (argc >= 3 && std::string(argv[1]) == "epd") {
+		// epd <file> [depth N] [movetime ms] [nodes N] [threads K] [hash MB] [tt shared|split]
+		search::Limits sl;
+		int threads = 1, hash = uci::Hash;
+		bool shared_tt = true;
+
+		for (int i = 3; i + 1 < argc; i += 2) {
+			const std::string token(argv[i]);
+			std::istringstream is(argv[i + 1]);
+			if (token == "depth")
+				is >> sl.depth;
+			else if (token == "movetime")
+				is >> sl.movetime;
+			else if (token == "nodes")
+				is >> sl.nodes;
+			else if (token == "threads")
+				is >> threads;
+			else if (token == "hash")
+				is >> hash;
+			else if (token == "tt")
+				shared_tt = is.str() != "split";
+		}
+
+		if (!sl.depth && !sl.movetime && !sl.nodes)
+			sl.depth = 12;
+
+		epd(argv[2], sl, threads, hash, shared_tt);
 	} else
 		uci::loop();
 }
@@ -26,34 +26,35 @@ using namespace std::chrono;
 namespace search {
 
 TTable TT;
-Refutation R;
+thread_local TTable *ThreadTT = &TT;
+thread_local Refutation R;
 
-uint64_t node_count;
+thread_local uint64_t node_count;
 
 }	// namespace search
 
 namespace {
 
-bool can_abort, pondering;
+thread_local bool can_abort, pondering, quiet;
 struct AbortSearch {};
 struct ForcedMove {};
 
-uint64_t node_limit;
-int time_limit[2], time_allowed;
-time_point<high_resolution_clock> start;
+thread_local uint64_t node_limit;
+thread_local int time_limit[2], time_allowed;
+thread_local time_point<high_resolution_clock> start;
 
-History H;
+thread_local History H;
 
 // Formulas tuned by CLOP
 int razor_margin(int depth)	  { return 73 * depth + 145; }
 int eval_margin(int depth)	  { return 37 * depth + 111; }
 int null_reduction(int depth) { return (13 * depth + 72) / 32; }
 
-int DrawScore[NB_COLOR];	// Contempt draw score by color
+thread_local int DrawScore[NB_COLOR];	// Contempt draw score by color
 
-move::move_t pv[MAX_PLY+1][MAX_PLY+1];
-move::move_t best_move, ponder_move;
-bool best_move_changed;
+thread_local move::move_t pv[MAX_PLY+1][MAX_PLY+1];
+thread_local move::move_t best_move, ponder_move;
+thread_local bool best_move_changed;
 
 void node_poll()
 {
@@ -73,6 +74,8 @@ void node_poll()
 			throw AbortSearch();
 
 		// handle input during search
+		if (quiet)
+			return;
 		std::string token = uci::check_input();
 		if (token == "stop")
 			throw AbortSearch();
@@ -144,7 +147,7 @@ int qsearch(board::Board& B, int alpha, int beta, int depth, int node_type, Sear
 	assert(alpha < beta && (node_type == PV || alpha + 1 == beta));
 
 	const Key key = B.get_key();
-	search::TT.prefetch(key);
+	search::ThreadTT->prefetch(key);
 	node_poll();
 
 	const bool in_check = B.is_check();
@@ -160,10 +163,11 @@ int qsearch(board::Board& B, int alpha, int beta, int depth, int node_type, Sear
 	const Bitboard hanging = hanging_pieces(B);
 
 	// TT lookup
-	const TTable::Entry *tte = search::TT.probe(key);
+	TTable::Entry tt_copy;
+	const TTable::Entry *tte = search::ThreadTT->probe(key, &tt_copy);
 	if (tte) {
 		if (node_type != PV && can_return_tt(tte, depth, beta, ss->ply)) {
-			search::TT.refresh(tte);
+			search::ThreadTT->refresh(key);
 			return score_from_tt(tte->score, ss->ply);
 		}
 		ss->eval = tte->eval;
@@ -253,7 +257,7 @@ int qsearch(board::Board& B, int alpha, int beta, int depth, int node_type, Sear
 
 	// update TT
 	node_type = best_score <= old_alpha ? All : best_score >= beta ? Cut : PV;
-	search::TT.store(key, node_type, depth, score_to_tt(best_score, ss->ply), ss->eval, ss->best);
+	search::ThreadTT->store(key, node_type, depth, score_to_tt(best_score, ss->ply), ss->eval, ss->best);
 
 	return best_score;
 }
@@ -278,7 +282,7 @@ int pvs(board::Board& B, int alpha, int beta, int depth, int node_type, SearchIn
 		return qsearch(B, alpha, beta, depth, node_type, ss);
 
 	const Key key = B.get_key();
-	search::TT.prefetch(key);
+	search::ThreadTT->prefetch(key);
 
 	if (node_type == PV)
 		pv[ss->ply][0] = move::move_t(0);
@@ -304,11 +308,12 @@ int pvs(board::Board& B, int alpha, int beta, int depth, int node_type, SearchIn
 	const Bitboard hanging = hanging_pieces(B);
 
 	// TT lookup
-	const TTable::Entry *tte = search::TT.probe(key);
+	TTable::Entry tt_copy;
+	const TTable::Entry *tte = search::ThreadTT->probe(key, &tt_copy);
 	if (tte) {
 		if (node_type != PV && can_return_tt(tte, depth, beta, ss->ply)) {
 			// Refresh TT entry to prevent ageing
-			search::TT.refresh(tte);
+			search::ThreadTT->refresh(key);
 
 			// update killers, refutation, and history on TT prune when alpha is raised
 			if (tte->score > old_alpha && (ss->best = tte->move) && !move::is_cop(B, ss->best)) {
@@ -534,7 +539,7 @@ tt_skip_null:
 
 	// update TT
 	node_type = best_score <= old_alpha ? All : best_score >= beta ? Cut : PV;
-	search::TT.store(key, node_type, depth, score_to_tt(best_score, ss->ply), ss->eval, ss->best);
+	search::ThreadTT->store(key, node_type, depth, score_to_tt(best_score, ss->ply), ss->eval, ss->best);
 
 	// best move is quiet: update move sorting heuristics if alpha was raised
 	if (best_score > old_alpha && ss->best && !move::is_cop(B, ss->best)) {
@@ -558,7 +563,8 @@ tt_skip_null:
 
 namespace search {
 
-std::pair<move::move_t, move::move_t> bestmove(board::Board& B, const Limits& sl)
+std::pair<move::move_t, move::move_t> bestmove(board::Board& B, const Limits& sl,
+		uci::info *last)
 // returns a pair (best move, ponder move)
 {
 	start = high_resolution_clock::now();
@@ -570,13 +576,14 @@ std::pair<move::move_t, move::move_t> bestmove(board::Board& B, const Limits& sl
 	node_count = 0;
 	node_limit = sl.nodes;
 	pondering = sl.ponder;
+	quiet = sl.quiet;
 	time_alloc(sl, time_limit);
 
 	best_move = ponder_move = move::move_t(0);
 	best_move_changed = false;
 
 	H.clear();
-	TT.new_search();
+	ThreadTT->new_search();
 	B.set_root();	// remember root node, for correct 2/3-fold in is_draw()
 
 	// Contempt Draw value
@@ -638,12 +645,12 @@ std::pair<move::move_t, move::move_t> bestmove(board::Board& B, const Limits& sl
 				if (ui.score <= alpha) {
 					alpha -= delta;
 					ui.bound = uci::info::UBOUND;
-					std::cout << ui << std::endl;
 				} else if (ui.score >= beta) {
 					beta += delta;
 					ui.bound = uci::info::LBOUND;
-					std::cout << ui << std::endl;
 				}
+				if (!quiet)
+					std::cout << ui << std::endl;
 				delta *= 2;
 
 				// increase time_allowed, to try to finish the current depth iteration
@@ -651,7 +658,10 @@ std::pair<move::move_t, move::move_t> bestmove(board::Board& B, const Limits& sl
 			}
 		}
 
-		std::cout << ui << std::endl;
+		if (last)
+			*last = ui;
+		if (!quiet)
+			std::cout << ui << std::endl;
 	}
 
 return_pair:
@@ -16,20 +16,31 @@
 #include "movesort.h"
 #include "tt.h"
 
+namespace uci {
+struct info;
+}
+
 namespace search {
 
 struct Limits {
-	Limits(): time(0), inc(0), movetime(0), depth(0), movestogo(0), nodes(0), ponder(false) {}
+	Limits(): time(0), inc(0), movetime(0), depth(0), movestogo(0), nodes(0), ponder(false),
+		quiet(false) {}
 	int time, inc, movetime, depth, movestogo;
 	uint64_t nodes;
 	bool ponder;
+	bool quiet;	// no info output, and no polling of stdin (batch searches, see epd.cc)
 };
 
+/* The search state is thread local, so that several threads can run independent searches. They
+ * share the global TT, unless ThreadTT is pointed elsewhere in the thread. */
 extern TTable TT;
+extern thread_local TTable *ThreadTT;
 
-extern uint64_t node_count;
+extern thread_local uint64_t node_count;
 
-std::pair<move::move_t, move::move_t> bestmove(board::Board& B, const Limits& sl);
+// If last != nullptr, the info of the last completed iteration is written there
+std::pair<move::move_t, move::move_t> bestmove(board::Board& B, const Limits& sl,
+		uci::info *last = nullptr);
 
 extern void clear_state();
 
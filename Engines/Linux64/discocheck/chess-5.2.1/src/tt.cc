@@ -82,13 +82,26 @@ void TTable::new_search()
 	++generation;
 }
 
-const TTable::Entry *TTable::probe(Key key) const
+void TTable::refresh(Key key) const
 {
 	const Entry *e = &cluster[key & (count - 1)].entry[0];
 
 	for (size_t i = 0; i < 4; ++i, ++e)
-		if (e->key_match(key))
-			return e;
+		if (e->key_match(key)) {
+			e->generation = generation;
+			return;
+		}
+}
+
+const TTable::Entry *TTable::probe(Key key, Entry *copy) const
+{
+	const Entry *e = &cluster[key & (count - 1)].entry[0];
+
+	for (size_t i = 0; i < 4; ++i, ++e) {
+		*copy = *e;
+		if (copy->key_match(key))
+			return copy;
+	}
 
 	return nullptr;
 }
@@ -96,12 +109,12 @@ const TTable::Entry *TTable::probe(Key key) const
 void TTable::Entry::save(Key k, uint8_t g, int nt, int8_t d, int16_t s, int16_t e,
 						 move::move_t m)
 {
-	key_type = (k & ~3ULL) ^ (nt + 1);
 	generation = g;
 	depth = d;
 	score = s;
 	eval = e;
 	move = m;
+	key_type = (k & ~3ULL) ^ (nt + 1) ^ data();
 }
 
 void TTable::store(Key key, int node_type, int8_t depth, int16_t score, int16_t eval, move::move_t move)
@@ -112,11 +125,12 @@ void TTable::store(Key key, int node_type, int8_t depth, int16_t score, int16_t
 		move = move::move_t(0);
 
 	for (size_t i = 0; i < 4; ++i, ++e) {
-		// overwrite empty or old
-		if (!e->key_type || e->key_match(key)) {
+		// overwrite empty or old (read a copy, as the slot may be written concurrently)
+		const Entry tmp = *e;
+		if (!tmp.key_type || tmp.key_match(key)) {
 			replace = e;
 			if (!move)
-				move = e->move;
+				move = tmp.move;
 			break;
 		}
 
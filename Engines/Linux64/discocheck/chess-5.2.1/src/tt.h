@@ -13,6 +13,7 @@
  * see <http://www.gnu.org/licenses/>.
 */
 #pragma once
+#include <cstring>
 #include "board.h"
 
 enum { PV = 0, All = -1, Cut = +1 };
@@ -20,7 +21,7 @@ enum { PV = 0, All = -1, Cut = +1 };
 class TTable {
 public:
 	struct Entry {
-		Key key_type;	// bit 0..1 for node_type+1, and 2..63 for key's 62 MSB
+		Key key_type;	// bit 0..1 for node_type+1, and 2..63 for key's 62 MSB (xored with data())
 		mutable uint8_t generation;
 		int8_t depth;
 		int16_t score, eval;
@@ -30,8 +31,18 @@ public:
 			return (key_type & 3) - 1;
 		}
 
+		/* Everything but the generation, packed in the 56 MSB. Xoring it into key_type means that
+		 * an entry torn by concurrent writers (several searchers sharing the TT) fails key_match(),
+		 * without any locking */
+		uint64_t data() const {
+			uint16_t m;
+			std::memcpy(&m, &move, sizeof(m));
+			return ((uint64_t)(uint8_t)depth | (uint64_t)(uint16_t)score << 8
+					| (uint64_t)(uint16_t)eval << 24 | (uint64_t)m << 40) << 8;
+		}
+
 		bool key_match(Key k) const {
-			return (key_type & ~3ULL) == (k & ~3ULL);
+			return ((key_type ^ data()) & ~3ULL) == (k & ~3ULL);
 		}
 
 		void save(Key k, uint8_t g, int nt, int8_t d, int16_t s, int16_t e,
@@ -49,11 +60,11 @@ public:
 	void clear();
 
 	void new_search();
-	void refresh(const Entry *e) const {
-		e->generation = generation;
-	}
+	void refresh(Key key) const;
 
-	const Entry *probe(Key key) const;
+	// On a hit, the entry is copied into *copy, which is returned. Use the copy rather than the
+	// TT slot, because another searcher may overwrite the slot at any time.
+	const Entry *probe(Key key, Entry *copy) const;
 	void prefetch(Key key) const {
 		__builtin_prefetch((char *)&cluster[key & (count - 1)]);
 	}
@@ -21,7 +21,11 @@
 //// Includes
 ////
 
+#include <cstdio>
+#include <iostream>
+
 #include "benchmark.h"
+#include "misc.h"
 #include "search.h"
 #include "thread.h"
 #include "ucioption.h"
@@ -89,3 +93,71 @@ void benchmark(const std::string &ttSize, const std::string &threads) {
   }
     
 }
+
+
+/// smp_benchmark() measures how well the two multithreaded search modes
+/// scale.  Each of the benchmark positions is searched to a fixed depth with
+/// 1, 2, 4, 8 and 16 threads, first with the split point search and then with
+/// lazy SMP, and the total time to reach the given depth is reported along
+/// with the speedup over a single thread.  The hash table is cleared before
+/// each search, so that all searches start from the same state.
+
+void smp_benchmark(const std::string &ttSize, const std::string &depth) {
+  const int ThreadCounts[] = {1, 2, 4, 8, 16};
+  const int NumThreadCounts = sizeof(ThreadCounts) / sizeof(int);
+  const std::string Modes[2] = {"Split Point", "Lazy SMP"};
+  int elapsed[2][NumThreadCounts];
+  int64_t nodes[2][NumThreadCounts];
+  Position pos;
+  Move moves[1] = {MOVE_NONE};
+  int i, j, k, d;
+
+  i = atoi(ttSize.c_str());
+  if(i < 4 || i > 1024) {
+    std::cerr << "The hash table size must be between 4 and 1024" << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  d = atoi(depth.c_str());
+  if(d < 1 || d > 40) {
+    std::cerr << "The search depth must be between 1 and 40" << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  set_option_value("Hash", ttSize);
+  set_option_value("OwnBook", "false");
+  set_option_value("Use Search Log", "false");
+
+  for(i = 0; i < 2; i++) {
+    set_option_value("SMP Mode", Modes[i]);
+    for(j = 0; j < NumThreadCounts; j++) {
+      char buf[16];
+      sprintf(buf, "%d", ThreadCounts[j]);
+      set_option_value("Threads", buf);
+      elapsed[i][j] = 0;
+      nodes[i][j] = 0;
+      for(k = 0; k < 15; k++) {
+        pos.from_fen(BenchmarkPositions[k]);
+        push_button("Clear Hash");
+        int t = get_system_time();
+        think(pos, true, false, 0, 0, 0, d, 0, 0, moves);
+        elapsed[i][j] += get_system_time() - t;
+        nodes[i][j] += nodes_searched();
+      }
+    }
+  }
+
+  std::cout << "\nTime to depth " << d << " over 15 positions:\n\n"
+            << "Threads  Mode         Time (ms)  Nodes        Speedup\n";
+  for(j = 0; j < NumThreadCounts; j++)
+    for(i = 0; i < 2; i++) {
+      char line[128];
+      sprintf(line, "%7d  %-11s  %9d  %11lld  %7.2f",
+              ThreadCounts[j], Modes[i].c_str(), elapsed[i][j],
+              (long long)nodes[i][j],
+              double(elapsed[0][0]) / Max(elapsed[i][j], 1));
+      std::cout << line << std::endl;
+    }
+  std::cout << "\nSpeedups are relative to the split point search with "
+            << "one thread." << std::endl;
+}
@@ -32,6 +32,7 @@
 ////
 
 extern void benchmark(const std::string &ttSize, const std::string &threads);
+extern void smp_benchmark(const std::string &ttSize, const std::string &depth);
 
 
 #endif // !defined(BENCHMARK_H_INCLUDED)
@@ -247,8 +247,8 @@ namespace {
 
 
   // Pawn and material hash tables, indexed by the current thread id:
-  PawnInfoTable *PawnTable[8] = {0, 0, 0, 0, 0, 0, 0, 0};
-  MaterialInfoTable *MaterialTable[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+  PawnInfoTable *PawnTable[THREAD_MAX];
+  MaterialInfoTable *MaterialTable[THREAD_MAX];
 
   // Sizes of pawn and material hash tables:
   const int PawnTableSize = 16384;
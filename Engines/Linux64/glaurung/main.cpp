@@ -81,6 +81,14 @@ int main(int argc, char *argv[]) {
       benchmark(std::string(argv[2]), std::string(argv[3]));
       return 0;
     }
+    else if(std::string(argv[1]) == "smpbench") {
+      if(argc != 4) {
+        std::cout << "Usage: glaurung smpbench <hash> <depth>" << std::endl;
+        exit(0);
+      }
+      smp_benchmark(std::string(argv[2]), std::string(argv[3]));
+      return 0;
+    }
   }
 
   // Print copyright notice
@@ -210,6 +210,12 @@ namespace {
   SplitPoint SplitPointStack[THREAD_MAX][MaxActiveSplitPoints];
   bool Idle = true;
 
+  // Lazy SMP mode.  Instead of splitting the tree at split points, all
+  // helper threads run their own iterative deepening loops from the root
+  // position, and share information only through the transposition table.
+  bool LazySMP = false;
+  Position RootPosition;
+
 #if !defined(_MSC_VER)
   pthread_cond_t WaitCond;
   pthread_mutex_t WaitLock;
@@ -249,6 +255,9 @@ namespace {
   void wait_for_stop_or_ponderhit();
 
   void idle_loop(int threadID, SplitPoint *waitSp);
+  void lazy_id_loop(int threadID);
+  void start_helper_threads(const Position &pos);
+  void stop_helper_threads();
   void init_split_point_stack();
   void destroy_split_point_stack();
   bool thread_should_stop(int threadID);
@@ -394,6 +403,7 @@ void think(const Position &pos, bool infinite, bool ponder, int time,
   MinimumSplitDepth = get_option_value_int("Minimum Split Depth") * OnePly;
   MaxThreadsPerSplitPoint =
     get_option_value_int("Maximum Number of Threads per Split Point");
+  LazySMP = (get_option_value_string("SMP Mode") == "Lazy SMP");
 
   read_weights(pos.side_to_move());
   
@@ -505,6 +515,7 @@ void init_threads() {
   for(i = 1; i < THREAD_MAX; i++) {
     Threads[i].stop = false;
     Threads[i].workIsWaiting = false;
+    Threads[i].lazyWorkIsWaiting = false;
     Threads[i].idle = true;
     Threads[i].running = false;
   }
@@ -576,6 +587,11 @@ namespace {
 
     EasyMove = rml.scan_for_easy_move();
 
+    // In lazy SMP mode, the helper threads start searching the root position
+    // now, and keep going until the main thread has finished:
+    if(LazySMP && ActiveThreads > 1)
+      start_helper_threads(p);
+
     // Iterative deepening loop
     while(!AbortSearch && Iteration < PLY_MAX) {
 
@@ -651,6 +667,9 @@ namespace {
         break;
     }
 
+    if(LazySMP && ActiveThreads > 1)
+      stop_helper_threads();
+
     rml.sort();
 
     // If we are pondering, we shouldn't print the best move before we
@@ -922,12 +941,13 @@ namespace {
           ss[ply].reduction = Depth(0);
           value = -search(pos, ss, -alpha, newDepth, ply+1, true, threadID);
           if(value > alpha && value < beta) {
-            if(ply == 1 && RootMoveNumber == 1)
+            if(ply == 1 && RootMoveNumber == 1 && threadID == 0)
               // When the search fails high at ply 1 while searching the first
               // move at the root, set the flag failHighPly1.  This is used for
               // time managment:  We don't want to stop the search early in
               // such cases, because resolving the fail high at ply 1 could
-              // result in a big drop in score at the root.
+              // result in a big drop in score at the root.  Lazy SMP helper
+              // threads have their own root, and are ignored here.
               Threads[threadID].failHighPly1 = true;
             value = -search_pv(pos, ss, -beta, -alpha, newDepth, ply+1, 
                                threadID);
@@ -951,13 +971,14 @@ namespace {
         // If we are at ply 1, and we are searching the first root move at
         // ply 0, set the 'Problem' variable if the score has dropped a lot
         // (from the computer's point of view) since the previous iteration:
-        if(ply == 1 && Iteration >= 2 &&
+        if(ply == 1 && threadID == 0 && Iteration >= 2 &&
            -value <= ValueByIteration[Iteration-1] - ProblemMargin)
           Problem = true;
       }
 
       // Split?
-      if(ActiveThreads > 1 && bestValue < beta && depth >= MinimumSplitDepth
+      if(ActiveThreads > 1 && !LazySMP && bestValue < beta
+         && depth >= MinimumSplitDepth
          && Iteration <= 99 && idle_thread_exists(threadID)
          && !AbortSearch && !thread_should_stop(threadID)
          && split(pos, ss, ply, &alpha, &beta, &bestValue, depth,
@@ -1200,7 +1221,8 @@ namespace {
       }
 
       // Split?
-      if(ActiveThreads > 1 && bestValue < beta && depth >= MinimumSplitDepth
+      if(ActiveThreads > 1 && !LazySMP && bestValue < beta
+         && depth >= MinimumSplitDepth
          && Iteration <= 99 && idle_thread_exists(threadID)
          && !AbortSearch && !thread_should_stop(threadID)
          && split(pos, ss, ply, &beta, &beta, &bestValue, depth, &moveCount,
@@ -2181,6 +2203,14 @@ namespace {
         Threads[threadID].idle = true;
       }
 
+      // In lazy SMP mode, a helper thread searches the root position on its
+      // own until the main thread tells it to stop:
+      if(Threads[threadID].lazyWorkIsWaiting) {
+        lazy_id_loop(threadID);
+        Threads[threadID].lazyWorkIsWaiting = false;
+        Threads[threadID].idle = true;
+      }
+
       // If this thread is the master of a split point and all threads have
       // finished their work at this split point, return from the idle loop:
       if(waitSp != NULL && waitSp->cpus == 0)
@@ -2191,6 +2221,67 @@ namespace {
   }
 
 
+  // lazy_id_loop() is the iterative deepening loop of a helper thread in lazy
+  // SMP mode.  There is no root move list and no output:  The helper just
+  // calls search_pv() on the root position with an infinite window, and
+  // everything it finds ends up in the shared transposition table.  Helpers
+  // with an odd threadID search one ply deeper than the main thread, so that
+  // the threads don't all search the same tree.  A helper which falls behind
+  // the main thread skips ahead to the main thread's current iteration.
+
+  void lazy_id_loop(int threadID) {
+    assert(threadID > 0 && threadID < ActiveThreads);
+
+    Position p(RootPosition);
+    SearchStack ss[PLY_MAX_PLUS_2];
+    int iteration = 1 + (threadID & 1);
+
+    init_search_stack(ss);
+
+    while(!AbortSearch && !thread_should_stop(threadID)) {
+      iteration = Max(iteration + 1, Iteration + (threadID & 1));
+      if(iteration >= PLY_MAX)
+        break;
+      search_pv(p, ss, -VALUE_INFINITE, VALUE_INFINITE,
+                (iteration-1)*OnePly + InitialDepth, 0, threadID);
+    }
+  }
+
+
+  // start_helper_threads() is called by the main thread at the beginning of a
+  // lazy SMP search.  It makes all helper threads leave the idle loop and
+  // start their own iterative deepening loops from the root position.
+
+  void start_helper_threads(const Position &pos) {
+    RootPosition.copy(pos);
+
+    lock_grab(&MPLock);
+    for(int i = 1; i < ActiveThreads; i++) {
+      // A stale split point from an earlier search would make
+      // thread_should_stop() return true:
+      Threads[i].splitPoint = NULL;
+      Threads[i].stop = false;
+      Threads[i].idle = false;
+      Threads[i].lazyWorkIsWaiting = true;
+    }
+    lock_release(&MPLock);
+  }
+
+
+  // stop_helper_threads() is called by the main thread when it has finished
+  // a lazy SMP search.  It asks the helper threads to stop, and waits until
+  // all of them are back in the idle loop.
+
+  void stop_helper_threads() {
+    int i;
+
+    for(i = 1; i < ActiveThreads; i++)
+      Threads[i].stop = true;
+    for(i = 1; i < ActiveThreads; i++)
+      while(!Threads[i].idle);
+  }
+
+
   // init_split_point_stack() is called during program initialization, and
   // initializes all split point objects.
 
@@ -35,7 +35,7 @@
 //// Constants and variables
 ////
 
-const int THREAD_MAX = 8;
+const int THREAD_MAX = 16;
 
 
 ////
@@ -70,6 +70,7 @@ struct Thread {
   volatile bool running;
   volatile bool idle;
   volatile bool workIsWaiting;
+  volatile bool lazyWorkIsWaiting;
   volatile bool printCurrentLine;
   unsigned char pad[64];
 };
@@ -111,9 +111,11 @@ namespace {
     { "Maximum Razoring Depth", "3", "3", SPIN, 0, 4, {""} },
     { "Razoring Margin", "300", "300", SPIN, 150, 600, {""} },
     { "Randomness", "0", "0", SPIN, 0, 10, {""} },
+    { "SMP Mode", "Split Point", "Split Point", COMBO, 0, 0,
+      { "Split Point", "Lazy SMP" } },
     { "Minimum Split Depth", "4", "4", SPIN, 4, 7, {""} },
-    { "Maximum Number of Threads per Split Point", "5", "5", SPIN, 4, 8, {""} },
-    { "Threads", "1", "1", SPIN, 1, 8, {""} },
+    { "Maximum Number of Threads per Split Point", "5", "5", SPIN, 4, 16, {""} },
+    { "Threads", "1", "1", SPIN, 1, 16, {""} },
     { "Hash", "32", "32", SPIN, 4, 4096, {""} },
     { "Clear Hash", "false", "false", BUTTON, 0, 0, {""} },
     { "Ponder", "true", "true", CHECK, 0, 0, {""} },
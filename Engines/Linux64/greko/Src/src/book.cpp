@@ -3,12 +3,21 @@
 //  http://greko.110mb.com
 
 //  book.cpp: opening book
-//  modified: 01-Mar-2013
+//  modified: 19-Oct-2026
 
+#include <chrono>
+#include <thread>
 #include "book.h"
 #include "notation.h"
 #include "utils.h"
 
+static const char BOOK_MAGIC[8] = { 'G', 'R', 'E', 'K', 'O', 'B', 'K', '1' };
+
+static int MillisecondsSince(const std::chrono::steady_clock::time_point& t0)
+{
+	return int(std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - t0).count());
+}
+
 struct MoveAndValue
 {
 	MoveAndValue(Move mv, int value) : m_mv(mv), m_value(value) {}
@@ -28,7 +37,8 @@ Move Book::GetMove(const Position& pos, std::string& comment)
 	comment.clear();
 
 	// check to avoid lines like 1. e4 e5 2. Nf3 a6 3. Bb5 Nc6?
-	if (m_data.find(pos.Hash()) == m_data.end()) return 0;
+	int count = 0;
+	if (!Find(pos.Hash(), count)) return 0;
 
 	m_pos = pos;
 	std::vector<MoveAndValue> x;
@@ -42,11 +52,10 @@ Move Book::GetMove(const Position& pos, std::string& comment)
 		Move mv = mvlist[i].m_mv;
 		if (m_pos.MakeMove(mv))
 		{
-			std::map<U64, int>::const_iterator it = m_data.find(m_pos.Hash());
-			if (it != m_data.end() && it->second > 0)
+			if (Find(m_pos.Hash(), count) && count > 0)
 			{
-				x.push_back(MoveAndValue(mv, it->second));
-				sumVal += it->second;
+				x.push_back(MoveAndValue(mv, count));
+				sumVal += count;
 			}
 			m_pos.UnmakeMove();
 		}
@@ -76,6 +85,71 @@ Move Book::GetMove(const Position& pos, std::string& comment)
 	return 0;
 }
 
+//
+//   PGN import is split into chunks of lines, each starting a new game
+//   (first token "1."), which are replayed by parallel threads into
+//   their own maps and merged at the end.
+//
+
+struct ImportJob
+{
+	const std::vector<std::string>* m_lines;
+	size_t m_begin;
+	size_t m_end;
+	int    m_maxPly;
+	bool   m_addColor[2];
+	int    m_games;
+	std::map<U64, int> m_data;
+};
+
+static bool IsGameStart(const std::string& line)
+{
+	TokenString s(line);
+	std::string token = s.GetToken();
+	return token == "1." || token == "1";
+}
+
+static void ImportLines(ImportJob* job)
+{
+	Position startpos;
+	startpos.SetInitial();
+	Position pos = startpos;
+
+	for (size_t i = job->m_begin; i < job->m_end; ++i)
+	{
+		const std::string& line = (*job->m_lines)[i];
+		if (line.length() < 2)
+			continue;
+		if (line[0] == '[')
+			continue;
+
+		TokenString s(line);
+		for (std::string token = s.GetToken(); token.length() > 0; token = s.GetToken())
+		{
+			if (token == "1." || token == "1")
+			{
+				pos = startpos;
+				++job->m_games;
+				continue;
+			}
+
+			if (pos.Ply() >= job->m_maxPly)
+				continue;
+
+			Move mv = StrToMove(token, pos);
+			if (mv)
+			{
+				pos.MakeMove(mv);
+
+				if (job->m_addColor[pos.Side() ^ 1])
+					++job->m_data[pos.Hash()];
+				else
+					job->m_data[pos.Hash()] += 0;
+			}
+		}
+	}
+}
+
 bool Book::Import(const std::string& strPath, const std::string& strMaxPly, const std::string& strColor)
 {
 	FILE* src = fopen(strPath.c_str(), "rt");
@@ -85,6 +159,9 @@ bool Book::Import(const std::string& strPath, const std::string& strMaxPly, cons
 		return false;
 	}
 
+	Materialize();
+	std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+
 	int maxPly = strMaxPly.empty() ? 20 : atoi(strMaxPly.c_str());
 	out("maxPly = %d\n", maxPly);
 
@@ -103,49 +180,59 @@ bool Book::Import(const std::string& strPath, const std::string& strMaxPly, cons
 		}
 	}
 
-	Position startpos;
-	startpos.SetInitial();
-
-	int nGames = 0;
+	std::vector<std::string> lines;
 	char buf[4096];
 	while (fgets(buf, sizeof(buf), src))
+		lines.push_back(buf);
+	fclose(src);
+
+	int nThreads = int(std::thread::hardware_concurrency());
+	if (nThreads < 1)
+		nThreads = 1;
+
+	std::vector<ImportJob> jobs;
+	size_t begin = 0;
+	for (int i = 1; i <= nThreads; ++i)
 	{
-		if (strlen(buf) < 2)
-			continue;
-		if (buf[0] == '[')
+		size_t end = lines.size() * i / nThreads;
+		while (end < lines.size() && !IsGameStart(lines[end]))
+			++end;
+		if (end <= begin && i < nThreads)
 			continue;
 
-		TokenString s(buf);
-		for (std::string token = s.GetToken(); token.length() > 0; token = s.GetToken())
-		{
-			if (token == "1." || token == "1")
-			{
-				m_pos = startpos;
-				++nGames;
-				printf("Games: %d, nodes: %d\r", nGames, m_data.size());
-				continue;
-			}
+		ImportJob job;
+		job.m_lines = &lines;
+		job.m_begin = begin;
+		job.m_end = end;
+		job.m_maxPly = maxPly;
+		job.m_addColor[WHITE] = addColor[WHITE];
+		job.m_addColor[BLACK] = addColor[BLACK];
+		job.m_games = 0;
+		jobs.push_back(job);
 
-			if (m_pos.Ply() >= maxPly)
-				continue;
+		begin = end;
+	}
 
-			Move mv = StrToMove(token, m_pos);
-			if (mv)
-			{
-				m_pos.MakeMove(mv);
+	std::vector<std::thread> threads;
+	for (size_t i = 0; i < jobs.size(); ++i)
+		threads.push_back(std::thread(ImportLines, &jobs[i]));
+	for (size_t i = 0; i < threads.size(); ++i)
+		threads[i].join();
 
-				if (addColor[m_pos.Side() ^ 1])
-					++m_data[m_pos.Hash()];
-				else
-					m_data[m_pos.Hash()] += 0;
-			}
-		}
+	int nGames = 0;
+	for (size_t i = 0; i < jobs.size(); ++i)
+	{
+		nGames += jobs[i].m_games;
+		for (std::map<U64, int>::const_iterator it = jobs[i].m_data.begin(); it != jobs[i].m_data.end(); ++it)
+			m_data[it->first] += it->second;
 	}
 
+	Position startpos;
+	startpos.SetInitial();
 	m_data.insert(std::pair<U64, int>(startpos.Hash(), 1));
 
-	printf("Games: %d, nodes: %d\n", nGames, m_data.size());
-	fclose(src);
+	out("Games: %d, nodes: %d", nGames, int(m_data.size()));
+	out(", threads: %d, %d ms\n", int(jobs.size()), MillisecondsSince(t0));
 	return true;
 }
 
@@ -153,7 +240,10 @@ void Book::Init()
 {
 	Clean();
 
-	if (Load("book.bin"))
+	// a compiled book is optional, only "book map" complains when it is missing
+	if (Map("book.cbk", false))
+		;
+	else if (Load("book.bin"))
 		;
 	else
 	{
@@ -182,6 +272,8 @@ bool Book::Load(const std::string& path)
 	FILE* srcBin = fopen(path.c_str(), "rb");
 	if (srcBin)
 	{
+		Materialize();
+
 		U64 hash;
 		int be;
 
@@ -217,6 +309,7 @@ void Book::ProcessLine(const std::string& str)
 
 bool Book::Save(const std::string& path)
 {
+	Materialize();
 	FILE* dest = fopen(path.c_str(), "wb");
 	if (dest)
 	{
@@ -237,3 +330,134 @@ bool Book::Save(const std::string& path)
 
 	return false;
 }
+
+bool Book::Compile(const std::string& path)
+{
+	//
+	//   Write to a temporary file first: other processes may have
+	//   the old book mapped, and truncating it under them would crash them
+	//
+
+	Materialize();
+	std::string tmpPath = path + ".tmp";
+	FILE* dest = fopen(tmpPath.c_str(), "wb");
+	if (!dest)
+	{
+		out("can't open %s\n", tmpPath);
+		return false;
+	}
+
+	out("writing %s...\n", path);
+
+	BookHeader header;
+	memcpy(header.m_magic, BOOK_MAGIC, sizeof(header.m_magic));
+	header.m_size = U32(m_data.size());
+	header.m_reserved = 0;
+	bool ok = (fwrite(&header, sizeof(header), 1, dest) == 1);
+
+	// std::map iterates in key order, so entries come out sorted
+	for (std::map<U64, int>::const_iterator it = m_data.begin(); ok && it != m_data.end(); ++it)
+	{
+		BookEntry e;
+		e.m_hash = it->first;
+		e.m_count = it->second;
+		e.m_reserved = 0;
+		ok = (fwrite(&e, sizeof(e), 1, dest) == 1);
+	}
+
+	if (fclose(dest) != 0)
+		ok = false;
+
+	if (!ok)
+	{
+		remove(tmpPath.c_str());
+		out("can't write %s\n", path);
+		return false;
+	}
+
+	if (!RenameFile(tmpPath, path))
+	{
+		// the old book is left as it was, the new one is not lost
+		out("can't replace %s, ", path);
+		out("the new book is in %s\n", tmpPath);
+		return false;
+	}
+	return true;
+}
+
+bool Book::Find(U64 hash, int& count) const
+{
+	if (m_entries)
+	{
+		BookEntry key;
+		key.m_hash = hash;
+		const BookEntry* end = m_entries + m_header->m_size;
+		const BookEntry* e = std::lower_bound(m_entries, end, key);
+		if (e == end || e->m_hash != hash)
+			return false;
+		count = e->m_count;
+		return true;
+	}
+
+	std::map<U64, int>::const_iterator it = m_data.find(hash);
+	if (it == m_data.end())
+		return false;
+	count = it->second;
+	return true;
+}
+
+bool Book::Map(const std::string& path, bool reportMissing)
+{
+	size_t size = 0;
+	const void* p = MapFile(path, size);
+	if (!p)
+	{
+		if (reportMissing)
+			out("can't open %s\n", path);
+		return false;
+	}
+
+	const BookHeader* header = static_cast<const BookHeader*>(p);
+	if (size < sizeof(BookHeader) ||
+		memcmp(header->m_magic, BOOK_MAGIC, sizeof(BOOK_MAGIC)) != 0 ||
+		size != sizeof(BookHeader) + header->m_size * sizeof(BookEntry))
+	{
+		UnmapFile(p, size);
+		out("%s: not a compiled book\n", path);
+		return false;
+	}
+
+	Unmap();
+	m_data.clear();
+
+	m_header = header;
+	m_entries = reinterpret_cast<const BookEntry*>(header + 1);
+	m_mappedSize = size;
+
+	out("%s: %d nodes (mapped)\n", path.c_str(), int(m_header->m_size));
+	return true;
+}
+
+void Book::Materialize()
+{
+	//
+	//   Copy a mapped book into m_data, before it gets modified
+	//
+
+	if (!m_entries)
+		return;
+
+	for (U32 i = 0; i < m_header->m_size; ++i)
+		m_data[m_entries[i].m_hash] += m_entries[i].m_count;
+	Unmap();
+}
+
+void Book::Unmap()
+{
+	if (m_header)
+		UnmapFile(m_header, m_mappedSize);
+
+	m_header = NULL;
+	m_entries = NULL;
+	m_mappedSize = 0;
+}
@@ -3,7 +3,7 @@
 //  http://greko.110mb.com
 
 //  book.h: opening book
-//  modified: 01-Mar-2013
+//  modified: 19-Oct-2026
 
 #ifndef BOOK_H
 #define BOOK_H
@@ -12,27 +12,62 @@
 #include <vector>
 #include "moves.h"
 
+//
+//   Compiled book file: header followed by entries sorted by hash.
+//   Mapped read-only into memory, so it needs no parsing at startup
+//   and its pages are shared by all GreKo processes using it.
+//
+
+struct BookHeader
+{
+	char m_magic[8];  // "GREKOBK1"
+	U32  m_size;      // number of entries
+	U32  m_reserved;
+};
+
+struct BookEntry
+{
+	U64 m_hash;
+	I32 m_count;
+	I32 m_reserved;
+
+	bool operator< (const BookEntry& e) const { return m_hash < e.m_hash; }
+};
+
 class Book
 {
 public:
+	Book() : m_header(NULL), m_entries(NULL), m_mappedSize(0) {}
+	~Book() { Unmap(); }
+
 	void Clean()
 	{
+		Unmap();
 		m_data.clear();
 		m_pos.SetInitial();
 		++m_data[m_pos.Hash()];
 	}
 
+	bool Compile(const std::string& path);
 	Move GetMove(const Position& pos, std::string& comment);
 	bool Import(const std::string& strPath, const std::string& strMaxPly, const std::string& strColor);
 	void Init();
 	bool Load(const std::string& path);
+	bool Map(const std::string& path, bool reportMissing = true);
 	bool Save(const std::string& path);
 
 private:
+	bool Find(U64 hash, int& count) const;
+	void Materialize();
 	void ProcessLine(const std::string& str);
+	void Unmap();
 
 	std::map<U64, int> m_data;
 	Position m_pos;
+
+	const BookHeader* m_header;
+	const BookEntry*  m_entries;
+	size_t            m_mappedSize;
 };
 
 #endif
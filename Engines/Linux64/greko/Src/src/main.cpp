@@ -3,7 +3,7 @@
 //  http://greko.110mb.com
 
 //  main.cpp: initialize and start engine, command line interface
-//  modified: 30-June-2013
+//  modified: 19-Oct-2026
 
 #include "book.h"
 #include "config.h"
@@ -68,6 +68,16 @@ private:
 			std::string path = GetToken();
 			g_book.Save(path);
 		}
+		else if (arg == "compile")
+		{
+			std::string path = GetToken();
+			g_book.Compile(path.empty() ? "book.cbk" : path);
+		}
+		else if (arg == "map")
+		{
+			std::string path = GetToken();
+			g_book.Map(path.empty() ? "book.cbk" : path);
+		}
 	}
 
 	void OnEpdtest()
@@ -3,12 +3,15 @@
 //  http://greko.110mb.com
 
 //  unix.cpp: Unix-specific code
-//  modified: 01-Mar-2013
+//  modified: 19-Oct-2026
 
 #ifndef _MSC_VER
 
 #include <stdio.h>
+#include <fcntl.h>
 #include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <sys/time.h>
 #include <sys/types.h>
 #include <signal.h>
@@ -16,7 +19,7 @@
 
 static int g_isPipe = 0;
 
-void SleepMilliseconds(int ms) {.usleep(1000 * ms); }
+void SleepMilliseconds(int ms) { usleep(1000 * ms); }
 
 void Highlight(bool on)
 {
@@ -71,4 +74,37 @@ int InputAvailable()
 
 	return 0;
 }
+
+const void* MapFile(const std::string& path, size_t& size)
+{
+	int fd = open(path.c_str(), O_RDONLY);
+	if (fd < 0)
+		return NULL;
+
+	struct stat st;
+	if (fstat(fd, &st) < 0 || st.st_size == 0)
+	{
+		close(fd);
+		return NULL;
+	}
+
+	void* p = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (p == MAP_FAILED)
+		return NULL;
+
+	size = st.st_size;
+	return p;
+}
+
+void UnmapFile(const void* p, size_t size)
+{
+	munmap(const_cast<void*>(p), size);
+}
+
+bool RenameFile(const std::string& from, const std::string& to)
+{
+	// atomic, processes that have the old file mapped keep seeing it
+	return rename(from.c_str(), to.c_str()) == 0;
+}
 #endif
@@ -3,7 +3,7 @@
 //  http://greko.110mb.com
 
 //  utils.h: some utilities
-//  modified: 01-Mar-2013
+//  modified: 19-Oct-2026
 
 #ifndef UTILS_H
 #define UTILS_H
@@ -22,6 +22,10 @@ U64   Rand64();
 void  Highlight(bool on);
 void  SleepMilliseconds(int ms);
 
+const void* MapFile(const std::string& path, size_t& size);
+void        UnmapFile(const void* p, size_t size);
+bool        RenameFile(const std::string& from, const std::string& to);
+
 inline void out(const char* s)
 {
 	printf(s);
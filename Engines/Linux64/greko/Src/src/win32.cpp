@@ -3,7 +3,7 @@
 //  http://greko.110mb.com
 
 //  win32.cpp: Windows-specific code
-//  modified: 01-Mar-2013
+//  modified: 19-Oct-2026
 
 #include <windows.h>
 #include <conio.h>
@@ -44,3 +44,67 @@ int InputAvailable()
 	else
 		return _kbhit() != 0;
 }
+
+const void* MapFile(const std::string& path, size_t& size)
+{
+	// FILE_SHARE_DELETE lets RenameFile move the file aside while it is mapped
+	HANDLE hFile = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (hFile == INVALID_HANDLE_VALUE)
+		return NULL;
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(hFile, &fileSize) || fileSize.QuadPart == 0)
+	{
+		CloseHandle(hFile);
+		return NULL;
+	}
+
+	HANDLE hMapping = CreateFileMappingA(hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+	CloseHandle(hFile);
+	if (!hMapping)
+		return NULL;
+
+	// the view keeps the mapping alive after its handle is closed
+	const void* p = MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0);
+	CloseHandle(hMapping);
+	if (!p)
+		return NULL;
+
+	size = size_t(fileSize.QuadPart);
+	return p;
+}
+
+void UnmapFile(const void* p, size_t)
+{
+	UnmapViewOfFile(p);
+}
+
+bool RenameFile(const std::string& from, const std::string& to)
+{
+	//
+	//   A file mapped by another process can't be replaced, but it can be
+	//   renamed aside and deleted: it goes away when the last view is closed
+	//
+
+	if (MoveFileExA(from.c_str(), to.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH))
+		return true;
+
+	DWORD err = GetLastError();
+	if (err != ERROR_ACCESS_DENIED && err != ERROR_SHARING_VIOLATION)
+		return false;
+
+	char suffix[32];
+	sprintf(suffix, ".%lu.old", (unsigned long) GetTickCount());
+	std::string old = to + suffix;
+	if (!MoveFileExA(to.c_str(), old.c_str(), 0))
+		return false;
+
+	if (!MoveFileExA(from.c_str(), to.c_str(), MOVEFILE_WRITE_THROUGH))
+	{
+		MoveFileExA(old.c_str(), to.c_str(), 0);
+		return false;
+	}
+
+	DeleteFileA(old.c_str());
+	return true;
+}
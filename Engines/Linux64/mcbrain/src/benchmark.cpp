@@ -18,9 +18,13 @@
   along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include <algorithm>
 #include <fstream>
+#include <iomanip>
 #include <iostream>
 #include <istream>
+#include <sstream>
+#include <thread>
 #include <vector>
 
 #include "misc.h"
@@ -86,17 +90,16 @@ const vector<string> Defaults = {
   "7k/7P/6K1/8/3B4/8/8/8 b - -"
 };
 
-} // namespace
+struct BenchResult {
+  uint64_t nodes;
+  TimePoint elapsed;
+};
 
-/// benchmark() runs a simple benchmark by letting Stockfish analyze a set
-/// of positions for a given limit each. There are five parameters: the
-/// transposition table size, the number of search threads that should
-/// be used, the limit value spent for each position (optional, default is
-/// depth 13), an optional file name where to look for positions in FEN
-/// format (defaults are the positions defined above) and the type of the
-/// limit value: depth (default), time in millisecs or number of nodes.
 
-void benchmark(const Position& current, istream& is) {
+/// run() does the work of benchmark(), reading the same parameters, and fills
+/// 'r' with the totals. Returns false if the positions could not be read.
+
+bool run(const Position& current, istream& is, BenchResult& r) {
 
   string token;
   vector<string> fens;
@@ -139,7 +142,7 @@ void benchmark(const Position& current, istream& is) {
       if (!file.is_open())
       {
           cerr << "Unable to open file " << fenFile << endl;
-          return;
+          return false;
       }
 
       while (getline(file, fen))
@@ -149,8 +152,8 @@ void benchmark(const Position& current, istream& is) {
       file.close();
   }
 
-  uint64_t nodes = 0;
-  TimePoint elapsed = now();
+  r.nodes = 0;
+  r.elapsed = now();
   Position pos;
 
   for (size_t i = 0; i < fens.size(); ++i)
@@ -161,23 +164,93 @@ void benchmark(const Position& current, istream& is) {
       cerr << "\nPosition: " << i + 1 << '/' << fens.size() << endl;
 
       if (limitType == "perft")
-          nodes += Search::perft(pos, limits.depth * ONE_PLY);
+          r.nodes += Search::perft(pos, limits.depth * ONE_PLY);
 
       else
       {
           limits.startTime = now();
           Threads.start_thinking(pos, states, limits);
           Threads.main()->wait_for_search_finished();
-          nodes += Threads.nodes_searched();
+          r.nodes += Threads.nodes_searched();
       }
   }
 
-  elapsed = now() - elapsed + 1; // Ensure positivity to avoid a 'divide by zero'
+  r.elapsed = now() - r.elapsed + 1; // Ensure positivity to avoid a 'divide by zero'
+
+  return true;
+}
+
+} // namespace
+
+/// benchmark() runs a simple benchmark by letting Stockfish analyze a set
+/// of positions for a given limit each. There are five parameters: the
+/// transposition table size, the number of search threads that should
+/// be used, the limit value spent for each position (optional, default is
+/// depth 13), an optional file name where to look for positions in FEN
+/// format (defaults are the positions defined above) and the type of the
+/// limit value: depth (default), time in millisecs or number of nodes.
+
+void benchmark(const Position& current, istream& is) {
+
+  BenchResult r;
+
+  if (!run(current, is, r))
+      return;
 
   dbg_print(); // Just before exiting
 
   cerr << "\n==========================="
-       << "\nTotal time (ms) : " << elapsed
-       << "\nNodes searched  : " << nodes
-       << "\nNodes/second    : " << 1000 * nodes / elapsed << endl;
+       << "\nTotal time (ms) : " << r.elapsed
+       << "\nNodes searched  : " << r.nodes
+       << "\nNodes/second    : " << 1000 * r.nodes / r.elapsed << endl;
+}
+
+
+/// thread_benchmark() shows how the search scales with the number of threads.
+/// The bench positions are searched to a fixed depth with 1, 2, 4... threads
+/// up to 'maxThreads' (default: the number of logical processors), and total
+/// time, NPS and their ratio to the single threaded run are printed. Further
+/// parameters are the hash size in MB (default 128) and the depth (default
+/// 13). On multi-socket machines run it with "Bind Threads" off and on.
+
+void thread_benchmark(const Position& current, istream& is) {
+
+  string token;
+  int maxThreads = (is >> token) ? stoi(token) : max(int(thread::hardware_concurrency()), 1);
+  string ttSize  = (is >> token) ? token : "128";
+  string depth   = (is >> token) ? token : "13";
+
+  vector<pair<int, BenchResult>> results;
+
+  for (int threads = 1; ; threads = min(2 * threads, maxThreads))
+  {
+      stringstream ss(ttSize + " " + to_string(threads) + " " + depth);
+      BenchResult r;
+
+      if (!run(current, ss, r))
+          return;
+
+      results.emplace_back(threads, r);
+
+      if (threads >= maxThreads)
+          break;
+  }
+
+  const BenchResult& base = results[0].second;
+
+  cerr << "\n==========================="
+       << "\nBind Threads: " << (Options["Bind Threads"] ? "on" : "off")
+       << "\nThreads   Time (ms)     Nodes/second   Time speedup   NPS speedup" << endl;
+
+  for (const auto& t : results)
+  {
+      const BenchResult& r = t.second;
+
+      cerr << setw(7)  << t.first
+           << setw(12) << r.elapsed
+           << setw(17) << 1000 * r.nodes / r.elapsed
+           << setw(15) << fixed << setprecision(2) << double(base.elapsed) / r.elapsed
+           << setw(14) << double(r.nodes) / r.elapsed / (double(base.nodes) / base.elapsed)
+           << endl;
+  }
 }
@@ -213,12 +213,21 @@ void prefetch2(void* addr) {
 
 namespace WinProcGroup {
 
-#ifndef _WIN32
+#if defined(__linux__) && !defined(__ANDROID__)
 
-void bindThisThread(size_t) {}
+// The Linux binding is Stockfish's numa.cpp, see our numa.cpp
+
+#elif !defined(_WIN32)
+
+bool configure(bool, int) { return true; }
+int generation() { return 0; }
+bool bindThisThread(size_t) { return false; }
 
 #else
 
+bool configure(bool, int) { return true; }
+int generation() { return 0; }
+
 /// get_group() retrieves logical processor information using Windows specific
 /// API and returns the best group id for the thread with index idx. Original
 /// code from Texel by Peter Österlund.
@@ -289,9 +298,10 @@ int get_group(size_t idx) {
 }
 
 
-/// bindThisThread() set the group affinity of the current thread
+/// bindThisThread() set the group affinity of the current thread. The tables
+/// of the thread are not allocated again, it returns false.
 
-void bindThisThread(size_t idx) {
+bool bindThisThread(size_t idx) {
 
   // If OS already scheduled us on a different group than 0 then don't overwrite
   // the choice, eventually we are one of many one-threaded processes running on
@@ -299,13 +309,13 @@ void bindThisThread(size_t idx) {
   // just check if running threads are below a threshold, in this case all this
   // NUMA machinery is not needed.
   if (Threads.size() < 8)
-      return;
+      return false;
 
   // Use only local variables to be thread-safe
   int group = get_group(idx);
 
   if (group == -1)
-      return;
+      return false;
 
   // Early exit if the needed API are not available at runtime
   HMODULE k32 = GetModuleHandle("Kernel32.dll");
@@ -313,11 +323,13 @@ void bindThisThread(size_t idx) {
   auto fun3 = (fun3_t)GetProcAddress(k32, "SetThreadGroupAffinity");
 
   if (!fun2 || !fun3)
-      return;
+      return false;
 
   GROUP_AFFINITY affinity;
   if (fun2(group, &affinity))
       fun3(GetCurrentThread(), &affinity, nullptr);
+
+  return false;
 }
 
 #endif
@@ -103,10 +103,14 @@ public:
 /// logical processor group. This usually means to be limited to use max 64
 /// cores. To overcome this, some special platform specific API should be
 /// called to set group affinity for each thread. Original code from Texel by
-/// Peter Österlund.
+/// Peter Österlund. On Linux, when enabled by the "Bind Threads" option, each
+/// search thread is instead pinned to a logical processor read from the /sys
+/// topology, see Stockfish's numa.cpp.
 
 namespace WinProcGroup {
-  void bindThisThread(size_t idx);
+  bool configure(bool enable, int node);
+  int generation();
+  bool bindThisThread(size_t idx);
 }
 
 #endif // #ifndef MISC_H_INCLUDED
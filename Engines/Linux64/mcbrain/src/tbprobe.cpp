@@ -350,6 +350,10 @@ public:
             std::cerr << "Could not mmap() " << fname << std::endl;
             exit(1);
         }
+#ifdef MADV_RANDOM
+        // Probes hit scattered blocks, read-ahead only wastes page cache
+        madvise(*baseAddress, statbuf.st_size, MADV_RANDOM);
+#endif
 #else
         HANDLE fd = CreateFile(fname.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
                                OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
@@ -39,6 +39,7 @@ Thread::Thread() {
   nodes = tbHits = 0;
   idx = Threads.size(); // Start from 0
   meanH = 0;	
+  bindGeneration = -1;
 
   std::unique_lock<Mutex> lk(mutex);
   searching = true;
@@ -95,7 +96,7 @@ void Thread::start_searching(bool resume) {
 
 void Thread::idle_loop() {
 
-  WinProcGroup::bindThisThread(idx);
+  bind();
 
   while (!exit)
   {
@@ -112,7 +113,28 @@ void Thread::idle_loop() {
       lk.unlock();
 
       if (!exit)
+      {
+          if (bindGeneration != WinProcGroup::generation())
+              bind();
+
           search();
+      }
+  }
+}
+
+
+/// Thread::bind() applies the current thread binding policy. Once pinned to
+/// another NUMA node the thread allocates its pawn and material tables again,
+/// so that their pages are first touched, and placed, in its local memory.
+
+void Thread::bind() {
+
+  bindGeneration = WinProcGroup::generation();
+
+  if (WinProcGroup::bindThisThread(idx))
+  {
+      pawnsTable = Pawns::Table();
+      materialTable = Material::Table();
   }
 }
 
@@ -52,6 +52,7 @@ public:
   virtual ~Thread();
   virtual void search();
   void idle_loop();
+  void bind();
   void start_searching(bool resume = false);
   void wait_for_search_finished();
   void wait(std::atomic_bool& condition);
@@ -60,7 +61,7 @@ public:
   Material::Table materialTable;
   Endgames endgames;
   size_t idx, PVIdx;
-  int maxPly, meanH;
+  int maxPly, meanH, bindGeneration;
   std::atomic<uint64_t> nodes, tbHits;
 
   Position rootPos;
@@ -36,6 +36,7 @@
 using namespace std;
 
 extern void benchmark(const Position& pos, istream& is);
+extern void thread_benchmark(const Position& pos, istream& is);
 
 namespace {
 
@@ -234,6 +235,7 @@ void UCI::loop(int argc, char* argv[]) {
       // Additional custom non-UCI commands, useful for debugging
       else if (token == "flip")       pos.flip();
       else if (token == "bench")      benchmark(pos, is);
+      else if (token == "threadbench") thread_benchmark(pos, is);
 	else if (token == "b")          benchmark(pos, is);
       else if (token == "d")          sync_cout << pos << sync_endl;
       else if (token == "eval")       sync_cout << Eval::trace(pos) << sync_endl;
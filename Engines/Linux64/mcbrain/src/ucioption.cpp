@@ -20,6 +20,7 @@
 
 #include <algorithm>
 #include <cassert>
+#include <iostream>
 #include <ostream>
 
 #include "misc.h"
@@ -41,6 +42,10 @@ void on_clear_hash(const Option&) { Search::clear(); }
 void on_hash_size(const Option& o) { TT.resize(o); }
 void on_logger(const Option& o) { start_logger(o); }
 void on_threads(const Option&) { Threads.read_uci_options(); }
+void on_binding(const Option&) {
+  if (!WinProcGroup::configure(Options["Bind Threads"], Options["NUMA Node"]))
+      sync_cout << "info string No processor found on NUMA node " << int(Options["NUMA Node"]) << sync_endl;
+}
 void on_tb_path(const Option& o) { Tablebases::init(o); }
 void on_brainbook_path(const Option& o) { tzbook.init(o); }
 void on_book_move2_prob(const Option& o) { tzbook.set_book_move2_probability(o); }
@@ -63,6 +68,8 @@ void init(OptionsMap& o) {
 	o["Hash"]                  << Option(16, 1, MaxHashMB, on_hash_size);
 	o["Ponder"]                << Option(false);
 	o["Threads"]               << Option(1, 1, 512, on_threads);
+	o["Bind Threads"]          << Option(false, on_binding);
+	o["NUMA Node"]             << Option(-1, -1, 63, on_binding);
 	
 	o["Clear Hash"]            << Option(on_clear_hash);
 	o["Clean Search"]          << Option(false);
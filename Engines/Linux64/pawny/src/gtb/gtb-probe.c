@@ -1,7 +1,7 @@
 /*
 This Software is distributed with the following X11 License,
 sometimes also known as MIT license.
- 
+
 Copyright (c) 2010 Miguel A. Ballicora
 
  Permission is hereby granted, free of charge, to any person
@@ -54,7 +54,7 @@ Copyright (c) 2010 Miguel A. Ballicora
 #else
 	#define mySHARED static
 	typedef unsigned char			SQ_CONTENT;
-	typedef unsigned int 			SQUARE; 
+	typedef unsigned int 			SQUARE;
 #endif
 
 #include "sysport.h"
@@ -115,11 +115,11 @@ typedef size_t 				index_t;
 /*typedef int 				index_t;*/
 #endif
 
-enum Loading_status {	
-				STATUS_ABSENT 		= 0, 
-				STATUS_STATICRAM 	= 1, 
+enum Loading_status {
+				STATUS_ABSENT 		= 0,
+				STATUS_STATICRAM 	= 1,
 				STATUS_MALLOC 		= 2,
-				STATUS_FILE   		= 3, 
+				STATUS_FILE   		= 3,
 				STATUS_REJECT 		= 4
 };
 
@@ -134,7 +134,7 @@ struct endgamekey {
 	dtm_t *		egt_b;
 	FILE *		fd;
 	int 		status;
-	int			pathn; 
+	int			pathn;
 };
 #endif
 
@@ -147,21 +147,21 @@ mySHARED int		bettarr [2] [8] [8];
 
 /*------------ ENUMS ----------------------------------------------------------*/
 
-enum Mask_values {	
-					RESMASK  = tb_RESMASK, 
-					INFOMASK = tb_INFOMASK, 
-					PLYSHIFT = tb_PLYSHIFT  
+enum Mask_values {
+					RESMASK  = tb_RESMASK,
+					INFOMASK = tb_INFOMASK,
+					PLYSHIFT = tb_PLYSHIFT
 };
 
-enum Info_values {	
-					iDRAW    = tb_DRAW, 
-					iWMATE   = tb_WMATE, 
-					iBMATE   = tb_BMATE, 
+enum Info_values {
+					iDRAW    = tb_DRAW,
+					iWMATE   = tb_WMATE,
+					iBMATE   = tb_BMATE,
 					iFORBID  = tb_FORBID,
-		 
-					iDRAWt   = tb_DRAW  |4, 
-					iWMATEt  = tb_WMATE |4, 
-					iBMATEt  = tb_BMATE |4, 
+
+					iDRAWt   = tb_DRAW  |4,
+					iWMATEt  = tb_WMATE |4,
+					iBMATEt  = tb_BMATE |4,
 					iUNKNOWN = tb_UNKNOWN,
 
 					iUNKNBIT = (1<<2)
@@ -206,7 +206,7 @@ enum SQUARES {
 };
 
 /*------------------- end of inherited from a previous maindef.h -----------*/
- 
+
 #if !defined(NDEBUG)
 #define NDEBUG
 #endif
@@ -222,7 +222,7 @@ enum SQUARES {
 
 /*************************************************\
 |
-|				COMPRESSION SCHEMES 
+|				COMPRESSION SCHEMES
 |
 \*************************************************/
 
@@ -243,7 +243,7 @@ static const char *const Extension[] = {
 
 /*************************************************\
 |
-|					MOVES 
+|					MOVES
 |
 \*************************************************/
 
@@ -255,7 +255,7 @@ enum move_kind {
 };
 
 enum move_content {
-		NOMOVE = 0	
+		NOMOVE = 0
 };
 
 #define MV_TYPE(mv)   ( (BYTE)       ((mv) >>6 & 3 )      )
@@ -283,7 +283,7 @@ enum move_content {
 
 /*************************************************\
 |
-|				STATIC VARIABLES 
+|				STATIC VARIABLES
 |
 \*************************************************/
 
@@ -291,18 +291,17 @@ static int GTB_scheme = 4;
 
 /*************************************************\
 |
-|	needed for 
-|	PRE LOAD CACHE AND DEPENDENT FUNCTIONS 
+|	needed for
+|	PRE LOAD CACHE AND DEPENDENT FUNCTIONS
 |
 \*************************************************/
 
 #define EGTB_MAXBLOCKSIZE 65536
+#define GTB_ENTRIES_PER_BLOCK (16 * 1024) /* fixed, needed for the compression schemes */
 
 static int GTB_MAXOPEN = 4;
 
 static bool_t 			Uncompressed = TRUE;
-static unsigned char 	Buffer_zipped [EGTB_MAXBLOCKSIZE];
-static unsigned char 	Buffer_packed [EGTB_MAXBLOCKSIZE];
 static unsigned int		zipinfo_init (void);
 static void 			zipinfo_done (void);
 
@@ -324,14 +323,33 @@ static bool_t			DTM_CACHE_INITIALIZED = FALSE;
 
 static int				WDL_FRACTION = 64;
 static int				WDL_FRACTION_MAX = 128;
-	
+
 static size_t			DTM_cache_size = 0;
 static size_t			WDL_cache_size = 0;
 
 static unsigned int		TB_AVAILABILITY = 0;
 
 /* LOCKS */
-static mythread_mutex_t	Egtb_lock;
+static mythread_mutex_t	Egtb_lock; /* file handles, drive counters */
+
+struct general_counters {
+	/* counters */
+	uint64_t		hits;
+	uint64_t		miss;
+	uint64_t		waits;
+};
+
+static struct general_counters Drive = {0,0,0};
+
+static void
+counted_lock (mythread_mutex_t *m, uint64_t *waits)
+/* lock and count the times another thread was holding it */
+{
+	if (!mythread_mutex_trylock (m)) {
+		mythread_mutex_lock (m);
+		(*waits)++;
+	}
+}
 
 
 /****************************************************************************\
@@ -356,7 +374,7 @@ static void 	print_pos (const sq_t *ws, const sq_t *bs, const pc_t *wp, const pc
 #endif
 
 #if defined(DEBUG) || defined(FOLLOW_EGTB)
-static void 	output_state (unsigned stm, const SQUARE *wSQ, const SQUARE *bSQ, 
+static void 	output_state (unsigned stm, const SQUARE *wSQ, const SQUARE *bSQ,
 								const SQ_CONTENT *wPC, const SQ_CONTENT *bPC);
 static const char *Square_str[64] = {
  	"a1","b1","c1","d1","e1","f1","g1","h1",
@@ -380,9 +398,9 @@ static const char *P_str[] = {
 #endif
 
 #if defined(FOLLOW_EGTB)
-static const char *Info_str[8] = {	
-	" Draw", " Wmate", " Bmate", "Illegal", 
-	"~Draw", "~Wmate", "~Bmate", "Unknown" 
+static const char *Info_str[8] = {
+	" Draw", " Wmate", " Bmate", "Illegal",
+	"~Draw", "~Wmate", "~Bmate", "Unknown"
 };
 #endif
 
@@ -450,7 +468,7 @@ static index_t 			ppp48_idx[48][48][48];
 static sq_t				wksq [MAX_KKINDEX];
 static sq_t				bksq [MAX_KKINDEX];
 static sq_t				pp48_sq_x[MAX_PP48_INDEX];
-static sq_t				pp48_sq_y[MAX_PP48_INDEX]; 
+static sq_t				pp48_sq_y[MAX_PP48_INDEX];
 
 static index_t		 	pp_hi24 [MAX_PPINDEX]; /* was unsigned int */
 static index_t		 	pp_lo48 [MAX_PPINDEX];
@@ -459,8 +477,8 @@ static index_t		 	aaidx [64] [64]; /* was unsigned int */
 static unsigned char 	aabase [MAX_AAINDEX];
 
 static uint8_t			ppp48_sq_x[MAX_PPP48_INDEX];
-static uint8_t			ppp48_sq_y[MAX_PPP48_INDEX]; 
-static uint8_t			ppp48_sq_z[MAX_PPP48_INDEX]; 
+static uint8_t			ppp48_sq_y[MAX_PPP48_INDEX];
+static uint8_t			ppp48_sq_z[MAX_PPP48_INDEX];
 
 /* FUNCTIONS */
 
@@ -587,12 +605,12 @@ static index_t	init_pp48_idx (void);
 static index_t	init_ppp48_idx (void);
 
 enum TB_INDEXES
-	 {	 MAX_KXK 	= MAX_KKINDEX*64 
-		,MAX_kabk 	= MAX_KKINDEX*64*64 
+	 {	 MAX_KXK 	= MAX_KKINDEX*64
+		,MAX_kabk 	= MAX_KKINDEX*64*64
 		,MAX_kakb 	= MAX_KKINDEX*64*64
 		,MAX_kpk	= 24*64*64
 		,MAX_kakp	= 24*64*64*64
-		,MAX_kapk	= 24*64*64*64		
+		,MAX_kapk	= 24*64*64*64
 		,MAX_kppk	= MAX_PPINDEX*64*64
 		,MAX_kpkp	= MAX_PpINDEX*64*64
 		,MAX_kaak	= MAX_KKINDEX*MAX_AAINDEX
@@ -611,11 +629,11 @@ enum TB_INDEXES
 		,MAX_kaapk  = 24*MAX_AAINDEX*64*64
 		,MAX_kaakp  = 24*MAX_AAINDEX*64*64
 		,MAX_kppkp  = 24*MAX_PP48_INDEX*64*64
-		,MAX_kpppk  = MAX_PPP48_INDEX*64*64	
+		,MAX_kpppk  = MAX_PPP48_INDEX*64*64
 };
 
 #if defined(SHARED_forbuilding)
-extern index_t 
+extern index_t
 biggest_memory_needed (void) {
     return MAX_kabkc;
 }
@@ -633,7 +651,11 @@ biggest_memory_needed (void) {
 mySHARED bool_t		get_dtm (tbkey_t key, unsigned side, index_t idx, dtm_t *out, bool_t probe_hard);
 #endif
 
-static bool_t	 	get_dtm_from_cache (tbkey_t key, unsigned side, index_t idx, dtm_t *out);
+struct cache_table;
+struct WDL_CACHE;
+static bool_t	 	get_dtm_from_cache (struct cache_table *c, tbkey_t key, unsigned side, index_t idx, dtm_t *out);
+static void			cache_locks_init (void);
+static void			cache_locks_done (void);
 
 
 /*--------------------------------*\
@@ -661,11 +683,11 @@ mySHARED struct endgamekey egkey[] = {
 {2, "kbk",  MAX_KXK,  1, kxk_indextopc,  kxk_pctoindex,  NULL ,  NULL   ,NULL ,0, 0 },
 {3, "knk",  MAX_KXK,  1, kxk_indextopc,  kxk_pctoindex,  NULL ,  NULL   ,NULL ,0, 0 },
 {4, "kpk",  MAX_kpk,  24,kpk_indextopc,  kpk_pctoindex,  NULL ,  NULL   ,NULL ,0, 0 },
-	/* 4 pieces */	
-{5, "kqkq", MAX_kakb, 1, kakb_indextopc, kakb_pctoindex, NULL ,  NULL   ,NULL ,0, 0 },	
-{6, "kqkr", MAX_kakb, 1, kakb_indextopc, kakb_pctoindex, NULL ,  NULL   ,NULL ,0, 0 },	
+	/* 4 pieces */
+{5, "kqkq", MAX_kakb, 1, kakb_indextopc, kakb_pctoindex, NULL ,  NULL   ,NULL ,0, 0 },
+{6, "kqkr", MAX_kakb, 1, kakb_indextopc, kakb_pctoindex, NULL ,  NULL   ,NULL ,0, 0 },
 {7, "kqkb", MAX_kakb, 1, kakb_indextopc, kakb_pctoindex, NULL ,  NULL   ,NULL ,0, 0 },
-{8, "kqkn", MAX_kakb, 1, kakb_indextopc, kakb_pctoindex, NULL ,  NULL   ,NULL ,0, 0 },	
+{8, "kqkn", MAX_kakb, 1, kakb_indextopc, kakb_pctoindex, NULL ,  NULL   ,NULL ,0, 0 },
 
 {9, "krkr", MAX_kakb, 1, kakb_indextopc, kakb_pctoindex, NULL ,  NULL   ,NULL ,0, 0 },
 {10,"krkb", MAX_kakb, 1, kakb_indextopc, kakb_pctoindex, NULL ,  NULL   ,NULL ,0, 0 },
@@ -675,21 +697,21 @@ mySHARED struct endgamekey egkey[] = {
 {13,"kbkn", MAX_kakb, 1, kakb_indextopc, kakb_pctoindex, NULL ,  NULL   ,NULL ,0, 0 },
 
 {14,"knkn", MAX_kakb, 1, kakb_indextopc, kakb_pctoindex, NULL ,  NULL   ,NULL ,0, 0 },
-	/**/		
-{15,"kqqk", MAX_kaak, 1, kaak_indextopc, kaak_pctoindex, NULL ,  NULL   ,NULL ,0, 0 },	
-{16,"kqrk", MAX_kabk, 1, kabk_indextopc, kabk_pctoindex, NULL ,  NULL   ,NULL ,0, 0 },	
+	/**/
+{15,"kqqk", MAX_kaak, 1, kaak_indextopc, kaak_pctoindex, NULL ,  NULL   ,NULL ,0, 0 },
+{16,"kqrk", MAX_kabk, 1, kabk_indextopc, kabk_pctoindex, NULL ,  NULL   ,NULL ,0, 0 },
 {17,"kqbk", MAX_kabk, 1, kabk_indextopc, kabk_pctoindex, NULL ,  NULL   ,NULL ,0, 0 },
-{18,"kqnk", MAX_kabk, 1, kabk_indextopc, kabk_pctoindex, NULL ,  NULL   ,NULL ,0, 0 },	
+{18,"kqnk", MAX_kabk, 1, kabk_indextopc, kabk_pctoindex, NULL ,  NULL   ,NULL ,0, 0 },
 
-{19,"krrk", MAX_kaak, 1, kaak_indextopc, kaak_pctoindex, NULL ,  NULL   ,NULL ,0, 0 },	
+{19,"krrk", MAX_kaak, 1, kaak_indextopc, kaak_pctoindex, NULL ,  NULL   ,NULL ,0, 0 },
 {20,"krbk", MAX_kabk, 1, kabk_indextopc, kabk_pctoindex, NULL ,  NULL   ,NULL ,0, 0 },
 {21,"krnk", MAX_kabk, 1, kabk_indextopc, kabk_pctoindex, NULL ,  NULL   ,NULL ,0, 0 },
 
-{22,"kbbk", MAX_kaak, 1, kaak_indextopc, kaak_pctoindex, NULL ,  NULL   ,NULL ,0, 0 },	
+{22,"kbbk", MAX_kaak, 1, kaak_indextopc, kaak_pctoindex, NULL ,  NULL   ,NULL ,0, 0 },
 {23,"kbnk", MAX_kabk, 1, kabk_indextopc, kabk_pctoindex, NULL ,  NULL   ,NULL ,0, 0 },
 
-{24,"knnk", MAX_kaak, 1, kaak_indextopc, kaak_pctoindex, NULL ,  NULL   ,NULL ,0, 0 },	
-	/**/	
+{24,"knnk", MAX_kaak, 1, kaak_indextopc, kaak_pctoindex, NULL ,  NULL   ,NULL ,0, 0 },
+	/**/
 	/**/
 {25,"kqkp", MAX_kakp, 24,kakp_indextopc, kakp_pctoindex, NULL ,  NULL   ,NULL ,0, 0 },
 {26,"krkp", MAX_kakp, 24,kakp_indextopc, kakp_pctoindex, NULL ,  NULL   ,NULL ,0, 0 },
@@ -700,7 +722,7 @@ mySHARED struct endgamekey egkey[] = {
 {30,"krpk", MAX_kapk, 24,kapk_indextopc, kapk_pctoindex, NULL ,  NULL   ,NULL ,0, 0 },
 {31,"kbpk", MAX_kapk, 24,kapk_indextopc, kapk_pctoindex, NULL ,  NULL   ,NULL ,0, 0 },
 {32,"knpk", MAX_kapk, 24,kapk_indextopc, kapk_pctoindex, NULL ,  NULL   ,NULL ,0, 0 },
-	/**/	
+	/**/
 {33,"kppk", MAX_kppk, MAX_PPINDEX ,kppk_indextopc, kppk_pctoindex, NULL ,  NULL   ,NULL ,0, 0 },
 	/**/
 {34,"kpkp", MAX_kpkp, MAX_PpINDEX ,kpkp_indextopc, kpkp_pctoindex, NULL ,  NULL   ,NULL ,0, 0 },
@@ -829,6 +851,48 @@ mySHARED struct endgamekey egkey[] = {
 
 };
 
+#define EGKEY_HASH_SIZE 512
+static tbkey_t egkey_hash[EGKEY_HASH_SIZE];
+
+static size_t
+str_hash_func_1 (const char * str)
+{
+	size_t h = 5381;
+	int c;
+	while ((c = *str++))
+		h = h * 31 + c;
+	return h;
+}
+
+static size_t
+str_hash_func_2 (const char * str)
+{
+	size_t h = 0;
+	int c;
+	while ((c = *str++))
+		h = h * 65599 + c;
+	return 2 * h + 1;
+}
+
+static void
+init_egkey_hash (void)
+{
+	size_t h1, h2;
+	int i;
+
+	for (i = 0; i < EGKEY_HASH_SIZE; i++)
+		egkey_hash[i] = -1;
+
+	for (i = 0; i < MAX_EGKEYS; i++) {
+		h1 = str_hash_func_1 (egkey[i].str) & (EGKEY_HASH_SIZE - 1);
+		h2 = str_hash_func_2 (egkey[i].str);
+		while (egkey_hash[h1] >= 0)
+			h1 = (h1 + h2) & (EGKEY_HASH_SIZE - 1);
+		egkey_hash[h1] = egkey[i].id;
+	}
+}
+
+
 static int eg_was_open[MAX_EGKEYS];
 
 static uint64_t Bytes_read = 0;
@@ -880,7 +944,7 @@ tbpaths_add_single(const char **ps, const char *newpath)
 	for (i = 0; i < psize; i++) ppath[i] = newpath[i];
 
 	for (counter = 0; ps[counter] != NULL; counter++)
-		; 
+		;
 
 	/* cast to deal with const poisoning */
 	newps =	(const char **) realloc ((char **)ps, sizeof(char *) * (counter+2));
@@ -906,11 +970,11 @@ tbpaths_add(const char **ps, const char *newpath)
 	if (NULL == mpath) {
 		return ps; /* failed to incorporate a new path */
 	}
-	for (i = 0; i < psize; i++) mpath[i] = newpath[i];	
+	for (i = 0; i < psize; i++) mpath[i] = newpath[i];
 
 	for (i = 0; i < psize; i++) {
 		if(';' == mpath[i])
-			mpath[i] = '\0';	
+			mpath[i] = '\0';
 	}
 
 	for (i = 0;;) {
@@ -929,14 +993,14 @@ extern const char **
 tbpaths_done(const char **ps)
 {
 	int counter;
-	void *q;	
+	void *q;
 
 	if (ps != NULL) {
 		for (counter = 0; ps[counter] != NULL; counter++) {
 			/* cast to deal with const poisoning */
 			void *p = (void *) ps[counter];
-			free(p);		
-		} 	
+			free(p);
+		}
 		/* cast to deal with const poisoning */
 		q = (void *) ps;
 		free(q);
@@ -972,7 +1036,7 @@ path_system_init (const char **path)
 	Gtbpath = (const char **) malloc (sz * sizeof(char *));
 
 	if (Gtbpath) {
-		
+
 		ok = TRUE;
 		/* point to the same strings provided */
 		Gtbpath_end_index = 0;
@@ -994,7 +1058,7 @@ path_system_done (void)
 	/* before we free Gtbpath, we have to deal with the
 	"const poisoning" and cast it. free() does not accept
 	const pointers */
-	char **	p = (char **) Gtbpath;	
+	char **	p = (char **) Gtbpath;
 	/* clean up */
 	if (p != NULL)
 		free(p);
@@ -1018,8 +1082,8 @@ static void 		wdl_cache_flush (void);
 static void			wdl_cache_reset_counters (void);
 static void			wdl_cache_done (void);
 
-static bool_t		get_WDL_from_cache (tbkey_t key, unsigned side, index_t idx, unsigned int *out);
-static bool_t		wdl_preload_cache (tbkey_t key, unsigned side, index_t idx);
+static bool_t		get_WDL_from_cache (struct WDL_CACHE *w, tbkey_t key, unsigned side, index_t idx, unsigned int *out);
+static bool_t		wdl_preload_cache (struct WDL_CACHE *w, tbkey_t key, unsigned side, index_t idx);
 #endif
 
 #ifdef GTB_SHARE
@@ -1058,6 +1122,8 @@ tb_init (int verbosity, int decoding_sch, const char **paths)
 
 	assert(!TB_INITIALIZED);
 
+	init_egkey_hash ();
+
 	if (verbosity) {
 		ini_str[0] = '\0';
 		ret_str = ini_str;
@@ -1067,7 +1133,7 @@ tb_init (int verbosity, int decoding_sch, const char **paths)
 
 	paths_ok = path_system_init (paths);
 
-	if (paths_ok && verbosity) { 
+	if (paths_ok && verbosity) {
 		int g;
 		assert(Gtbpath!=NULL);
 		sjoin(ini_str,"\nGTB PATHS\n",INISIZE);
@@ -1082,7 +1148,7 @@ tb_init (int verbosity, int decoding_sch, const char **paths)
 		}
 	}
 
-	if (!paths_ok && verbosity) { 
+	if (!paths_ok && verbosity) {
 		sjoin (ini_str,"\nGTB PATHS not initialized\n",INISIZE);
 	}
 
@@ -1091,7 +1157,7 @@ tb_init (int verbosity, int decoding_sch, const char **paths)
 
 	attack_maps_init (); /* external initialization */
 
-	init_indexing(0 /* no verbosity */);	
+	init_indexing(0 /* no verbosity */);
 
 	#ifdef GTB_SHARE
 	init_bettarr();
@@ -1101,7 +1167,7 @@ tb_init (int verbosity, int decoding_sch, const char **paths)
 		sjoin (ini_str,"  File Open Memory initialization = **FAILED**\n",INISIZE);
 		return ret_str;
 	}
-	
+
 	GTB_scheme = decoding_sch;
 	Uncompressed = GTB_scheme == 0;
 
@@ -1128,12 +1194,12 @@ tb_init (int verbosity, int decoding_sch, const char **paths)
 			int n, bit;
 
 			n = 3; bit = 1;
-			if (zi&(1u<<bit)) 
+			if (zi&(1u<<bit))
 				sprintf (localstr,"  Compression Indexes (%d-pc) = PASSED\n",n);
 			else
 				sprintf (localstr,"  Compression Indexes (%d-pc) = **FAILED**\n",n);
 			sjoin (ini_str,localstr,INISIZE);
-			
+
 			n = 4; bit = 3;
 			if (zi&(1u<<bit))
 				sprintf (localstr,"  Compression Indexes (%d-pc) = PASSED\n",n);
@@ -1155,6 +1221,7 @@ tb_init (int verbosity, int decoding_sch, const char **paths)
 	Bytes_read = 0;
 
 	mythread_mutex_init (&Egtb_lock);
+	cache_locks_init();
 
 	TB_INITIALIZED = TRUE;
 
@@ -1182,6 +1249,7 @@ tb_done (void)
 	zipinfo_done();
 	path_system_done();
 	mythread_mutex_destroy (&Egtb_lock);
+	cache_locks_done();
 	TB_INITIALIZED = FALSE;
 
 	/*
@@ -1218,24 +1286,24 @@ static void
 init_bettarr (void)
 {
 /*
-		iDRAW  = 0, iWMATE  = 1, iBMATE  = 2, iFORBID  = 3, 
+		iDRAW  = 0, iWMATE  = 1, iBMATE  = 2, iFORBID  = 3,
 		iDRAWt = 4, iWMATEt = 5, iBMATEt = 6, iUNKNOWN = 7
  */
 
 	int temp[] = {
-	/*White*/	
+	/*White*/
 	/*iDRAW   vs*/
 		1, 2, 1, 1,     2, 2, 2, 2,
-	/*iWMATE  vs*/	
+	/*iWMATE  vs*/
 		1, 3, 1, 1,     1, 1, 1, 1,
 	/*iBMATE  vs*/
 		2, 2, 4, 1,     2, 2, 2, 2,
 	/*iFORBID vs*/
 		2, 2, 2, 2,     2, 2, 2, 2,
-	
+
 	/*iDRAWt  vs*/
 		1, 2, 1, 1,     2, 2, 1, 2,
-	/*iWMATEt vs*/	
+	/*iWMATEt vs*/
 		1, 2, 1, 1,     1, 3, 1, 1,
 	/*iBMATEt vs*/
 		1, 2, 1, 1,     2, 2, 4, 2,
@@ -1245,16 +1313,16 @@ init_bettarr (void)
 	/*Black*/
 	/*iDRAW   vs*/
 		1, 1, 2, 1,     2, 2, 2, 2,
-	/*iWMATE  vs*/	
+	/*iWMATE  vs*/
 		2, 4, 2, 1,     2, 2, 2, 2,
 	/*iBMATE  vs*/
 		1, 1, 3, 1,     1, 1, 1, 1,
 	/*iFORBID vs*/
 		2, 2, 2, 2,     2, 2, 2, 2,
-	
+
 	/*iDRAWt  vs*/
 		1, 1, 2, 1,     2, 1, 2, 2,
-	/*iWMATEt vs*/	
+	/*iWMATEt vs*/
 		1, 1, 2, 1,     2, 4, 2, 2,
 	/*iBMATEt vs*/
 		1, 1, 2, 1,     1, 1, 3, 1,
@@ -1263,12 +1331,12 @@ init_bettarr (void)
 	};
 
 	int i, j, k, z;
-	
+
 	/* reset */
 	z = 0;
 	for (i = 0; i < 2; i++)
-		for (j = 0; j < 8; j++) 
-			for (k = 0; k < 8; k++)	
+		for (j = 0; j < 8; j++)
+			for (k = 0; k < 8; k++)
 				bettarr [i][j][k] = temp[z++];
 
 	return;
@@ -1293,13 +1361,13 @@ fd_init (struct filesopen *pfd)
 	if (allowed < 4)
 		GTB_MAXOPEN = 4;
 	if (allowed > 32)
-		GTB_MAXOPEN = 32;		
+		GTB_MAXOPEN = 32;
 
 	p =	(tbkey_t *) malloc(sizeof(tbkey_t)*(size_t)GTB_MAXOPEN);
 
 	if (p != NULL) {
 		for (i = 0; i < GTB_MAXOPEN; i++) {
-			p[i] = -1;	
+			p[i] = -1;
 		}
 		pfd->key = p;
 		return TRUE;
@@ -1322,7 +1390,7 @@ fd_done (struct filesopen *pfd)
 		finp = egkey [closingkey].fd;
 		fclose (finp);
 		egkey[closingkey].fd = NULL;
-		pfd->key[i] = -1;	
+		pfd->key[i] = -1;
 	}
 	pfd->n = 0;
 	free(pfd->key);
@@ -1368,75 +1436,75 @@ static bool_t 			egtb_filepeek (tbkey_t key, unsigned side, index_t idx, dtm_t *
 #ifdef WDL_PROBE
 static bool_t
 tb_probe_wdl
-			(unsigned stm, 
-			 const SQUARE *inp_wSQ, 
+			(unsigned stm,
+			 const SQUARE *inp_wSQ,
 			 const SQUARE *inp_bSQ,
-			 const SQ_CONTENT *inp_wPC, 
+			 const SQ_CONTENT *inp_wPC,
 			 const SQ_CONTENT *inp_bPC,
 			 bool_t probingtype,
 			 /*@out@*/ unsigned *res);
 #endif
 
 static bool_t
-tb_probe_	(unsigned stm, 
+tb_probe_	(unsigned stm,
 			 SQUARE epsq,
-			 const SQUARE *inp_wSQ, 
+			 const SQUARE *inp_wSQ,
 			 const SQUARE *inp_bSQ,
-			 const SQ_CONTENT *inp_wPC, 
+			 const SQ_CONTENT *inp_wPC,
 			 const SQ_CONTENT *inp_bPC,
 			 bool_t probingtype,
-			 /*@out@*/ unsigned *res, 
+			 /*@out@*/ unsigned *res,
 			 /*@out@*/ unsigned *ply);
 
 
 extern bool_t
 tb_probe_soft
-			(unsigned stm, 
+			(unsigned stm,
 			 SQUARE epsq,
 			 unsigned castles,
-			 const SQUARE *inp_wSQ, 
+			 const SQUARE *inp_wSQ,
 			 const SQUARE *inp_bSQ,
-			 const SQ_CONTENT *inp_wPC, 
+			 const SQ_CONTENT *inp_wPC,
 			 const SQ_CONTENT *inp_bPC,
-			 /*@out@*/ unsigned *res, 
+			 /*@out@*/ unsigned *res,
 			 /*@out@*/ unsigned *ply)
 {
-	if (castles != 0) 
+	if (castles != 0)
 		return FALSE;
 	return tb_probe_ (stm, epsq, inp_wSQ, inp_bSQ, inp_wPC, inp_bPC, FALSE, res, ply);
-} 
+}
 
 extern bool_t
 tb_probe_hard
-			(unsigned stm, 
+			(unsigned stm,
 			 SQUARE epsq,
 			 unsigned castles,
-			 const SQUARE *inp_wSQ, 
+			 const SQUARE *inp_wSQ,
 			 const SQUARE *inp_bSQ,
-			 const SQ_CONTENT *inp_wPC, 
+			 const SQ_CONTENT *inp_wPC,
 			 const SQ_CONTENT *inp_bPC,
-			 /*@out@*/ unsigned *res, 
+			 /*@out@*/ unsigned *res,
 			 /*@out@*/ unsigned *ply)
 {
-	if (castles != 0) 
+	if (castles != 0)
 		return FALSE;
 	return tb_probe_ (stm, epsq, inp_wSQ, inp_bSQ, inp_wPC, inp_bPC, TRUE, res, ply);
-} 
+}
 
 extern bool_t
 tb_probe_WDL_soft
-			(unsigned stm, 
+			(unsigned stm,
 			 SQUARE epsq,
 			 unsigned castles,
-			 const SQUARE *inp_wSQ, 
+			 const SQUARE *inp_wSQ,
 			 const SQUARE *inp_bSQ,
-			 const SQ_CONTENT *inp_wPC, 
+			 const SQ_CONTENT *inp_wPC,
 			 const SQ_CONTENT *inp_bPC,
 			 /*@out@*/ unsigned *res)
 {
 	unsigned ply_n;
 	unsigned *ply = &ply_n;
-	if (castles != 0) 
+	if (castles != 0)
 		return FALSE;
 	if (epsq != NOSQUARE)
 		return tb_probe_ (stm, epsq, inp_wSQ, inp_bSQ, inp_wPC, inp_bPC, FALSE, res, ply);
@@ -1446,23 +1514,23 @@ tb_probe_WDL_soft
 	return tb_probe_wdl    (stm, inp_wSQ, inp_bSQ, inp_wPC, inp_bPC, FALSE, res);
 	#else
 	return tb_probe_ (stm, epsq, inp_wSQ, inp_bSQ, inp_wPC, inp_bPC, FALSE, res, ply);
-	#endif	
-} 
+	#endif
+}
 
 extern bool_t
 tb_probe_WDL_hard
-			(unsigned stm, 
+			(unsigned stm,
 			 SQUARE epsq,
 			 unsigned castles,
-			 const SQUARE *inp_wSQ, 
+			 const SQUARE *inp_wSQ,
 			 const SQUARE *inp_bSQ,
-			 const SQ_CONTENT *inp_wPC, 
+			 const SQ_CONTENT *inp_wPC,
 			 const SQ_CONTENT *inp_bPC,
 			 /*@out@*/ unsigned *res)
 {
 	unsigned ply_n;
 	unsigned *ply = &ply_n;
-	if (castles != 0) 
+	if (castles != 0)
 		return FALSE;
 	if (epsq != NOSQUARE)
 		return tb_probe_ (stm, epsq, inp_wSQ, inp_bSQ, inp_wPC, inp_bPC, TRUE, res, ply);
@@ -1472,24 +1540,24 @@ tb_probe_WDL_hard
 	return tb_probe_wdl    (stm, inp_wSQ, inp_bSQ, inp_wPC, inp_bPC, TRUE, res);
 	#else
 	return tb_probe_ (stm, epsq, inp_wSQ, inp_bSQ, inp_wPC, inp_bPC, TRUE, res, ply);
-	#endif	
-} 
+	#endif
+}
 
 
 static bool_t
-tb_probe_	(unsigned stm, 
+tb_probe_	(unsigned stm,
 			 SQUARE epsq,
-			 const SQUARE *inp_wSQ, 
+			 const SQUARE *inp_wSQ,
 			 const SQUARE *inp_bSQ,
-			 const SQ_CONTENT *inp_wPC, 
+			 const SQ_CONTENT *inp_wPC,
 			 const SQ_CONTENT *inp_bPC,
 			 bool_t probingtype,
-			 /*@out@*/ unsigned *res, 
+			 /*@out@*/ unsigned *res,
 			 /*@out@*/ unsigned *ply)
 {
 	int i = 0, j = 0;
 	tbkey_t id = -1;
-	dtm_t dtm;
+	dtm_t dtm = 0;
 
 	SQUARE 		storage_ws [MAX_LISTSIZE], storage_bs [MAX_LISTSIZE];
 	SQ_CONTENT  storage_wp [MAX_LISTSIZE], storage_bp [MAX_LISTSIZE];
@@ -1509,9 +1577,9 @@ tb_probe_	(unsigned stm,
 
 	SQUARE *temps;
 	bool_t straight = FALSE;
-	
+
 	SQUARE capturer_a, capturer_b, xed = NOSQUARE;
-	
+
 	unsigned int plies;
 	unsigned int inf;
 
@@ -1531,7 +1599,7 @@ tb_probe_	(unsigned stm,
 		*res = b? iDRAW: iFORBID;
 		*ply = 0;
 		return TRUE;
-	} 
+	}
 
 	/* copy input */
 	list_pc_copy (inp_wPC, wp);
@@ -1561,7 +1629,7 @@ tb_probe_	(unsigned stm,
 	} else {
 		#if defined(DEBUG)
 		printf("did not get id...\n");
-		output_state (stm, ws, bs, wp, bp);		
+		output_state (stm, ws, bs, wp, bp);
 		#endif
 		unpackdist (iFORBID, res, ply);
 		return FALSE;
@@ -1597,23 +1665,23 @@ tb_probe_	(unsigned stm,
 		capturer_b = NOSQUARE;
 
 		if (epsq != NOSQUARE) {
-			/* captured pawn, trick: from epsquare to captured */		
+			/* captured pawn, trick: from epsquare to captured */
 			xed = epsq ^ (1<<3);
 
 			/* find index captured (j) */
 			for (j = 0; ys[j] != NOSQUARE; j++) {
 				if (ys[j] == xed) break;
-			}	
+			}
 
 			/* try first possible ep capture */
-			if (0 == (0x88 & (map88(xed) + 1))) 
+			if (0 == (0x88 & (map88(xed) + 1)))
 				capturer_a = xed + 1;
 			/* try second possible ep capture */
-			if (0 == (0x88 & (map88(xed) - 1))) 
+			if (0 == (0x88 & (map88(xed) - 1)))
 				capturer_b = xed - 1;
 
 			if (ys[j] == xed) {
-	
+
 				/* find capturers (i) */
 				for (i = 0; xs[i] != NOSQUARE && okcall; i++) {
 
@@ -1623,41 +1691,41 @@ tb_probe_	(unsigned stm,
 						/* execute capture */
 						xs[i] = epsq;
 						removepiece (ys, yp, j);
-					
+
 						okcall = tb_probe_ (Opp(stm), NOSQUARE, ws, bs, wp, bp, probingtype, &inf, &plies);
-						
+
 						if (okcall) {
-							epscore = packdist (inf, plies); 					
+							epscore = packdist (inf, plies);
 							epscore = adjust_up (epscore);
 
 							/* chooses to ep or not */
 							dtm = bestx (stm, epscore, dtm);
 						}
-	
+
 						/* restore position */
 						list_pc_copy (tmp_wp, wp);
 						list_pc_copy (tmp_bp, bp);
 
 						list_sq_copy (tmp_ws, ws);
-						list_sq_copy (tmp_bs, bs);					
+						list_sq_copy (tmp_bs, bs);
 					}
 				}
-			} 
+			}
 		} /* ep */
 
 		if (straight) {
 			unpackdist (dtm, res, ply);
 		} else {
 			unpackdist (inv_dtm (dtm), res, ply);
-		}	 
-	} 
+		}
+	}
 
 	if (!okdtm || !okcall) {
 		unpackdist (iFORBID, res, ply);
 	}
-	
+
 	return okdtm && okcall;
-} 
+}
 
 #ifdef _MSC_VER
 /* to silence warning for sprintf usage */
@@ -1688,25 +1756,25 @@ egtb_filepeek (tbkey_t key, unsigned side, index_t idx, dtm_t *out_dtm)
 	assert (idx >= 0);
 	assert (key < MAX_EGKEYS);
 
-		
+
 	#if defined(USE_FD)
 		if (NULL == (finp = egkey[key].fd) ) {
 			if (NULL == (finp = fd_openit (key))) {
 				return FALSE;
-			}	
+			}
 		}
 	#else
 		sprintf (buf, "%s.gtb", egkey[key].str);
 		if (NULL == (finp = fopen (filename, "rb"))) {
 			return FALSE;
-		}	
+		}
 	#endif
 
 	ok = fpark_entry_packed (finp, side, maxindex, idx);
 	ok = ok && fread_entry_packed (finp, side, &x);
 
 	if (ok) {
-		*out_dtm = x;		
+		*out_dtm = x;
 	} else
 		*out_dtm = iFORBID;
 
@@ -1758,13 +1826,9 @@ egtb_get_dtm (tbkey_t k, unsigned stm, const SQUARE *wS, const SQUARE *bS, bool_
 		if (idxavail) {
 			bool_t success;
 
-			/* 
-			|		LOCK 
-			*-------------------------------*/
-			mythread_mutex_lock (&Egtb_lock);	
-
 			if (dtm_cache_is_on()) {
 
+				/* locks the cache shard and the files as needed */
 				success = get_dtm       (k, stm, idx, dtm, probe_hard_flag);
 
 				FOLLOW_LU("get_dtm (succ)",success)
@@ -1778,30 +1842,29 @@ egtb_get_dtm (tbkey_t k, unsigned stm, const SQUARE *wS, const SQUARE *bS, bool_
 
 						assert (decoding_scheme() == 0 && GTB_scheme == 0);
 
+						mythread_mutex_lock (&Egtb_lock);
 						success2 = egtb_filepeek (k, stm, idx, &dtm_temp);
+						mythread_mutex_unlock (&Egtb_lock);
 						ok =  (success == success2) && (!success || *dtm == dtm_temp);
 						if (!ok) {
 							printf ("\nERROR\nsuccess1=%d sucess2=%d\n"
-									"k=%d stm=%u idx=%d dtm_peek=%d dtm_cache=%d\n", 
+									"k=%d stm=%u idx=%d dtm_peek=%d dtm_cache=%d\n",
 									success, success2, k, stm, idx, dtm_temp, *dtm);
 							fatal_error();
 						}
 					}
 					#endif
 
-			} else {	
-				assert(Uncompressed);		
-				if (probe_hard_flag && Uncompressed)
+			} else {
+				assert(Uncompressed);
+				if (probe_hard_flag && Uncompressed) {
+					counted_lock (&Egtb_lock, &Drive.waits);
 					success = egtb_filepeek (k, stm, idx, dtm);
-				else
+					mythread_mutex_unlock (&Egtb_lock);
+				} else
 					success = FALSE;
 			}
 
-			mythread_mutex_unlock (&Egtb_lock);	
-			/*------------------------------*\ 
-			|		UNLOCK 
-			*/
-			
 
 			if (success) {
 				return TRUE;
@@ -1816,7 +1879,7 @@ egtb_get_dtm (tbkey_t k, unsigned stm, const SQUARE *wS, const SQUARE *bS, bool_
 			*dtm = iFORBID;
 			return 	TRUE;
 		}
-		
+
 	} else if (egkey[k].status == STATUS_REJECT) {
 
 		FOLLOW_label("STATUS_REJECT")
@@ -1830,9 +1893,9 @@ egtb_get_dtm (tbkey_t k, unsigned stm, const SQUARE *wS, const SQUARE *bS, bool_
 		assert(0);
 		*dtm = iFORBID;
 		return 	FALSE;
-	} 
+	}
 
-} 
+}
 
 static void
 removepiece (SQUARE *ys, SQ_CONTENT *yp, int j)
@@ -1844,21 +1907,21 @@ removepiece (SQUARE *ys, SQ_CONTENT *yp, int j)
 	}
 }
 
-/* 
+/*
 |
-|	mySHARED by probe and build 
+|	mySHARED by probe and build
 |
 \*----------------------------------------------------*/
 
 mySHARED /*@NULL@*/ FILE *
 fd_openit (tbkey_t key)
-{	
+{
 	int 			i;
 	tbkey_t			closingkey;
 	FILE *			finp = NULL;
 	char	 		buf[4096];
 	char *			filename = buf;
-	int 			start; 
+	int 			start;
 	int				end;
 	int				pth;
 	const char *	extension;
@@ -1878,10 +1941,10 @@ fd_openit (tbkey_t key)
 		finp = NULL;
 
 		for (i = 1; i < fd.n; i++) {
-			fd.key[i-1] = fd.key[i]; 		
+			fd.key[i-1] = fd.key[i];
 		}
 		fd.key[--fd.n] = -1;
-	} 
+	}
 
 	assert (fd.n < GTB_MAXOPEN);
 
@@ -1913,7 +1976,7 @@ printf ("path: %s\n",path);
 				sprintf (buf, "%s%s%s", path, egkey[key].str, extension);
 		} else {
 			if (isfoldersep( path[pl-1] )) {
-				sprintf (buf, "%s%s%s", path, egkey[key].str, extension);			
+				sprintf (buf, "%s%s%s", path, egkey[key].str, extension);
 			} else {
 				sprintf (buf, "%s%s%s%s", path, FOLDERSEP, egkey[key].str, extension);
 			}
@@ -1943,7 +2006,7 @@ printf ("path: %s\n",path);
 				sprintf (buf, "%s%s%s", path, egkey[key].str, extension);
 		} else {
 			if (isfoldersep( path[pl-1] )) {
-				sprintf (buf, "%s%s%s", path, egkey[key].str, extension);			
+				sprintf (buf, "%s%s%s", path, egkey[key].str, extension);
 			} else {
 				sprintf (buf, "%s%s%s%s", path, FOLDERSEP, egkey[key].str, extension);
 			}
@@ -1979,12 +2042,12 @@ sortlists (SQUARE *ws, SQ_CONTENT *wp)
 	SQ_CONTENT tp;
 	/* input is sorted */
 	for (i = 0; wp[i] != NOPIECE; i++) {
-		for (j = (i+1); wp[j] != NOPIECE; j++) {	
+		for (j = (i+1); wp[j] != NOPIECE; j++) {
 			if (wp[j] > wp[i]) {
-				tp = wp[i]; wp[i] = wp[j]; wp[j] = tp;		
+				tp = wp[i]; wp[i] = wp[j]; wp[j] = tp;
 				ts = ws[i]; ws[i] = ws[j]; ws[j] = ts;
-			}			
-		}	
+			}
+		}
 	}
 }
 
@@ -2010,7 +2073,7 @@ inv_dtm (dtm_t x)
 
 	if (x == iDRAW || x == iFORBID)
 		return x;
-	
+
 	mat = (unsigned)x & 3u;
 	if (mat == iWMATE)
 		mat = iBMATE;
@@ -2029,38 +2092,47 @@ egtb_get_id (SQ_CONTENT *w, SQ_CONTENT *b, tbkey_t *id)
 {
 
 	char pcstr[2*MAX_LISTSIZE];
-	SQ_CONTENT *s; 
+	SQ_CONTENT *s;
 	char *t;
 	bool_t found;
 	tbkey_t i;
 	static tbkey_t cache_i = 0;
-	
+	size_t h1, h2;
+
 	assert (PAWN == 1 && KNIGHT == 2 && BISHOP == 3 && ROOK == 4 && QUEEN == 5 && KING == 6);
 
-	t = pcstr; 
+	t = pcstr;
 
 	s = w;
 	while (NOPIECE != *s)
-		*t++ = pctoch[*s++]; 		
+		*t++ = pctoch[*s++];
 	s = b;
 	while (NOPIECE != *s)
-		*t++ = pctoch[*s++]; 		
+		*t++ = pctoch[*s++];
 
 	*t = '\0';
 
 	found = (0 == strcmp(pcstr, egkey[cache_i].str));
 	if (found) {
 		*id = cache_i;
-		return found;		
+		return found;
 	}
-	
-	for (i = 0, found = FALSE; !found && egkey[i].str != NULL; i++) {
+
+	h1 = str_hash_func_1 (pcstr) & (EGKEY_HASH_SIZE - 1);
+	h2 = str_hash_func_2 (pcstr);
+	while (1) {
+		i = egkey_hash[h1];
+		if (i < 0)
+			break;
 		found = (0 == strcmp(pcstr, egkey[i].str));
+		if (found)
+			break;
+		h1 = (h1 + h2) & (EGKEY_HASH_SIZE - 1);
 	}
 	if (found) {
-		cache_i = *id = i - 1;
+		cache_i = *id = i;
 	}
-	
+
 	return found;
 }
 
@@ -2091,14 +2163,14 @@ mySHARED dtm_t
 adjust_up (dtm_t dist)
 {
 	#if 0
-	static const dtm_t adding[] = {	
-		0, 1<<PLYSHIFT, 1<<PLYSHIFT, 0, 
+	static const dtm_t adding[] = {
+		0, 1<<PLYSHIFT, 1<<PLYSHIFT, 0,
 		0, 1<<PLYSHIFT, 1<<PLYSHIFT, 0
 	};
 	dist += adding [dist&INFOMASK];
 	return dist;
-	#else			
-	unsigned udist = (unsigned) dist;				
+	#else
+	unsigned udist = (unsigned) dist;
 	switch (udist & INFOMASK) {
 		case iWMATE:
 		case iWMATEt:
@@ -2106,10 +2178,10 @@ adjust_up (dtm_t dist)
 		case iBMATEt:
 			udist += (1u << PLYSHIFT);
 			break;
-		default:			
+		default:
 			break;
 	}
-	return (dtm_t) udist;	
+	return (dtm_t) udist;
 	#endif
 }
 
@@ -2117,7 +2189,7 @@ adjust_up (dtm_t dist)
 mySHARED dtm_t
 bestx (unsigned stm, dtm_t a, dtm_t b)
 {
-	unsigned int key;	
+	unsigned int key;
 	static const unsigned int
 	comparison [4] [4] = {
 	 			/*draw, wmate, bmate, forbid*/
@@ -2132,17 +2204,17 @@ bestx (unsigned stm, dtm_t a, dtm_t b)
 	/* 3 = selectsecond  */
 	};
 
-	static const unsigned int xorkey [2] = {0, 3};	
+	static const unsigned int xorkey [2] = {0, 3};
 	dtm_t retu[4];
 	dtm_t ret = iFORBID;
-	
+
 	assert (stm == WH || stm == BL);
 	assert ((a & iUNKNBIT) == 0 && (b & iUNKNBIT) == 0 );
-	
+
 	if (a == iFORBID)
 		return b;
 	if (b == iFORBID)
-		return a;	
+		return a;
 
 	retu[0] = a; /* first parameter */
 	retu[1] = a; /* the lowest by default */
@@ -2150,12 +2222,12 @@ bestx (unsigned stm, dtm_t a, dtm_t b)
 	retu[3]	= b; /* second parameter */
 	if (b < a) {
 		retu[1] = b;
-		retu[2] = a;		
+		retu[2] = a;
 	}
-	
+
 	key = comparison [a&3] [b&3] ^ xorkey[stm];
 	ret = retu [key];
-		
+
 	return ret;
 }
 
@@ -2164,6 +2236,7 @@ bestx (unsigned stm, dtm_t a, dtm_t b)
  |								PACKING ZONE
  *--------------------------------------------------------------------------*/
 
+inline
 mySHARED dtm_t
 dtm_unpack (unsigned stm, unsigned char packed)
 {
@@ -2174,17 +2247,17 @@ dtm_unpack (unsigned stm, unsigned char packed)
 	if (iDRAW == p || iFORBID == p) {
 		return (dtm_t) p;
 	}
-	
+
 	info  = (unsigned int) p & 3;
 	store = (unsigned int) p >> 2;
 
 	if (WH == stm) {
 		switch (info) {
-			case iWMATE:		
+			case iWMATE:
 						moves = store + 1;
 						plies = moves * 2 - 1;
 						prefx = info;
-						break;				
+						break;
 
 			case iBMATE:
 						moves = store;
@@ -2195,7 +2268,7 @@ dtm_unpack (unsigned stm, unsigned char packed)
 			case iDRAW:
 						moves = store + 1 + 63;
 						plies = moves * 2 - 1;
-						prefx = iWMATE;						
+						prefx = iWMATE;
 						break;
 
 			case iFORBID:
@@ -2204,7 +2277,7 @@ dtm_unpack (unsigned stm, unsigned char packed)
 						plies = moves * 2;
 						prefx = iBMATE;
 						break;
-			default:	
+			default:
             plies = 0;
             prefx = 0;
             assert(0);
@@ -2214,11 +2287,11 @@ dtm_unpack (unsigned stm, unsigned char packed)
 		ret = (dtm_t) (prefx | (plies << 3));
 	} else {
 		switch (info) {
-			case iBMATE:		
+			case iBMATE:
 						moves = store + 1;
 						plies = moves * 2 - 1;
 						prefx = info;
-						break;				
+						break;
 
 			case iWMATE:
 						moves = store;
@@ -2229,22 +2302,22 @@ dtm_unpack (unsigned stm, unsigned char packed)
 			case iDRAW:
 
 						if (store == 63) {
-						/* 	exception: no position in the 5-man 
-							TBs needs to store 63 for iBMATE 
-							it is then used to indicate iWMATE 
+						/* 	exception: no position in the 5-man
+							TBs needs to store 63 for iBMATE
+							it is then used to indicate iWMATE
 							when just overflows */
 							store++;
 
 							moves = store + 63;
 							plies = moves * 2;
-							prefx = iWMATE;	
+							prefx = iWMATE;
 
 							break;
 						}
-	
+
 						moves = store + 1 + 63;
 						plies = moves * 2 - 1;
-						prefx = iBMATE;						
+						prefx = iBMATE;
 						break;
 
 			case iFORBID:
@@ -2253,7 +2326,7 @@ dtm_unpack (unsigned stm, unsigned char packed)
 						plies = moves * 2;
 						prefx = iWMATE;
 						break;
-			default:	
+			default:
             plies = 0;
             prefx = 0;
             assert(0);
@@ -2262,7 +2335,7 @@ dtm_unpack (unsigned stm, unsigned char packed)
 		}
 		ret = (dtm_t) (prefx | (plies << 3));
 	}
-	return ret;	
+	return ret;
 }
 
 
@@ -2289,7 +2362,7 @@ fpark_entry_packed  (FILE *finp, unsigned side, index_t max, index_t idx)
 	bool_t ok;
 	index_t i;
 	long int fseek_i;
-	index_t sz = (index_t) sizeof(unsigned char);	
+	index_t sz = (index_t) sizeof(unsigned char);
 
 	assert (side == WH || side == BL);
 	assert (finp != NULL);
@@ -2301,12 +2374,31 @@ fpark_entry_packed  (FILE *finp, unsigned side, index_t max, index_t idx)
 	return ok;
 }
 
-/*----------------------------------------------------*\ 
+/*----------------------------------------------------*\
 |
-|	shared by probe and build 
+|	shared by probe and build
 |
 \*/
 
+static size_t
+hash_func_1 (tbkey_t key, unsigned side, index_t offset)
+{
+	size_t h = offset | (key << 1) | side;
+	h = ((h >> 16) ^ h) * 0x45d9f3b;
+	h = ((h >> 16) ^ h) * 0x45d9f3b;
+	h = ((h >> 16) ^ h);
+	return h;
+}
+
+static size_t
+hash_func_2 (tbkey_t key, unsigned side, index_t offset)
+{
+	size_t h = offset | (key << 1) | side;
+	h = ((h >> 16) ^ h) * 0x3335b369;
+	h = ((h >> 16) ^ h) * 0x3335b369;
+	h = ((h >> 16) ^ h);
+	return h * 2 + 1;
+}
 
 /*---------------------------------------------------------------------*\
 |			WDL CACHE Implementation  ZONE
@@ -2332,6 +2424,8 @@ struct wdl_block {
 };
 
 struct WDL_CACHE {
+	mythread_mutex_t lock;
+
 	/* defined at init */
 	bool_t			cached;
 	size_t			max_blocks;
@@ -2344,6 +2438,11 @@ struct WDL_CACHE {
 	size_t			n;
 	wdl_block_t *	blocks; /* was entry */
 
+	/* fast lookup in LRU list */
+	wdl_block_t**	hash_table;
+	size_t			ht_size;
+	size_t			ht_used;
+
 	/* counters */
 	uint64_t		hard;
 	uint64_t		soft;
@@ -2351,11 +2450,19 @@ struct WDL_CACHE {
 	uint64_t		hits;
 	uint64_t		softmisses;
 	uint64_t 		comparisons;
+	uint64_t		waits;
 };
 
-struct WDL_CACHE 	wdl_cache = {FALSE,0,0,NULL,
-								 NULL,NULL,0,NULL,
-								 0,0,0,0,0,0};
+/*
+|	Both caches are split in shards, each one with its own lock, LRU list,
+|	lookup table and counters. The shard of a block is given by its key,
+|	side and offset, so threads probing different blocks rarely wait on
+|	each other. Egtb_lock is only taken to read from the files.
+*/
+#define GTB_CACHE_SHARDS 16 /* maximum, power of 2 */
+
+static struct WDL_CACHE	wdl_cache [GTB_CACHE_SHARDS];
+static size_t			WDL_shards = 0;
 
 
 /*---------------------------------------------------------------------*\
@@ -2376,6 +2483,8 @@ struct dtm_block {
 };
 
 struct cache_table {
+	mythread_mutex_t lock;
+
 	/* defined at init */
 	bool_t			cached;
 	size_t			max_blocks;
@@ -2388,6 +2497,11 @@ struct cache_table {
 	size_t			n;
 	dtm_block_t *	entry;
 
+	/* fast lookup in LRU list */
+	dtm_block_t**	hash_table;
+	size_t			ht_size;
+	size_t			ht_used;
+
 	/* counters */
 	uint64_t		hard;
 	uint64_t		soft;
@@ -2395,33 +2509,76 @@ struct cache_table {
 	uint64_t		hits;
 	uint64_t		softmisses;
 	unsigned long	comparisons;
+	uint64_t		waits;
 };
 
-struct cache_table 	dtm_cache = {FALSE,0,0,NULL,
-								NULL,NULL,0,NULL,
-								0,0,0,0,0,0};
+static struct cache_table	dtm_cache [GTB_CACHE_SHARDS];
+static size_t				DTM_shards = 0;
 
-struct general_counters {
-	/* counters */
-	uint64_t		hits;
-	uint64_t		miss;
-};
+static void
+cache_locks_init (void)
+{
+	int i;
+	for (i = 0; i < GTB_CACHE_SHARDS; i++) {
+		mythread_mutex_init (&dtm_cache[i].lock);
+		mythread_mutex_init (&wdl_cache[i].lock);
+	}
+}
+
+static void
+cache_locks_done (void)
+{
+	int i;
+	for (i = 0; i < GTB_CACHE_SHARDS; i++) {
+		mythread_mutex_destroy (&dtm_cache[i].lock);
+		mythread_mutex_destroy (&wdl_cache[i].lock);
+	}
+}
+
+static size_t
+cache_shards (size_t max_blocks)
+/* largest power of 2 that leaves at least one block per shard */
+{
+	size_t n = 1;
+	while (n < GTB_CACHE_SHARDS && 2 * n <= max_blocks)
+		n *= 2;
+	return n;
+}
+
+static size_t
+shard_of (tbkey_t key, unsigned side, index_t offset, size_t n_shards)
+{
+	/* hash_func_1 bits are used inside the shard, take others */
+	return (hash_func_2 (key, side, offset) >> 1) & (n_shards - 1);
+}
+
+static struct cache_table *
+dtm_shard (tbkey_t key, unsigned side, index_t idx)
+{
+	index_t offset = idx - idx % (index_t) GTB_ENTRIES_PER_BLOCK;
+	return &dtm_cache[shard_of (key, side, offset, DTM_shards)];
+}
 
-static struct general_counters Drive = {0,0};
+static struct WDL_CACHE *
+wdl_shard (tbkey_t key, unsigned side, index_t idx)
+{
+	index_t offset = idx - idx % (index_t) GTB_ENTRIES_PER_BLOCK;
+	return &wdl_cache[shard_of (key, side, offset, WDL_shards)];
+}
 
 
 static void 		split_index (size_t entries_per_block, index_t i, index_t *o, index_t *r);
-static dtm_block_t *point_block_to_replace (void);
-static bool_t 		preload_cache (tbkey_t key, unsigned side, index_t idx);
-static void			movetotop (dtm_block_t *t);
+static dtm_block_t *point_block_to_replace (struct cache_table *c);
+static bool_t 		preload_cache (struct cache_table *c, tbkey_t key, unsigned side, index_t idx, dtm_t *out);
+static void			movetotop (struct cache_table *c, dtm_block_t *t);
 
 /*--cache prototypes--------------------------------------------------------*/
 
 /*- WDL --------------------------------------------------------------------*/
 #ifdef WDL_PROBE
 static unsigned int		wdl_extract (unit_t *uarr, index_t x);
-static wdl_block_t *	wdl_point_block_to_replace (void);
-static void				wdl_movetotop (wdl_block_t *t);
+static wdl_block_t *	wdl_point_block_to_replace (struct WDL_CACHE *w);
+static void				wdl_movetotop (struct WDL_CACHE *w, wdl_block_t *t);
 
 #if 0
 static bool_t			wdl_cache_init (size_t cache_mem);
@@ -2433,10 +2590,10 @@ static bool_t			wdl_cache_is_on (void);
 static void				wdl_cache_reset_counters (void);
 static void				wdl_cache_done (void);
 
-static wdl_block_t *	wdl_point_block_to_replace (void);
-static bool_t			get_WDL_from_cache (tbkey_t key, unsigned side, index_t idx, unsigned int *out);
-static void				wdl_movetotop (wdl_block_t *t);
-static bool_t			wdl_preload_cache (tbkey_t key, unsigned side, index_t idx);
+static wdl_block_t *	wdl_point_block_to_replace (struct WDL_CACHE *w);
+static bool_t			get_WDL_from_cache (struct WDL_CACHE *w, tbkey_t key, unsigned side, index_t idx, unsigned int *out);
+static void				wdl_movetotop (struct WDL_CACHE *w, wdl_block_t *t);
+static bool_t			wdl_preload_cache (struct WDL_CACHE *w, tbkey_t key, unsigned side, index_t idx);
 #endif
 /*--------------------------------------------------------------------------*/
 /*- DTM --------------------------------------------------------------------*/
@@ -2451,110 +2608,174 @@ static void				dtm_cache_flush (void);
 static bool_t
 dtm_cache_is_on (void)
 {
-	return dtm_cache.cached;
+	return DTM_shards > 0 && dtm_cache[0].cached;
 }
 
 static void
 dtm_cache_reset_counters (void)
 {
-	dtm_cache.hard = 0;
-	dtm_cache.soft = 0;
-	dtm_cache.hardmisses = 0;
-	dtm_cache.hits = 0;
-	dtm_cache.softmisses = 0;
-	dtm_cache.comparisons = 0;
+	size_t i;
+	struct cache_table *c;
+
+	for (i = 0; i < GTB_CACHE_SHARDS; i++) {
+		c = &dtm_cache[i];
+		c->hard = 0;
+		c->soft = 0;
+		c->hardmisses = 0;
+		c->hits = 0;
+		c->softmisses = 0;
+		c->comparisons = 0;
+		c->waits = 0;
+	}
 	return;
 }
 
+static void dtm_shard_done (struct cache_table *c);
+
 
 static size_t
-dtm_cache_init (size_t cache_mem)
+dtm_shard_init (struct cache_table *c, size_t max_blocks)
 {
 	unsigned int 	i;
 	dtm_block_t 	*p;
-	size_t 			entries_per_block;
-	size_t 			max_blocks;
-	size_t 			block_mem; 
-
-	if (DTM_CACHE_INITIALIZED)
-		dtm_cache_done();
-
-	entries_per_block 	= 16 * 1024;  /* fixed, needed for the compression schemes */
-
-	block_mem 			= entries_per_block * sizeof(dtm_t);
-
-	max_blocks 			= cache_mem / block_mem;
-	if (!Uncompressed && 1 > max_blocks)
-		max_blocks = 1; 
-	cache_mem 			= max_blocks * block_mem;
-
-
-	dtm_cache_reset_counters ();
-
-	dtm_cache.entries_per_block	= entries_per_block;
-	dtm_cache.max_blocks 		= max_blocks;
-	dtm_cache.cached 			= TRUE;
-	dtm_cache.top 				= NULL;
-	dtm_cache.bot 				= NULL;
-	dtm_cache.n 				= 0;
-
-	if (0 == cache_mem || NULL == (dtm_cache.buffer = (dtm_t *)  malloc (cache_mem))) {
-		dtm_cache.cached = FALSE;
-		dtm_cache.buffer = NULL;
-		dtm_cache.entry = NULL;
+	size_t 			entries_per_block = GTB_ENTRIES_PER_BLOCK;
+	size_t 			cache_mem = max_blocks * entries_per_block * sizeof(dtm_t);
+
+	c->entries_per_block	= entries_per_block;
+	c->max_blocks 		= max_blocks;
+	c->cached 			= TRUE;
+	c->top 				= NULL;
+	c->bot 				= NULL;
+	c->n 				= 0;
+
+	if (0 == cache_mem || NULL == (c->buffer = (dtm_t *)  malloc (cache_mem))) {
+		c->cached = FALSE;
+		c->buffer = NULL;
+		c->entry = NULL;
 		return 0;
 	}
 
-	if (0 == max_blocks|| NULL == (dtm_cache.entry  = (dtm_block_t *) malloc (max_blocks * sizeof(dtm_block_t)))) {
-		dtm_cache.cached = FALSE;
-		dtm_cache.entry = NULL;
-		free (dtm_cache.buffer);
-		dtm_cache.buffer = NULL;
+	if (0 == max_blocks|| NULL == (c->entry  = (dtm_block_t *) malloc (max_blocks * sizeof(dtm_block_t)))) {
+		c->cached = FALSE;
+		c->entry = NULL;
+		free (c->buffer);
+		c->buffer = NULL;
 		return 0;
 	}
-	
+
 	for (i = 0; i < max_blocks; i++) {
-		p = &dtm_cache.entry[i];
+		p = &c->entry[i];
 		p->key  	= -1;
 		p->side 	= gtbNOSIDE;
 		p->offset 	= gtbNOINDEX;
-		p->p_arr 	= dtm_cache.buffer + i * entries_per_block;
+		p->p_arr 	= c->buffer + i * entries_per_block;
 		p->prev 	= NULL;
 		p->next 	= NULL;
 	}
 
-	DTM_CACHE_INITIALIZED = TRUE;
+	c->ht_size = 1;
+	while (c->ht_size < max_blocks * 4)
+		c->ht_size *= 2;
+	c->ht_used = 0;
+	c->hash_table = (dtm_block_t**) malloc (c->ht_size * sizeof(dtm_block_t*));;
+	if (c->hash_table == NULL) {
+		c->cached = FALSE;
+		free (c->entry);
+		c->entry = NULL;
+		free (c->buffer);
+		c->buffer = NULL;
+		return 0;
+	}
+
+	for (i = 0; i < c->ht_size; i++) {
+		c->hash_table[i] = NULL;
+	}
 
 	return cache_mem;
 }
 
+static size_t
+dtm_cache_init (size_t cache_mem)
+{
+	size_t 			i;
+	size_t 			max_blocks;
+	size_t 			block_mem;
+	size_t 			allocated;
+
+	if (DTM_CACHE_INITIALIZED)
+		dtm_cache_done();
+
+	block_mem 			= GTB_ENTRIES_PER_BLOCK * sizeof(dtm_t);
+
+	max_blocks 			= cache_mem / block_mem;
+	if (!Uncompressed && 1 > max_blocks)
+		max_blocks = 1;
+
+	dtm_cache_reset_counters ();
+
+	DTM_shards = cache_shards (max_blocks);
+
+	for (i = 0, allocated = 0; i < DTM_shards; i++) {
+		size_t blocks = max_blocks / DTM_shards + (i < max_blocks % DTM_shards ? 1 : 0);
+		size_t mem = dtm_shard_init (&dtm_cache[i], blocks);
+		if (0 == mem && 0 != blocks) {
+			/* all shards on or none */
+			for (; i > 0; i--)
+				dtm_shard_done (&dtm_cache[i-1]);
+			DTM_shards = 0;
+			return 0;
+		}
+		allocated += mem;
+	}
+
+	DTM_CACHE_INITIALIZED = TRUE;
+
+	return allocated;
+}
+
 
 static void
-dtm_cache_done (void)
-{
-	assert(DTM_CACHE_INITIALIZED);
+dtm_shard_done (struct cache_table *c)
+{
+	c->cached = FALSE;
+	c->hard = 0;
+	c->soft = 0;
+	c->hardmisses = 0;
+	c->hits = 0;
+	c->softmisses = 0;
+	c->comparisons = 0;
+	c->max_blocks = 0;
+	c->entries_per_block = 0;
+
+	c->top = NULL;
+	c->bot = NULL;
+	c->n = 0;
+
+	if (c->buffer != NULL)
+		free (c->buffer);
+	c->buffer = NULL;
+
+	if (c->entry != NULL)
+		free (c->entry);
+	c->entry = NULL;
+
+	if (c->hash_table != NULL)
+		free (c->hash_table);
+	c->hash_table = NULL;
 
-	dtm_cache.cached = FALSE;
-	dtm_cache.hard = 0;
-	dtm_cache.soft = 0;
-	dtm_cache.hardmisses = 0;
-	dtm_cache.hits = 0;
-	dtm_cache.softmisses = 0;
-	dtm_cache.comparisons = 0;
-	dtm_cache.max_blocks = 0;
-	dtm_cache.entries_per_block = 0;
+	return;
+}
 
-	dtm_cache.top = NULL;
-	dtm_cache.bot = NULL;
-	dtm_cache.n = 0;
+static void
+dtm_cache_done (void)
+{
+	size_t i;
 
-	if (dtm_cache.buffer != NULL)
-		free (dtm_cache.buffer);
-	dtm_cache.buffer = NULL;
+	assert(DTM_CACHE_INITIALIZED);
 
-	if (dtm_cache.entry != NULL)
-		free (dtm_cache.entry);
-	dtm_cache.entry = NULL;
+	for (i = 0; i < DTM_shards; i++)
+		dtm_shard_done (&dtm_cache[i]);
+	DTM_shards = 0;
 
 	DTM_CACHE_INITIALIZED = FALSE;
 
@@ -2565,23 +2786,27 @@ static void
 dtm_cache_flush (void)
 {
 	unsigned int 	i;
+	size_t			k;
 	dtm_block_t 	*p;
-	size_t entries_per_block = dtm_cache.entries_per_block;
-	size_t max_blocks = dtm_cache.max_blocks;
+	struct cache_table *c;
 
-	dtm_cache.top 				= NULL;
-	dtm_cache.bot 				= NULL;
-	dtm_cache.n 				= 0;
-	
-	for (i = 0; i < max_blocks; i++) {
-		p = &dtm_cache.entry[i];
+	for (k = 0; k < DTM_shards; k++) {
+	c = &dtm_cache[k];
+
+	c->top 				= NULL;
+	c->bot 				= NULL;
+	c->n 				= 0;
+
+	for (i = 0; i < c->max_blocks; i++) {
+		p = &c->entry[i];
 		p->key  	= -1;
 		p->side 	= gtbNOSIDE;
 		p->offset 	= gtbNOINDEX;
-		p->p_arr 	= dtm_cache.buffer + i * entries_per_block;
+		p->p_arr 	= c->buffer + i * c->entries_per_block;
 		p->prev 	= NULL;
 		p->next 	= NULL;
 	}
+	}
 	dtm_cache_reset_counters ();
 	return;
 }
@@ -2598,55 +2823,79 @@ tbcache_is_on (void)
 
 /* STATISTICS OUTPUT */
 
-extern void 
+extern void
 tbstats_get (struct TB_STATS *x)
 {
 	long unsigned mask = 0xfffffffflu;
 	uint64_t memory_hits, total_hits;
+	uint64_t wdl_hits = 0, wdl_hard = 0, wdl_soft = 0, wdl_waits = 0;
+	uint64_t dtm_hits = 0, dtm_hard = 0, dtm_soft = 0, dtm_waits = 0;
+	size_t wdl_n = 0, wdl_max = 0, dtm_n = 0, dtm_max = 0;
+	size_t i;
+
+	/* counters are read without locking, approximate while probing */
+	for (i = 0; i < WDL_shards; i++) {
+		struct WDL_CACHE *w = &wdl_cache[i];
+		wdl_hits  += w->hits;
+		wdl_hard  += w->hard;
+		wdl_soft  += w->soft;
+		wdl_waits += w->waits;
+		wdl_n     += w->n;
+		wdl_max   += w->max_blocks;
+	}
 
+	for (i = 0; i < DTM_shards; i++) {
+		struct cache_table *c = &dtm_cache[i];
+		dtm_hits  += c->hits;
+		dtm_hard  += c->hard;
+		dtm_soft  += c->soft;
+		dtm_waits += c->waits;
+		dtm_n     += c->n;
+		dtm_max   += c->max_blocks;
+	}
 
 	/*
 	|	WDL CACHE
 	\*---------------------------------------------------*/
 
-	x->wdl_easy_hits[0] = (long unsigned)(wdl_cache.hits & mask);
-	x->wdl_easy_hits[1] = (long unsigned)(wdl_cache.hits >> 32);
+	x->wdl_easy_hits[0] = (long unsigned)(wdl_hits & mask);
+	x->wdl_easy_hits[1] = (long unsigned)(wdl_hits >> 32);
 
-	x->wdl_hard_prob[0] = (long unsigned)(wdl_cache.hard & mask);
-	x->wdl_hard_prob[1] = (long unsigned)(wdl_cache.hard >> 32);
+	x->wdl_hard_prob[0] = (long unsigned)(wdl_hard & mask);
+	x->wdl_hard_prob[1] = (long unsigned)(wdl_hard >> 32);
 
-	x->wdl_soft_prob[0] = (long unsigned)(wdl_cache.soft & mask);
-	x->wdl_soft_prob[1] = (long unsigned)(wdl_cache.soft >> 32);
+	x->wdl_soft_prob[0] = (long unsigned)(wdl_soft & mask);
+	x->wdl_soft_prob[1] = (long unsigned)(wdl_soft >> 32);
 
 	x->wdl_cachesize    = WDL_cache_size;
 
 	/* occupancy */
-	x->wdl_occupancy = wdl_cache.max_blocks==0? 0:(double)100.0*(double)wdl_cache.n/(double)wdl_cache.max_blocks;
+	x->wdl_occupancy = wdl_max==0? 0:(double)100.0*(double)wdl_n/(double)wdl_max;
 
 	/*
 	|	DTM CACHE
 	\*---------------------------------------------------*/
 
-	x->dtm_easy_hits[0] = (long unsigned)(dtm_cache.hits & mask);
-	x->dtm_easy_hits[1] = (long unsigned)(dtm_cache.hits >> 32);
+	x->dtm_easy_hits[0] = (long unsigned)(dtm_hits & mask);
+	x->dtm_easy_hits[1] = (long unsigned)(dtm_hits >> 32);
 
-	x->dtm_hard_prob[0] = (long unsigned)(dtm_cache.hard & mask);
-	x->dtm_hard_prob[1] = (long unsigned)(dtm_cache.hard >> 32);
+	x->dtm_hard_prob[0] = (long unsigned)(dtm_hard & mask);
+	x->dtm_hard_prob[1] = (long unsigned)(dtm_hard >> 32);
 
-	x->dtm_soft_prob[0] = (long unsigned)(dtm_cache.soft & mask);
-	x->dtm_soft_prob[1] = (long unsigned)(dtm_cache.soft >> 32);
+	x->dtm_soft_prob[0] = (long unsigned)(dtm_soft & mask);
+	x->dtm_soft_prob[1] = (long unsigned)(dtm_soft >> 32);
 
 	x->dtm_cachesize    = DTM_cache_size;
 
 	/* occupancy */
-	x->dtm_occupancy = dtm_cache.max_blocks==0? 0:(double)100.0*(double)dtm_cache.n/(double)dtm_cache.max_blocks;
+	x->dtm_occupancy = dtm_max==0? 0:(double)100.0*(double)dtm_n/(double)dtm_max;
 
 	/*
 	|	GENERAL
 	\*---------------------------------------------------*/
 
 	/* memory */
-	memory_hits = wdl_cache.hits + dtm_cache.hits;
+	memory_hits = wdl_hits + dtm_hits;
 	x->memory_hits[0] = (long unsigned)(memory_hits & mask);
 	x->memory_hits[1] = (long unsigned)(memory_hits >> 32);
 
@@ -2671,6 +2920,16 @@ tbstats_get (struct TB_STATS *x)
 	{ uint64_t denominator = memory_hits + Drive.hits + Drive.miss;
 	x->memory_efficiency = 0==denominator? 0: 100.0 * (double)(memory_hits) / (double)(denominator);
 	}
+
+	/* lock contention */
+	x->wdl_lock_waits[0] = (long unsigned)(wdl_waits & mask);
+	x->wdl_lock_waits[1] = (long unsigned)(wdl_waits >> 32);
+
+	x->dtm_lock_waits[0] = (long unsigned)(dtm_waits & mask);
+	x->dtm_lock_waits[1] = (long unsigned)(dtm_waits >> 32);
+
+	x->drive_lock_waits[0] = (long unsigned)(Drive.waits & mask);
+	x->drive_lock_waits[1] = (long unsigned)(Drive.waits >> 32);
 }
 
 
@@ -2683,7 +2942,7 @@ tbcache_init (size_t cache_mem, int wdl_fraction)
 	if (wdl_fraction > WDL_FRACTION_MAX) wdl_fraction = WDL_FRACTION_MAX;
 	if (wdl_fraction <                0) wdl_fraction = 0;
 	WDL_FRACTION = wdl_fraction;
-	
+
 	DTM_cache_size = (cache_mem/(size_t)WDL_FRACTION_MAX)*(size_t)(WDL_FRACTION_MAX-WDL_FRACTION);
 	WDL_cache_size = (cache_mem/(size_t)WDL_FRACTION_MAX)*(size_t)     				WDL_FRACTION ;
 
@@ -2727,7 +2986,7 @@ tbcache_flush (void)
 	return;
 }
 
-extern void	
+extern void
 tbstats_reset (void)
 {
 	dtm_cache_reset_counters ();
@@ -2737,32 +2996,73 @@ tbstats_reset (void)
 	eg_was_open_reset();
 	Drive.hits = 0;
 	Drive.miss = 0;
+	Drive.waits = 0;
 	return;
 }
 
+static void dtm_hash_insert (struct cache_table *c, dtm_block_t * e);
+
+static void
+dtm_hash_rebuild (struct cache_table *c)
+{
+	dtm_block_t	* p;
+	size_t i;
+
+	for (i = 0; i < c->ht_size; i++)
+		c->hash_table[i] = NULL;
+	c->ht_used = 0;
+
+	for (p = c->top; p != NULL; p = p->prev)
+		dtm_hash_insert (c, p);
+}
+
+static void
+dtm_hash_insert (struct cache_table *c, dtm_block_t * e)
+{
+	size_t h1, h2;
+
+	if (c->ht_used + 1 > c->ht_size * 3 / 4) /* keep an empty slot to end lookups */
+		dtm_hash_rebuild (c);
+
+    h1 = hash_func_1 (e->key, e->side, e->offset) & (c->ht_size - 1);
+    h2 = hash_func_2 (e->key, e->side, e->offset);
+    while (c->hash_table[h1])
+        h1 = (h1 + h2) & (c->ht_size - 1);
+    c->hash_table[h1] = e;
+    c->ht_used++;
+}
+
 static dtm_block_t	*
-dtm_cache_pointblock (tbkey_t key, unsigned side, index_t idx)
+dtm_cache_pointblock (struct cache_table *c, tbkey_t key, unsigned side, index_t idx)
 {
 	index_t 		offset;
 	index_t			remainder;
 	dtm_block_t	*	p;
 	dtm_block_t	*	ret;
+	size_t			h1, h2;
 
 	if (!dtm_cache_is_on())
 		return NULL;
 
-	split_index (dtm_cache.entries_per_block, idx, &offset, &remainder); 
+	split_index (c->entries_per_block, idx, &offset, &remainder);
 
 	ret   = NULL;
 
-	for (p = dtm_cache.top; p != NULL; p = p->prev) {
+	h1 = hash_func_1 (key, side, offset) & (c->ht_size - 1);
+	h2 = hash_func_2 (key, side, offset);
+	while (1) {
+		p = c->hash_table[h1];
+		if (!p)
+			break;
 
-		dtm_cache.comparisons++;
+		c->comparisons++;
 
 		if (key == p->key && side == p->side && offset  == p->offset) {
 			ret = p;
 			break;
 		}
+
+		h1 = (h1 + h2) & (c->ht_size - 1);
 	}
 
 	FOLLOW_LU("point_to_dtm_block ok?",(ret!=NULL))
@@ -2782,7 +3082,7 @@ dtm_cache_pointblock (tbkey_t key, unsigned side, index_t idx)
 
 /*
 |
-|	PRE LOAD CACHE AND DEPENDENT FUNCTIONS 
+|	PRE LOAD CACHE AND DEPENDENT FUNCTIONS
 |
 \*--------------------------------------------------------------------------*/
 
@@ -2798,7 +3098,7 @@ static index_t 	egtb_block_getnumber 		(tbkey_t key, unsigned side, index_t idx)
 static index_t 	egtb_block_getsize 			(tbkey_t key, index_t idx);
 static index_t 	egtb_block_getsize_zipped 	(tbkey_t key, index_t block );
 static  bool_t 	egtb_block_park  			(tbkey_t key, index_t block);
-static  bool_t 	egtb_block_read 			(tbkey_t key, index_t len, unsigned char *buffer); 
+static  bool_t 	egtb_block_read 			(tbkey_t key, index_t len, unsigned char *buffer);
 static  bool_t 	egtb_block_decode 			(tbkey_t key, index_t z, unsigned char *bz, index_t n, unsigned char *bp);
 static  bool_t 	egtb_block_unpack 			(unsigned side, index_t n, const unsigned char *bp, dtm_t *out);
 static  bool_t 	egtb_file_beready 			(tbkey_t key);
@@ -2860,7 +3160,7 @@ zipinfo_init (void)
 
 
 	for (j = 0, z = 0, x = 3; x < 8; x++) {
-		if (partial[x]) z |= 1u << j; 
+		if (partial[x]) z |= 1u << j;
 		j++;
 		if (complet[x]) z |= 1u << j;
 		j++;
@@ -2938,7 +3238,7 @@ egtb_loadindexes (tbkey_t key)
 	unsigned long int i;
 	unsigned long int blocks;
 	unsigned long int n_idx;
-	unsigned long int idx;
+	unsigned long int idx = 0;
 	index_t	*p;
 
 	bool_t ok;
@@ -2946,7 +3246,7 @@ egtb_loadindexes (tbkey_t key)
 	FILE *f;
 
 	if (Uncompressed) {
-		assert (decoding_scheme() == 0 && GTB_scheme == 0);	
+		assert (decoding_scheme() == 0 && GTB_scheme == 0);
 		return TRUE; /* no need to load indexes */
 	}
 	if (Zipinfo[key].blockindex != NULL)
@@ -2957,7 +3257,7 @@ egtb_loadindexes (tbkey_t key)
 
 	/* Get Reserved bytes, blocksize, offset */
 	ok = (0 == fseek (f, 0, SEEK_SET)) &&
-	fread32 (f, &dummy) &&	
+	fread32 (f, &dummy) &&
 	fread32 (f, &dummy) &&
 	fread32 (f, &blocksize) &&
 	fread32 (f, &dummy) &&
@@ -2982,11 +3282,11 @@ egtb_loadindexes (tbkey_t key)
 	}
 
 	if (ok) {
-		Zipinfo[key].extraoffset = 0;	
+		Zipinfo[key].extraoffset = 0;
 		assert (n_idx <= MAXINDEX_T);
-		Zipinfo[key].totalblocks = (index_t) n_idx; 
+		Zipinfo[key].totalblocks = (index_t) n_idx;
 		Zipinfo[key].blockindex  = p;
-	}	
+	}
 
 	if (!ok && p != NULL) {
 		free(p);
@@ -3003,7 +3303,7 @@ egtb_block_uncompressed_to_index (tbkey_t key, index_t b)
 	index_t idx;
 
 	max = egkey[key].maxindex;
-	blocks_per_side = 1 + (max-1) / (index_t)dtm_cache.entries_per_block;
+	blocks_per_side = 1 + (max-1) / (index_t)GTB_ENTRIES_PER_BLOCK;
 
 	if (b < blocks_per_side) {
 		idx = 0;
@@ -3011,7 +3311,7 @@ egtb_block_uncompressed_to_index (tbkey_t key, index_t b)
 		b -= blocks_per_side;
 		idx = max;
 	}
-	idx += b * (index_t)dtm_cache.entries_per_block;
+	idx += b * (index_t)GTB_ENTRIES_PER_BLOCK;
 	return idx;
 }
 
@@ -3023,46 +3323,46 @@ egtb_block_getnumber (tbkey_t key, unsigned side, index_t idx)
 	index_t block_in_side;
 	index_t max = egkey[key].maxindex;
 
-	blocks_per_side = 1 + (max-1) / (index_t)dtm_cache.entries_per_block;
-	block_in_side   = idx         / (index_t)dtm_cache.entries_per_block;
+	blocks_per_side = 1 + (max-1) / (index_t)GTB_ENTRIES_PER_BLOCK;
+	block_in_side   = idx         / (index_t)GTB_ENTRIES_PER_BLOCK;
 
 	return (index_t)side * blocks_per_side + block_in_side; /* block */
 }
 
 
-static index_t 
+static index_t
 egtb_block_getsize (tbkey_t key, index_t idx)
 {
-	index_t blocksz = (index_t) dtm_cache.entries_per_block;
+	index_t blocksz = (index_t) GTB_ENTRIES_PER_BLOCK;
 	index_t maxindex  = egkey[key].maxindex;
-	index_t block, offset, x; 
+	index_t block, offset, x;
 
-	assert (dtm_cache.entries_per_block <= MAXINDEX_T);
+	assert (GTB_ENTRIES_PER_BLOCK <= MAXINDEX_T);
 	assert (0 <= idx && idx < maxindex);
 	assert (key < MAX_EGKEYS);
 
 	block = idx / blocksz;
 	offset = block * blocksz;
 
-	/* 
-	|	adjust block size in case that this is the last block 
-	|	and is shorter than "blocksz" 
+	/*
+	|	adjust block size in case that this is the last block
+	|	and is shorter than "blocksz"
 	*/
-	if ( (offset + blocksz) > maxindex) 
+	if ( (offset + blocksz) > maxindex)
 		x = maxindex - offset; /* last block size */
 	else
 		x = blocksz; /* size of a normal block */
-	
+
 	return x;
 }
 
-static index_t 
+static index_t
 egtb_block_getsize_zipped (tbkey_t key, index_t block )
 {
 	index_t i, j;
 	assert (Zipinfo[key].blockindex != NULL);
 	i = Zipinfo[key].blockindex[block];
-	j = Zipinfo[key].blockindex[block+1];	
+	j = Zipinfo[key].blockindex[block+1];
 	return j - i;
 }
 
@@ -3074,7 +3374,7 @@ egtb_file_beready (tbkey_t key)
 	assert (key < MAX_EGKEYS);
 	success = 	(NULL != egkey[key].fd) ||
 				(NULL != fd_openit(key) && egtb_loadindexes (key));
-	return success; 
+	return success;
 }
 
 
@@ -3086,7 +3386,7 @@ egtb_block_park  (tbkey_t key, index_t block)
 	assert (egkey[key].fd != NULL);
 
 	if (Uncompressed) {
-		assert (decoding_scheme() == 0 && GTB_scheme == 0);	
+		assert (decoding_scheme() == 0 && GTB_scheme == 0);
 		i = egtb_block_uncompressed_to_index (key, block);
 	} else {
 		assert (Zipinfo[key].blockindex != NULL);
@@ -3101,11 +3401,11 @@ egtb_block_park  (tbkey_t key, index_t block)
 
 
 static bool_t
-egtb_block_read (tbkey_t key, index_t len, unsigned char *buffer) 
+egtb_block_read (tbkey_t key, index_t len, unsigned char *buffer)
 {
 	assert (egkey[key].fd != NULL);
 	assert (sizeof(size_t) >= sizeof(len));
-	return ((size_t)len == fread (buffer, sizeof (unsigned char), (size_t)len, egkey[key].fd));	
+	return ((size_t)len == fread (buffer, sizeof (unsigned char), (size_t)len, egkey[key].fd));
 }
 
 tbkey_t TB_PROBE_indexing_dummy;
@@ -3126,106 +3426,113 @@ static bool_t
 egtb_block_unpack (unsigned side, index_t n, const unsigned char *bp, dtm_t *out)
 /* bp:buffer packed to out:distance to mate buffer */
 {
-	index_t i;
-	for (i = 0; i < n; i++) {
-		*out++ = dtm_unpack (side, bp[i]);		
-	}	
+    index_t i;
+    if (WH == side) {
+        for (i = 0; i < n; i++) {
+            *out++ = dtm_unpack (WH, bp[i]);
+        }
+    } else {
+        for (i = 0; i < n; i++) {
+            *out++ = dtm_unpack (BL, bp[i]);
+        }
+    }
 	return TRUE;
 }
 
 static bool_t
-preload_cache (tbkey_t key, unsigned side, index_t idx)
-/* output to the least used block of the cache */
+preload_cache (struct cache_table *c, tbkey_t key, unsigned side, index_t idx, dtm_t *out)
+/* output to the least used block of the shard */
 {
 	dtm_block_t 	*pblock;
-	dtm_t 			*p;
 	bool_t 			ok;
+	index_t 		block = 0;
+	index_t			n = 0;
+	index_t			z = 0;
+	index_t 		offset;
+	index_t			remainder;
+	/* per thread buffers, decoding is done without holding any lock */
+	unsigned char	Buffer_zipped [EGTB_MAXBLOCKSIZE];
+	unsigned char	Buffer_packed [EGTB_MAXBLOCKSIZE];
 
 	FOLLOW_label("preload_cache starts")
 
 	if (idx >= egkey[key].maxindex) {
-		FOLLOW_LULU("Wrong index", __LINE__, idx)	
+		FOLLOW_LULU("Wrong index", __LINE__, idx)
 		return FALSE;
 	}
-	
-	/* find aged blocked in cache */
-	pblock = point_block_to_replace();
 
-	if (NULL == pblock)
-		return FALSE;
-
-	p = pblock->p_arr;
+	/*
+	|	READ (file handles are shared)
+	*-------------------------------*/
+	counted_lock (&Egtb_lock, &Drive.waits);
 
-	if (Uncompressed) {
+	ok =	   egtb_file_beready (key);
 
-		index_t block = egtb_block_getnumber (key, side, idx);
-		index_t n     = egtb_block_getsize   (key, idx);
+	FOLLOW_LULU("preload_cache", __LINE__, ok)
 
-		ok =	   egtb_file_beready (key)
-				&& egtb_block_park   (key, block)
-				&& egtb_block_read   (key, n, Buffer_packed)
-				&& egtb_block_unpack (side, n, Buffer_packed, p);	
+	if (ok) {
+		block = egtb_block_getnumber (key, side, idx);
+		n     = egtb_block_getsize   (key, idx);
+		z     = Uncompressed? n: egtb_block_getsize_zipped (key, block);
+	}
 
-		FOLLOW_LULU("preload_cache", __LINE__, ok)
+	ok =	   ok
+			&& egtb_block_park   (key, block)
+			&& egtb_block_read   (key, z, Uncompressed? Buffer_packed: Buffer_zipped);
 
-		assert (decoding_scheme() == 0 && GTB_scheme == 0);	
+	FOLLOW_LULU("preload_cache", __LINE__, ok)
 
-		if (ok) { Bytes_read = Bytes_read + (uint64_t) n; }
+	if (ok) { Bytes_read = Bytes_read + (uint64_t) z; }
 
-	} else {
-
-        index_t block = 0;
-		index_t n = 0;
-		index_t z = 0;
-		
-		ok =	   egtb_file_beready (key);
-
-		FOLLOW_LULU("preload_cache", __LINE__, ok)
-
-		if (ok) {
-			block = egtb_block_getnumber (key, side, idx);
-			n     = egtb_block_getsize   (key, idx);
-			z     = egtb_block_getsize_zipped (key, block);				
-		}
+	mythread_mutex_unlock (&Egtb_lock);
 
+	/*
+	|	DECODE
+	*-------------------------------*/
+	if (!Uncompressed) {
 		ok =	   ok
-				&& egtb_block_park   (key, block);
+				&& egtb_block_decode (key, z, Buffer_zipped, n, Buffer_packed);
 		FOLLOW_LULU("preload_cache", __LINE__, ok)
+	} else {
+		assert (decoding_scheme() == 0 && GTB_scheme == 0);
+	}
 
-		ok =	   ok	
-				&& egtb_block_read   (key, z, Buffer_zipped);
-		FOLLOW_LULU("preload_cache", __LINE__, ok)
+	if (!ok)
+		return FALSE;
 
-		ok =	   ok		
-				&& egtb_block_decode (key, z, Buffer_zipped, n, Buffer_packed);
-		FOLLOW_LULU("preload_cache", __LINE__, ok)
+	/*
+	|	STORE
+	*-------------------------------*/
+	split_index (GTB_ENTRIES_PER_BLOCK, idx, &offset, &remainder);
 
-		ok =	   ok		 
-				&& egtb_block_unpack (side, n, Buffer_packed, p);	
-		FOLLOW_LULU("preload_cache", __LINE__, ok)
+	counted_lock (&c->lock, &c->waits);
 
-		if (ok) { Bytes_read = Bytes_read + (uint64_t) z; }
+	/* another thread may have loaded the same block in the meantime */
+	pblock = dtm_cache_pointblock (c, key, side, idx);
+
+	if (NULL == pblock) {
+		/* find aged blocked in cache */
+		pblock = point_block_to_replace (c);
+		ok = NULL != pblock;
+		if (ok) {
+			egtb_block_unpack (side, n, Buffer_packed, pblock->p_arr);
+			pblock->key    = key;
+			pblock->side   = side;
+			pblock->offset = offset;
+			dtm_hash_insert (c, pblock);
+		}
 	}
 
 	if (ok) {
-
-		index_t 		offset;
-		index_t			remainder;
-		split_index (dtm_cache.entries_per_block, idx, &offset, &remainder); 
-
-		pblock->key    = key;
-		pblock->side   = side;
-		pblock->offset = offset;
-	} else {
-		/* make it unusable */
-		pblock->key    = -1;
-		pblock->side   = gtbNOSIDE;
-		pblock->offset = gtbNOINDEX;
+		*out = pblock->p_arr[remainder];
+		movetotop (c, pblock);
 	}
 
+	mythread_mutex_unlock (&c->lock);
+
 	FOLLOW_LU("preload_cache?", ok)
 
-	return ok;		
+	return ok;
 }
 
 /****************************************************************************\
@@ -3242,13 +3549,13 @@ egtb_freemem (int i)
 {
 	if (egkey[i].status == STATUS_MALLOC) {
 		assert (egkey[i].egt_w != NULL);
-		assert (egkey[i].egt_b != NULL);	
+		assert (egkey[i].egt_b != NULL);
 		free (egkey[i].egt_w);
-		free (egkey[i].egt_b);	
+		free (egkey[i].egt_b);
 		egkey[i].egt_w = NULL;
 		egkey[i].egt_b = NULL;
-	}	
-	egkey[i].status = STATUS_ABSENT;	
+	}
+	egkey[i].status = STATUS_ABSENT;
 }
 
 /***************************************************************************/
@@ -3256,39 +3563,52 @@ egtb_freemem (int i)
 mySHARED bool_t
 get_dtm (tbkey_t key, unsigned side, index_t idx, dtm_t *out, bool_t probe_hard_flag)
 {
+	struct cache_table *c;
 	bool_t found;
 
+	if (!dtm_cache_is_on())
+		return FALSE;
+
+	c = dtm_shard (key, side, idx);
+
+	counted_lock (&c->lock, &c->waits);
+
 	if (probe_hard_flag) {
-		dtm_cache.hard++;
+		c->hard++;
 	} else {
-		dtm_cache.soft++;
+		c->soft++;
 	}
 
-	if (get_dtm_from_cache (key, side, idx, out)) {
-		dtm_cache.hits++;
-		found = TRUE;
+	found = get_dtm_from_cache (c, key, side, idx, out);
+
+	if (found) {
+		c->hits++;
 	} else if (probe_hard_flag) {
-		dtm_cache.hardmisses++;
-		found = preload_cache (key, side, idx) &&
-				get_dtm_from_cache (key, side, idx, out);
+		c->hardmisses++;
+	} else {
+		c->softmisses++;
+	}
 
+	mythread_mutex_unlock (&c->lock);
+
+	if (!found && probe_hard_flag) {
+
+		found = preload_cache (c, key, side, idx, out);
+
+		counted_lock (&Egtb_lock, &Drive.waits);
 		if (found) {
-			Drive.hits++;			
+			Drive.hits++;
 		} else {
-			Drive.miss++;					
+			Drive.miss++;
 		}
-			
-
-	} else {
-		dtm_cache.softmisses++;
-		found = FALSE;
+		mythread_mutex_unlock (&Egtb_lock);
 	}
 	return found;
 }
 
 
 static bool_t
-get_dtm_from_cache (tbkey_t key, unsigned side, index_t idx, dtm_t *out)
+get_dtm_from_cache (struct cache_table *c, tbkey_t key, unsigned side, index_t idx, dtm_t *out)
 {
 	index_t 	offset;
 	index_t		remainder;
@@ -3298,13 +3618,13 @@ get_dtm_from_cache (tbkey_t key, unsigned side, index_t idx, dtm_t *out)
 	if (!dtm_cache_is_on())
 		return FALSE;
 
-	split_index (dtm_cache.entries_per_block, idx, &offset, &remainder); 
+	split_index (c->entries_per_block, idx, &offset, &remainder);
 
-	found = NULL != (p = dtm_cache_pointblock (key, side, idx));
+	found = NULL != (p = dtm_cache_pointblock (c, key, side, idx));
 
 	if (found) {
 		*out = p->p_arr[remainder];
-		movetotop(p);
+		movetotop (c, p);
 	}
 
 	FOLLOW_LU("get_dtm_from_cache ok?",found)
@@ -3325,76 +3645,76 @@ split_index (size_t entries_per_block, index_t i, index_t *o, index_t *r)
 
 
 static dtm_block_t *
-point_block_to_replace (void)
+point_block_to_replace (struct cache_table *c)
 {
 	dtm_block_t *p, *t, *s;
 
-	assert (0 == dtm_cache.n || dtm_cache.top != NULL);
-	assert (0 == dtm_cache.n || dtm_cache.bot != NULL);
-	assert (0 == dtm_cache.n || dtm_cache.bot->prev == NULL);
-	assert (0 == dtm_cache.n || dtm_cache.top->next == NULL);
+	assert (0 == c->n || c->top != NULL);
+	assert (0 == c->n || c->bot != NULL);
+	assert (0 == c->n || c->bot->prev == NULL);
+	assert (0 == c->n || c->top->next == NULL);
 
 	/* no cache is being used */
-	if (dtm_cache.max_blocks == 0)
+	if (c->max_blocks == 0)
 		return NULL;
 
-	if (dtm_cache.n > 0 && -1 == dtm_cache.top->key) {
+	if (c->n > 0 && -1 == c->top->key) {
 
 		/* top entry is unusable, should be the one to replace*/
-		p = dtm_cache.top;
+		p = c->top;
 
 	} else
-	if (dtm_cache.n == 0) {
-		
-		assert (NULL != dtm_cache.entry);
-		p = &dtm_cache.entry[dtm_cache.n++];
-		dtm_cache.top = p;
-		dtm_cache.bot = p;
-	
+	if (c->n == 0) {
+
+		assert (NULL != c->entry);
+		p = &c->entry[c->n++];
+		c->top = p;
+		c->bot = p;
+
 		assert (NULL != p);
 		p->prev = NULL;
 		p->next = NULL;
 
 	} else
-	if (dtm_cache.n < dtm_cache.max_blocks) { /* add */
+	if (c->n < c->max_blocks) { /* add */
+
+		assert (NULL != c->entry);
+		s = c->top;
+		p = &c->entry[c->n++];
+		c->top = p;
 
-		assert (NULL != dtm_cache.entry);
-		s = dtm_cache.top;
-		p = &dtm_cache.entry[dtm_cache.n++];
-		dtm_cache.top = p;
-	
 		assert (NULL != p && NULL != s);
 		s->next = p;
 		p->prev = s;
 		p->next = NULL;
 
-	} else if (1 < dtm_cache.max_blocks) { /* replace*/ 
-		
-		assert (NULL != dtm_cache.bot && NULL != dtm_cache.top);
-		t = dtm_cache.bot;
-		s = dtm_cache.top;
+	} else if (1 < c->max_blocks) { /* replace*/
 
-		dtm_cache.bot = t->next;
-		dtm_cache.top = t;
+		assert (NULL != c->bot && NULL != c->top);
+		t = c->bot;
+		s = c->top;
+
+		c->bot = t->next;
+		c->top = t;
 
 		s->next = t;
 		t->prev = s;
 
-		assert (dtm_cache.top);
-		dtm_cache.top->next = NULL;
+		assert (c->top);
+		c->top->next = NULL;
 
-		assert (dtm_cache.bot);
-		dtm_cache.bot->prev = NULL;
+		assert (c->bot);
+		c->bot->prev = NULL;
 
 		p = t;
 
 	} else {
-		
-		assert (1 == dtm_cache.max_blocks);
-		p =	dtm_cache.top;
-		assert (p == dtm_cache.bot && p == dtm_cache.entry);
+
+		assert (1 == c->max_blocks);
+		p =	c->top;
+		assert (p == c->bot && p == c->entry);
 	}
-	
+
 	/* make the information content unusable, it will be replaced */
 	p->key    = -1;
 	p->side   = gtbNOSIDE;
@@ -3404,7 +3724,7 @@ point_block_to_replace (void)
 }
 
 static void
-movetotop (dtm_block_t *t)
+movetotop (struct cache_table *c, dtm_block_t *t)
 {
 	dtm_block_t *s, *nx, *pv;
 
@@ -3418,26 +3738,26 @@ movetotop (dtm_block_t *t)
 	nx = t->next;
 
 	if (pv == NULL)  /* at the bottom */
-		dtm_cache.bot = nx;
-	else 
+		c->bot = nx;
+	else
 		pv->next = nx;
 
 	if (nx == NULL) /* at the top */
-		dtm_cache.top = pv;
+		c->top = pv;
 	else
 		nx->prev = pv;
 
 	/* relocate */
-	s = dtm_cache.top;
+	s = c->top;
 	assert (s != NULL);
 	if (s == NULL)
-		dtm_cache.bot = t;	
+		c->bot = t;
 	else
 		s->next = t;
 
 	t->next = NULL;
 	t->prev = s;
-	dtm_cache.top = t;
+	c->top = t;
 
 	return;
 }
@@ -3457,8 +3777,8 @@ init_indexing (int verbosity)
 
 	init_flipt ();
 
-	a = init_kkidx     () ;	
-	b = init_ppidx     () ;	
+	a = init_kkidx     () ;
+	b = init_ppidx     () ;
 	c = init_aaidx     () ;
 	d = init_aaa       () ;
 	e = init_pp48_idx  () ;
@@ -3466,8 +3786,8 @@ init_indexing (int verbosity)
 
 	if (verbosity) {
 		printf ("\nGTB supporting tables, Initialization\n");
-		printf ("  Max    kk idx: %8d\n", (int)a );	
-		printf ("  Max    pp idx: %8d\n", (int)b );	
+		printf ("  Max    kk idx: %8d\n", (int)a );
+		printf ("  Max    pp idx: %8d\n", (int)b );
 		printf ("  Max    aa idx: %8d\n", (int)c );
 		printf ("  Max   aaa idx: %8d\n", (int)d );
 		printf ("  Max  pp48 idx: %8d\n", (int)e );
@@ -3491,22 +3811,22 @@ init_indexing (int verbosity)
 		test_kaabk ();
 		test_kaaak ();
 		test_kabbk ();
-	
+
 		test_kapkb ();
 		test_kabkp ();
-	
+
 		test_kppka ();
 
 		test_kapkp ();
 		test_kabpk();
 		test_kaapk ();
-	
-		test_kappk ();	
+
+		test_kappk ();
 		test_kaakp ();
 		test_kppk ();
 	 	test_kppkp ();
 	 	test_kpppk ();
-	}	
+	}
 
 #ifdef _MSC_VER
 #pragma warning(default:4127)
@@ -3522,7 +3842,7 @@ init_kkidx (void)
 {
 	index_t idx;
 	SQUARE x, y, i, j;
-	
+
 	/* default is noindex */
 	for (x = 0; x < 64; x++) {
 		for (y = 0; y < 64; y++) {
@@ -3533,25 +3853,25 @@ init_kkidx (void)
 	idx = 0;
 	for (x = 0; x < 64; x++) {
 		for (y = 0; y < 64; y++) {
-		
+
 			/* is x,y illegal? continue */
 			if (possible_attack (x, y, wK) || x == y)
 				continue;
-		
+
 			/* normalize */
 			/*i <-- x; j <-- y */
 			norm_kkindex (x, y, &i, &j);
-		
+
 			if (IDX_is_empty(kkidx [i][j])) { /* still empty */
 				kkidx [i][j] = idx;
 				kkidx [x][y] = idx;
 				bksq [idx] = i;
-				wksq [idx] = j;			
+				wksq [idx] = j;
 				idx++;
 			}
 		}
 	}
-	
+
 	assert (idx == MAX_KKINDEX);
 
 	return idx;
@@ -3564,7 +3884,7 @@ init_aaidx (void)
 {
 	index_t idx;
 	SQUARE x, y;
-	
+
 	/* default is noindex */
 	for (x = 0; x < 64; x++) {
 		for (y = 0; y < 64; y++) {
@@ -3582,7 +3902,7 @@ init_aaidx (void)
 			assert (idx == (int)((y - x) + x * (127-x)/2 - 1) );
 
 			if (IDX_is_empty(aaidx [x][y])) { /* still empty */
-				aaidx [x] [y] = idx; 
+				aaidx [x] [y] = idx;
 				aaidx [y] [x] = idx;
 				aabase [idx] = (unsigned char) x;
 				idx++;
@@ -3594,7 +3914,7 @@ init_aaidx (void)
 
 		}
 	}
-	
+
 	assert (idx == MAX_AAINDEX);
 
 	return idx;
@@ -3615,12 +3935,12 @@ init_ppidx (void)
 			IDX_set_empty(ppidx [i][j]);
 		}
 	}
-		
+
 	for (idx = 0; idx < MAX_PPINDEX; idx++) {
 		IDX_set_empty(pp_hi24 [idx]);
-		IDX_set_empty(pp_lo48 [idx]);		
-	}		
-		
+		IDX_set_empty(pp_lo48 [idx]);
+	}
+
 	idx = 0;
 	for (a = H7; a >= A2; a--) {
 
@@ -3628,19 +3948,19 @@ init_ppidx (void)
 			continue;
 
 		for (b = a - 1; b >= A2; b--) {
-			
+
 			SQUARE anchor, loosen;
-	
+
 			pp_putanchorfirst (a, b, &anchor, &loosen);
-			
+
 			if ((anchor & 07) > 3) { /* square in the king side */
 				anchor = flipWE(anchor);
-				loosen = flipWE(loosen);				
+				loosen = flipWE(loosen);
 			}
-			
+
 			i = wsq_to_pidx24 (anchor);
 			j = wsq_to_pidx48 (loosen);
-			
+
 			if (IDX_is_empty(ppidx [i] [j])) {
 
                 ppidx [i] [j] = idx;
@@ -3651,8 +3971,8 @@ init_ppidx (void)
                 assert (j < 48);
 				idx++;
 			}
-			
-		}	
+
+		}
 	}
 	assert (idx == MAX_PPINDEX);
 	return idx;
@@ -3665,7 +3985,7 @@ init_flipt (void)
 	for (i = 0; i < 64; i++) {
 		for (j = 0; j < 64; j++) {
 			flipt [i] [j] = flip_type (i, j);
-		}		
+		}
 	}
 }
 
@@ -3675,31 +3995,31 @@ static void
 norm_kkindex (SQUARE x, SQUARE y, /*@out@*/ SQUARE *pi, /*@out@*/ SQUARE *pj)
 {
 	unsigned int rowx, rowy, colx, coly;
-	
+
 	assert (x < 64);
 	assert (y < 64);
-	
-	if (getcol(x) > 3) { 
+
+	if (getcol(x) > 3) {
 		x = flipWE (x); /* x = x ^ 07  */
-		y = flipWE (y);		
+		y = flipWE (y);
 	}
-	if (getrow(x) > 3)  { 
+	if (getrow(x) > 3)  {
 		x = flipNS (x); /* x = x ^ 070  */
-		y = flipNS (y);		
-	}	
+		y = flipNS (y);
+	}
 	rowx = getrow(x);
 	colx = getcol(x);
 	if ( rowx > colx ) {
 		x = flipNW_SE (x); /* x = ((x&7)<<3) | (x>>3) */
-		y = flipNW_SE (y);			
+		y = flipNW_SE (y);
 	}
 	rowy = getrow(y);
-	coly = getcol(y);	
+	coly = getcol(y);
 	if ( rowx == colx && rowy > coly) {
 		x = flipNW_SE (x);
-		y = flipNW_SE (y);			
-	}	
-	
+		y = flipNW_SE (y);
+	}
+
 	*pi = x;
 	*pj = y;
 }
@@ -3709,35 +4029,35 @@ flip_type (SQUARE x, SQUARE y)
 {
 	unsigned int rowx, rowy, colx, coly;
 	unsigned int ret = 0;
-	
+
 	assert (x < 64);
 	assert (y < 64);
-	
-	
-	if (getcol(x) > 3) { 
+
+
+	if (getcol(x) > 3) {
 		x = flipWE (x); /* x = x ^ 07  */
-		y = flipWE (y);		
+		y = flipWE (y);
 		ret |= 1;
 	}
-	if (getrow(x) > 3)  { 
+	if (getrow(x) > 3)  {
 		x = flipNS (x); /* x = x ^ 070  */
-		y = flipNS (y);		
-		ret |= 2;		
-	}	
+		y = flipNS (y);
+		ret |= 2;
+	}
 	rowx = getrow(x);
 	colx = getcol(x);
 	if ( rowx > colx ) {
 		x = flipNW_SE (x); /* x = ((x&7)<<3) | (x>>3) */
-		y = flipNW_SE (y);	
-		ret |= 4;				
+		y = flipNW_SE (y);
+		ret |= 4;
 	}
 	rowy = getrow(y);
-	coly = getcol(y);	
+	coly = getcol(y);
 	if ( rowx == colx && rowy > coly) {
 		x = flipNW_SE (x);
-		y = flipNW_SE (y);	
-		ret |= 4;					
-	}	
+		y = flipNW_SE (y);
+		ret |= 4;
+	}
 	return ret;
 }
 
@@ -3746,18 +4066,18 @@ static void
 pp_putanchorfirst (SQUARE a, SQUARE b, /*@out@*/ SQUARE *out_anchor, /*@out@*/ SQUARE *out_loosen)
 {
 	unsigned int anchor, loosen;
-			
+
 	unsigned int row_b, row_a;
 	row_b = b & 070;
 	row_a = a & 070;
-			
+
 	/* default */
 	anchor = a;
 	loosen = b;
 	if (row_b > row_a) {
 		anchor = b;
 		loosen = a;
-	} 
+	}
 	else
 	if (row_b == row_a) {
 		unsigned int x, col, inv, hi_a, hi_b;
@@ -3765,34 +4085,34 @@ pp_putanchorfirst (SQUARE a, SQUARE b, /*@out@*/ SQUARE *out_anchor, /*@out@*/ S
 		col = x & 07;
 		inv = col ^ 07;
 		x = (1u<<col) | (1u<<inv);
-		x &= (x-1);	
+		x &= (x-1);
 		hi_a = x;
-		
+
 		x = b;
 		col = x & 07;
 		inv = col ^ 07;
 		x = (1u<<col) | (1u<<inv);
-		x &= (x-1);	
-		hi_b = x;			
-				
+		x &= (x-1);
+		hi_b = x;
+
 		if (hi_b > hi_a) {
 			anchor = b;
-			loosen = a;					
+			loosen = a;
 		}
 
 		if (hi_b < hi_a) {
 			anchor = a;
-			loosen = b;					
+			loosen = b;
 		}
 
 		if (hi_b == hi_a) {
 			if (a < b) {
 				anchor = a;
-				loosen = b;	
+				loosen = b;
 			} else {
 				anchor = b;
-				loosen = a;	
-			}				
+				loosen = a;
+			}
 		}
 	}
 
@@ -3814,7 +4134,7 @@ wsq_to_pidx24 (SQUARE pawn)
 
 	sq ^= 070; /* flipNS*/
 	sq -= 8;   /* down one row*/
-	idx24 = (sq+(sq&3)) >> 1; 
+	idx24 = (sq+(sq&3)) >> 1;
 	assert (idx24 < 24);
 	return (index_t) idx24;
 }
@@ -3864,33 +4184,33 @@ pidx48_to_wsq (index_t a)
 static void
 kxk_indextopc (index_t i, SQUARE *pw, SQUARE *pb)
 {
-	enum  {BLOCK_A = 64}; 
+	enum  {BLOCK_A = 64};
 
 	index_t a = i / BLOCK_A;
 	index_t b = i - a * BLOCK_A;
-	
+
 	pw[0] = wksq [a];
 	pb[0] = bksq [a];
 	pw[1] = (SQUARE) b;
 	pw[2] = NOSQUARE;
 	pb[1] = NOSQUARE;
-	
+
 	assert (kxk_pctoindex (pw, pb, &a) && a == i);
 
 	return;
 }
 
-static bool_t 
+static bool_t
 kxk_pctoindex (const SQUARE *inp_pw, const SQUARE *inp_pb, index_t *out)
 {
-	enum  {BLOCK_A = 64}; 
+	enum  {BLOCK_A = 64};
 	SQUARE *p;
 	SQUARE ws[32], bs[32];
 	index_t ki;
 	int i;
-	
+
 	unsigned int ft;
-	
+
 	ft = flip_type (inp_pb[0],inp_pw[0]);
 
 	assert (ft < 8);
@@ -3906,23 +4226,23 @@ kxk_pctoindex (const SQUARE *inp_pw, const SQUARE *inp_pb, index_t *out)
 	bs[i] = NOSQUARE;
 
 	if ((ft & 1) != 0) {
-		for (p = ws; *p != NOSQUARE; p++) 
+		for (p = ws; *p != NOSQUARE; p++)
 				*p = flipWE (*p);
-		for (p = bs; *p != NOSQUARE; p++) 
+		for (p = bs; *p != NOSQUARE; p++)
 				*p = flipWE (*p);
 	}
 
 	if ((ft & 2) != 0) {
-		for (p = ws; *p != NOSQUARE; p++) 
+		for (p = ws; *p != NOSQUARE; p++)
 				*p = flipNS (*p);
-		for (p = bs; *p != NOSQUARE; p++) 
+		for (p = bs; *p != NOSQUARE; p++)
 				*p = flipNS (*p);
 	}
 
 	if ((ft & 4) != 0) {
-		for (p = ws; *p != NOSQUARE; p++) 
+		for (p = ws; *p != NOSQUARE; p++)
 				*p = flipNW_SE (*p);
-		for (p = bs; *p != NOSQUARE; p++) 
+		for (p = bs; *p != NOSQUARE; p++)
 				*p = flipNW_SE (*p);
 	}
 
@@ -3931,26 +4251,26 @@ kxk_pctoindex (const SQUARE *inp_pw, const SQUARE *inp_pb, index_t *out)
 	if (IDX_is_empty(ki)) {
 		*out = NOINDEX;
 		return FALSE;
-	}	
-	*out = ki * BLOCK_A + (index_t) ws[1]; 
+	}
+	*out = ki * BLOCK_A + (index_t) ws[1];
 	return TRUE;
-	
+
 }
 
 
 static void
 kabk_indextopc (index_t i, SQUARE *pw, SQUARE *pb)
 {
-	enum  {BLOCK_A = 64*64, BLOCK_B = 64}; 
+	enum  {BLOCK_A = 64*64, BLOCK_B = 64};
 	index_t a, b, c, r;
 
 	r = i;
 	a  = r / BLOCK_A;
 	r -= a * BLOCK_A;
 	b  = r / BLOCK_B;
-	r -= b * BLOCK_B;	
+	r -= b * BLOCK_B;
 	c  = r;
-	
+
 	pw[0] = wksq [a];
 	pb[0] = bksq [a];
 
@@ -3959,24 +4279,24 @@ kabk_indextopc (index_t i, SQUARE *pw, SQUARE *pb)
 	pw[3] = NOSQUARE;
 
 	pb[1] = NOSQUARE;
-	
+
 	assert (kabk_pctoindex (pw, pb, &a) && a == i);
 
 	return;
 }
 
 
-static bool_t 
+static bool_t
 kabk_pctoindex (const SQUARE *inp_pw, const SQUARE *inp_pb, index_t *out)
 {
-	enum  {BLOCK_A = 64*64, BLOCK_B = 64}; 
+	enum  {BLOCK_A = 64*64, BLOCK_B = 64};
 	SQUARE *p;
 	SQUARE ws[32], bs[32];
 	index_t ki;
 	int i;
-	
+
 	unsigned int ft;
-	
+
 	ft = flip_type (inp_pb[0],inp_pw[0]);
 
 	assert (ft < 8);
@@ -3991,23 +4311,23 @@ kabk_pctoindex (const SQUARE *inp_pw, const SQUARE *inp_pb, index_t *out)
 	bs[i] = NOSQUARE;
 
 	if ((ft & 1) != 0) {
-		for (p = ws; *p != NOSQUARE; p++) 
+		for (p = ws; *p != NOSQUARE; p++)
 				*p = flipWE (*p);
-		for (p = bs; *p != NOSQUARE; p++) 
+		for (p = bs; *p != NOSQUARE; p++)
 				*p = flipWE (*p);
 	}
 
 	if ((ft & 2) != 0) {
-		for (p = ws; *p != NOSQUARE; p++) 
+		for (p = ws; *p != NOSQUARE; p++)
 				*p = flipNS (*p);
-		for (p = bs; *p != NOSQUARE; p++) 
+		for (p = bs; *p != NOSQUARE; p++)
 				*p = flipNS (*p);
 	}
 
 	if ((ft & 4) != 0) {
-		for (p = ws; *p != NOSQUARE; p++) 
+		for (p = ws; *p != NOSQUARE; p++)
 				*p = flipNW_SE (*p);
-		for (p = bs; *p != NOSQUARE; p++) 
+		for (p = bs; *p != NOSQUARE; p++)
 				*p = flipNW_SE (*p);
 	}
 
@@ -4016,28 +4336,28 @@ kabk_pctoindex (const SQUARE *inp_pw, const SQUARE *inp_pb, index_t *out)
 	if (IDX_is_empty(ki)) {
 		*out = NOINDEX;
 		return FALSE;
-	}	
-	*out = ki * BLOCK_A + (index_t)ws[1] * BLOCK_B + (index_t)ws[2]; 
+	}
+	*out = ki * BLOCK_A + (index_t)ws[1] * BLOCK_B + (index_t)ws[2];
 	return TRUE;
-	
+
 }
 
 
 static void
 kabkc_indextopc (index_t i, SQUARE *pw, SQUARE *pb)
 {
-	enum  {BLOCK_A = 64*64*64, BLOCK_B = 64*64, BLOCK_C = 64}; 
+	enum  {BLOCK_A = 64*64*64, BLOCK_B = 64*64, BLOCK_C = 64};
 	index_t a, b, c, d, r;
 
 	r = i;
 	a  = r / BLOCK_A;
 	r -= a * BLOCK_A;
 	b  = r / BLOCK_B;
-	r -= b * BLOCK_B;	
+	r -= b * BLOCK_B;
 	c  = r / BLOCK_C;
 	r -= c * BLOCK_C;
 	d  = r;
-	
+
 	pw[0] = wksq [a];
 	pb[0] = bksq [a];
 
@@ -4047,19 +4367,19 @@ kabkc_indextopc (index_t i, SQUARE *pw, SQUARE *pb)
 
 	pb[1] = (SQUARE) d;
 	pb[2] = NOSQUARE;
-	
+
 	assert (kabkc_pctoindex (pw, pb, &a) && a == i);
 
 	return;
 }
 
 
-static bool_t 
+static bool_t
 kabkc_pctoindex (const SQUARE *inp_pw, const SQUARE *inp_pb, index_t *out)
 {
 	enum  {N_WHITE = 3, N_BLACK = 2};
 
-	enum  {BLOCK_A = 64*64*64, BLOCK_B = 64*64, BLOCK_C = 64}; 
+	enum  {BLOCK_A = 64*64*64, BLOCK_B = 64*64, BLOCK_C = 64};
 	SQUARE ws[MAX_LISTSIZE], bs[MAX_LISTSIZE];
 	index_t ki;
 	int i;
@@ -4074,7 +4394,7 @@ kabkc_pctoindex (const SQUARE *inp_pw, const SQUARE *inp_pb, index_t *out)
 	assert (ft < 8);
 
 	for (i = 0; i < N_WHITE; i++) ws[i] = inp_pw[i]; ws[N_WHITE] = NOSQUARE;
-	for (i = 0; i < N_BLACK; i++) bs[i] = inp_pb[i]; bs[N_BLACK] = NOSQUARE;	
+	for (i = 0; i < N_BLACK; i++) bs[i] = inp_pb[i]; bs[N_BLACK] = NOSQUARE;
 
 	if ((ft & WE_FLAG) != 0) {
 		for (i = 0; i < N_WHITE; i++) ws[i] = flipWE (ws[i]);
@@ -4097,10 +4417,10 @@ kabkc_pctoindex (const SQUARE *inp_pw, const SQUARE *inp_pb, index_t *out)
 	if (IDX_is_empty(ki)) {
 		*out = NOINDEX;
 		return FALSE;
-	}	
-	*out = ki * BLOCK_A + (index_t)ws[1] * BLOCK_B + (index_t)ws[2] * BLOCK_C + (index_t)bs[1]; 
+	}
+	*out = ki * BLOCK_A + (index_t)ws[1] * BLOCK_B + (index_t)ws[2] * BLOCK_C + (index_t)bs[1];
 	return TRUE;
-	
+
 }
 
 /* ABC/ ***/
@@ -4108,18 +4428,18 @@ kabkc_pctoindex (const SQUARE *inp_pw, const SQUARE *inp_pb, index_t *out)
 extern void
 kabck_indextopc (index_t i, SQUARE *pw, SQUARE *pb)
 {
-	enum  {BLOCK_A = 64*64*64, BLOCK_B = 64*64, BLOCK_C = 64}; 
+	enum  {BLOCK_A = 64*64*64, BLOCK_B = 64*64, BLOCK_C = 64};
 	index_t a, b, c, d, r;
 
 	r = i;
 	a  = r / BLOCK_A;
 	r -= a * BLOCK_A;
 	b  = r / BLOCK_B;
-	r -= b * BLOCK_B;	
+	r -= b * BLOCK_B;
 	c  = r / BLOCK_C;
 	r -= c * BLOCK_C;
 	d  = r;
-	
+
 	pw[0] = wksq [a];
 	pb[0] = bksq [a];
 
@@ -4129,18 +4449,18 @@ kabck_indextopc (index_t i, SQUARE *pw, SQUARE *pb)
 	pw[4] = NOSQUARE;
 
 	pb[1] = NOSQUARE;
-	
+
 	assert (kabck_pctoindex (pw, pb, &a) && a == i);
 
 	return;
 }
 
 
-extern bool_t 
+extern bool_t
 kabck_pctoindex (const SQUARE *inp_pw, const SQUARE *inp_pb, index_t *out)
 {
 	enum  {N_WHITE = 4, N_BLACK = 1};
-	enum  {BLOCK_A = 64*64*64, BLOCK_B = 64*64, BLOCK_C = 64}; 
+	enum  {BLOCK_A = 64*64*64, BLOCK_B = 64*64, BLOCK_C = 64};
 
 	SQUARE ws[MAX_LISTSIZE], bs[MAX_LISTSIZE];
 	index_t ki;
@@ -4152,7 +4472,7 @@ kabck_pctoindex (const SQUARE *inp_pw, const SQUARE *inp_pb, index_t *out)
 	assert (ft < 8);
 
 	for (i = 0; i < N_WHITE; i++) ws[i] = inp_pw[i]; ws[N_WHITE] = NOSQUARE;
-	for (i = 0; i < N_BLACK; i++) bs[i] = inp_pb[i]; bs[N_BLACK] = NOSQUARE;	
+	for (i = 0; i < N_BLACK; i++) bs[i] = inp_pb[i]; bs[N_BLACK] = NOSQUARE;
 
 	if ((ft & WE_FLAG) != 0) {
 		for (i = 0; i < N_WHITE; i++) ws[i] = flipWE (ws[i]);
@@ -4175,26 +4495,26 @@ kabck_pctoindex (const SQUARE *inp_pw, const SQUARE *inp_pb, index_t *out)
 	if (IDX_is_empty(ki)) {
 		*out = NOINDEX;
 		return FALSE;
-	}	
-	*out = ki * BLOCK_A + (index_t)ws[1] * BLOCK_B + (index_t)ws[2] * BLOCK_C + (index_t)ws[3]; 
+	}
+	*out = ki * BLOCK_A + (index_t)ws[1] * BLOCK_B + (index_t)ws[2] * BLOCK_C + (index_t)ws[3];
 	return TRUE;
-	
+
 }
 
 
 static void
 kakb_indextopc (index_t i, SQUARE *pw, SQUARE *pb)
 {
-	enum  {BLOCK_A = 64*64, BLOCK_B = 64}; 
+	enum  {BLOCK_A = 64*64, BLOCK_B = 64};
 	index_t a, b, c, r;
 
 	r = i;
 	a  = r / BLOCK_A;
 	r -= a * BLOCK_A;
 	b  = r / BLOCK_B;
-	r -= b * BLOCK_B;	
+	r -= b * BLOCK_B;
 	c  = r;
-	
+
 	pw[0] = wksq [a];
 	pb[0] = bksq [a];
 
@@ -4203,21 +4523,21 @@ kakb_indextopc (index_t i, SQUARE *pw, SQUARE *pb)
 
 	pb[1] = (SQUARE) c;
 	pb[2] = NOSQUARE;
-	
+
 	assert (kakb_pctoindex (pw, pb, &a) && a == i);
 
 	return;
 }
 
 
-static bool_t 
+static bool_t
 kakb_pctoindex (const SQUARE *inp_pw, const SQUARE *inp_pb, index_t *out)
 {
-	enum  {BLOCK_A = 64*64, BLOCK_B = 64}; 
+	enum  {BLOCK_A = 64*64, BLOCK_B = 64};
 	SQUARE ws[32], bs[32];
 	index_t ki;
 	unsigned int ft;
-	
+
 	#if 0
 		ft = flip_type (inp_pb[0], inp_pw[0]);
 	#else
@@ -4229,7 +4549,7 @@ kakb_pctoindex (const SQUARE *inp_pw, const SQUARE *inp_pb, index_t *out)
 	ws[0] = inp_pw[0];
 	ws[1] = inp_pw[1];
 	ws[2] = NOSQUARE;
-	
+
 	bs[0] = inp_pb[0];
 	bs[1] = inp_pb[1];
 	bs[2] = NOSQUARE;
@@ -4260,10 +4580,10 @@ kakb_pctoindex (const SQUARE *inp_pw, const SQUARE *inp_pb, index_t *out)
 	if (IDX_is_empty(ki)) {
 		*out = NOINDEX;
 		return FALSE;
-	}	
-	*out = ki * BLOCK_A + (index_t)ws[1] * BLOCK_B + (index_t)bs[1]; 
+	}
+	*out = ki * BLOCK_A + (index_t)ws[1] * BLOCK_B + (index_t)bs[1];
 	return TRUE;
-	
+
 }
 
 /********************** KAAKB *************************************/
@@ -4280,7 +4600,7 @@ test_kaakb (void)
 	char 		str[] = "kaakb";
 	SQUARE 		a, b, c, d, e;
 	SQUARE 		pw[MAXPC], pb[MAXPC];
-	SQUARE 		px[MAXPC], py[MAXPC];	
+	SQUARE 		px[MAXPC], py[MAXPC];
 
 	index_t		i, j;
 	bool_t 		err = FALSE;
@@ -4294,23 +4614,23 @@ test_kaakb (void)
 		for (e = 0; e < 64; e++) {
 
 			pw[0] = a;
-			pw[1] = b;	
+			pw[1] = b;
 			pw[2] = c;
 			pw[3] = NOSQUARE;
-		
+
 			pb[0] = d;
 			pb[1] = e;
 			pb[2] = NOSQUARE;
-	
+
 			if (kaakb_pctoindex (pw, pb, &i)) {
-							kaakb_indextopc (i, px, py);		
+							kaakb_indextopc (i, px, py);
 							kaakb_pctoindex (px, py, &j);
 							if (i != j) {
 								err = TRUE;
 							}
-							assert (i == j);	
+							assert (i == j);
 			}
-	
+
 		}
 		}
 		}
@@ -4322,10 +4642,10 @@ test_kaakb (void)
         }
 	}
 
-	if (err)		
-		printf ("> %s NOT passed\n", str);	
+	if (err)
+		printf ("> %s NOT passed\n", str);
 	else
-		printf ("> %s PASSED\n", str);	
+		printf ("> %s PASSED\n", str);
 	return !err;
 }
 
@@ -4334,8 +4654,8 @@ kaakb_indextopc (index_t i, SQUARE *pw, SQUARE *pb)
 {
 	enum  {
 			BLOCK_B = 64,
-			BLOCK_A = BLOCK_B * MAX_AAINDEX 
-		}; 
+			BLOCK_A = BLOCK_B * MAX_AAINDEX
+		};
 	index_t a, b, c, r, x, y;
 
 	r = i;
@@ -4346,7 +4666,7 @@ kaakb_indextopc (index_t i, SQUARE *pw, SQUARE *pb)
 	r -= b * BLOCK_B;
 
 	c  = r;
-	
+
 	assert (i == (a * BLOCK_A + b * BLOCK_B + c));
 
 	pw[0] = wksq [a];
@@ -4361,20 +4681,20 @@ kaakb_indextopc (index_t i, SQUARE *pw, SQUARE *pb)
 
 	pb[1] = (SQUARE) c;
 	pb[2] = NOSQUARE;
-	
+
 	assert (kaakb_pctoindex (pw, pb, &a) && a == i);
 
 	return;
 }
 
-static bool_t 
+static bool_t
 kaakb_pctoindex (const SQUARE *inp_pw, const SQUARE *inp_pb, /*@out@*/ index_t *out)
 {
 	enum  {N_WHITE = 3, N_BLACK = 2};
 	enum  {
 			BLOCK_B = 64,
-			BLOCK_A = BLOCK_B * MAX_AAINDEX 
-		}; 
+			BLOCK_A = BLOCK_B * MAX_AAINDEX
+		};
 	SQUARE ws[MAX_LISTSIZE], bs[MAX_LISTSIZE];
 	index_t ki, ai;
 	unsigned int ft;
@@ -4385,7 +4705,7 @@ kaakb_pctoindex (const SQUARE *inp_pw, const SQUARE *inp_pb, /*@out@*/ index_t *
 	assert (ft < 8);
 
 	for (i = 0; i < N_WHITE; i++) ws[i] = inp_pw[i]; ws[N_WHITE] = NOSQUARE;
-	for (i = 0; i < N_BLACK; i++) bs[i] = inp_pb[i]; bs[N_BLACK] = NOSQUARE;	
+	for (i = 0; i < N_BLACK; i++) bs[i] = inp_pb[i]; bs[N_BLACK] = NOSQUARE;
 
 	if ((ft & WE_FLAG) != 0) {
 		for (i = 0; i < N_WHITE; i++) ws[i] = flipWE (ws[i]);
@@ -4408,8 +4728,8 @@ kaakb_pctoindex (const SQUARE *inp_pw, const SQUARE *inp_pb, /*@out@*/ index_t *
 	if (IDX_is_empty(ki) || IDX_is_empty(ai)) {
 		*out = NOINDEX;
 		return FALSE;
-	}	
-	*out = ki * BLOCK_A + ai * BLOCK_B + (index_t)bs[1]; 
+	}
+	*out = ki * BLOCK_A + ai * BLOCK_B + (index_t)bs[1];
 	return TRUE;
 }
 
@@ -4429,7 +4749,7 @@ test_kaabk (void)
 	char 		str[] = "kaabk";
 	SQUARE 		a, b, c, d, e;
 	SQUARE 		pw[MAXPC], pb[MAXPC];
-	SQUARE 		px[MAXPC], py[MAXPC];	
+	SQUARE 		px[MAXPC], py[MAXPC];
 
 	index_t		i, j;
 	bool_t 		err = FALSE;
@@ -4443,23 +4763,23 @@ test_kaabk (void)
 		for (e = 0; e < 64; e++) {
 
 			pw[0] = a;
-			pw[1] = b;	
+			pw[1] = b;
 			pw[2] = c;
 			pw[3] = d;
 			pw[4] = NOSQUARE;
-		
+
 			pb[0] = e;
 			pb[1] = NOSQUARE;
-	
+
 			if (kaabk_pctoindex (pw, pb, &i)) {
-							kaabk_indextopc (i, px, py);		
+							kaabk_indextopc (i, px, py);
 							kaabk_pctoindex (px, py, &j);
 							if (i != j) {
 								err = TRUE;
 							}
-							assert (i == j);	
+							assert (i == j);
 			}
-	
+
 		}
 		}
 		}
@@ -4471,10 +4791,10 @@ test_kaabk (void)
         }
 	}
 
-	if (err)		
-		printf ("> %s NOT passed\n", str);	
+	if (err)
+		printf ("> %s NOT passed\n", str);
 	else
-		printf ("> %s PASSED\n", str);	
+		printf ("> %s PASSED\n", str);
 	return !err;
 }
 
@@ -4483,8 +4803,8 @@ kaabk_indextopc (index_t i, SQUARE *pw, SQUARE *pb)
 {
 	enum  {
 			BLOCK_B = 64,
-			BLOCK_A = BLOCK_B * MAX_AAINDEX 
-		}; 
+			BLOCK_A = BLOCK_B * MAX_AAINDEX
+		};
 	index_t a, b, c, r, x, y;
 
 	r = i;
@@ -4495,7 +4815,7 @@ kaabk_indextopc (index_t i, SQUARE *pw, SQUARE *pb)
 	r -= b * BLOCK_B;
 
 	c  = r;
-	
+
 	assert (i == (a * BLOCK_A + b * BLOCK_B + c));
 
 	pw[0] = wksq [a];
@@ -4510,20 +4830,20 @@ kaabk_indextopc (index_t i, SQUARE *pw, SQUARE *pb)
 	pw[4] = NOSQUARE;
 
 	pb[1] = NOSQUARE;
-	
+
 	assert (kaabk_pctoindex (pw, pb, &a) && a == i);
 
 	return;
 }
 
-static bool_t 
+static bool_t
 kaabk_pctoindex (const SQUARE *inp_pw, const SQUARE *inp_pb, /*@out@*/ index_t *out)
 {
 	enum  {N_WHITE = 4, N_BLACK = 1};
 	enum  {
 			BLOCK_B = 64,
-			BLOCK_A = BLOCK_B * MAX_AAINDEX 
-		}; 
+			BLOCK_A = BLOCK_B * MAX_AAINDEX
+		};
 	SQUARE ws[MAX_LISTSIZE], bs[MAX_LISTSIZE];
 	index_t ki, ai;
 	unsigned int ft;
@@ -4534,7 +4854,7 @@ kaabk_pctoindex (const SQUARE *inp_pw, const SQUARE *inp_pb, /*@out@*/ index_t *
 	assert (ft < 8);
 
 	for (i = 0; i < N_WHITE; i++) ws[i] = inp_pw[i]; ws[N_WHITE] = NOSQUARE;
-	for (i = 0; i < N_BLACK; i++) bs[i] = inp_pb[i]; bs[N_BLACK] = NOSQUARE;	
+	for (i = 0; i < N_BLACK; i++) bs[i] = inp_pb[i]; bs[N_BLACK] = NOSQUARE;
 
 	if ((ft & WE_FLAG) != 0) {
 		for (i = 0; i < N_WHITE; i++) ws[i] = flipWE (ws[i]);
@@ -4557,8 +4877,8 @@ kaabk_pctoindex (const SQUARE *inp_pw, const SQUARE *inp_pb, /*@out@*/ index_t *
 	if (IDX_is_empty(ki) || IDX_is_empty(ai)) {
 		*out = NOINDEX;
 		return FALSE;
-	}	
-	*out = ki * BLOCK_A + ai * BLOCK_B + (index_t)ws[3]; 
+	}
+	*out = ki * BLOCK_A + ai * BLOCK_B + (index_t)ws[3];
 	return TRUE;
 }
 
@@ -4578,7 +4898,7 @@ test_kabbk (void)
 	char 		str[] = "kabbk";
 	SQUARE 		a, b, c, d, e;
 	SQUARE 		pw[MAXPC], pb[MAXPC];
-	SQUARE 		px[MAXPC], py[MAXPC];	
+	SQUARE 		px[MAXPC], py[MAXPC];
 
 	index_t		i, j;
 	bool_t 		err = FALSE;
@@ -4592,23 +4912,23 @@ test_kabbk (void)
 		for (e = 0; e < 64; e++) {
 
 			pw[0] = a;
-			pw[1] = b;	
+			pw[1] = b;
 			pw[2] = c;
 			pw[3] = d;
 			pw[4] = NOSQUARE;
-		
+
 			pb[0] = e;
 			pb[1] = NOSQUARE;
-	
+
 			if (kabbk_pctoindex (pw, pb, &i)) {
-							kabbk_indextopc (i, px, py);		
+							kabbk_indextopc (i, px, py);
 							kabbk_pctoindex (px, py, &j);
 							if (i != j) {
 								err = TRUE;
 							}
-							assert (i == j);	
+							assert (i == j);
 			}
-	
+
 		}
 		}
 		}
@@ -4620,10 +4940,10 @@ test_kabbk (void)
         }
 	}
 
-	if (err)		
-		printf ("> %s NOT passed\n", str);	
+	if (err)
+		printf ("> %s NOT passed\n", str);
 	else
-		printf ("> %s PASSED\n", str);	
+		printf ("> %s PASSED\n", str);
 	return !err;
 }
 
@@ -4632,8 +4952,8 @@ kabbk_indextopc (index_t i, SQUARE *pw, SQUARE *pb)
 {
 	enum  {
 			BLOCK_B = 64,
-			BLOCK_A = BLOCK_B * MAX_AAINDEX 
-		}; 
+			BLOCK_A = BLOCK_B * MAX_AAINDEX
+		};
 	index_t a, b, c, r, x, y;
 
 	r = i;
@@ -4644,7 +4964,7 @@ kabbk_indextopc (index_t i, SQUARE *pw, SQUARE *pb)
 	r -= b * BLOCK_B;
 
 	c  = r;
-	
+
 	assert (i == (a * BLOCK_A + b * BLOCK_B + c));
 
 	pw[0] = wksq [a];
@@ -4659,20 +4979,20 @@ kabbk_indextopc (index_t i, SQUARE *pw, SQUARE *pb)
 	pw[4] = NOSQUARE;
 
 	pb[1] = NOSQUARE;
-	
+
 	assert (kabbk_pctoindex (pw, pb, &a) && a == i);
 
 	return;
 }
 
-static bool_t 
+static bool_t
 kabbk_pctoindex (const SQUARE *inp_pw, const SQUARE *inp_pb, /*@out@*/ index_t *out)
 {
 	enum  {N_WHITE = 4, N_BLACK = 1};
 	enum  {
 			BLOCK_B = 64,
-			BLOCK_A = BLOCK_B * MAX_AAINDEX 
-		}; 
+			BLOCK_A = BLOCK_B * MAX_AAINDEX
+		};
 	SQUARE ws[MAX_LISTSIZE], bs[MAX_LISTSIZE];
 	index_t ki, ai;
 	unsigned int ft;
@@ -4683,7 +5003,7 @@ kabbk_pctoindex (const SQUARE *inp_pw, const SQUARE *inp_pb, /*@out@*/ index_t *
 	assert (ft < 8);
 
 	for (i = 0; i < N_WHITE; i++) ws[i] = inp_pw[i]; ws[N_WHITE] = NOSQUARE;
-	for (i = 0; i < N_BLACK; i++) bs[i] = inp_pb[i]; bs[N_BLACK] = NOSQUARE;	
+	for (i = 0; i < N_BLACK; i++) bs[i] = inp_pb[i]; bs[N_BLACK] = NOSQUARE;
 
 	if ((ft & WE_FLAG) != 0) {
 		for (i = 0; i < N_WHITE; i++) ws[i] = flipWE (ws[i]);
@@ -4706,8 +5026,8 @@ kabbk_pctoindex (const SQUARE *inp_pw, const SQUARE *inp_pb, /*@out@*/ index_t *
 	if (IDX_is_empty(ki) || IDX_is_empty(ai)) {
 		*out = NOINDEX;
 		return FALSE;
-	}	
-	*out = ki * BLOCK_A + ai * BLOCK_B + (index_t)ws[1]; 
+	}
+	*out = ki * BLOCK_A + ai * BLOCK_B + (index_t)ws[1];
 	return TRUE;
 }
 
@@ -4728,21 +5048,21 @@ init_aaa (void)
 	index_t comb [64];
 	index_t accum;
 	index_t a;
-	
+
 	index_t idx;
 	SQUARE x, y, z;
 
-	/* getting aaa_base */	
-	comb [0] = 0;	
+	/* getting aaa_base */
+	comb [0] = 0;
 	for (a = 1; a < 64; a++) {
-		comb [a] = a * (a-1) / 2;	
+		comb [a] = a * (a-1) / 2;
 	}
-	
+
 	accum = 0;
-	aaa_base [0] = accum;		
+	aaa_base [0] = accum;
 	for (a = 0; a < (64-1); a++) {
 		accum += comb[a];
-		aaa_base [a+1] = accum;	
+		aaa_base [a+1] = accum;
 	}
 
 	assert ((accum + comb[63]) == MAX_AAAINDEX);
@@ -4752,7 +5072,7 @@ init_aaa (void)
 	/* initialize aaa_xyz [][] */
 	for (idx = 0; idx < MAX_AAAINDEX; idx++) {
 		IDX_set_empty (aaa_xyz[idx][0]);
-		IDX_set_empty (aaa_xyz[idx][1]);				
+		IDX_set_empty (aaa_xyz[idx][1]);
 		IDX_set_empty (aaa_xyz[idx][2]);
 	}
 
@@ -4760,18 +5080,18 @@ init_aaa (void)
 	for (z = 0; z < 64; z++) {
 		for (y = 0; y < z; y++) {
 			for (x = 0; x < y; x++) {
-			
+
 				assert (idx == aaa_getsubi (x, y, z));
-	
+
 				aaa_xyz [idx] [0] = x;
-				aaa_xyz [idx] [1] = y;				
+				aaa_xyz [idx] [1] = y;
 				aaa_xyz [idx] [2] = z;
-				
+
 				idx++;
-			}	
+			}
 		}
 	}
-	
+
 	assert (idx == MAX_AAAINDEX);
 
 	return idx;
@@ -4783,7 +5103,7 @@ aaa_getsubi (sq_t x, sq_t y, sq_t z)
 /* uses aaa_base */
 {
 	index_t calc_idx, base;
-	
+
 	assert (x < 64 && y < 64 && z < 64);
 	assert (x < y && y < z);
 
@@ -4807,7 +5127,7 @@ test_kaaak (void)
 	char 		str[] = "kaaak";
 	SQUARE 		a, b, c, d, e;
 	SQUARE 		pw[MAXPC], pb[MAXPC];
-	SQUARE 		px[MAXPC], py[MAXPC];	
+	SQUARE 		px[MAXPC], py[MAXPC];
 
 	index_t		i, j;
 	bool_t 		err = FALSE;
@@ -4821,23 +5141,23 @@ test_kaaak (void)
 		for (e = 0; e < 64; e++) {
 
 			pw[0] = a;
-			pw[1] = b;	
+			pw[1] = b;
 			pw[2] = c;
 			pw[3] = d;
 			pw[4] = NOSQUARE;
-		
+
 			pb[0] = e;
 			pb[1] = NOSQUARE;
-	
+
 			if (kaaak_pctoindex (pw, pb, &i)) {
-							kaaak_indextopc (i, px, py);		
+							kaaak_indextopc (i, px, py);
 							kaaak_pctoindex (px, py, &j);
 							if (i != j) {
 								err = TRUE;
 							}
-							assert (i == j);	
+							assert (i == j);
 			}
-	
+
 		}
 		}
 		}
@@ -4849,10 +5169,10 @@ test_kaaak (void)
         }
 	}
 
-	if (err)		
-		printf ("> %s NOT passed\n", str);	
+	if (err)
+		printf ("> %s NOT passed\n", str);
 	else
-		printf ("> %s PASSED\n", str);	
+		printf ("> %s PASSED\n", str);
 	return !err;
 }
 
@@ -4860,7 +5180,7 @@ static void
 kaaak_indextopc (index_t i, SQUARE *pw, SQUARE *pb)
 {
 	enum  {
-			BLOCK_A = MAX_AAAINDEX 
+			BLOCK_A = MAX_AAAINDEX
 		};
 	index_t a, b, r;
 
@@ -4869,7 +5189,7 @@ kaaak_indextopc (index_t i, SQUARE *pw, SQUARE *pb)
 	r -= a * BLOCK_A;
 
 	b  = r;
-	
+
 	assert (i == (a * BLOCK_A + b));
 	assert (b < BLOCK_A);
 
@@ -4888,13 +5208,13 @@ kaaak_indextopc (index_t i, SQUARE *pw, SQUARE *pb)
 	return;
 }
 
-static bool_t 
+static bool_t
 kaaak_pctoindex (const SQUARE *inp_pw, const SQUARE *inp_pb, index_t *out)
 {
 	enum  {N_WHITE = 4, N_BLACK = 1};
 	enum  {
-			BLOCK_A = MAX_AAAINDEX 
-		}; 
+			BLOCK_A = MAX_AAAINDEX
+		};
 	SQUARE ws[MAX_LISTSIZE], bs[MAX_LISTSIZE];
 	index_t ki, ai;
 	unsigned int ft;
@@ -4905,7 +5225,7 @@ kaaak_pctoindex (const SQUARE *inp_pw, const SQUARE *inp_pb, index_t *out)
 	assert (ft < 8);
 
 	for (i = 0; i < N_WHITE; i++) ws[i] = inp_pw[i]; ws[N_WHITE] = NOSQUARE;
-	for (i = 0; i < N_BLACK; i++) bs[i] = inp_pb[i]; bs[N_BLACK] = NOSQUARE;	
+	for (i = 0; i < N_BLACK; i++) bs[i] = inp_pb[i]; bs[N_BLACK] = NOSQUARE;
 
 	if ((ft & WE_FLAG) != 0) {
 		for (i = 0; i < N_WHITE; i++) ws[i] = flipWE (ws[i]);
@@ -4923,7 +5243,7 @@ kaaak_pctoindex (const SQUARE *inp_pw, const SQUARE *inp_pb, index_t *out)
 	}
 
 
-	{ 
+	{
 		SQUARE tmp;
 		if (ws[2] < ws[1]) {
             tmp = ws[1];
@@ -4941,23 +5261,23 @@ kaaak_pctoindex (const SQUARE *inp_pw, const SQUARE *inp_pb, index_t *out)
             ws[2] = tmp;
 		}
 	}
-	
+
 	ki = kkidx [bs[0]] [ws[0]]; /* kkidx [black king] [white king] */
 
 /*128 == (128 & (((ws[1]^ws[2])-1) | ((ws[1]^ws[3])-1) | ((ws[2]^ws[3])-1)) */
-	
+
 	if (ws[1] == ws[2] || ws[1] == ws[3] || ws[2] == ws[3]) {
 		*out = NOINDEX;
 		return FALSE;
 	}
-	
-	ai = aaa_getsubi ( ws[1], ws[2], ws[3] );	
-	
+
+	ai = aaa_getsubi ( ws[1], ws[2], ws[3] );
+
 	if (IDX_is_empty(ki) || IDX_is_empty(ai)) {
 		*out = NOINDEX;
 		return FALSE;
-	}	
-	*out = ki * BLOCK_A + ai; 
+	}
+	*out = ki * BLOCK_A + ai;
 	return TRUE;
 }
 
@@ -4977,7 +5297,7 @@ test_kapkb (void)
 	char 		str[] = "kapkb";
 	SQUARE 		a, b, c, d, e;
 	SQUARE 		pw[MAXPC], pb[MAXPC];
-	SQUARE 		px[MAXPC], py[MAXPC];	
+	SQUARE 		px[MAXPC], py[MAXPC];
 
 	index_t		i, j;
 	bool_t 		err = FALSE;
@@ -4992,25 +5312,25 @@ test_kapkb (void)
 
 			if (c <= H1 || c >= A8)
 				continue;
-			
+
 			pw[0] = a;
-			pw[1] = b;	
+			pw[1] = b;
 			pw[2] = c;
 			pw[3] = NOSQUARE;
-		
+
 			pb[0] = e;
 			pb[1] = d;
 			pb[2] = NOSQUARE;
-	
+
 			if (kapkb_pctoindex (pw, pb, &i)) {
-							kapkb_indextopc (i, px, py);		
+							kapkb_indextopc (i, px, py);
 							kapkb_pctoindex (px, py, &j);
 							if (i != j) {
 								err = TRUE;
 							}
-							assert (i == j);	
+							assert (i == j);
 			}
-	
+
 		}
 		}
 		}
@@ -5022,10 +5342,10 @@ test_kapkb (void)
         }
 	}
 
-	if (err)		
-		printf ("> %s NOT passed\n", str);	
+	if (err)
+		printf ("> %s NOT passed\n", str);
 	else
-		printf ("> %s PASSED\n", str);	
+		printf ("> %s PASSED\n", str);
 	return !err;
 }
 
@@ -5034,24 +5354,24 @@ kapkb_indextopc (index_t i, SQUARE *pw, SQUARE *pb)
 {
 	/*---------------------------------------------------------*
 		inverse work to make sure that the following is valid
-		index = a * BLOCK_A + b * BLOCK_B + c * BLOCK_C + d * BLOCK_D + e; 
+		index = a * BLOCK_A + b * BLOCK_B + c * BLOCK_C + d * BLOCK_D + e;
 	*----------------------------------------------------------*/
 	enum  {B11100  = 7u << 2};
-	enum  {BLOCK_A = 64*64*64*64, BLOCK_B = 64*64*64, BLOCK_C = 64*64, BLOCK_D = 64}; 
+	enum  {BLOCK_A = 64*64*64*64, BLOCK_B = 64*64*64, BLOCK_C = 64*64, BLOCK_D = 64};
 	index_t a, b, c, d, e, r;
 	index_t x;
-	
+
 	r = i;
 	a  = r / BLOCK_A;
 	r -= a * BLOCK_A;
 	b  = r / BLOCK_B;
-	r -= b * BLOCK_B;	
+	r -= b * BLOCK_B;
 	c  = r / BLOCK_C;
-	r -= c * BLOCK_C;	
+	r -= c * BLOCK_C;
 	d  = r / BLOCK_D;
 	r -= d * BLOCK_D;
 	e  = r;
-	
+
 	/* x is pslice */
 	x = a;
 	x += x & B11100; /* get upper part and double it */
@@ -5059,23 +5379,23 @@ kapkb_indextopc (index_t i, SQUARE *pw, SQUARE *pb)
 	x ^= 070;        /* flip NS */
 
 	pw[0] = (SQUARE) b;
-	pb[0] = (SQUARE) c;	
+	pb[0] = (SQUARE) c;
 	pw[1] = (SQUARE) d;
 	pw[2] = (SQUARE) x;
 	pw[3] = NOSQUARE;
 	pb[1] = (SQUARE) e;
 	pb[2] = NOSQUARE;
-	
+
 	assert (kapkb_pctoindex (pw, pb, &a) && a == i);
 
 	return;
 }
 
 
-static bool_t 
+static bool_t
 kapkb_pctoindex (const SQUARE *pw, const SQUARE *pb, index_t *out)
 {
-	enum  {BLOCK_A = 64*64*64*64, BLOCK_B = 64*64*64, BLOCK_C = 64*64, BLOCK_D = 64}; 	
+	enum  {BLOCK_A = 64*64*64*64, BLOCK_B = 64*64*64, BLOCK_C = 64*64, BLOCK_D = 64};
 	index_t pslice;
 	SQUARE sq;
 	SQUARE pawn = pw[2];
@@ -5083,26 +5403,26 @@ kapkb_pctoindex (const SQUARE *pw, const SQUARE *pb, index_t *out)
 	SQUARE wk   = pw[0];
 	SQUARE bk   = pb[0];
 	SQUARE ba   = pb[1];
-	
+
 	assert (A2 <= pawn && pawn < A8);
 
 	if (  !(A2 <= pawn && pawn < A8)) {
 		*out = NOINDEX;
 		return FALSE;
-	}	
-	
+	}
+
 	if ((pawn & 07) > 3) { /* column is more than 3. e.g. = e,f,g, or h */
 		pawn = flipWE (pawn);
-		wk   = flipWE (wk);		
-		bk   = flipWE (bk);		
+		wk   = flipWE (wk);
+		bk   = flipWE (bk);
 		wa   = flipWE (wa);
-		ba   = flipWE (ba);		
+		ba   = flipWE (ba);
 	}
 
 	sq = pawn;
 	sq ^= 070; /* flipNS*/
 	sq -= 8;   /* down one row*/
-	pslice = (index_t) ((sq+(sq&3)) >> 1); 
+	pslice = (index_t) ((sq+(sq&3)) >> 1);
 
 	*out = pslice * BLOCK_A + (index_t)wk * BLOCK_B  + (index_t)bk * BLOCK_C + (index_t)wa * BLOCK_D + (index_t)ba;
 
@@ -5124,7 +5444,7 @@ test_kabkp (void)
 	char 		str[] = "kabkp";
 	SQUARE 		a, b, c, d, e;
 	SQUARE 		pw[MAXPC], pb[MAXPC];
-	SQUARE 		px[MAXPC], py[MAXPC];	
+	SQUARE 		px[MAXPC], py[MAXPC];
 
 	index_t		i, j;
 	bool_t 		err = FALSE;
@@ -5139,25 +5459,25 @@ test_kabkp (void)
 
 			if (d <= H1 || d >= A8)
 				continue;
-			
+
 			pw[0] = a;
-			pw[1] = b;	
+			pw[1] = b;
 			pw[2] = c;
 			pw[3] = NOSQUARE;
-		
+
 			pb[0] = e;
 			pb[1] = d;
 			pb[2] = NOSQUARE;
-	
+
 			if (kabkp_pctoindex (pw, pb, &i)) {
-							kabkp_indextopc (i, px, py);		
+							kabkp_indextopc (i, px, py);
 							kabkp_pctoindex (px, py, &j);
 							if (i != j) {
 								err = TRUE;
 							}
-							assert (i == j);	
+							assert (i == j);
 			}
-	
+
 		}
 		}
 		}
@@ -5169,10 +5489,10 @@ test_kabkp (void)
         }
 	}
 
-	if (err)		
-		printf ("> %s NOT passed\n", str);	
+	if (err)
+		printf ("> %s NOT passed\n", str);
 	else
-		printf ("> %s PASSED\n", str);	
+		printf ("> %s PASSED\n", str);
 	return !err;
 }
 
@@ -5181,24 +5501,24 @@ kabkp_indextopc (index_t i, SQUARE *pw, SQUARE *pb)
 {
 	/*---------------------------------------------------------*
 		inverse work to make sure that the following is valid
-		index = a * BLOCK_A + b * BLOCK_B + c * BLOCK_C + d * BLOCK_D + e; 
+		index = a * BLOCK_A + b * BLOCK_B + c * BLOCK_C + d * BLOCK_D + e;
 	*----------------------------------------------------------*/
 	enum  {B11100  = 7u << 2};
-	enum  {BLOCK_A = 64*64*64*64, BLOCK_B = 64*64*64, BLOCK_C = 64*64, BLOCK_D = 64}; 
+	enum  {BLOCK_A = 64*64*64*64, BLOCK_B = 64*64*64, BLOCK_C = 64*64, BLOCK_D = 64};
 	index_t a, b, c, d, e, r;
 	index_t x;
-	
+
 	r = i;
 	a  = r / BLOCK_A;
 	r -= a * BLOCK_A;
 	b  = r / BLOCK_B;
-	r -= b * BLOCK_B;	
+	r -= b * BLOCK_B;
 	c  = r / BLOCK_C;
-	r -= c * BLOCK_C;	
+	r -= c * BLOCK_C;
 	d  = r / BLOCK_D;
 	r -= d * BLOCK_D;
 	e  = r;
-	
+
 	/* x is pslice */
 	x = a;
 	x += x & B11100; /* get upper part and double it */
@@ -5206,23 +5526,23 @@ kabkp_indextopc (index_t i, SQUARE *pw, SQUARE *pb)
 	/*x ^= 070;*/        /* do not flip NS */
 
 	pw[0] = (SQUARE) b;
-	pb[0] = (SQUARE) c;	
+	pb[0] = (SQUARE) c;
 	pw[1] = (SQUARE) d;
 	pw[2] = (SQUARE) e;
 	pw[3] = NOSQUARE;
 	pb[1] = (SQUARE) x;
 	pb[2] = NOSQUARE;
-	
+
 	assert (kabkp_pctoindex (pw, pb, &a) && a == i);
 
 	return;
 }
 
 
-static bool_t 
+static bool_t
 kabkp_pctoindex (const SQUARE *pw, const SQUARE *pb, index_t *out)
 {
-	enum  {BLOCK_A = 64*64*64*64, BLOCK_B = 64*64*64, BLOCK_C = 64*64, BLOCK_D = 64}; 	
+	enum  {BLOCK_A = 64*64*64*64, BLOCK_B = 64*64*64, BLOCK_C = 64*64, BLOCK_D = 64};
 	index_t pslice;
 	SQUARE sq;
 	SQUARE pawn = pb[1];
@@ -5230,26 +5550,26 @@ kabkp_pctoindex (const SQUARE *pw, const SQUARE *pb, index_t *out)
 	SQUARE wk   = pw[0];
 	SQUARE bk   = pb[0];
 	SQUARE wb   = pw[2];
-	
+
 	assert (A2 <= pawn && pawn < A8);
 
 	if (  !(A2 <= pawn && pawn < A8)) {
 		*out = NOINDEX;
 		return FALSE;
-	}	
-	
+	}
+
 	if ((pawn & 07) > 3) { /* column is more than 3. e.g. = e,f,g, or h */
 		pawn = flipWE (pawn);
-		wk   = flipWE (wk);		
-		bk   = flipWE (bk);		
+		wk   = flipWE (wk);
+		bk   = flipWE (bk);
 		wa   = flipWE (wa);
-		wb   = flipWE (wb);		
+		wb   = flipWE (wb);
 	}
 
 	sq = pawn;
 	/*sq ^= 070;*/ /* do not flipNS*/
 	sq -= 8;   /* down one row*/
-	pslice = (index_t) ((sq+(sq&3)) >> 1); 
+	pslice = (index_t) ((sq+(sq&3)) >> 1);
 
 	*out = pslice * BLOCK_A + (index_t)wk * BLOCK_B  + (index_t)bk * BLOCK_C + (index_t)wa * BLOCK_D + (index_t)wb;
 
@@ -5263,43 +5583,43 @@ kpk_indextopc (index_t i, SQUARE *pw, SQUARE *pb)
 {
 	/*---------------------------------------------------------*
 		inverse work to make sure that the following is valid
-		index = a * BLOCK_A + b * BLOCK_B + c; 
+		index = a * BLOCK_A + b * BLOCK_B + c;
 	*----------------------------------------------------------*/
 	enum  {B11100  = 7u << 2};
-	enum  {BLOCK_A = 64*64, BLOCK_B = 64}; 
+	enum  {BLOCK_A = 64*64, BLOCK_B = 64};
 	index_t a, b, c, r;
 	index_t x;
-	
+
 	r = i;
 	a  = r / BLOCK_A;
 	r -= a * BLOCK_A;
 	b  = r / BLOCK_B;
-	r -= b * BLOCK_B;	
+	r -= b * BLOCK_B;
 	c  = r;
-	
+
 	/* x is pslice */
 	x = a;
 	x += x & B11100; /* get upper part and double it */
 	x += 8;          /* add extra row  */
 	x ^= 070;        /* flip NS */
-	
+
 	pw[1] = (SQUARE) x;
 	pw[0] = (SQUARE) b;
 	pb[0] = (SQUARE) c;
 
 	pw[2] = NOSQUARE;
 	pb[1] = NOSQUARE;
-	
+
 	assert (kpk_pctoindex (pw, pb, &a) && a == i);
 
 	return;
 }
 
 
-static bool_t 
+static bool_t
 kpk_pctoindex (const SQUARE *pw, const SQUARE *pb, index_t *out)
 {
-	enum  {BLOCK_A = 64*64, BLOCK_B = 64}; 	
+	enum  {BLOCK_A = 64*64, BLOCK_B = 64};
 	index_t pslice;
 	SQUARE sq;
 	SQUARE pawn = pw[1];
@@ -5313,7 +5633,7 @@ kpk_pctoindex (const SQUARE *pw, const SQUARE *pb, index_t *out)
         wp[1] = PAWN;
         wp[2] = bp[1] = NOPIECE;
 		output_state (0, pw, pb, wp, bp);
-	}	
+	}
 	#endif
 
 	assert (A2 <= pawn && pawn < A8);
@@ -5321,18 +5641,18 @@ kpk_pctoindex (const SQUARE *pw, const SQUARE *pb, index_t *out)
 	if (  !(A2 <= pawn && pawn < A8)) {
 		*out = NOINDEX;
 		return FALSE;
-	}	
-	
+	}
+
 	if ((pawn & 07) > 3) { /* column is more than 3. e.g. = e,f,g, or h */
 		pawn = flipWE (pawn);
-		wk   = flipWE (wk);		
-		bk   = flipWE (bk);		
+		wk   = flipWE (wk);
+		bk   = flipWE (bk);
 	}
 
 	sq = pawn;
 	sq ^= 070; /* flipNS*/
 	sq -= 8;   /* down one row*/
-	pslice = (index_t) ((sq+(sq&3)) >> 1); 
+	pslice = (index_t) ((sq+(sq&3)) >> 1);
 
 	*out = pslice * BLOCK_A + (index_t)wk * BLOCK_B  + (index_t)bk;
 
@@ -5354,7 +5674,7 @@ test_kppk (void)
 	char 		str[] = "kppk";
 	SQUARE 		a, b, c, d;
 	SQUARE 		pw[MAXPC], pb[MAXPC];
-	SQUARE 		px[MAXPC], py[MAXPC];	
+	SQUARE 		px[MAXPC], py[MAXPC];
 
 	index_t		i, j;
 	bool_t 		err = FALSE;
@@ -5374,7 +5694,7 @@ test_kppk (void)
 			if (!(anchor1 == anchor2 && loosen1 == loosen2)) {
 				printf ("Output depends on input in pp_outanchorfirst()\n input:%u, %u\n",(unsigned)b,(unsigned)c);
 				fatal_error();
-			} 
+			}
 		}
 	}
 
@@ -5390,25 +5710,25 @@ test_kppk (void)
 			if (b <= H1 || b >= A8)
 				continue;
 
-			
+
 			pw[0] = a;
-			pw[1] = b;	
+			pw[1] = b;
 			pw[2] = c;
 			pw[3] = NOSQUARE;
-		
+
 			pb[0] = d;
 			pb[1] = NOSQUARE;
-	
+
 			if (kppk_pctoindex (pw, pb, &i)) {
-							kppk_indextopc (i, px, py);		
+							kppk_indextopc (i, px, py);
 							kppk_pctoindex (px, py, &j);
 							if (i != j) {
 								err = TRUE;
 							}
-							assert (i == j);	
+							assert (i == j);
 			}
-	
-		
+
+
 		}
 		}
 		}
@@ -5419,10 +5739,10 @@ test_kppk (void)
         }
 	}
 
-	if (err)		
-		printf ("> %s NOT passed\n", str);	
+	if (err)
+		printf ("> %s NOT passed\n", str);
 	else
-		printf ("> %s PASSED\n", str);	
+		printf ("> %s PASSED\n", str);
 	return !err;
 }
 
@@ -5431,27 +5751,27 @@ kppk_indextopc (index_t i, SQUARE *pw, SQUARE *pb)
 {
 	/*---------------------------------------------------------*
 		inverse work to make sure that the following is valid
-		index = a * BLOCK_A + b * BLOCK_B + c; 
+		index = a * BLOCK_A + b * BLOCK_B + c;
 	*----------------------------------------------------------*/
 	enum  {B11100  = 7u << 2};
-	enum  {BLOCK_A = 64*64, BLOCK_B = 64}; 
+	enum  {BLOCK_A = 64*64, BLOCK_B = 64};
 	index_t a, b, c, r;
 	index_t m, n;
-	
+
 	r = i;
 	a  = r / BLOCK_A;
 	r -= a * BLOCK_A;
 	b  = r / BLOCK_B;
-	r -= b * BLOCK_B;	
+	r -= b * BLOCK_B;
 	c  = r;
 
 	m = pp_hi24 [a];
 	n = pp_lo48 [a];
-	
+
 	pw[0] = (SQUARE) b;
-	pb[0] = (SQUARE) c;	
-	pb[1] = NOSQUARE;	
-	
+	pb[0] = (SQUARE) c;
+	pb[1] = NOSQUARE;
+
 	pw[1] = pidx24_to_wsq (m);
 	pw[2] = pidx48_to_wsq (n);
 
@@ -5464,7 +5784,7 @@ kppk_indextopc (index_t i, SQUARE *pw, SQUARE *pb)
 #ifdef DEBUG
 	if (!(kppk_pctoindex (pw, pb, &a) && a == i)) {
 		pc_t wp[] = {KING, PAWN, PAWN, NOPIECE};
-		pc_t bp[] = {KING, NOPIECE};		
+		pc_t bp[] = {KING, NOPIECE};
 		printf("Indexes not matching: input:%d, output:%d\n", i, a);
 		print_pos (pw, pb, wp, bp);
 	}
@@ -5476,13 +5796,13 @@ kppk_indextopc (index_t i, SQUARE *pw, SQUARE *pb)
 }
 
 
-static bool_t 
+static bool_t
 kppk_pctoindex (const SQUARE *pw, const SQUARE *pb, index_t *out)
 {
-	enum  {BLOCK_A = 64*64, BLOCK_B = 64}; 	
+	enum  {BLOCK_A = 64*64, BLOCK_B = 64};
 	index_t pp_slice;
 	SQUARE anchor, loosen;
-	
+
 	SQUARE wk     = pw[0];
 	SQUARE pawn_a = pw[1];
 	SQUARE pawn_b = pw[2];
@@ -5509,10 +5829,10 @@ kppk_pctoindex (const SQUARE *pw, const SQUARE *pb, index_t *out)
 	if ((anchor & 07) > 3) { /* column is more than 3. e.g. = e,f,g, or h */
 		anchor = flipWE (anchor);
 		loosen = flipWE (loosen);
-		wk     = flipWE (wk);		
-		bk     = flipWE (bk);		
+		wk     = flipWE (wk);
+		bk     = flipWE (bk);
 	}
- 
+
 	i = wsq_to_pidx24 (anchor);
 	j = wsq_to_pidx48 (loosen);
 
@@ -5524,7 +5844,7 @@ kppk_pctoindex (const SQUARE *pw, const SQUARE *pb, index_t *out)
 	}
 
 	assert (pp_slice < MAX_PPINDEX );
-	
+
 	*out = pp_slice * BLOCK_A + (index_t)wk * BLOCK_B  + (index_t)bk;
 
 	return TRUE;
@@ -5536,22 +5856,22 @@ kakp_indextopc (index_t i, SQUARE *pw, SQUARE *pb)
 {
 	/*---------------------------------------------------------*
 		inverse work to make sure that the following is valid
-		index = a * BLOCK_A + b * BLOCK_B + c * BLOCK_C + d; 
+		index = a * BLOCK_A + b * BLOCK_B + c * BLOCK_C + d;
 	*----------------------------------------------------------*/
 	enum  {B11100  = 7u << 2};
-	enum  {BLOCK_A = 64*64*64, BLOCK_B = 64*64, BLOCK_C = 64}; 
+	enum  {BLOCK_A = 64*64*64, BLOCK_B = 64*64, BLOCK_C = 64};
 	index_t a, b, c, d, r;
 	index_t x;
-	
+
 	r = i;
 	a  = r / BLOCK_A;
 	r -= a * BLOCK_A;
 	b  = r / BLOCK_B;
-	r -= b * BLOCK_B;	
+	r -= b * BLOCK_B;
 	c  = r / BLOCK_C;
-	r -= c * BLOCK_C;	
+	r -= c * BLOCK_C;
 	d  = r;
-	
+
 	/* x is pslice */
 	x = a;
 	x += x & B11100; /* get upper part and double it */
@@ -5559,22 +5879,22 @@ kakp_indextopc (index_t i, SQUARE *pw, SQUARE *pb)
 /*	x ^= 070;   */     /* flip NS */
 
 	pw[0] = (SQUARE) b;
-	pb[0] = (SQUARE) c;	
+	pb[0] = (SQUARE) c;
 	pw[1] = (SQUARE) d;
 	pb[1] = (SQUARE) x;
 	pw[2] = NOSQUARE;
 	pb[2] = NOSQUARE;
-	
+
 	assert (kakp_pctoindex (pw, pb, &a) && a == i);
 
 	return;
 }
 
 
-static bool_t 
+static bool_t
 kakp_pctoindex (const SQUARE *pw, const SQUARE *pb, index_t *out)
 {
-	enum  {BLOCK_A = 64*64*64, BLOCK_B = 64*64, BLOCK_C = 64}; 	
+	enum  {BLOCK_A = 64*64*64, BLOCK_B = 64*64, BLOCK_C = 64};
 	index_t pslice;
 	SQUARE sq;
 	SQUARE pawn = pb[1];
@@ -5587,19 +5907,19 @@ kakp_pctoindex (const SQUARE *pw, const SQUARE *pb, index_t *out)
 	if (  !(A2 <= pawn && pawn < A8)) {
 		*out = NOINDEX;
 		return FALSE;
-	}	
-	
+	}
+
 	if ((pawn & 07) > 3) { /* column is more than 3. e.g. = e,f,g, or h */
 		pawn = flipWE (pawn);
-		wk   = flipWE (wk);		
-		bk   = flipWE (bk);		
+		wk   = flipWE (wk);
+		bk   = flipWE (bk);
 		wa   = flipWE (wa);
 	}
 
 	sq = pawn;
 	/*sq ^= 070;*/ /* flipNS*/
 	sq -= 8;   /* down one row*/
-	pslice = (index_t) ((sq+(sq&3)) >> 1); 
+	pslice = (index_t) ((sq+(sq&3)) >> 1);
 
 	*out = pslice * BLOCK_A + (index_t)wk * BLOCK_B  + (index_t)bk * BLOCK_C + (index_t)wa;
 
@@ -5612,22 +5932,22 @@ kapk_indextopc (index_t i, SQUARE *pw, SQUARE *pb)
 {
 	/*---------------------------------------------------------*
 		inverse work to make sure that the following is valid
-		index = a * BLOCK_A + b * BLOCK_B + c * BLOCK_C + d; 
+		index = a * BLOCK_A + b * BLOCK_B + c * BLOCK_C + d;
 	*----------------------------------------------------------*/
 	enum  {B11100  = 7u << 2};
-	enum  {BLOCK_A = 64*64*64, BLOCK_B = 64*64, BLOCK_C = 64}; 
+	enum  {BLOCK_A = 64*64*64, BLOCK_B = 64*64, BLOCK_C = 64};
 	index_t a, b, c, d, r;
 	index_t x;
-	
+
 	r = i;
 	a  = r / BLOCK_A;
 	r -= a * BLOCK_A;
 	b  = r / BLOCK_B;
-	r -= b * BLOCK_B;	
+	r -= b * BLOCK_B;
 	c  = r / BLOCK_C;
-	r -= c * BLOCK_C;	
+	r -= c * BLOCK_C;
 	d  = r;
-	
+
 	/* x is pslice */
 	x = a;
 	x += x & B11100; /* get upper part and double it */
@@ -5635,22 +5955,22 @@ kapk_indextopc (index_t i, SQUARE *pw, SQUARE *pb)
 	x ^= 070;        /* flip NS */
 
 	pw[0] = (SQUARE) b;
-	pb[0] = (SQUARE) c;	
+	pb[0] = (SQUARE) c;
 	pw[1] = (SQUARE) d;
 	pw[2] = (SQUARE) x;
 	pw[3] = NOSQUARE;
 	pb[1] = NOSQUARE;
-	
+
 	assert (kapk_pctoindex (pw, pb, &a) && a == i);
 
 	return;
 }
 
 
-static bool_t 
+static bool_t
 kapk_pctoindex (const SQUARE *pw, const SQUARE *pb, index_t *out)
 {
-	enum  {BLOCK_A = 64*64*64, BLOCK_B = 64*64, BLOCK_C = 64}; 	
+	enum  {BLOCK_A = 64*64*64, BLOCK_B = 64*64, BLOCK_C = 64};
 	index_t pslice;
 	SQUARE sq;
 	SQUARE pawn = pw[2];
@@ -5663,19 +5983,19 @@ kapk_pctoindex (const SQUARE *pw, const SQUARE *pb, index_t *out)
 	if (  !(A2 <= pawn && pawn < A8)) {
 		*out = NOINDEX;
 		return FALSE;
-	}	
-	
+	}
+
 	if ((pawn & 07) > 3) { /* column is more than 3. e.g. = e,f,g, or h */
 		pawn = flipWE (pawn);
-		wk   = flipWE (wk);		
-		bk   = flipWE (bk);		
+		wk   = flipWE (wk);
+		bk   = flipWE (bk);
 		wa   = flipWE (wa);
 	}
 
 	sq = pawn;
 	sq ^= 070; /* flipNS*/
 	sq -= 8;   /* down one row*/
-	pslice = (index_t) ((sq+(sq&3)) >> 1); 
+	pslice = (index_t) ((sq+(sq&3)) >> 1);
 
 	*out = pslice * BLOCK_A + (index_t)wk * BLOCK_B  + (index_t)bk * BLOCK_C + (index_t)wa;
 
@@ -5686,14 +6006,14 @@ kapk_pctoindex (const SQUARE *pw, const SQUARE *pb, index_t *out)
 static void
 kaak_indextopc (index_t i, SQUARE *pw, SQUARE *pb)
 {
-	enum  {BLOCK_A = MAX_AAINDEX}; 
+	enum  {BLOCK_A = MAX_AAINDEX};
 	index_t a, b, r, x, y;
 
 	r = i;
 	a  = r / BLOCK_A;
 	r -= a * BLOCK_A;
 	b  = r;
-	
+
 	assert (i == (a * BLOCK_A + b));
 
 	pw[0] = wksq [a];
@@ -5707,18 +6027,18 @@ kaak_indextopc (index_t i, SQUARE *pw, SQUARE *pb)
 	pw[3] = NOSQUARE;
 
 	pb[1] = NOSQUARE;
-	
+
 	assert (kaak_pctoindex (pw, pb, &a) && a == i);
 
 	return;
 }
 
 
-static bool_t 
+static bool_t
 kaak_pctoindex (const SQUARE *inp_pw, const SQUARE *inp_pb, index_t *out)
 {
 	enum  {N_WHITE = 3, N_BLACK = 1};
-	enum  {BLOCK_A = MAX_AAINDEX}; 
+	enum  {BLOCK_A = MAX_AAINDEX};
 	SQUARE ws[MAX_LISTSIZE], bs[MAX_LISTSIZE];
 	index_t ki, ai;
 	unsigned int ft;
@@ -5754,8 +6074,8 @@ kaak_pctoindex (const SQUARE *inp_pw, const SQUARE *inp_pb, index_t *out)
 	if (IDX_is_empty(ki) || IDX_is_empty(ai)) {
 		*out = NOINDEX;
 		return FALSE;
-	}	
-	*out = ki * BLOCK_A + ai; 
+	}
+	*out = ki * BLOCK_A + ai;
 	return TRUE;
 }
 
@@ -5773,7 +6093,7 @@ test_kppka (void)
 	char 		str[] = "kppka";
 	SQUARE 		a, b, c, d, e;
 	SQUARE 		pw[MAXPC], pb[MAXPC];
-	SQUARE 		px[MAXPC], py[MAXPC];	
+	SQUARE 		px[MAXPC], py[MAXPC];
 
 	index_t		i, j;
 	bool_t 		err = FALSE;
@@ -5791,25 +6111,25 @@ test_kppka (void)
 			if (b <= H1 || b >= A8)
 				continue;
 
-			
+
 			pw[0] = a;
-			pw[1] = b;	
+			pw[1] = b;
 			pw[2] = c;
 			pw[3] = NOSQUARE;
-		
+
 			pb[0] = e;
 			pb[1] = d;
 			pb[2] = NOSQUARE;
-	
+
 			if (kppka_pctoindex (pw, pb, &i)) {
-							kppka_indextopc (i, px, py);		
+							kppka_indextopc (i, px, py);
 							kppka_pctoindex (px, py, &j);
 							if (i != j) {
 								err = TRUE;
 							}
-							assert (i == j);	
+							assert (i == j);
 			}
-	
+
 		}
 		}
 		}
@@ -5821,10 +6141,10 @@ test_kppka (void)
         }
 	}
 
-	if (err)		
-		printf ("> %s NOT passed\n", str);	
+	if (err)
+		printf ("> %s NOT passed\n", str);
 	else
-		printf ("> %s PASSED\n", str);	
+		printf ("> %s PASSED\n", str);
 	return !err;
 }
 
@@ -5834,33 +6154,33 @@ kppka_indextopc (index_t i, SQUARE *pw, SQUARE *pb)
 {
 	/*---------------------------------------------------------*
 		inverse work to make sure that the following is valid
-		index = a * BLOCK_A + b * BLOCK_B + c * BLOCK_C + d; 
+		index = a * BLOCK_A + b * BLOCK_B + c * BLOCK_C + d;
 	*----------------------------------------------------------*/
 
-	enum  {BLOCK_A = 64*64*64, BLOCK_B = 64*64, BLOCK_C = 64}; 
+	enum  {BLOCK_A = 64*64*64, BLOCK_B = 64*64, BLOCK_C = 64};
 	index_t a, b, c, d, r;
 	index_t m, n;
-	
+
 	r = i;
 	a  = r / BLOCK_A;
 	r -= a * BLOCK_A;
 	b  = r / BLOCK_B;
-	r -= b * BLOCK_B;	
+	r -= b * BLOCK_B;
 	c  = r / BLOCK_C;
-	r -= c * BLOCK_C;	
+	r -= c * BLOCK_C;
 	d  = r;
-	
+
 	m = pp_hi24 [a];
 	n = pp_lo48 [a];
-	
+
 	pw[0] = (SQUARE) b;
 	pw[1] = pidx24_to_wsq (m);
 	pw[2] = pidx48_to_wsq (n);
 	pw[3] = NOSQUARE;
 
-	pb[0] = (SQUARE) c;	
+	pb[0] = (SQUARE) c;
 	pb[1] = (SQUARE) d;
-	pb[2] = NOSQUARE;	
+	pb[2] = NOSQUARE;
 
 
 	assert (A2 <= pw[1] && pw[1] < A8);
@@ -5871,20 +6191,20 @@ kppka_indextopc (index_t i, SQUARE *pw, SQUARE *pb)
 }
 
 
-static bool_t 
+static bool_t
 kppka_pctoindex (const SQUARE *pw, const SQUARE *pb, index_t *out)
 {
-	enum  {BLOCK_A = 64*64*64, BLOCK_B = 64*64, BLOCK_C = 64}; 
+	enum  {BLOCK_A = 64*64*64, BLOCK_B = 64*64, BLOCK_C = 64};
 	index_t pp_slice;
 	index_t i, j;
 
 	SQUARE anchor, loosen;
-	
+
 	SQUARE wk     = pw[0];
 	SQUARE pawn_a = pw[1];
 	SQUARE pawn_b = pw[2];
 	SQUARE bk     = pb[0];
-	SQUARE ba	  = pb[1];	
+	SQUARE ba	  = pb[1];
 
 
 	assert (A2 <= pawn_a && pawn_a < A8);
@@ -5895,11 +6215,11 @@ kppka_pctoindex (const SQUARE *pw, const SQUARE *pb, index_t *out)
 	if ((anchor & 07) > 3) { /* column is more than 3. e.g. = e,f,g, or h */
 		anchor = flipWE (anchor);
 		loosen = flipWE (loosen);
-		wk     = flipWE (wk);		
-		bk     = flipWE (bk);		
-		ba	   = flipWE (ba);	
+		wk     = flipWE (wk);
+		bk     = flipWE (bk);
+		ba	   = flipWE (ba);
 	}
- 
+
 	i = wsq_to_pidx24 (anchor);
 	j = wsq_to_pidx48 (loosen);
 
@@ -5911,7 +6231,7 @@ kppka_pctoindex (const SQUARE *pw, const SQUARE *pb, index_t *out)
 	}
 
 	assert (pp_slice < MAX_PPINDEX );
-	
+
 	*out = pp_slice * (index_t)BLOCK_A + (index_t)wk * (index_t)BLOCK_B  + (index_t)bk * (index_t)BLOCK_C + (index_t)ba;
 
 	return TRUE;
@@ -5933,7 +6253,7 @@ test_kappk (void)
 	char 		str[] = "kappk";
 	SQUARE 		a, b, c, d, e;
 	SQUARE 		pw[MAXPC], pb[MAXPC];
-	SQUARE 		px[MAXPC], py[MAXPC];	
+	SQUARE 		px[MAXPC], py[MAXPC];
 
 	index_t		i, j;
 	bool_t 		err = FALSE;
@@ -5951,25 +6271,25 @@ test_kappk (void)
 			if (b <= H1 || b >= A8)
 				continue;
 
-			
+
 			pw[0] = a;
-			pw[1] = d;	
+			pw[1] = d;
 			pw[2] = b;
 			pw[3] = c;
 			pw[4] = NOSQUARE;
-		
+
 			pb[0] = e;
 			pb[1] = NOSQUARE;
-	
+
 			if (kappk_pctoindex (pw, pb, &i)) {
-							kappk_indextopc (i, px, py);		
+							kappk_indextopc (i, px, py);
 							kappk_pctoindex (px, py, &j);
 							if (i != j) {
 								err = TRUE;
 							}
-							assert (i == j);	
+							assert (i == j);
 			}
-	
+
 		}
 		}
 		}
@@ -5981,10 +6301,10 @@ test_kappk (void)
         }
 	}
 
-	if (err)		
-		printf ("> %s NOT passed\n", str);	
+	if (err)
+		printf ("> %s NOT passed\n", str);
 	else
-		printf ("> %s PASSED\n", str);	
+		printf ("> %s PASSED\n", str);
 	return !err;
 }
 
@@ -5994,33 +6314,33 @@ kappk_indextopc (index_t i, SQUARE *pw, SQUARE *pb)
 {
 	/*---------------------------------------------------------*
 		inverse work to make sure that the following is valid
-		index = a * BLOCK_A + b * BLOCK_B + c * BLOCK_C + d; 
+		index = a * BLOCK_A + b * BLOCK_B + c * BLOCK_C + d;
 	*----------------------------------------------------------*/
 
-	enum  {BLOCK_A = 64*64*64, BLOCK_B = 64*64, BLOCK_C = 64}; 
+	enum  {BLOCK_A = 64*64*64, BLOCK_B = 64*64, BLOCK_C = 64};
 	index_t a, b, c, d, r;
 	index_t m, n;
-	
+
 	r = i;
 	a  = r / BLOCK_A;
 	r -= a * BLOCK_A;
 	b  = r / BLOCK_B;
-	r -= b * BLOCK_B;	
+	r -= b * BLOCK_B;
 	c  = r / BLOCK_C;
-	r -= c * BLOCK_C;	
+	r -= c * BLOCK_C;
 	d  = r;
-	
+
 	m = pp_hi24 [a];
 	n = pp_lo48 [a];
-	
+
 	pw[0] = (SQUARE) b;
 	pw[1] = (SQUARE) d;
 	pw[2] = pidx24_to_wsq (m);
 	pw[3] = pidx48_to_wsq (n);
 	pw[4] = NOSQUARE;
 
-	pb[0] = (SQUARE) c;	
-	pb[1] = NOSQUARE;	
+	pb[0] = (SQUARE) c;
+	pb[1] = NOSQUARE;
 
 
 	assert (A2 <= pw[3] && pw[3] < A8);
@@ -6031,15 +6351,15 @@ kappk_indextopc (index_t i, SQUARE *pw, SQUARE *pb)
 }
 
 
-static bool_t 
+static bool_t
 kappk_pctoindex (const SQUARE *pw, const SQUARE *pb, index_t *out)
 {
-	enum  {BLOCK_A = 64*64*64, BLOCK_B = 64*64, BLOCK_C = 64}; 
+	enum  {BLOCK_A = 64*64*64, BLOCK_B = 64*64, BLOCK_C = 64};
 	index_t pp_slice;
 	SQUARE anchor, loosen;
-	
+
 	SQUARE wk     = pw[0];
-	SQUARE wa	  = pw[1];	
+	SQUARE wa	  = pw[1];
 	SQUARE pawn_a = pw[2];
 	SQUARE pawn_b = pw[3];
 	SQUARE bk     = pb[0];
@@ -6054,11 +6374,11 @@ kappk_pctoindex (const SQUARE *pw, const SQUARE *pb, index_t *out)
 	if ((anchor & 07) > 3) { /* column is more than 3. e.g. = e,f,g, or h */
 		anchor = flipWE (anchor);
 		loosen = flipWE (loosen);
-		wk     = flipWE (wk);		
-		bk     = flipWE (bk);		
-		wa	   = flipWE (wa);	
+		wk     = flipWE (wk);
+		bk     = flipWE (bk);
+		wa	   = flipWE (wa);
 	}
- 
+
 	i = wsq_to_pidx24 (anchor);
 	j = wsq_to_pidx48 (loosen);
 
@@ -6070,7 +6390,7 @@ kappk_pctoindex (const SQUARE *pw, const SQUARE *pb, index_t *out)
 	}
 
 	assert (pp_slice < MAX_PPINDEX );
-	
+
 	*out = pp_slice * (index_t)BLOCK_A + (index_t)wk * (index_t)BLOCK_B  + (index_t)bk * (index_t)BLOCK_C + (index_t)wa;
 
 	return TRUE;
@@ -6092,7 +6412,7 @@ test_kapkp (void)
 	char 		str[] = "kapkp";
 	SQUARE 		a, b, c, d, e;
 	SQUARE 		pw[MAXPC], pb[MAXPC];
-	SQUARE 		px[MAXPC], py[MAXPC];	
+	SQUARE 		px[MAXPC], py[MAXPC];
 
 	index_t		i, j;
 	bool_t 		err = FALSE;
@@ -6110,25 +6430,25 @@ test_kapkp (void)
 			if (b <= H1 || b >= A8)
 				continue;
 
-			
+
 			pw[0] = a;
-			pw[1] = d;	
+			pw[1] = d;
 			pw[2] = b;
 			pw[3] = NOSQUARE;
-		
+
 			pb[0] = e;
 			pb[1] = c;
 			pb[2] = NOSQUARE;
-	
+
 			if (kapkp_pctoindex (pw, pb, &i)) {
-							kapkp_indextopc (i, px, py);		
+							kapkp_indextopc (i, px, py);
 							kapkp_pctoindex (px, py, &j);
 							if (i != j) {
 								err = TRUE;
 							}
-							assert (i == j);	
+							assert (i == j);
 			}
-	
+
 		}
 		}
 		}
@@ -6140,21 +6460,21 @@ test_kapkp (void)
         }
 	}
 
-	if (err)		
-		printf ("> %s NOT passed\n", str);	
+	if (err)
+		printf ("> %s NOT passed\n", str);
 	else
-		printf ("> %s PASSED\n", str);	
+		printf ("> %s PASSED\n", str);
 	return !err;
 }
 
 
-static bool_t 
+static bool_t
 kapkp_pctoindex (const SQUARE *pw, const SQUARE *pb, index_t *out)
 {
-	enum  {BLOCK_A = 64*64*64, BLOCK_B = 64*64, BLOCK_C = 64}; 	
+	enum  {BLOCK_A = 64*64*64, BLOCK_B = 64*64, BLOCK_C = 64};
 	index_t pp_slice;
 	SQUARE anchor, loosen;
-	
+
 	SQUARE wk     = pw[0];
 	SQUARE wa	  = pw[1];
 	SQUARE pawn_a = pw[2];
@@ -6172,15 +6492,15 @@ kapkp_pctoindex (const SQUARE *pw, const SQUARE *pb, index_t *out)
 	if ((anchor & 07) > 3) { /* column is more than 3. e.g. = e,f,g, or h */
 		anchor = flipWE (anchor);
 		loosen = flipWE (loosen);
-		wk     = flipWE (wk);		
-		bk     = flipWE (bk);		
-		wa	   = flipWE (wa);		
+		wk     = flipWE (wk);
+		bk     = flipWE (bk);
+		wa	   = flipWE (wa);
 	}
- 
+
 	m = wsq_to_pidx24 (anchor);
 	n = (index_t)loosen - 8;
 
-	pp_slice = m * 48 + n; 
+	pp_slice = m * 48 + n;
 
 	if (IDX_is_empty(pp_slice)) {
 		*out = NOINDEX;
@@ -6188,7 +6508,7 @@ kapkp_pctoindex (const SQUARE *pw, const SQUARE *pb, index_t *out)
 	}
 
 	assert (pp_slice < (64*MAX_PpINDEX) );
-	
+
 	*out = pp_slice * (index_t)BLOCK_A + (index_t)wk * (index_t)BLOCK_B  + (index_t)bk * (index_t)BLOCK_C + (index_t)wa;
 
 	return TRUE;
@@ -6199,23 +6519,23 @@ kapkp_indextopc (index_t i, SQUARE *pw, SQUARE *pb)
 {
 	/*---------------------------------------------------------*
 		inverse work to make sure that the following is valid
-		index = a * BLOCK_A + b * BLOCK_B + c * BLOCK_C + d; 
+		index = a * BLOCK_A + b * BLOCK_B + c * BLOCK_C + d;
 	*----------------------------------------------------------*/
-	enum  {BLOCK_A = 64*64*64, BLOCK_B = 64*64, BLOCK_C = 64}; 
+	enum  {BLOCK_A = 64*64*64, BLOCK_B = 64*64, BLOCK_C = 64};
 	enum  {block_m = 48};
 	index_t a, b, c, d, r;
 	index_t m, n;
 	SQUARE sq_m, sq_n;
-	
+
 	r = i;
 	a  = r / BLOCK_A;
 	r -= a * BLOCK_A;
 	b  = r / BLOCK_B;
-	r -= b * BLOCK_B;	
+	r -= b * BLOCK_B;
 	c  = r / BLOCK_C;
-	r -= c * BLOCK_C;	
+	r -= c * BLOCK_C;
 	d  = r;
-	
+
 	/* unpack a, which is pslice, into m and n */
 	r = a;
 	m  = r / block_m;
@@ -6224,15 +6544,15 @@ kapkp_indextopc (index_t i, SQUARE *pw, SQUARE *pb)
 
 	sq_m = pidx24_to_wsq (m);
 	sq_n = (SQUARE) n + 8;
-	
+
 	pw[0] = (SQUARE) b;
-	pb[0] = (SQUARE) c;	
+	pb[0] = (SQUARE) c;
 	pw[1] = (SQUARE) d;
 	pw[2] = sq_m;
 	pb[1] = sq_n;
 	pw[3] = NOSQUARE;
-	pb[2] = NOSQUARE;	
-	
+	pb[2] = NOSQUARE;
+
 	assert (A2 <= sq_m && sq_m < A8);
 	assert (A2 <= sq_n && sq_n < A8);
 	assert (kapkp_pctoindex (pw, pb, &a) && a == i);
@@ -6256,7 +6576,7 @@ test_kabpk (void)
 	char 		str[] = "kabpk";
 	SQUARE 		a, b, c, d, e;
 	SQUARE 		pw[MAXPC], pb[MAXPC];
-	SQUARE 		px[MAXPC], py[MAXPC];	
+	SQUARE 		px[MAXPC], py[MAXPC];
 
 	index_t		i, j;
 	bool_t 		err = FALSE;
@@ -6271,25 +6591,25 @@ test_kabpk (void)
 
 			if (d <= H1 || d >= A8)
 				continue;
-		
+
 			pw[0] = a;
-			pw[1] = b;	
+			pw[1] = b;
 			pw[2] = c;
 			pw[3] = d;
 			pw[4] = NOSQUARE;
-		
+
 			pb[0] = e;
 			pb[1] = NOSQUARE;
-	
+
 			if (kabpk_pctoindex (pw, pb, &i)) {
-							kabpk_indextopc (i, px, py);		
+							kabpk_indextopc (i, px, py);
 							kabpk_pctoindex (px, py, &j);
 							if (i != j) {
 								err = TRUE;
 							}
-							assert (i == j);	
+							assert (i == j);
 			}
-	
+
 		}
 		}
 		}
@@ -6301,10 +6621,10 @@ test_kabpk (void)
         }
 	}
 
-	if (err)		
-		printf ("> %s NOT passed\n", str);	
+	if (err)
+		printf ("> %s NOT passed\n", str);
 	else
-		printf ("> %s PASSED\n", str);	
+		printf ("> %s PASSED\n", str);
 	return !err;
 }
 
@@ -6312,26 +6632,26 @@ test_kabpk (void)
 static void
 kabpk_indextopc (index_t i, SQUARE *pw, SQUARE *pb)
 {
-	
+
 	/*---------------------------------------------------------*
 		inverse work to make sure that the following is valid
-		index = a * BLOCK_A + b * BLOCK_B + c * BLOCK_C + d * BLOCK_D + e; 
+		index = a * BLOCK_A + b * BLOCK_B + c * BLOCK_C + d * BLOCK_D + e;
 	*----------------------------------------------------------*/
-	enum  {BLOCK_A = 64*64*64*64, BLOCK_B = 64*64*64, BLOCK_C = 64*64, BLOCK_D = 64}; 
+	enum  {BLOCK_A = 64*64*64*64, BLOCK_B = 64*64*64, BLOCK_C = 64*64, BLOCK_D = 64};
 	index_t a, b, c, d, e, r;
 	SQUARE x;
-	
+
 	r = i;
 	a  = r / BLOCK_A;
 	r -= a * BLOCK_A;
 	b  = r / BLOCK_B;
-	r -= b * BLOCK_B;	
+	r -= b * BLOCK_B;
 	c  = r / BLOCK_C;
-	r -= c * BLOCK_C;	
+	r -= c * BLOCK_C;
 	d  = r / BLOCK_D;
 	r -= d * BLOCK_D;
 	e  = r;
-	
+
 	x = pidx24_to_wsq(a);
 
 	pw[0] = (SQUARE) b;
@@ -6340,19 +6660,19 @@ kabpk_indextopc (index_t i, SQUARE *pw, SQUARE *pb)
 	pw[3] = x;
 	pw[4] = NOSQUARE;
 
-	pb[0] = (SQUARE) c;	
+	pb[0] = (SQUARE) c;
 	pb[1] = NOSQUARE;
-	
+
 	assert (kabpk_pctoindex (pw, pb, &a) && a == i);
 
 	return;
 }
 
 
-static bool_t 
+static bool_t
 kabpk_pctoindex (const SQUARE *pw, const SQUARE *pb, index_t *out)
 {
-	enum  {BLOCK_A = 64*64*64*64, BLOCK_B = 64*64*64, BLOCK_C = 64*64, BLOCK_D = 64}; 	
+	enum  {BLOCK_A = 64*64*64*64, BLOCK_B = 64*64*64, BLOCK_C = 64*64, BLOCK_D = 64};
 	index_t pslice;
 
 	SQUARE wk   = pw[0];
@@ -6362,13 +6682,13 @@ kabpk_pctoindex (const SQUARE *pw, const SQUARE *pb, index_t *out)
 	SQUARE bk   = pb[0];
 
 	assert (A2 <= pawn && pawn < A8);
-	
+
 	if ((pawn & 07) > 3) { /* column is more than 3. e.g. = e,f,g, or h */
 		pawn = flipWE (pawn);
-		wk   = flipWE (wk);		
-		bk   = flipWE (bk);		
+		wk   = flipWE (wk);
+		bk   = flipWE (bk);
 		wa   = flipWE (wa);
-		wb   = flipWE (wb);		
+		wb   = flipWE (wb);
 	}
 
 	pslice = wsq_to_pidx24 (pawn);
@@ -6394,7 +6714,7 @@ test_kaapk (void)
 	char 		str[] = "kaapk";
 	SQUARE 		a, b, c, d, e;
 	SQUARE 		pw[MAXPC], pb[MAXPC];
-	SQUARE 		px[MAXPC], py[MAXPC];	
+	SQUARE 		px[MAXPC], py[MAXPC];
 
 	index_t		i, j;
 	bool_t 		err = FALSE;
@@ -6409,25 +6729,25 @@ test_kaapk (void)
 
 			if (d <= H1 || d >= A8)
 				continue;
-		
+
 			pw[0] = a;
-			pw[1] = b;	
+			pw[1] = b;
 			pw[2] = c;
 			pw[3] = d;
 			pw[4] = NOSQUARE;
-		
+
 			pb[0] = e;
 			pb[1] = NOSQUARE;
-	
+
 			if (kaapk_pctoindex (pw, pb, &i)) {
-							kaapk_indextopc (i, px, py);		
+							kaapk_indextopc (i, px, py);
 							kaapk_pctoindex (px, py, &j);
 							if (i != j) {
 								err = TRUE;
 							}
-							assert (i == j);	
+							assert (i == j);
 			}
-	
+
 		}
 		}
 		}
@@ -6439,10 +6759,10 @@ test_kaapk (void)
         }
 	}
 
-	if (err)		
-		printf ("> %s NOT passed\n", str);	
+	if (err)
+		printf ("> %s NOT passed\n", str);
 	else
-		printf ("> %s PASSED\n", str);	
+		printf ("> %s PASSED\n", str);
 	return !err;
 }
 
@@ -6452,28 +6772,28 @@ kaapk_indextopc (index_t i, SQUARE *pw, SQUARE *pb)
 {
 	/*---------------------------------------------------------*
 		inverse work to make sure that the following is valid
-		index = a * BLOCK_A + b * BLOCK_B + c * BLOCK_C + d; 
+		index = a * BLOCK_A + b * BLOCK_B + c * BLOCK_C + d;
 	*----------------------------------------------------------*/
 	enum 	{BLOCK_C = MAX_AAINDEX
 			,BLOCK_B = 64*BLOCK_C
 			,BLOCK_A = 64*BLOCK_B
-	}; 	
+	};
 	index_t a, b, c, d, r;
 	index_t x, y, z;
-	
+
 	assert (i >= 0);
 
 	r = i;
 	a  = r / BLOCK_A;
 	r -= a * BLOCK_A;
 	b  = r / BLOCK_B;
-	r -= b * BLOCK_B;	
+	r -= b * BLOCK_B;
 	c  = r / BLOCK_C;
-	r -= c * BLOCK_C;	
+	r -= c * BLOCK_C;
 	d  = r;
 
 	z = (index_t) pidx24_to_wsq(a);
-	
+
 	/* split d into x, y*/
 	x = aabase [d];
 	y = (d + 1) + x - (x * (127-x)/2);
@@ -6487,23 +6807,23 @@ kaapk_indextopc (index_t i, SQUARE *pw, SQUARE *pb)
 	pw[2] = (SQUARE) y;
 	pw[3] = (SQUARE) z;
 	pw[4] = NOSQUARE;
-	
-	pb[0] = (SQUARE) c;	
+
+	pb[0] = (SQUARE) c;
 	pb[1] = NOSQUARE;
-	
+
 	assert (kaapk_pctoindex (pw, pb, &a) && a == i);
 
 	return;
 }
 
 
-static bool_t 
+static bool_t
 kaapk_pctoindex (const SQUARE *pw, const SQUARE *pb, index_t *out)
 {
 	enum 	{BLOCK_C = MAX_AAINDEX
 			,BLOCK_B = 64*BLOCK_C
 			,BLOCK_A = 64*BLOCK_B
-	}; 	
+	};
 	index_t aa_combo, pslice;
 
 	SQUARE wk   = pw[0];
@@ -6516,8 +6836,8 @@ kaapk_pctoindex (const SQUARE *pw, const SQUARE *pb, index_t *out)
 
 	if ((pawn & 07) > 3) { /* column is more than 3. e.g. = e,f,g, or h */
 		pawn = flipWE (pawn);
-		wk   = flipWE (wk);		
-		bk   = flipWE (bk);		
+		wk   = flipWE (wk);
+		bk   = flipWE (bk);
 		wa   = flipWE (wa);
 		wa2  = flipWE (wa2);
 	}
@@ -6529,7 +6849,7 @@ kaapk_pctoindex (const SQUARE *pw, const SQUARE *pb, index_t *out)
 	if (IDX_is_empty(aa_combo)) {
 		*out = NOINDEX;
 		return FALSE;
-	}	
+	}
 
 	*out = pslice * (index_t)BLOCK_A + (index_t)wk * (index_t)BLOCK_B  + (index_t)bk * (index_t)BLOCK_C + aa_combo;
 
@@ -6554,7 +6874,7 @@ test_kaakp (void)
 	char 		str[] = "kaakp";
 	SQUARE 		a, b, c, d, e;
 	SQUARE 		pw[MAXPC], pb[MAXPC];
-	SQUARE 		px[MAXPC], py[MAXPC];	
+	SQUARE 		px[MAXPC], py[MAXPC];
 
 	index_t		i, j;
 	bool_t 		err = FALSE;
@@ -6569,25 +6889,25 @@ test_kaakp (void)
 
 			if (d <= H1 || d >= A8)
 				continue;
-		
+
 			pw[0] = a;
-			pw[1] = b;	
+			pw[1] = b;
 			pw[2] = c;
 			pw[3] = NOSQUARE;
-		
+
 			pb[0] = e;
 			pb[1] = d;
 			pb[2] = NOSQUARE;
-	
+
 			if (kaakp_pctoindex (pw, pb, &i)) {
-							kaakp_indextopc (i, px, py);		
+							kaakp_indextopc (i, px, py);
 							kaakp_pctoindex (px, py, &j);
 							if (i != j) {
 								err = TRUE;
 							}
-							assert (i == j);	
+							assert (i == j);
 			}
-	
+
 		}
 		}
 		}
@@ -6599,10 +6919,10 @@ test_kaakp (void)
         }
 	}
 
-	if (err)		
-		printf ("> %s NOT passed\n", str);	
+	if (err)
+		printf ("> %s NOT passed\n", str);
 	else
-		printf ("> %s PASSED\n", str);	
+		printf ("> %s PASSED\n", str);
 	return !err;
 }
 
@@ -6612,15 +6932,15 @@ kaakp_indextopc (index_t i, SQUARE *pw, SQUARE *pb)
 {
 	/*---------------------------------------------------------*
 		inverse work to make sure that the following is valid
-		index = a * BLOCK_A + b * BLOCK_B + c * BLOCK_C + d; 
+		index = a * BLOCK_A + b * BLOCK_B + c * BLOCK_C + d;
 	*----------------------------------------------------------*/
 	enum 	{BLOCK_C = MAX_AAINDEX
 			,BLOCK_B = 64*BLOCK_C
 			,BLOCK_A = 64*BLOCK_B
-	}; 	
+	};
 	index_t a, b, c, d, r;
 	index_t x, y, z;
-	SQUARE zq;	
+	SQUARE zq;
 
 	assert (i >= 0);
 
@@ -6628,15 +6948,15 @@ kaakp_indextopc (index_t i, SQUARE *pw, SQUARE *pb)
 	a  = r / BLOCK_A;
 	r -= a * BLOCK_A;
 	b  = r / BLOCK_B;
-	r -= b * BLOCK_B;	
+	r -= b * BLOCK_B;
 	c  = r / BLOCK_C;
-	r -= c * BLOCK_C;	
+	r -= c * BLOCK_C;
 	d  = r;
 
-	zq = pidx24_to_wsq(a); 
+	zq = pidx24_to_wsq(a);
 	z  = (index_t)flipNS(zq);
 
-	
+
 	/* split d into x, y*/
 	x = aabase [d];
 	y = (d + 1) + x - (x * (127-x)/2);
@@ -6649,24 +6969,24 @@ kaakp_indextopc (index_t i, SQUARE *pw, SQUARE *pb)
 	pw[1] = (SQUARE)x;
 	pw[2] = (SQUARE)y;
 	pw[3] = NOSQUARE;
-	
-	pb[0] = (SQUARE)c;	
+
+	pb[0] = (SQUARE)c;
 	pb[1] = (SQUARE)z;
 	pb[2] = NOSQUARE;
-	
+
 	assert (kaakp_pctoindex (pw, pb, &a) && a == i);
 
 	return;
 }
 
 
-static bool_t 
+static bool_t
 kaakp_pctoindex (const SQUARE *pw, const SQUARE *pb, index_t *out)
 {
 	enum 	{BLOCK_C = MAX_AAINDEX
 			,BLOCK_B = 64*BLOCK_C
 			,BLOCK_A = 64*BLOCK_B
-	}; 	
+	};
 	index_t aa_combo, pslice;
 
 	SQUARE wk   = pw[0];
@@ -6679,8 +6999,8 @@ kaakp_pctoindex (const SQUARE *pw, const SQUARE *pb, index_t *out)
 
 	if ((pawn & 07) > 3) { /* column is more than 3. e.g. = e,f,g, or h */
 		pawn = flipWE (pawn);
-		wk   = flipWE (wk);		
-		bk   = flipWE (bk);		
+		wk   = flipWE (wk);
+		bk   = flipWE (bk);
 		wa   = flipWE (wa);
 		wa2  = flipWE (wa2);
 	}
@@ -6693,7 +7013,7 @@ kaakp_pctoindex (const SQUARE *pw, const SQUARE *pb, index_t *out)
 	if (IDX_is_empty(aa_combo)) {
 		*out = NOINDEX;
 		return FALSE;
-	}	
+	}
 
 	*out = pslice * (index_t)BLOCK_A + (index_t)wk * (index_t)BLOCK_B  + (index_t)bk * (index_t)BLOCK_C + aa_combo;
 
@@ -6708,7 +7028,7 @@ kaakp_pctoindex (const SQUARE *pw, const SQUARE *pb, index_t *out)
 /*
 index_t 	pp48_idx[48][48];
 sq_t		pp48_sq_x[MAX_PP48_INDEX];
-sq_t		pp48_sq_y[MAX_PP48_INDEX]; 
+sq_t		pp48_sq_y[MAX_PP48_INDEX];
 */
 static bool_t 	test_kppkp (void);
 static bool_t 	kppkp_pctoindex (const SQUARE *inp_pw, const SQUARE *inp_pb, index_t *out);
@@ -6732,12 +7052,12 @@ init_pp48_idx (void)
 			IDX_set_empty (pp48_idx [i][j]);
 		}
 	}
-		
+
 	for (idx = 0; idx < MAX_PP48_INDEX; idx++) {
-		pp48_sq_x [idx] = NOSQUARE;	
-		pp48_sq_y [idx] = NOSQUARE;			
-	}		
-		
+		pp48_sq_x [idx] = NOSQUARE;
+		pp48_sq_y [idx] = NOSQUARE;
+	}
+
 	idx = 0;
 	for (a = H7; a >= A2; a--) {
 
@@ -6745,16 +7065,16 @@ init_pp48_idx (void)
 
 			i = flipWE( flipNS (a) ) - 8;
 			j = flipWE( flipNS (b) ) - 8;
-			
+
 			if (IDX_is_empty(pp48_idx [i] [j])) {
 
 				pp48_idx  [i][j]= idx; 	assert (idx < MAX_PP48_INDEX);
 				pp48_idx  [j][i]= idx;
 				pp48_sq_x [idx] = i; 	assert (i < MAX_I);
-				pp48_sq_y [idx] = j; 	assert (j < MAX_J);		
+				pp48_sq_y [idx] = j; 	assert (j < MAX_J);
 				idx++;
 			}
-		}	
+		}
 	}
 	assert (idx == MAX_PP48_INDEX);
 	return idx;
@@ -6770,7 +7090,7 @@ test_kppkp (void)
 	char 		str[] = "kppkp";
 	SQUARE 		a, b, c, d, e;
 	SQUARE 		pw[MAXPC], pb[MAXPC];
-	SQUARE 		px[MAXPC], py[MAXPC];	
+	SQUARE 		px[MAXPC], py[MAXPC];
 
 	index_t		i, j;
 	bool_t 		err = FALSE;
@@ -6789,25 +7109,25 @@ test_kppkp (void)
 				continue;
 			if (d <= H1 || d >= A8)
 				continue;
-			
+
 			pw[0] = a;
-			pw[1] = b;	
+			pw[1] = b;
 			pw[2] = c;
 			pw[3] = NOSQUARE;
-		
+
 			pb[0] = e;
 			pb[1] = d;
 			pb[2] = NOSQUARE;
-	
+
 			if (kppkp_pctoindex (pw, pb, &i)) {
-							kppkp_indextopc (i, px, py);		
+							kppkp_indextopc (i, px, py);
 							kppkp_pctoindex (px, py, &j);
 							if (i != j) {
 								err = TRUE;
 							}
-							assert (i == j);	
+							assert (i == j);
 			}
-	
+
 		}
 		}
 		}
@@ -6819,10 +7139,10 @@ test_kppkp (void)
         }
 	}
 
-	if (err)		
-		printf ("> %s NOT passed\n", str);	
+	if (err)
+		printf ("> %s NOT passed\n", str);
 	else
-		printf ("> %s PASSED\n", str);	
+		printf ("> %s PASSED\n", str);
 	return !err;
 }
 
@@ -6832,33 +7152,33 @@ kppkp_indextopc (index_t i, SQUARE *pw, SQUARE *pb)
 {
 	/*---------------------------------------------------------*
 		inverse work to make sure that the following is valid
-		index = a * BLOCK_A + b * BLOCK_B + c * BLOCK_C + d; 
+		index = a * BLOCK_A + b * BLOCK_B + c * BLOCK_C + d;
 	*----------------------------------------------------------*/
 
-	enum  {BLOCK_A = MAX_PP48_INDEX*64*64, BLOCK_B = 64*64, BLOCK_C = 64}; 
+	enum  {BLOCK_A = MAX_PP48_INDEX*64*64, BLOCK_B = 64*64, BLOCK_C = 64};
 	index_t a, b, c, d, r;
 	SQUARE m, n;
-	
+
 	r = i;
 	a  = r / BLOCK_A;
 	r -= a * BLOCK_A;
 	b  = r / BLOCK_B;
-	r -= b * BLOCK_B;	
+	r -= b * BLOCK_B;
 	c  = r / BLOCK_C;
-	r -= c * BLOCK_C;	
+	r -= c * BLOCK_C;
 	d  = r;
-	
+
 	m = pp48_sq_x [b];
 	n = pp48_sq_y [b];
-	
+
 	pw[0] = (SQUARE)c;
 	pw[1] = flipWE(flipNS(m+8));
 	pw[2] = flipWE(flipNS(n+8));
 	pw[3] = NOSQUARE;
 
-	pb[0] = (SQUARE)d;	
+	pb[0] = (SQUARE)d;
 	pb[1] = (SQUARE)unmap24_b (a);
-	pb[2] = NOSQUARE;	
+	pb[2] = NOSQUARE;
 
 
 	assert (A2 <= pw[1] && pw[1] < A8);
@@ -6870,17 +7190,17 @@ kppkp_indextopc (index_t i, SQUARE *pw, SQUARE *pb)
 }
 
 
-static bool_t 
+static bool_t
 kppkp_pctoindex (const SQUARE *pw, const SQUARE *pb, index_t *out)
 {
-	enum  {BLOCK_A = MAX_PP48_INDEX*64*64, BLOCK_B = 64*64, BLOCK_C = 64}; 
-	index_t pp48_slice;	
-	
+	enum  {BLOCK_A = MAX_PP48_INDEX*64*64, BLOCK_B = 64*64, BLOCK_C = 64};
+	index_t pp48_slice;
+
 	SQUARE wk     = pw[0];
 	SQUARE pawn_a = pw[1];
 	SQUARE pawn_b = pw[2];
 	SQUARE bk     = pb[0];
-	SQUARE pawn_c = pb[1];	
+	SQUARE pawn_c = pb[1];
 	SQUARE i, j, k;
 
 	assert (A2 <= pawn_a && pawn_a < A8);
@@ -6888,13 +7208,13 @@ kppkp_pctoindex (const SQUARE *pw, const SQUARE *pb, index_t *out)
 	assert (A2 <= pawn_c && pawn_c < A8);
 
 	if ((pawn_c & 07) > 3) { /* column is more than 3. e.g. = e,f,g, or h */
-		wk     = flipWE (wk);		
+		wk     = flipWE (wk);
 		pawn_a = flipWE (pawn_a);
 		pawn_b = flipWE (pawn_b);
-		bk     = flipWE (bk);		
-		pawn_c = flipWE (pawn_c);	
+		bk     = flipWE (bk);
+		pawn_c = flipWE (pawn_c);
 	}
- 
+
 	i = flipWE( flipNS (pawn_a) ) - 8;
 	j = flipWE( flipNS (pawn_b) ) - 8;
 	k = map24_b (pawn_c); /* black pawn, so low indexes mean more advanced 0 == A2 */
@@ -6907,7 +7227,7 @@ kppkp_pctoindex (const SQUARE *pw, const SQUARE *pb, index_t *out)
 	}
 
 	assert (pp48_slice < MAX_PP48_INDEX );
-	
+
 	*out = (index_t)k * (index_t)BLOCK_A + pp48_slice * (index_t)BLOCK_B + (index_t)wk * (index_t)BLOCK_C  + (index_t)bk;
 
 	return TRUE;
@@ -6967,12 +7287,12 @@ init_ppp48_idx (void)
 			}
 		}
 	}
-		
+
 	for (idx = 0; idx < MAX_PPP48_INDEX; idx++) {
-		ppp48_sq_x [idx] = (uint8_t)NOSQUARE;	
-		ppp48_sq_y [idx] = (uint8_t)NOSQUARE;	
-		ppp48_sq_z [idx] = (uint8_t)NOSQUARE;		
-	}		
+		ppp48_sq_x [idx] = (uint8_t)NOSQUARE;
+		ppp48_sq_y [idx] = (uint8_t)NOSQUARE;
+		ppp48_sq_z [idx] = (uint8_t)NOSQUARE;
+	}
 
 	idx = 0;
 	for (x = 0; x < 48; x++) {
@@ -6982,29 +7302,29 @@ init_ppp48_idx (void)
 				a = itosq [x];
 				b = itosq [y];
 				c = itosq [z];
-		
-				if (!in_queenside(b) || !in_queenside(c))			
+
+				if (!in_queenside(b) || !in_queenside(c))
 						continue;
 
 				i = a - 8;
 				j = b - 8;
 				k = c - 8;
-				
+
 				if (IDX_is_empty(ppp48_idx [i] [j] [k])) {
 
-					ppp48_idx  [i][j][k] = idx; 	
+					ppp48_idx  [i][j][k] = idx;
 					ppp48_idx  [i][k][j] = idx;
 					ppp48_idx  [j][i][k] = idx;
 					ppp48_idx  [j][k][i] = idx;
 					ppp48_idx  [k][i][j] = idx;
 					ppp48_idx  [k][j][i] = idx;
 					ppp48_sq_x [idx] = (uint8_t) i; 	assert (i < MAX_I);
-					ppp48_sq_y [idx] = (uint8_t) j; 	assert (j < MAX_J);		
-					ppp48_sq_z [idx] = (uint8_t) k; 	assert (k < MAX_K);	
+					ppp48_sq_y [idx] = (uint8_t) j; 	assert (j < MAX_J);
+					ppp48_sq_z [idx] = (uint8_t) k; 	assert (k < MAX_K);
 					idx++;
 				}
 			}
-		}	
+		}
 	}
 
 /*	assert (idx == MAX_PPP48_INDEX);*/
@@ -7019,7 +7339,7 @@ test_kpppk (void)
 	char 		str[] = "kpppk";
 	SQUARE 		a, b, c, d, e;
 	SQUARE 		pw[MAXPC], pb[MAXPC];
-	SQUARE 		px[MAXPC], py[MAXPC];	
+	SQUARE 		px[MAXPC], py[MAXPC];
 
 	index_t		i, j;
 	bool_t 		err = FALSE;
@@ -7038,25 +7358,25 @@ test_kpppk (void)
 				continue;
 			if (d <= H1 || d >= A8)
 				continue;
-			
+
 			pw[0] = a;
-			pw[1] = b;	
+			pw[1] = b;
 			pw[2] = c;
 			pw[3] = d;
 			pw[4] = NOSQUARE;
-		
+
 			pb[0] = e;
 			pb[1] = NOSQUARE;
-	
+
 			if (kpppk_pctoindex (pw, pb, &i)) {
-							kpppk_indextopc (i, px, py);		
+							kpppk_indextopc (i, px, py);
 							kpppk_pctoindex (px, py, &j);
 							if (i != j) {
 								err = TRUE;
 							}
-							assert (i == j);	
+							assert (i == j);
 			}
-	
+
 		}
 		}
 		}
@@ -7068,10 +7388,10 @@ test_kpppk (void)
         }
 	}
 
-	if (err)		
-		printf ("> %s NOT passed\n", str);	
+	if (err)
+		printf ("> %s NOT passed\n", str);
 	else
-		printf ("> %s PASSED\n", str);	
+		printf ("> %s PASSED\n", str);
 	return !err;
 }
 
@@ -7081,33 +7401,33 @@ kpppk_indextopc (index_t i, SQUARE *pw, SQUARE *pb)
 {
 	/*---------------------------------------------------------*
 		inverse work to make sure that the following is valid
-		index = a * BLOCK_A + b * BLOCK_B + c * BLOCK_C + d; 
+		index = a * BLOCK_A + b * BLOCK_B + c * BLOCK_C + d;
 	*----------------------------------------------------------*/
 
-	enum  {BLOCK_A = 64*64, BLOCK_B = 64}; 
+	enum  {BLOCK_A = 64*64, BLOCK_B = 64};
 	index_t a, b, c, r;
 	SQUARE m, n, o;
-	
+
 	r  = i;
 	a  = r / BLOCK_A;
 	r -= a * BLOCK_A;
 	b  = r / BLOCK_B;
-	r -= b * BLOCK_B;	
+	r -= b * BLOCK_B;
 	c  = r;
-	
+
 	m = ppp48_sq_x [a];
 	n = ppp48_sq_y [a];
 	o = ppp48_sq_z [a];
 
-	
+
 	pw[0] = (SQUARE)b;
 	pw[1] = m + 8;
 	pw[2] = n + 8;
 	pw[3] = o + 8;
 	pw[4] = NOSQUARE;
 
-	pb[0] = (SQUARE)c;	
-	pb[1] = NOSQUARE;	
+	pb[0] = (SQUARE)c;
+	pb[1] = NOSQUARE;
 
 
 	assert (A2 <= pw[1] && pw[1] < A8);
@@ -7119,16 +7439,16 @@ kpppk_indextopc (index_t i, SQUARE *pw, SQUARE *pb)
 }
 
 
-static bool_t 
+static bool_t
 kpppk_pctoindex (const SQUARE *pw, const SQUARE *pb, index_t *out)
 {
-	enum  {BLOCK_A = 64*64, BLOCK_B = 64}; 
-	index_t ppp48_slice;	
-	
+	enum  {BLOCK_A = 64*64, BLOCK_B = 64};
+	index_t ppp48_slice;
+
 	SQUARE wk     = pw[0];
 	SQUARE pawn_a = pw[1];
 	SQUARE pawn_b = pw[2];
-	SQUARE pawn_c = pw[3];	
+	SQUARE pawn_c = pw[3];
 
 	SQUARE bk     = pb[0];
 
@@ -7144,12 +7464,12 @@ kpppk_pctoindex (const SQUARE *pw, const SQUARE *pb, index_t *out)
 
 	ppp48_slice = ppp48_idx [i] [j] [k];
 
-	if (IDX_is_empty(ppp48_slice)) { 
-		wk     = flipWE (wk);		
+	if (IDX_is_empty(ppp48_slice)) {
+		wk     = flipWE (wk);
 		pawn_a = flipWE (pawn_a);
 		pawn_b = flipWE (pawn_b);
 		pawn_c = flipWE (pawn_c);
-		bk     = flipWE (bk);		
+		bk     = flipWE (bk);
 	}
 
 	i = pawn_a - 8;
@@ -7157,14 +7477,14 @@ kpppk_pctoindex (const SQUARE *pw, const SQUARE *pb, index_t *out)
 	k = pawn_c - 8;
 
 	ppp48_slice = ppp48_idx [i] [j] [k];
- 
+
 	if (IDX_is_empty(ppp48_slice)) {
 		*out = NOINDEX;
 		return FALSE;
 	}
 
 	assert (ppp48_slice < MAX_PPP48_INDEX );
-	
+
 	*out = (index_t)ppp48_slice * BLOCK_A + (index_t)wk * BLOCK_B  + (index_t)bk;
 
 	return TRUE;
@@ -7174,13 +7494,13 @@ kpppk_pctoindex (const SQUARE *pw, const SQUARE *pb, index_t *out)
 /********************** end KPPP/K ************************************/
 
 
-static bool_t 
+static bool_t
 kpkp_pctoindex (const SQUARE *pw, const SQUARE *pb, index_t *out)
 {
-	enum  {BLOCK_A = 64*64, BLOCK_B = 64}; 	
-	SQUARE pp_slice;	
+	enum  {BLOCK_A = 64*64, BLOCK_B = 64};
+	SQUARE pp_slice;
 	SQUARE anchor, loosen;
-	
+
 	SQUARE wk     = pw[0];
 	SQUARE bk     = pb[0];
 	SQUARE pawn_a = pw[1];
@@ -7211,14 +7531,14 @@ kpkp_pctoindex (const SQUARE *pw, const SQUARE *pb, index_t *out)
 	if ((anchor & 07) > 3) { /* column is more than 3. e.g. = e,f,g, or h */
 		anchor = flipWE (anchor);
 		loosen = flipWE (loosen);
-		wk     = flipWE (wk);		
-		bk     = flipWE (bk);		
+		wk     = flipWE (wk);
+		bk     = flipWE (bk);
 	}
- 
+
 	m = (SQUARE)wsq_to_pidx24 (anchor);
 	n = loosen - 8;
 
-	pp_slice = m * 48 + n; 
+	pp_slice = m * 48 + n;
 
 	if (IDX_is_empty(pp_slice)) {
 		*out = NOINDEX;
@@ -7226,7 +7546,7 @@ kpkp_pctoindex (const SQUARE *pw, const SQUARE *pb, index_t *out)
 	}
 
 	assert (pp_slice < MAX_PpINDEX );
-	
+
 	*out = (index_t) (pp_slice * BLOCK_A + wk * BLOCK_B  + bk);
 
 	return TRUE;
@@ -7238,22 +7558,22 @@ kpkp_indextopc (index_t i, SQUARE *pw, SQUARE *pb)
 {
 	/*---------------------------------------------------------*
 		inverse work to make sure that the following is valid
-		index = a * BLOCK_A + b * BLOCK_B + c; 
+		index = a * BLOCK_A + b * BLOCK_B + c;
 	*----------------------------------------------------------*/
 	enum  {B11100  = 7u << 2};
-	enum  {BLOCK_A = 64*64, BLOCK_B = 64}; 
+	enum  {BLOCK_A = 64*64, BLOCK_B = 64};
 	enum  {block_m = 48};
 	index_t a, b, c, r;
 	index_t m, n;
 	SQUARE sq_m, sq_n;
-	
+
 	r = i;
 	a  = r / BLOCK_A;
 	r -= a * BLOCK_A;
 	b  = r / BLOCK_B;
-	r -= b * BLOCK_B;	
+	r -= b * BLOCK_B;
 	c  = r;
-	
+
 	/* unpack a, which is pslice, into m and n */
 	r = a;
 	m  = r / block_m;
@@ -7262,14 +7582,14 @@ kpkp_indextopc (index_t i, SQUARE *pw, SQUARE *pb)
 
 	sq_m  = pidx24_to_wsq (m);
 	sq_n  = (SQUARE)n + 8;
-	
+
 	pw[0] = (SQUARE)b;
-	pb[0] = (SQUARE)c;	
+	pb[0] = (SQUARE)c;
 	pw[1] = sq_m;
 	pb[1] = sq_n;
 	pw[2] = NOSQUARE;
-	pb[2] = NOSQUARE;	
-	
+	pb[2] = NOSQUARE;
+
 	assert (A2 <= pw[1] && pw[1] < A8);
 	assert (A2 <= pb[1] && pb[1] < A8);
 
@@ -7280,23 +7600,23 @@ kpkp_indextopc (index_t i, SQUARE *pw, SQUARE *pb)
 /****************************************************************************\
  *
  *
- *								DEBUG ZONE 
+ *								DEBUG ZONE
  *
  *
  ****************************************************************************/
 
-#if defined(DEBUG) 
+#if defined(DEBUG)
 static void
 print_pos (const sq_t *ws, const sq_t *bs, const pc_t *wp, const pc_t *bp)
 {
 	int i;
 	printf ("White: ");
 	for (i = 0; ws[i] != NOSQUARE; i++) {
-		printf ("%s%s ", P_str[wp[i]], Square_str[ws[i]]);	
+		printf ("%s%s ", P_str[wp[i]], Square_str[ws[i]]);
 	}
 	printf ("\nBlack: ");
 	for (i = 0; bs[i] != NOSQUARE; i++) {
-		printf ("%s%s ", P_str[bp[i]], Square_str[bs[i]]);	
+		printf ("%s%s ", P_str[bp[i]], Square_str[bs[i]]);
 	}
 	printf ("\n");
 }
@@ -7304,22 +7624,22 @@ print_pos (const sq_t *ws, const sq_t *bs, const pc_t *wp, const pc_t *bp)
 
 #if defined(DEBUG) || defined(FOLLOW_EGTB)
 static void
-output_state (unsigned stm, const SQUARE *wSQ, const SQUARE *bSQ, 
+output_state (unsigned stm, const SQUARE *wSQ, const SQUARE *bSQ,
 								const SQ_CONTENT *wPC, const SQ_CONTENT *bPC)
 {
 	int i;
 	assert (stm == WH || stm == BL);
-	
+
 	printf("\n%s to move\n", stm==WH?"White":"Black");
 	printf("W: ");
 	for (i = 0; wSQ[i] != NOSQUARE; i++) {
 		printf("%s%s ", P_str[wPC[i]], Square_str[wSQ[i]]);
-	} 				
+	}
 	printf("\n");
-	printf("B: ");	
+	printf("B: ");
 	for (i = 0; bSQ[i] != NOSQUARE; i++) {
 		printf("%s%s ", P_str[bPC[i]], Square_str[bSQ[i]]);
-	} 
+	}
 	printf("\n\n");
 }
 #endif
@@ -7328,17 +7648,17 @@ static void
 list_index (void)
 {
 	enum  {START_GTB = 0, END_GTB = (MAX_EGKEYS)};
-	int i; 
+	int i;
 	index_t accum = 0;
 	printf ("\nIndex for each GTB\n");
-		printf ("%3s: %7s  %7s   %7s   %7s\n" , "i", "TB", "RAM-slice", "RAM-max", "HD-cumulative");	
-	for (i = START_GTB; i < END_GTB; i++) { 
+		printf ("%3s: %7s  %7s   %7s   %7s\n" , "i", "TB", "RAM-slice", "RAM-max", "HD-cumulative");
+	for (i = START_GTB; i < END_GTB; i++) {
 		index_t indiv_k  = egkey[i].maxindex * (index_t)sizeof(dtm_t) * 2/1024;
 		accum += indiv_k;
-		printf ("%3d: %7s %8luk %8luk %8luM\n", i, egkey[i].str, (long unsigned)(indiv_k/egkey[i].slice_n), 
-													(long unsigned)indiv_k, (long unsigned)accum/1024/2);	
+		printf ("%3d: %7s %8luk %8luk %8luM\n", i, egkey[i].str, (long unsigned)(indiv_k/egkey[i].slice_n),
+													(long unsigned)indiv_k, (long unsigned)accum/1024/2);
 	}
-	printf ("\n");	
+	printf ("\n");
 	return;
 }
 
@@ -7358,8 +7678,8 @@ list_index (void)
 
 /*--------------------------------------------------------------------------*/
 static unsigned int		wdl_extract (unit_t *uarr, index_t x);
-static wdl_block_t *	wdl_point_block_to_replace (void);
-static void				wdl_movetotop (wdl_block_t *t);
+static wdl_block_t *	wdl_point_block_to_replace (struct WDL_CACHE *w);
+static void				wdl_movetotop (struct WDL_CACHE *w, wdl_block_t *t);
 
 #if 0
 static bool_t			wdl_cache_init (size_t cache_mem);
@@ -7371,10 +7691,10 @@ static bool_t			wdl_cache_is_on (void);
 static void				wdl_cache_reset_counters (void);
 static void				wdl_cache_done (void);
 
-static wdl_block_t *	wdl_point_block_to_replace (void);
-static bool_t			get_WDL_from_cache (tbkey_t key, unsigned side, index_t idx, unsigned int *out);
-static void				wdl_movetotop (wdl_block_t *t);
-static bool_t			wdl_preload_cache (tbkey_t key, unsigned side, index_t idx);
+static wdl_block_t *	wdl_point_block_to_replace (struct WDL_CACHE *w);
+static bool_t			get_WDL_from_cache (struct WDL_CACHE *w, tbkey_t key, unsigned side, index_t idx, unsigned int *out);
+static void				wdl_movetotop (struct WDL_CACHE *w, wdl_block_t *t);
+static bool_t			wdl_preload_cache (struct WDL_CACHE *w, tbkey_t key, unsigned side, index_t idx);
 
 /*--------------------------------------------------------------------------*/
 
@@ -7382,90 +7702,146 @@ static bool_t			wdl_preload_cache (tbkey_t key, unsigned side, index_t idx);
 |			WDL CACHE Maintainance
 \*---------------------------------------------------------------------*/
 
+static void wdl_shard_done (struct WDL_CACHE *w);
 
 static size_t
-wdl_cache_init (size_t cache_mem)
+wdl_shard_init (struct WDL_CACHE *w, size_t max_blocks)
 {
 	unsigned int 	i;
 	wdl_block_t 	*p;
-	size_t 			entries_per_block;
+	size_t 			entries_per_block = GTB_ENTRIES_PER_BLOCK;
+	size_t 			cache_mem = max_blocks * WDL_units_per_block * sizeof(unit_t);
+
+	w->entries_per_block = entries_per_block;
+	w->max_blocks 		= max_blocks;
+	w->cached 			= TRUE;
+	w->top 				= NULL;
+	w->bot 				= NULL;
+	w->n 				= 0;
+
+	if (0 == cache_mem || NULL == (w->buffer = (unit_t *) malloc (cache_mem))) {
+		w->cached = FALSE;
+		return 0;
+	}
+
+	if (0 == max_blocks|| NULL == (w->blocks = (wdl_block_t *) malloc (max_blocks * sizeof(wdl_block_t)))) {
+		w->cached = FALSE;
+		free (w->buffer);
+		return 0;
+	}
+
+	for (i = 0; i < max_blocks; i++) {
+		p = &w->blocks[i];
+		p->key  	= -1;
+		p->side 	= gtbNOSIDE;
+		p->offset 	= gtbNOINDEX;
+		p->p_arr 	= w->buffer + i * WDL_units_per_block;
+		p->prev 	= NULL;
+		p->next 	= NULL;
+	}
+
+	w->ht_size = 1;
+	while (w->ht_size < max_blocks * 4)
+		w->ht_size *= 2;
+	w->ht_used = 0;
+	w->hash_table = (wdl_block_t**) malloc (w->ht_size * sizeof(wdl_block_t*));;
+	if (w->hash_table == NULL) {
+		w->cached = FALSE;
+		free (w->blocks);
+		w->blocks = NULL;
+		free (w->buffer);
+		w->buffer = NULL;
+		return 0;
+	}
+
+	for (i = 0; i < w->ht_size; i++) {
+		w->hash_table[i] = NULL;
+	}
+
+	return cache_mem;
+}
+
+static size_t
+wdl_cache_init (size_t cache_mem)
+{
+	size_t 			i;
 	size_t 			max_blocks;
 	size_t 			block_mem;
+	size_t 			allocated;
 
 	if (WDL_CACHE_INITIALIZED)
 		wdl_cache_done();
 
-	entries_per_block 	= 16 * 1024;  /* fixed, needed for the compression schemes */
-
-	WDL_units_per_block	= entries_per_block / WDL_entries_per_unit;
+	WDL_units_per_block	= GTB_ENTRIES_PER_BLOCK / WDL_entries_per_unit;
 	block_mem			= WDL_units_per_block * sizeof(unit_t);
 
 	max_blocks 			= cache_mem / block_mem;
-	cache_mem 			= max_blocks * block_mem;
-
 
 	wdl_cache_reset_counters ();
 
-	wdl_cache.entries_per_block = entries_per_block;
-	wdl_cache.max_blocks 		= max_blocks;
-	wdl_cache.cached 			= TRUE;
-	wdl_cache.top 				= NULL;
-	wdl_cache.bot 				= NULL;
-	wdl_cache.n 				= 0;
-
-	if (0 == cache_mem || NULL == (wdl_cache.buffer = (unit_t *) malloc (cache_mem))) {
-		wdl_cache.cached = FALSE;
-		return 0;
-	}
-
-	if (0 == max_blocks|| NULL == (wdl_cache.blocks = (wdl_block_t *) malloc (max_blocks * sizeof(wdl_block_t)))) {
-		wdl_cache.cached = FALSE;
-		free (wdl_cache.buffer);
-		return 0;
-	}
-	
-	for (i = 0; i < max_blocks; i++) {
-		p = &wdl_cache.blocks[i];
-		p->key  	= -1;
-		p->side 	= gtbNOSIDE;
-		p->offset 	= gtbNOINDEX;
-		p->p_arr 	= wdl_cache.buffer + i * WDL_units_per_block;
-		p->prev 	= NULL;
-		p->next 	= NULL;
+	WDL_shards = cache_shards (max_blocks);
+
+	for (i = 0, allocated = 0; i < WDL_shards; i++) {
+		size_t blocks = max_blocks / WDL_shards + (i < max_blocks % WDL_shards ? 1 : 0);
+		size_t mem = wdl_shard_init (&wdl_cache[i], blocks);
+		if (0 == mem) {
+			/* all shards on or none */
+			for (; i > 0; i--)
+				wdl_shard_done (&wdl_cache[i-1]);
+			WDL_shards = 0;
+			return 0;
+		}
+		allocated += mem;
 	}
 
 	WDL_CACHE_INITIALIZED = TRUE;
 
-	return cache_mem;
+	return allocated;
 }
 
 
 static void
-wdl_cache_done (void)
-{
-	assert(WDL_CACHE_INITIALIZED);
+wdl_shard_done (struct WDL_CACHE *w)
+{
+	w->cached = FALSE;
+	w->hard = 0;
+	w->soft = 0;
+	w->hardmisses = 0;
+	w->hits = 0;
+	w->softmisses = 0;
+	w->comparisons = 0;
+	w->max_blocks = 0;
+	w->entries_per_block = 0;
+
+	w->top = NULL;
+	w->bot = NULL;
+	w->n = 0;
+
+	if (w->buffer != NULL)
+		free (w->buffer);
+	w->buffer = NULL;
+
+	if (w->blocks != NULL)
+		free (w->blocks);
+	w->blocks = NULL;
+
+	if (w->hash_table != NULL)
+		free (w->hash_table);
+	w->hash_table = NULL;
 
-	wdl_cache.cached = FALSE;
-	wdl_cache.hard = 0;
-	wdl_cache.soft = 0;
-	wdl_cache.hardmisses = 0;
-	wdl_cache.hits = 0;
-	wdl_cache.softmisses = 0;
-	wdl_cache.comparisons = 0;
-	wdl_cache.max_blocks = 0;
-	wdl_cache.entries_per_block = 0;
+	return;
+}
 
-	wdl_cache.top = NULL;
-	wdl_cache.bot = NULL;
-	wdl_cache.n = 0;
+static void
+wdl_cache_done (void)
+{
+	size_t i;
 
-	if (wdl_cache.buffer != NULL)
-		free (wdl_cache.buffer);
-	wdl_cache.buffer = NULL;
+	assert(WDL_CACHE_INITIALIZED);
 
-	if (wdl_cache.blocks != NULL)
-		free (wdl_cache.blocks);
-	wdl_cache.blocks = NULL;
+	for (i = 0; i < WDL_shards; i++)
+		wdl_shard_done (&wdl_cache[i]);
+	WDL_shards = 0;
 
 	WDL_CACHE_INITIALIZED = FALSE;
 	return;
@@ -7476,22 +7852,27 @@ static void
 wdl_cache_flush (void)
 {
 	unsigned int 	i;
+	size_t			k;
 	wdl_block_t 	*p;
-	size_t max_blocks = wdl_cache.max_blocks;
+	struct WDL_CACHE *w;
 
-	wdl_cache.top 				= NULL;
-	wdl_cache.bot 				= NULL;
-	wdl_cache.n 				= 0;
-	
-	for (i = 0; i < max_blocks; i++) {
-		p = &wdl_cache.blocks[i];
+	for (k = 0; k < WDL_shards; k++) {
+	w = &wdl_cache[k];
+
+	w->top 				= NULL;
+	w->bot 				= NULL;
+	w->n 				= 0;
+
+	for (i = 0; i < w->max_blocks; i++) {
+		p = &w->blocks[i];
 		p->key  	= -1;
 		p->side 	= gtbNOSIDE;
 		p->offset 	= gtbNOINDEX;
-		p->p_arr 	= wdl_cache.buffer + i * WDL_units_per_block;
+		p->p_arr 	= w->buffer + i * WDL_units_per_block;
 		p->prev 	= NULL;
 		p->next 	= NULL;
 	}
+	}
 
 	wdl_cache_reset_counters  ();
 
@@ -7502,12 +7883,19 @@ wdl_cache_flush (void)
 static void
 wdl_cache_reset_counters (void)
 {
-	wdl_cache.hard = 0;
-	wdl_cache.soft = 0;
-	wdl_cache.hardmisses = 0;
-	wdl_cache.hits = 0;
-	wdl_cache.softmisses = 0;
-	wdl_cache.comparisons = 0;
+	size_t i;
+	struct WDL_CACHE *w;
+
+	for (i = 0; i < GTB_CACHE_SHARDS; i++) {
+		w = &wdl_cache[i];
+		w->hard = 0;
+		w->soft = 0;
+		w->hardmisses = 0;
+		w->hits = 0;
+		w->softmisses = 0;
+		w->comparisons = 0;
+		w->waits = 0;
+	}
 	return;
 }
 
@@ -7515,7 +7903,7 @@ wdl_cache_reset_counters (void)
 static bool_t
 wdl_cache_is_on (void)
 {
-	return wdl_cache.cached;
+	return WDL_shards > 0 && wdl_cache[0].cached;
 }
 
 /****************************************************************************\
@@ -7523,56 +7911,56 @@ wdl_cache_is_on (void)
 \****************************************************************************/
 
 static wdl_block_t *
-wdl_point_block_to_replace (void)
+wdl_point_block_to_replace (struct WDL_CACHE *w)
 {
 	wdl_block_t *p, *t, *s;
 
-	assert (0 == wdl_cache.n || wdl_cache.top != NULL);
-	assert (0 == wdl_cache.n || wdl_cache.bot != NULL);
-	assert (0 == wdl_cache.n || wdl_cache.bot->prev == NULL);
-	assert (0 == wdl_cache.n || wdl_cache.top->next == NULL);
+	assert (0 == w->n || w->top != NULL);
+	assert (0 == w->n || w->bot != NULL);
+	assert (0 == w->n || w->bot->prev == NULL);
+	assert (0 == w->n || w->top->next == NULL);
 
-	if (wdl_cache.n > 0 && -1 == wdl_cache.top->key) {
+	if (w->n > 0 && -1 == w->top->key) {
 
 		/* top blocks is unusable, should be the one to replace*/
-		p = wdl_cache.top;
+		p = w->top;
 
 	} else
-	if (wdl_cache.n == 0) {
-		
-		p = &wdl_cache.blocks[wdl_cache.n++];
-		wdl_cache.top = p;
-		wdl_cache.bot = p;
-	
+	if (w->n == 0) {
+
+		p = &w->blocks[w->n++];
+		w->top = p;
+		w->bot = p;
+
 		p->prev = NULL;
 		p->next = NULL;
 
 	} else
-	if (wdl_cache.n < wdl_cache.max_blocks) { /* add */
+	if (w->n < w->max_blocks) { /* add */
+
+		s = w->top;
+		p = &w->blocks[w->n++];
+		w->top = p;
 
-		s = wdl_cache.top;
-		p = &wdl_cache.blocks[wdl_cache.n++];
-		wdl_cache.top = p;
-	
 		s->next = p;
 		p->prev = s;
 		p->next = NULL;
 
-	} else {                       /* replace*/ 
-		
-		t = wdl_cache.bot;
-		s = wdl_cache.top;
-		wdl_cache.bot = t->next;
-		wdl_cache.top = t;
-		
+	} else {                       /* replace*/
+
+		t = w->bot;
+		s = w->top;
+		w->bot = t->next;
+		w->top = t;
+
 		s->next = t;
 		t->prev = s;
-		wdl_cache.top->next = NULL;
-		wdl_cache.bot->prev = NULL;
+		w->top->next = NULL;
+		w->bot->prev = NULL;
 
 		p = t;
 	}
-	
+
 	/* make the information content unusable, it will be replaced */
 	p->key    = -1;
 	p->side   = gtbNOSIDE;
@@ -7588,75 +7976,146 @@ wdl_point_block_to_replace (void)
 \****************************************************************************/
 
 static unsigned int	wdl_extract (unit_t *uarr, index_t x);
-static bool_t		get_WDL_from_cache (tbkey_t key, unsigned side, index_t idx, unsigned int *info_out);
-static unsigned 	dtm2WDL(dtm_t dtm);	
-static void			wdl_movetotop (wdl_block_t *t);
-static bool_t		wdl_preload_cache (tbkey_t key, unsigned side, index_t idx);
-static void			dtm_block_2_wdl_block(dtm_block_t *g, wdl_block_t *w, size_t n);	
+static bool_t		get_WDL_from_cache (struct WDL_CACHE *w, tbkey_t key, unsigned side, index_t idx, unsigned int *info_out);
+static unsigned 	dtm2WDL(dtm_t dtm);
+static void			wdl_movetotop (struct WDL_CACHE *w, wdl_block_t *t);
+static bool_t		wdl_preload_cache (struct WDL_CACHE *w, tbkey_t key, unsigned side, index_t idx);
+static void			dtm_block_2_wdl_block(const dtm_t *s, unit_t *d, size_t n);
 
 static bool_t
 get_WDL (tbkey_t key, unsigned side, index_t idx, unsigned int *info_out, bool_t probe_hard_flag)
 {
+	struct WDL_CACHE *w;
 	dtm_t dtm;
 	bool_t found;
 
-	found = get_WDL_from_cache (key, side, idx, info_out);
+	if (!wdl_cache_is_on()) {
+		found = get_dtm (key, side, idx, &dtm, probe_hard_flag);
+		if (found)
+			*info_out = dtm2WDL(dtm);
+		return found;
+	}
+
+	w = wdl_shard (key, side, idx);
+
+	counted_lock (&w->lock, &w->waits);
+
+	found = get_WDL_from_cache (w, key, side, idx, info_out);
 
 	if (found) {
-		wdl_cache.hits++;
+		w->hits++;
+	}
+	if (probe_hard_flag) {
+		w->hard++;
 	} else {
+		w->soft++;
+	}
+
+	mythread_mutex_unlock (&w->lock);
+
+	if (!found) {
 		/* may probe soft */
 		found = get_dtm (key, side, idx, &dtm, probe_hard_flag);
 		if (found) {
-			*info_out = dtm2WDL(dtm);			
+			*info_out = dtm2WDL(dtm);
 			/* move cache info from dtm_cache to WDL_cache */
-			if (wdl_cache_is_on())
-				wdl_preload_cache (key, side, idx);
-		} 
-	}
-
-	if (probe_hard_flag) {
-		wdl_cache.hard++;
-		if (!found) {
-			wdl_cache.hardmisses++;
-		}
-	} else {
-		wdl_cache.soft++;
-		if (!found) {
-			wdl_cache.softmisses++;
+			wdl_preload_cache (w, key, side, idx);
+		} else {
+			counted_lock (&w->lock, &w->waits);
+			if (probe_hard_flag) {
+				w->hardmisses++;
+			} else {
+				w->softmisses++;
+			}
+			mythread_mutex_unlock (&w->lock);
 		}
 	}
 
 	return found;
 }
 
-static bool_t
-get_WDL_from_cache (tbkey_t key, unsigned side, index_t idx, unsigned int *out)
+static void wdl_hash_insert (struct WDL_CACHE *w, wdl_block_t * e);
+
+static void
+wdl_hash_rebuild (struct WDL_CACHE *w)
+{
+	wdl_block_t	* p;
+	size_t i;
+
+	for (i = 0; i < w->ht_size; i++)
+		w->hash_table[i] = NULL;
+	w->ht_used = 0;
+
+	for (p = w->top; p != NULL; p = p->prev)
+		wdl_hash_insert (w, p);
+}
+
+static void
+wdl_hash_insert (struct WDL_CACHE *w, wdl_block_t * e)
+{
+	size_t h1, h2;
+
+	if (w->ht_used + 1 > w->ht_size * 3 / 4) /* keep an empty slot to end lookups */
+		wdl_hash_rebuild (w);
+
+    h1 = hash_func_1 (e->key, e->side, e->offset) & (w->ht_size - 1);
+    h2 = hash_func_2 (e->key, e->side, e->offset);
+    while (w->hash_table[h1])
+        h1 = (h1 + h2) & (w->ht_size - 1);
+    w->hash_table[h1] = e;
+    w->ht_used++;
+}
+
+static wdl_block_t *
+wdl_cache_pointblock (struct WDL_CACHE *w, tbkey_t key, unsigned side, index_t idx)
 {
 	index_t 	offset;
 	index_t		remainder;
 	wdl_block_t	*p;
 	wdl_block_t	*ret;
+	size_t		h1, h2;
 
-	if (!wdl_cache_is_on())
-		return FALSE;
-
-	split_index (wdl_cache.entries_per_block, idx, &offset, &remainder); 
+	split_index (w->entries_per_block, idx, &offset, &remainder);
 
 	ret = NULL;
-	for (p = wdl_cache.top; p != NULL; p = p->prev) {
 
-		wdl_cache.comparisons++;
+	h1 = hash_func_1 (key, side, offset) & (w->ht_size - 1);
+	h2 = hash_func_2 (key, side, offset);
+	while (1) {
+		p = w->hash_table[h1];
+		if (!p)
+			break;
+
+		w->comparisons++;
 
 		if (key == p->key && side == p->side && offset  == p->offset) {
 			ret = p;
 			break;
 		}
+
+		h1 = (h1 + h2) & (w->ht_size - 1);
 	}
 
+	return ret;
+}
+
+static bool_t
+get_WDL_from_cache (struct WDL_CACHE *w, tbkey_t key, unsigned side, index_t idx, unsigned int *out)
+{
+	index_t 	offset;
+	index_t		remainder;
+	wdl_block_t	*ret;
+
+	if (!wdl_cache_is_on())
+		return FALSE;
+
+	split_index (w->entries_per_block, idx, &offset, &remainder);
+
+	ret = wdl_cache_pointblock (w, key, side, idx);
+
 	if (ret != NULL) {
-		*out = wdl_extract (ret->p_arr, remainder); 
-		wdl_movetotop(ret);
+		*out = wdl_extract (ret->p_arr, remainder);
+		wdl_movetotop (w, ret);
 	}
 
 	FOLLOW_LU("get_wdl_from_cache ok?",(ret != NULL))
@@ -7674,7 +8133,7 @@ wdl_extract (unit_t *uarr, index_t x)
 }
 
 static void
-wdl_movetotop (wdl_block_t *t)
+wdl_movetotop (struct WDL_CACHE *w, wdl_block_t *t)
 {
 	wdl_block_t *s, *nx, *pv;
 
@@ -7688,26 +8147,26 @@ wdl_movetotop (wdl_block_t *t)
 	nx = t->next;
 
 	if (pv == NULL)  /* at the bottom */
-		wdl_cache.bot = nx;
-	else 
+		w->bot = nx;
+	else
 		pv->next = nx;
 
 	if (nx == NULL) /* at the top */
-		wdl_cache.top = pv;
+		w->top = pv;
 	else
 		nx->prev = pv;
 
 	/* relocate */
-	s = wdl_cache.top;
+	s = w->top;
 	assert (s != NULL);
 	if (s == NULL)
-		wdl_cache.bot = t;	
+		w->bot = t;
 	else
 		s->next = t;
 
 	t->next = NULL;
 	t->prev = s;
-	wdl_cache.top = t;
+	w->top = t;
 
 	return;
 }
@@ -7715,73 +8174,76 @@ wdl_movetotop (wdl_block_t *t)
 /****************************************************************************************************/
 
 static bool_t
-wdl_preload_cache (tbkey_t key, unsigned side, index_t idx)
-/* output to the least used block of the cache */
+wdl_preload_cache (struct WDL_CACHE *w, tbkey_t key, unsigned side, index_t idx)
+/* output to the least used block of the shard */
 {
+	struct cache_table *c;
 	dtm_block_t		*dtm_block;
 	wdl_block_t 	*to_modify;
-	bool_t 			ok;
+	index_t 		offset;
+	index_t			remainder;
+	unit_t			units [GTB_ENTRIES_PER_BLOCK / WDL_entries_per_unit];
 
 	FOLLOW_label("wdl preload_cache starts")
 
 	if (idx >= egkey[key].maxindex) {
-		FOLLOW_LULU("Wrong index", __LINE__, idx)	
+		FOLLOW_LULU("Wrong index", __LINE__, idx)
 		return FALSE;
 	}
 
-	/* find fresh block in dtm cache */
-	dtm_block = dtm_cache_pointblock (key, side, idx); 
+	/* find fresh block in dtm cache and transform it */
+	c = dtm_shard (key, side, idx);
+	counted_lock (&c->lock, &c->waits);
+	dtm_block = dtm_cache_pointblock (c, key, side, idx);
+	if (NULL != dtm_block)
+		dtm_block_2_wdl_block (dtm_block->p_arr, units, c->entries_per_block);
+	mythread_mutex_unlock (&c->lock);
 
-	/* find aged blocked in wdl cache */
-	to_modify = wdl_point_block_to_replace ();
+	if (NULL == dtm_block)
+		return FALSE;
 
-	ok = !(NULL == dtm_block || NULL == to_modify);
+	split_index (w->entries_per_block, idx, &offset, &remainder);
 
-	if (!ok)
-		return FALSE;
-	
-	/* transform and move a block */
-	dtm_block_2_wdl_block(dtm_block, to_modify, dtm_cache.entries_per_block);	
+	counted_lock (&w->lock, &w->waits);
 
-	if (ok) {
-		index_t 		offset;
-		index_t			remainder;
-		split_index (wdl_cache.entries_per_block, idx, &offset, &remainder); 
+	/* may have been stored by another thread in the meantime */
+	if (NULL == wdl_cache_pointblock (w, key, side, idx)) {
+
+		/* find aged blocked in wdl cache */
+		to_modify = wdl_point_block_to_replace (w);
+
+		memcpy (to_modify->p_arr, units, WDL_units_per_block * sizeof(unit_t));
 
 		to_modify->key    = key;
 		to_modify->side   = side;
 		to_modify->offset = offset;
-	} else {
-		/* make it unusable */
-		to_modify->key    = -1;
-		to_modify->side   = gtbNOSIDE;
-		to_modify->offset = gtbNOINDEX;
+		wdl_hash_insert (w, to_modify);
 	}
 
-	FOLLOW_LU("wdl preload_cache?", ok)
+	mythread_mutex_unlock (&w->lock);
 
-	return ok;		
+	FOLLOW_LU("wdl preload_cache?", TRUE)
+
+	return TRUE;
 }
 
 /****************************************************************************************************/
 
-static void			
-dtm_block_2_wdl_block(dtm_block_t *g, wdl_block_t *w, size_t n)
+static void
+dtm_block_2_wdl_block(const dtm_t *s, unit_t *d, size_t n)
 {
 	int width = 2;
 	int shifting;
 	size_t i;
 	int j;
 	unsigned int x ,y;
-	 dtm_t *s = g->p_arr;
-	unit_t *d = w->p_arr;
 
 	for (i = 0, y = 0; i < n; i++) {
 		j =  i & 3; /* modulo WDL_entries_per_unit */
 		x = dtm2WDL(s[i]);
 		shifting = j * width;
-		y |= (x << shifting);		
-		
+		y |= (x << shifting);
+
 		if (j == 3) {
 			d[i/WDL_entries_per_unit] = (unit_t) y;
 			y = 0;
@@ -7794,13 +8256,13 @@ dtm_block_2_wdl_block(dtm_block_t *g, wdl_block_t *w, size_t n)
 	}
 
 	return;
-}	
+}
 
-static unsigned 	
+static unsigned
 dtm2WDL(dtm_t dtm)
 {
 	return (unsigned) dtm & 3;
-}	
+}
 
 
 /**************************/
@@ -7811,10 +8273,10 @@ static bool_t	egtb_get_wdl (tbkey_t k, unsigned stm, const SQUARE *wS, const SQU
 
 static bool_t
 tb_probe_wdl
-			(unsigned stm, 
-			 const SQUARE *inp_wSQ, 
+			(unsigned stm,
+			 const SQUARE *inp_wSQ,
 			 const SQUARE *inp_bSQ,
-			 const SQ_CONTENT *inp_wPC, 
+			 const SQ_CONTENT *inp_wPC,
 			 const SQ_CONTENT *inp_bPC,
 			 bool_t probingtype,
 			 /*@out@*/ unsigned *res)
@@ -7834,7 +8296,7 @@ tb_probe_wdl
 
 	SQUARE *temps;
 	bool_t straight = FALSE;
-	
+
 	bool_t  okcall  = TRUE;
 	unsigned ply_;
 	unsigned *ply = &ply_;
@@ -7850,7 +8312,7 @@ tb_probe_wdl
 		*res = b? iDRAW: iFORBID;
 		*ply = 0;
 		return TRUE;
-	} 
+	}
 
 	/* copy input */
 	list_pc_copy (inp_wPC, wp);
@@ -7880,7 +8342,7 @@ tb_probe_wdl
 	} else {
 		#if defined(DEBUG)
 		printf("did not get id...\n");
-		output_state (stm, ws, bs, wp, bp);		
+		output_state (stm, ws, bs, wp, bp);
 		#endif
 		unpackdist (iFORBID, res, ply);
 		return FALSE;
@@ -7919,13 +8381,13 @@ tb_probe_wdl
 			*res = wdl;
 		} else {
 			*res = inv_wdl (wdl);
-		}	 
+		}
 	} else {
 			unpackdist (iFORBID, res, ply);
 	}
 
 	return okcall;
-} 
+}
 
 static unsigned int
 inv_wdl(unsigned w)
@@ -7980,34 +8442,27 @@ egtb_get_wdl (tbkey_t k, unsigned stm, const SQUARE *wS, const SQUARE *bS, bool_
 		if (idxavail) {
 			bool_t success;
 
-			/* 
-			|		LOCK 
-			*-------------------------------*/
-			mythread_mutex_lock (&Egtb_lock);	
-
+			/* locks the cache shards and the files as needed */
 			success = get_WDL (k, stm, idx, wdl, probe_hard_flag);
 			FOLLOW_LU("get_wld (succ)",success)
 			FOLLOW_LU("get_wld (wdl )",*wdl)
 
 			/* this may not be needed */
-			if (!success) {		
+			if (!success) {
 				dtm_t dtm;
 				unsigned res, ply;
 				if (probe_hard_flag && Uncompressed) {
 					assert(Uncompressed);
+					counted_lock (&Egtb_lock, &Drive.waits);
 					success = egtb_filepeek (k, stm, idx, &dtm);
-					unpackdist (dtm, &res, &ply);			
-					*wdl = res;		
+					mythread_mutex_unlock (&Egtb_lock);
+					unpackdist (dtm, &res, &ply);
+					*wdl = res;
 				}
 				else
 					success = FALSE;
 			}
 
-			mythread_mutex_unlock (&Egtb_lock);	
-			/*------------------------------*\ 
-			|		UNLOCK 
-			*/
-
 			if (success) {
 				return TRUE;
 			} else {
@@ -8030,9 +8485,9 @@ egtb_get_wdl (tbkey_t k, unsigned stm, const SQUARE *wS, const SQUARE *bS, bool_
 		assert(0);
 		*wdl = dtm2WDL(iFORBID);
 		return 	FALSE;
-	} 
+	}
 
-} 
+}
 #endif
 
 
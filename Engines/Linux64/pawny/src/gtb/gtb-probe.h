@@ -211,6 +211,10 @@ struct TB_STATS {
 	long unsigned int  bytes_read    [2]; /* bytes read from Hard drive */
 	long unsigned int files_opened      ; /* number of files newly opened */
 	double			  memory_efficiency ; /* % hits from memory over total hits */
+
+	long unsigned int wdl_lock_waits [2]; /* times a wdl cache shard was busy */
+	long unsigned int dtm_lock_waits [2]; /* times a dtm cache shard was busy */
+	long unsigned int drive_lock_waits[2]; /* times the file lock was busy     */
 };
 
 extern void			tbstats_reset (void);
@@ -223,6 +223,7 @@ extern void 			mythread_mutex_init		(mythread_mutex_t *m);
 extern void 			mythread_mutex_destroy	(mythread_mutex_t *m);
 extern void 			mythread_mutex_lock     (mythread_mutex_t *m);
 extern void 			mythread_mutex_unlock   (mythread_mutex_t *m);
+extern int /*boolean*/	mythread_mutex_trylock  (mythread_mutex_t *m);
 
 extern void 			mythread_spinx_init		(mythread_spinx_t *m); /**/
 extern void 			mythread_spinx_destroy	(mythread_spinx_t *m); /**/
@@ -80,6 +80,7 @@ void BStar::Run(char *fen)
 	int TiempoLimiteOld;
 	DumpTree *dt;
 	ini = TimeElapsed();
+	SmpWorkers.ResetStats();
 
 	Running = 1;
 	PrintPVV = true;
@@ -121,13 +122,13 @@ void BStar::Run(char *fen)
 		TimeLimit = TiempoLimiteOld; //60000-15;
 	}
 	// antes primero a ver si ya tenemos en memoria el nodo a expandir
-	TreeNode *raiz = GetNodeOfFEN(TreeNode::GetRootNode(),fen);
+	TreeNode *raiz = GetNodeOfFEN(fen);
 	if(raiz && raiz->SubtreeSize && raiz->MoveTo(FIRSTCHILD))
 	{
 		if(DumpData)
 			Print("info string position in Cache saving %d nodes\n",raiz->SubtreeSize);
 		TreeNode *OldRoot = TreeNode::GetRootNode();
-		TreeNode::SetRootNode(raiz);
+		TreeNode::SetRootNode(raiz,fen);
 		if(OldRoot && OldRoot != raiz)
 			OldRoot->Delete();
 	}
@@ -141,8 +142,9 @@ void BStar::Run(char *fen)
 			raiz->Delete();
 		// establecer el nodo raiz
 		raiz = TreeNode::GetFree();
-		TreeNode::SetRootNode(raiz);
-		strcpy(raiz->fen,fen);
+		_Board.LoadFen(fen);
+		raiz->Hash = _Board.PositionKey();
+		TreeNode::SetRootNode(raiz,fen);
 
 		// expand del nodo raiz
 		if(Cancel) {Running = 0;return;}
@@ -166,9 +168,11 @@ void BStar::Run(char *fen)
 		dt->DumpRoot();
 		dt->Write();
 	}
+	if(SmpWorkers.NumThreads > 1)
+		SmpWorkers.PrintStats();
 	// Print the best move...
 	int BestMove;
-	_Board.LoadFen(TreeNode::GetRootNode()->fen); // para movetoAlgebra
+	_Board.LoadFen(fen); // para movetoAlgebra
 	BestMove = TreeNode::GetRootNode()->SelectBestReal()->Move;
 	int ColorMove = _Board.MoveToAlgebra(BestMove,BestMoveStr);
 	Print("bestmove %s\n",BestMoveStr);
@@ -493,12 +497,12 @@ int BStar::EsRepeticion(TreeNode *nodo)
 	TreeNode *aux;
 	for(aux = nodo->MoveTo(PARENT);aux;aux = aux->MoveTo(PARENT))
 	{
-		if(strcmp(nodo->fen,aux->fen)==0)
+		if(nodo->Hash == aux->Hash)
 		{
 			return 1;
 		}
 	}
-	if(ThreeFold.IsRep(nodo->fen))
+	if(ThreeFold.IsRep(nodo->Hash))
 		return 1;
 	return 0;
 }
@@ -566,7 +570,9 @@ int EsRaiz;
 	}
 	if(SelectedNode->MoveCount != 0) return; // already expanded ?
 
-	_Board.LoadFen(SelectedNode->fen);
+	char fen[100];
+	SelectedNode->GetFen(fen);
+	_Board.LoadFen(fen);
 
 	if(EsRaiz)
 	{
@@ -601,7 +607,6 @@ int EsRaiz;
 			aux->Color = _Board.wtm;
 			aux->Stopper = 0;
 			aux->Move = Move;
-			_Board.MoveToAlgebra(Move,aux->MoveStr);
 			aux->Flags = Normal;
 			if(undo.capture || undo.IsPromote)
 				aux->Flags = Capture;
@@ -611,9 +616,7 @@ int EsRaiz;
 			assert(aux->OptVal <= UNDEFINED);
 			assert(aux->PessVal <= UNDEFINED);
 
-			char dest[100];
-			_Board.SaveFEN(&dest[0]);
-			strcpy(aux->fen,dest);
+			aux->Hash = _Board.PositionKey();
 			SelectedNode->Add(aux);
 			NMoves++;
 		}
@@ -650,7 +653,7 @@ int EsRaiz;
 		}
 	}
 	// wait for all workers end his job
-	while(!SmpWorkers.AllIdle())SmpWorkers.Sleep();
+	SmpWorkers.WaitIdle();
 
 	for(aux = SelectedNode->MoveTo(FIRSTCHILD);aux; aux = aux->MoveTo(NEXTSIBBLING))
 	{
@@ -1144,7 +1147,7 @@ void BStar::VerifyInitNode(int ColorRoot,TreeNode *parent)
 		}
 	}
 // wait for all workers end his job
-	while(!SmpWorkers.AllIdle())SmpWorkers.Sleep();
+	SmpWorkers.WaitIdle();
 
 	for(aux = parent->MoveTo(FIRSTCHILD);
 		aux; aux = aux->MoveTo(NEXTSIBBLING))
@@ -1282,7 +1285,9 @@ void BStar::PrintPV()
 	Path[0] = '\0';
 	for(aux = TreeNode::GetRootNode()->SelectBestReal();aux; aux = aux->SelectBestReal())
 	{
-		strcat(Path,aux->MoveStr);
+		char MoveStr[6];
+		aux->GetMoveStr(MoveStr);
+		strcat(Path,MoveStr);
 		strcat(Path," ");
 		SelDepth++;
 		if(SelDepth > 20) break; // avoid buffer overrun on Path
@@ -1340,21 +1345,10 @@ void BStar::SetProbeDepth(int d)
 	DepthEval = d;
 }
 
-TreeNode *BStar::GetNodeOfFEN(TreeNode *parent,char *fen)
+TreeNode *BStar::GetNodeOfFEN(char *fen)
 {
-	TreeNode *aux,*aux1;
-	if(!parent)
-		return NULL;
-
-	for(aux = parent->MoveTo(FIRSTCHILD);aux;aux = aux->MoveTo(NEXTSIBBLING))
-	{
-		if(strcmp(aux->fen,fen)==0)
-			return aux;
-		aux1 = GetNodeOfFEN(aux,fen);
-		if(aux1)
-			return aux1;
-	}
-	return NULL;
+	_Board.LoadFen(fen);
+	return TreeNode::Find(_Board.PositionKey());
 }
 int BStar::GetToSq(char *movestr)
 {
@@ -84,7 +84,7 @@ private:
 	int OptVal2Best();
 	void RecalcSubtreeOptPrb(TreeNode *parent);
 	void PrintPV();
-	TreeNode *GetNodeOfFEN(TreeNode *parent,char *fen);
+	TreeNode *GetNodeOfFEN(char *fen);
 	int GetToSq(char *movestr);
 	void RecalcSubtreeOptPrbVerify(TreeNode *parent);
 	void CalcVerifPrbP(TreeNode *parent);
@@ -2036,6 +2036,25 @@ static char *pieceList[12] = {"P","p","N","n","B","b","R","r","Q","q","K","k"};
 	strcpy(dest,s);
 }
 
+u64 Board::PositionKey()
+{
+	// Built from scratch over the fields written by SaveFEN, the
+	// incremental hash of the search differs from the one LoadFen builds.
+	u64 key = 0ull;
+	int sq;
+	for(sq = 0;sq < 64;sq++)
+	{
+		int pieza = board[sq64to16x12(sq)];
+		if(pieza != Empty)
+			key ^= Zobrist[sq*16+piece_to_12(pieza)];
+	}
+	if(EnPassant)
+		key ^= Zobrist[ZB_ENPASANT+file07(EnPassant)];
+	// one entry for each castle state and side to move
+	key ^= Zobrist[ZB_STATUSENROQUE+CastleFlags+(wtm == White ? 0 : 16)];
+	return key;
+}
+
 void Board::DoMoveAlgebraic(char *move)
 {
 	// gen all moves
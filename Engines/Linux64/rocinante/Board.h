@@ -147,6 +147,7 @@ public:
 
 	void LoadFen(char *fen);
 	void SaveFEN(char *dest);
+	u64 PositionKey(); // zobrist key of the position, same for equal FEN
 	// search
 	int TotalNodes;
 	int Search();
@@ -3,7 +3,7 @@
 
 C3FoldRep ThreeFold;
 
-static char Pos[600][100];
+static u64 Pos[600];	// Board::PositionKey of the game positions
 static int actual;
 
 C3FoldRep::C3FoldRep(void)
@@ -19,19 +19,18 @@ void C3FoldRep::Reset()
 {
 	actual = 0;
 }
-void C3FoldRep::Add(char *fen)
+void C3FoldRep::Add(u64 hash)
 {
-	strcpy(&Pos[actual++][0],fen);
+	Pos[actual++] = hash;
 }
-bool C3FoldRep::IsRep(char *fen)
+bool C3FoldRep::IsRep(u64 hash)
 {
 	int i;
-	if(!fen) return false;
-	if(*fen == '\0') return false;
+	if(!hash) return false;
 	if(actual==0) return false;
 	for(i = actual-1;i>= 0;i--)
 	{
-		if(strcmp(&Pos[i][0],fen) ==0 )
+		if(Pos[i] == hash)
 			return true;
 	}
 	return false;
@@ -1,4 +1,5 @@
 #pragma once
+#include "zobrist.h"
 
 class C3FoldRep
 {
@@ -6,8 +7,8 @@ public:
 	C3FoldRep(void);
 	~C3FoldRep(void);
 static	void Reset();
-static	void Add(char *fen);
-static	bool IsRep(char *fen);
+static	void Add(u64 hash);
+static	bool IsRep(u64 hash);
 };
 
 extern C3FoldRep ThreeFold;
@@ -40,8 +40,10 @@ DumpTree::DumpTree(void)
 			if(Root)
 			{
 				// primero el fen y un diagrama
-				fprintf(fd,"Root %s\n",Root->fen);
-				board.LoadFen(Root->fen);
+				char fen[100];
+				Root->GetFen(fen);
+				fprintf(fd,"Root %s\n",fen);
+				board.LoadFen(fen);
 				board.Display(fd);
 			}
 		}
@@ -59,8 +61,12 @@ void DumpTree::Write()
 	if(fd)
 	{
 		// primero el fen y un diagrama
-		fprintf(fd,"Root %s\n",Root->fen);
-		fprintf(fd,"\nSelected move %s\n",Root->SelectBestReal()->MoveStr);
+		char fen[100];
+		char MoveStr[6];
+		Root->GetFen(fen);
+		Root->SelectBestReal()->GetMoveStr(MoveStr);
+		fprintf(fd,"Root %s\n",fen);
+		fprintf(fd,"\nSelected move %s\n",MoveStr);
 		fprintf(fd,"\nRoot Node Value:");
 		DumpNode(Root,0);
 	}
@@ -69,17 +75,21 @@ void DumpTree::Write()
 void DumpTree::DumpNode(TreeNode *FromNode)
 {
 	TreeNode *aux;
+	char fen[100];
+	char MoveStr[6];
 	// recorremos y volccamos la info
 	for(aux = FromNode->MoveTo(FIRSTCHILD);
 		aux; aux = aux->MoveTo(NEXTSIBBLING))
 	{
+		aux->GetFen(fen);
+		aux->GetMoveStr(MoveStr);
 		fprintf(fd,"Jugada %s Real %d Opt %d SubtreeSize %d Prb %lf Fen %s\n",
-			aux->MoveStr,
+			MoveStr,
 			aux->RealVal,
 			aux->OptVal,
 			aux->SubtreeSize,
 			aux->OptPrb,
-			aux->fen 
+			fen 
 			);
 	}
 }
@@ -90,14 +100,18 @@ void DumpTree::DumpPath(TreeNode *FromNode,TreeNode *RefNode)
 {
 	char buf[0x1000];
 	char buf1[0x1000];
+	char fen[100];
+	char MoveStr[6];
 	buf[0] = '\0';
+	FromNode->GetFen(fen);
 	sprintf(buf1," %d Opt %d Pess %d Prb %4.3lf Fen %s",FromNode->RealVal,
-		FromNode->OptVal,FromNode->PessVal ,FromNode->OptPrb, FromNode->fen );
+		FromNode->OptVal,FromNode->PessVal ,FromNode->OptPrb, fen );
 	strcpy(buf,buf1);
 	while(FromNode && FromNode != RefNode && FromNode->Move)
 	{
 //		J.Set(FromNode->Move);
-		sprintf(buf1," %s %d",FromNode->MoveStr, FromNode->SubtreeSize);
+		FromNode->GetMoveStr(MoveStr);
+		sprintf(buf1," %s %d",MoveStr, FromNode->SubtreeSize);
 		strcat(buf1,buf);
 		strcpy(buf,buf1);
 		FromNode = FromNode->MoveTo(PARENT);
@@ -46,7 +46,9 @@ void JobWorker::DoJob(void)
 	if(Cancel == 1) return;
 	Node->HNCount = 0;
 
-	_Board.LoadFen(Node->fen);
+	char fen[100];
+	Node->GetFen(fen);
+	_Board.LoadFen(fen);
 	int mc = Node->MoveTo(PARENT)->MoveCount;
 	if(CreditNps)
 	{
@@ -69,6 +69,7 @@ void MCTS_AB::Run(char *fen)
 	int TiempoLimiteOld;
 	DumpTree *dt;
 	ini = TimeElapsed();
+	SmpWorkers.ResetStats();
 
 	Running = 1;
 
@@ -107,14 +108,15 @@ void MCTS_AB::Run(char *fen)
 
 
 	// antes primero a ver si ya tenemos en memoria el nodo a expandir
-	TreeNode *raiz = GetNodeOfFEN(TreeNode::GetRootNode(),fen);
+	TreeNode *raiz = GetNodeOfFEN(fen);
 	if(raiz && raiz->SubtreeSize)
 	{
 		if(DumpData)
 			Print("info string position in Cache saving %d nodes\n",raiz->SubtreeSize);
 		TreeNode *OldRoot = TreeNode::GetRootNode();
-		TreeNode::SetRootNode(raiz);
-		OldRoot->Delete();
+		TreeNode::SetRootNode(raiz,fen);
+		if(OldRoot && OldRoot != raiz)
+			OldRoot->Delete();
 	}
 	else
 	{
@@ -126,8 +128,9 @@ void MCTS_AB::Run(char *fen)
 			raiz->Delete();
 		// establecer el nodo raiz
 		raiz = TreeNode::GetFree();
-		TreeNode::SetRootNode(raiz);
-		strcpy(raiz->fen,fen);
+		_Board.LoadFen(fen);
+		raiz->Hash = _Board.PositionKey();
+		TreeNode::SetRootNode(raiz,fen);
 
 		// expand del nodo raiz
 		if(Cancel) {Running = 0;return;}
@@ -147,9 +150,11 @@ void MCTS_AB::Run(char *fen)
 		dt->DumpRoot();
 		dt->Write();
 	}
+	if(SmpWorkers.NumThreads > 1)
+		SmpWorkers.PrintStats();
 	// Print the best move...
 	int BestMove;
-	_Board.LoadFen(TreeNode::GetRootNode()->fen); // para movetoAlgebra
+	_Board.LoadFen(fen); // para movetoAlgebra
 	BestMove = TreeNode::GetRootNode()->SelectBestReal()->Move;
 	int ColorMove = _Board.MoveToAlgebra(BestMove,BestMoveStr);
 	//if(ColorMove != TreeNode::GetRootNode()->Color)
@@ -200,12 +205,12 @@ int MCTS_AB::EsRepeticion(TreeNode *nodo)
 	TreeNode *aux;
 	for(aux = nodo->MoveTo(PARENT);aux;aux = aux->MoveTo(PARENT))
 	{
-		if(strcmp(nodo->fen,aux->fen)==0)
+		if(nodo->Hash == aux->Hash)
 		{
 			return 1;
 		}
 	}
-	if(ThreeFold.IsRep(nodo->fen))
+	if(ThreeFold.IsRep(nodo->Hash))
 		return 1;
 	return 0;
 }
@@ -234,7 +239,9 @@ int EsRaiz;
 	}
 	assert(SelectedNode->MoveCount == 0);
 
-	_Board.LoadFen(SelectedNode->fen);
+	char fen[100];
+	SelectedNode->GetFen(fen);
+	_Board.LoadFen(fen);
 
 	SelectedNode->Color = _Board.wtm;
 	SelectedNode->SubtreeSize = 1;
@@ -264,7 +271,6 @@ int EsRaiz;
 			aux->PessVal = SelectedNode->OptVal;
 			aux->OptVal = UNDEFINED;
 
-			_Board.MoveToAlgebra(Move,aux->MoveStr);
 			aux->Flags = Normal;
 			if(undo.capture || undo.IsPromote)
 				aux->Flags = Capture;
@@ -272,9 +278,7 @@ int EsRaiz;
 			if(_Board.IsCheck())
 				aux->Flags = InCheck;
 
-			char dest[100];
-			_Board.SaveFEN(&dest[0]);
-			strcpy(aux->fen,dest);
+			aux->Hash = _Board.PositionKey();
 			SelectedNode->Add(aux);
 			NMoves++;
 		}
@@ -305,7 +309,7 @@ int EsRaiz;
 		}
 	}
 	// wait for all workers end his job
-	while(!SmpWorkers.AllIdle())SmpWorkers.Sleep();
+	SmpWorkers.WaitIdle();
 
 	for(aux = SelectedNode->MoveTo(FIRSTCHILD);aux; aux = aux->MoveTo(NEXTSIBBLING))
 	{
@@ -399,7 +403,9 @@ void MCTS_AB::PrintPV()
 	Path[0] = '\0';
 	for(aux = TreeNode::GetRootNode()->SelectBestReal();aux; aux = aux->SelectBestReal())
 	{
-		strcat(Path,aux->MoveStr);
+		char MoveStr[6];
+		aux->GetMoveStr(MoveStr);
+		strcat(Path,MoveStr);
 		strcat(Path," ");
 		SelDepth++;
 		if(SelDepth > 20) break; // avoid buffer overrun on Path
@@ -453,21 +459,10 @@ if(!mate)
 	}
 }
 
-TreeNode *MCTS_AB::GetNodeOfFEN(TreeNode *parent,char *fen)
+TreeNode *MCTS_AB::GetNodeOfFEN(char *fen)
 {
-	TreeNode *aux,*aux1;
-	if(!parent)
-		return NULL;
-
-	for(aux = parent->MoveTo(FIRSTCHILD);aux;aux = aux->MoveTo(NEXTSIBBLING))
-	{
-		if(strcmp(aux->fen,fen)==0)
-			return aux;
-		aux1 = GetNodeOfFEN(aux,fen);
-		if(aux1)
-			return aux1;
-	}
-	return NULL;
+	_Board.LoadFen(fen);
+	return TreeNode::Find(_Board.PositionKey());
 }
 
 
@@ -46,7 +46,7 @@ private:
 	void PropagateReal(TreeNode *parent);
 	int GetDepth(TreeNode *node);
 	void PrintPV();
-	TreeNode *GetNodeOfFEN(TreeNode *parent,char *fen);
+	TreeNode *GetNodeOfFEN(char *fen);
 	void Search();
 	TreeNode *TraceDown(TreeNode *parent);
 };
@@ -21,9 +21,27 @@
 #  include <sys/time.h>
 #  include <signal.h>
 #  include <pthread.h>
+typedef pthread_mutex_t Lock;
+typedef pthread_cond_t Event;
+#  define lock_init(x) pthread_mutex_init(&(x), NULL)
+#  define lock_grab(x) pthread_mutex_lock(&(x))
+#  define lock_release(x) pthread_mutex_unlock(&(x))
+#  define event_init(x) pthread_cond_init(&(x), NULL)
+#  define event_wait(x,l) pthread_cond_wait(&(x), &(l))
+#  define event_signal(x) pthread_cond_signal(&(x))
+#  define event_broadcast(x) pthread_cond_broadcast(&(x))
 #else
 #  include <windows.h>
 #  define inline __inline
+typedef CRITICAL_SECTION Lock;
+typedef CONDITION_VARIABLE Event;
+#  define lock_init(x) InitializeCriticalSection(&(x))
+#  define lock_grab(x) EnterCriticalSection(&(x))
+#  define lock_release(x) LeaveCriticalSection(&(x))
+#  define event_init(x) InitializeConditionVariable(&(x))
+#  define event_wait(x,l) SleepConditionVariableCS(&(x), &(l), INFINITE)
+#  define event_signal(x) WakeConditionVariable(&(x))
+#  define event_broadcast(x) WakeAllConditionVariable(&(x))
 #endif
 #include <assert.h>
 
@@ -42,27 +60,49 @@
 #include "SmpManager.h"
 #include "system.h"
 
+extern void Print(const char *fmt, ...);
+
+struct _Job {
+	TreeNode *Node;
+	bool EvalOptimism;
+	int CreditNps;
+};
+
+// Each worker owns a deque of leaf evaluations. The owner takes the
+// newest job from the bottom, idle workers steal the oldest from the top.
 struct _ThreadData {
 	JobWorker work;
 	bool Running;
-	bool Idle;
-	bool Start;
 	int index;
-	bool Stop;
+	struct _Job Queue[MaxQueuedJobs];
+	int Top,Bottom;		// Queue[Top % MaxQueuedJobs] is the oldest
+	Lock QueueLock;
+	// counters
+	int Jobs;
+	long IdleTime;
 #ifndef _MSC_VER
-	pthread_cond_t IdleEvent;
 	pthread_t thread;
-	pthread_mutex_t WaitLock;
-#else
-	HANDLE IdleEvent;
 #endif
 } ThreadData[MaxNumOfThreads];
 
+// WorkLock guards the counters below and the two events.
+static Lock WorkLock;
+static Event WorkReady;		// a job was queued or Stop was set
+static Event AllDone;		// Pending dropped to zero
+static int Queued;			// jobs sitting in the deques
+static int Pending;			// jobs queued or running
+static bool Stop;
+
 SmpManager::SmpManager(void)
 {
 
   NumThreads = 1;
   InitDone = false;
+  NextQueue = 0;
+  StatsStart = 0;
+  lock_init(WorkLock);
+  event_init(WorkReady);
+  event_init(AllDone);
 }
 
 SmpManager::~SmpManager(void)
@@ -78,25 +118,31 @@ void SmpManager::InitWorkers(int cpus)
 {
   volatile int i;
 
+  if(InitDone)
+  {
+	  StopWorkers();
+	  while(!AllStopped()) Sleep();
+  }
+  if(cpus < 1) cpus = 1;
+  if(cpus > MaxNumOfThreads) cpus = MaxNumOfThreads;
   NumThreads = cpus;
+  Stop = false;
+  Queued = Pending = 0;
+  NextQueue = 0;
 
-  
-  // All threads except the main thread should be initialized to idle state:
   for(i = 0; i < NumThreads; i++) {
 	  ThreadData[i].Running = false;
-	  ThreadData[i].Idle = true;
 	  ThreadData[i].work.Node = NULL;
 	  ThreadData[i].work.ThreadId = i+1;
-	  ThreadData[i].Stop = false;
-	  ThreadData[i].Start = false;
 	  ThreadData[i].index = i;
-#ifndef _MSC_VER
-  pthread_cond_init(&ThreadData[i].IdleEvent, NULL);
-  pthread_mutex_init(&ThreadData[i].WaitLock, NULL); 
-#else
-    ThreadData[i].IdleEvent = CreateEvent(0, FALSE, FALSE, 0);
-#endif
+	  ThreadData[i].Top = ThreadData[i].Bottom = 0;
+	  ThreadData[i].Jobs = 0;
+	  ThreadData[i].IdleTime = 0;
+	  lock_init(ThreadData[i].QueueLock);
   }
+  // a single thread does the jobs itself in DoWork
+  if(NumThreads == 1)
+	  return;
   // Launch the helper threads:
   for(i = 0; i < NumThreads; i++) {
 #ifndef _MSC_VER
@@ -107,32 +153,35 @@ void SmpManager::InitWorkers(int cpus)
       CreateThread(NULL, 0, (LPTHREAD_START_ROUTINE)SmpManager::RunThread, (LPVOID)(&ThreadData[i]), 0, iID);
     }
 #endif
-    // Wait until the thread has finished launching:
-	while(!ThreadData[i].Running) Sleep();
-	InitDone = true;
   }
+  // Wait until the threads have finished launching:
+  while(!AllStarted()) Sleep();
+  InitDone = true;
 }
 
 void SmpManager::StopWorkers()
 {
-	int i;
-	for(i = 0; i < NumThreads; i++)
-	{
-		ThreadData[i].Stop = true;
+	lock_grab(WorkLock);
+	Stop = true;
+	event_broadcast(WorkReady);
+	lock_release(WorkLock);
 #ifndef _MSC_VER
-		pthread_mutex_lock(&ThreadData[i].WaitLock);
-		pthread_cond_broadcast(&ThreadData[i].IdleEvent);
-		pthread_mutex_unlock(&ThreadData[i].WaitLock);
-#else
-		SetEvent(ThreadData[i].IdleEvent);
-#endif
+	if(InitDone)
+	{
+		int i;
+		for(i = 0; i < NumThreads; i++)
+			pthread_join(ThreadData[i].thread,NULL);
 	}
+#endif
+	InitDone = false;
 }
 
+// Queue the evaluation of w, the call returns at once.
+// WaitIdle blocks until all queued jobs are done.
 void SmpManager::DoWork(TreeNode *w,bool EvalOpt,int credit)
 {
 	int i;
-	if(w->fen[0] == '\0')
+	if(w->Hash == 0)
 	{
 		w = w;
 		return;
@@ -144,158 +193,200 @@ void SmpManager::DoWork(TreeNode *w,bool EvalOpt,int credit)
 		ThreadData[0].work.EvalOptimism = EvalOpt;
 		ThreadData[0].work.CreditNps = credit;
 		ThreadData[0].work.DoJob();
+		ThreadData[0].Jobs++;
 		return;
 	}
 	if(InitDone == false)
-	{
 		InitWorkers(NumThreads);
-		// start smp threads
-		while(!SmpWorkers.AllStarted())SmpWorkers.Sleep();
-	}
-#ifndef _MSC_VER
-	while(true)
-	{
-		for(i = 0; i < NumThreads; i++)
-		{
-		// buscamos alguien libre
-			if(ThreadData[i].Idle && !ThreadData[i].Start )
-			{
-				ThreadData[i].work.Node = w;
-				ThreadData[i].work.EvalOptimism = EvalOpt;
-				ThreadData[i].work.CreditNps = credit;
-				ThreadData[i].Start = true;
-				// liberamos el thread
-				pthread_mutex_lock(&ThreadData[i].WaitLock);
-				pthread_cond_signal(&ThreadData[i].IdleEvent);
-				pthread_mutex_unlock(&ThreadData[i].WaitLock);
-				// esperamos a que se ponga en marcha
-				while(ThreadData[i].Idle && ThreadData[i].Start){
-					Sleep();
-				}
-				ThreadData[i].Start = false;
-				return;
-			}
-		}
-		// no hemos podido lanzarlo cedemos el paso a otro a ver si termina
-		Sleep();
-	}
-#else
-	while(true)
+
+	lock_grab(WorkLock);
+	for(i = 0; i < NumThreads; i++)
 	{
-		for(i = 0; i < NumThreads; i++)
+		struct _ThreadData *t = &ThreadData[NextQueue];
+		NextQueue = (NextQueue+1) % NumThreads;
+		lock_grab(t->QueueLock);
+		if(t->Bottom - t->Top < MaxQueuedJobs)
 		{
-		// buscamos alguien libre
-			if(ThreadData[i].Idle)// && ThreadData[i].Start == false)
-			{
-				ThreadData[i].work.Node = w;
-				ThreadData[i].work.EvalOptimism = EvalOpt;
-				ThreadData[i].work.CreditNps = credit;
-				ThreadData[i].Start = true;
-				// liberamos el thread
-				SetEvent(ThreadData[i].IdleEvent);
-				// esperamos a que se ponga en marcha
-				while(ThreadData[i].Idle && ThreadData[i].Start) Sleep();
-				ThreadData[i].Start = false;
-				return;
-			}
+			struct _Job *job = &t->Queue[t->Bottom % MaxQueuedJobs];
+			job->Node = w;
+			job->EvalOptimism = EvalOpt;
+			job->CreditNps = credit;
+			t->Bottom++;
+			lock_release(t->QueueLock);
+			Queued++;
+			Pending++;
+			event_signal(WorkReady);
+			lock_release(WorkLock);
+			return;
 		}
-		// no hemos podido lanzarlo cedemos el paso a otro a ver si termina
-		Sleep();
+		lock_release(t->QueueLock);
 	}
-#endif
+	lock_release(WorkLock);
+	// all deques full, should not happen with MaxQueuedJobs > MAXMOVES
+	assert(false);
+}
+
+void SmpManager::WaitIdle()
+{
+	if(NumThreads == 1 || !InitDone)
+		return;
+	lock_grab(WorkLock);
+	while(Pending > 0)
+		event_wait(AllDone,WorkLock);
+	lock_release(WorkLock);
 }
 
 int SmpManager::AllIdle()
 {
-	int i;
-	int ret = 1;
+	int ret;
 	if(NumThreads == 1)
 		return true;
+	lock_grab(WorkLock);
+	ret = Pending == 0;
+	lock_release(WorkLock);
+	return ret;
+}
+
+int SmpManager::AllStopped()
+{
+	int i;
+	int ret = true;
+	lock_grab(WorkLock);
 	for(i = 0; i < NumThreads; i++)
 	{
-		// buscamos alguien libre
-		if(!ThreadData[i].Idle) 
+		if(ThreadData[i].Running)
 		{
-			ret = 0;
+			ret = false;
 			break;
 		}
 	}
+	lock_release(WorkLock);
 	return ret;
 }
-
-int SmpManager::AllStopped()
+int SmpManager::AllStarted()
 {
 	int i;
+	int ret = true;
+	lock_grab(WorkLock);
 	for(i = 0; i < NumThreads; i++)
 	{
-		// buscamos alguien libre
-		if(ThreadData[i].Running)
+		if(!ThreadData[i].Running)
 		{
-			return false;
+			ret = false;
+			break;
 		}
 	}
-	return true;
+	lock_release(WorkLock);
+	return ret;
+}
+
+void SmpManager::ResetStats()
+{
+	int i;
+	for(i = 0; i < NumThreads; i++)
+	{
+		ThreadData[i].Jobs = 0;
+		ThreadData[i].IdleTime = 0;
+	}
+	StatsStart = TimeElapsed();
 }
-int SmpManager::AllStarted()
+
+void SmpManager::PrintStats()
 {
 	int i;
+	long elapsed = TimeElapsed()-StatsStart;
+	if(elapsed <= 0)
+		elapsed = 1;
 	for(i = 0; i < NumThreads; i++)
 	{
-		// buscamos alguien libre
-		if(!ThreadData[i].Running)
+		Print("info string thread %d jobs %d jobs/s %ld idle %ld ms\n",
+			i+1,
+			ThreadData[i].Jobs,
+			(ThreadData[i].Jobs * 1000L)/elapsed,
+			ThreadData[i].IdleTime);
+	}
+}
+
+// Take the newest job from our own deque, else steal the oldest
+// from the first other deque that has one.
+static bool GetJob(struct _ThreadData *pData,struct _Job &job)
+{
+	int i,n;
+	struct _ThreadData *t;
+	bool found = false;
+
+	t = pData;
+	lock_grab(t->QueueLock);
+	if(t->Bottom > t->Top)
+	{
+		t->Bottom--;
+		job = t->Queue[t->Bottom % MaxQueuedJobs];
+		found = true;
+	}
+	lock_release(t->QueueLock);
+
+	n = SmpWorkers.NumThreads;
+	for(i = 1; i < n && !found; i++)
+	{
+		t = &ThreadData[(pData->index+i) % n];
+		lock_grab(t->QueueLock);
+		if(t->Bottom > t->Top)
 		{
-			return false;
+			job = t->Queue[t->Top % MaxQueuedJobs];
+			t->Top++;
+			found = true;
 		}
+		lock_release(t->QueueLock);
+	}
+	if(found)
+	{
+		lock_grab(WorkLock);
+		Queued--;
+		lock_release(WorkLock);
 	}
-	return true;
+	return found;
 }
 
 void *SmpManager::RunThread(void *data)
 {
 	struct _ThreadData * pData = (struct _ThreadData *)data;
+	struct _Job job;
+	lock_grab(WorkLock);
 	pData->Running = true; // estamos vivos
+	lock_release(WorkLock);
 
-#ifndef _MSC_VER
 	while(true)
 	{
-		// we'r idle
-		pData->Idle = true;
-		// esperamos faena // Wait for work to do
-		pthread_mutex_lock(&pData->WaitLock);
-		if(!pData->Start)	// we are signaled while waiting for the lock ?
+		if(!GetJob(pData,job))
 		{
-			pthread_cond_wait(&pData->IdleEvent,&pData->WaitLock);
-		}
-		pthread_mutex_unlock(&pData->WaitLock);
-		if(pData->Start) // check false awakening
-		{
-			pData->Idle = false;
+			// esperamos faena // Wait for work to do
+			long start = TimeElapsed();
+			bool stop;
+			lock_grab(WorkLock);
+			while(Queued == 0 && !Stop)
+				event_wait(WorkReady,WorkLock);
 			// si nos avisan de salir // if we are signaled to stop
-			if(pData->Stop) break;
-			// hacemos la faena
-			pData->work.DoJob();
+			stop = Stop;
+			lock_release(WorkLock);
+			pData->IdleTime += TimeElapsed()-start;
+			if(stop) break;
+			continue;
 		}
-    } // vuelta a empezar
-#else
-	while(true)
-	{
-		pData->Idle = true;
-	// esperamos faena // Wait for work to do
-      WaitForSingleObject(pData->IdleEvent, INFINITE);
-	  if(pData->Start) // check false awakening
-	  {
-		  pData->Idle = false;
-			// si nos avisan de salir // if we are signaled to stop
-			if(pData->Stop) break;
-		  // hacemos la faena
-			pData->work.DoJob();
-		  // avisamos volvemos a estar libres
-		  pData->Start = false;
-	  }
-    } // vuelta a empezar
-#endif
+		// hacemos la faena
+		pData->work.Node = job.Node;
+		pData->work.EvalOptimism = job.EvalOptimism;
+		pData->work.CreditNps = job.CreditNps;
+		pData->work.DoJob();
+		pData->Jobs++;
+
+		lock_grab(WorkLock);
+		if(--Pending == 0)
+			event_broadcast(AllDone);
+		lock_release(WorkLock);
+	} // vuelta a empezar
 	// salida
+	lock_grab(WorkLock);
 	pData->Running = false; // No estamos vivos
-	pData->Idle = true;
+	lock_release(WorkLock);
 	return 0;
 }
@@ -19,6 +19,7 @@
 #pragma once
 
 const int MaxNumOfThreads = 256;
+const int MaxQueuedJobs = 256;	// per worker deque
 
 class SmpManager
 {
@@ -36,9 +37,16 @@ public:
 	void InitWorkers(int cpus);
 	void StopWorkers();
 	void DoWork(TreeNode *w,bool EvalOpt,int Credit);
+	void WaitIdle();
 	int AllIdle();
 	int AllStopped();
 	int AllStarted();
 	void Sleep();
+	// per thread counters
+	void ResetStats();
+	void PrintStats();
+private:
+	int NextQueue;	// round robin over the worker deques
+	long StatsStart;
 };
 extern SmpManager SmpWorkers;
@@ -18,16 +18,25 @@
 
 #include <cassert>
 #include <math.h>
+#include <string.h>
 #include "TreeNode.h"
 #include <stdio.h>
 
 // includes for White
-#include "Color.h"
+#include "MoveList.h"
+#include "UndoData.h"
+#include "Board.h"
 
-static TreeNode *Nodes;
+static TreeNode **Chunks;	// node arena, grows NODECHUNK nodes at a time
+static int NumChunks;
+static int MaxChunks;
 static TreeNode *RootNode;
 static TreeNode *FirstFree;
+static TreeNode **Index;	// nodes in the tree by Hash, chained on NextInIndex
+static int IndexSize;		// power of two
+static char RootFen[100];	// only the root keeps its FEN, see GetFen
 
+const int MAXPATH = 1024;
 
 TreeNode::TreeNode(void)
 {
@@ -39,22 +48,94 @@ TreeNode::~TreeNode(void)
 }
 
 void TreeNode::InitTree()
+{
+	int c,i;
+	// keep the arena, all nodes back to the free list
+	FirstFree = 0;
+	for(c = NumChunks-1;c >= 0;c--)
+	{
+		for(i = NODECHUNK-1;i >= 0;i--)
+		{
+			Chunks[c][i].Reset();
+			Chunks[c][i].NextSibbling = FirstFree;
+			FirstFree = &Chunks[c][i];
+		}
+	}
+	if(Index)
+		memset(Index,0,IndexSize*sizeof(TreeNode *));
+	RootNode = 0;
+	RootFen[0] = '\0';
+}
+
+void TreeNode::GrowArena()
 {
 	int i;
-	if(Nodes) delete[] Nodes;
-	Nodes = new TreeNode[MAXNODES];
+	TreeNode *New;
+	if(NumChunks == MaxChunks)
+	{
+		TreeNode **aux;
+		MaxChunks = MaxChunks ? MaxChunks*2 : 16;
+		aux = new TreeNode *[MaxChunks];
+		for(i = 0;i < NumChunks;i++)
+			aux[i] = Chunks[i];
+		if(Chunks) delete[] Chunks;
+		Chunks = aux;
+	}
+	New = new TreeNode[NODECHUNK];
+	Chunks[NumChunks++] = New;
+	for(i = NODECHUNK-2;i >= 0;i--)
+		New[i].NextSibbling = &New[i+1];
+	New[NODECHUNK-1].NextSibbling = FirstFree;
+	FirstFree = &New[0];
+
+	// one bucket per node in the arena
+	if(IndexSize < NumChunks*NODECHUNK)
+	{
+		TreeNode **OldIndex = Index;
+		int OldSize = IndexSize;
+		while(IndexSize < NumChunks*NODECHUNK)
+			IndexSize = IndexSize ? IndexSize*2 : NODECHUNK;
+		Index = new TreeNode *[IndexSize];
+		memset(Index,0,IndexSize*sizeof(TreeNode *));
+		for(i = 0;i < OldSize;i++)
+		{
+			TreeNode *aux,*next;
+			for(aux = OldIndex[i];aux;aux = next)
+			{
+				next = aux->NextInIndex;
+				aux->AddToIndex();
+			}
+		}
+		if(OldIndex) delete[] OldIndex;
+	}
+}
 
-	for(i = MAXNODES-2;i >= 0;i--)
+void TreeNode::AddToIndex()
+{
+	TreeNode **bucket = &Index[Hash & (IndexSize-1)];
+	NextInIndex = *bucket;
+	*bucket = this;
+}
+
+void TreeNode::RemoveFromIndex()
+{
+	TreeNode **aux;
+	if(!Index) return;
+	for(aux = &Index[Hash & (IndexSize-1)];*aux;aux = &(*aux)->NextInIndex)
 	{
-		Nodes[i].Reset();
-		Nodes[i].NextSibbling = &Nodes[i+1];
+		if(*aux == this)
+		{
+			*aux = NextInIndex;
+			NextInIndex = 0;
+			return;
+		}
 	}
-	FirstFree = &Nodes[0];
 }
 
 void TreeNode::Reset()
 {
 	Parent = FirstChild = NextSibbling = 0;
+	NextInIndex = 0;
 	RealVal = UNDEFINED;
 	OptVal = UNDEFINED;
 	PessVal = UNDEFINED;
@@ -62,8 +143,7 @@ void TreeNode::Reset()
 	MoveCount = 0;
 	Color = White;
 	Move = 0;
-	fen[0] = '\0';
-	MoveStr[0] = '\0';
+	Hash = 0;
 	SubtreeSize = 0;
 	NChecks = 0;
 	NCaptures = 0;
@@ -72,9 +152,9 @@ void TreeNode::Reset()
 // Get the first free node
 TreeNode *TreeNode::GetFree()
 {
-	TreeNode *aux = FirstFree;
+	TreeNode *aux;
 	if(!FirstFree)
-		InitTree();
+		GrowArena();
 	aux = FirstFree;
 		
 	FirstFree = FirstFree->NextSibbling;
@@ -82,9 +162,29 @@ TreeNode *TreeNode::GetFree()
 	return aux;
 }
 
-void TreeNode::SetRootNode(TreeNode *New)
+// Node in the tree for the position with this key.
+// Transpositions give several nodes, keep the one with the biggest subtree.
+TreeNode *TreeNode::Find(u64 hash)
+{
+	TreeNode *aux;
+	TreeNode *Sel = 0;
+	if(!Index) return 0;
+	for(aux = Index[hash & (IndexSize-1)];aux;aux = aux->NextInIndex)
+	{
+		if(aux->Hash != hash) continue;
+		if(!Sel || aux->SubtreeSize > Sel->SubtreeSize)
+			Sel = aux;
+	}
+	return Sel;
+}
+
+void TreeNode::SetRootNode(TreeNode *New,char *fen)
 {
 	RootNode = New;
+	strcpy(RootFen,fen);
+	// a new root from GetFree is not in the index yet
+	New->RemoveFromIndex();
+	New->AddToIndex();
 }
 
 TreeNode *TreeNode::GetRootNode()
@@ -92,6 +192,39 @@ TreeNode *TreeNode::GetRootNode()
 	return RootNode;
 }
 
+// Rebuild the FEN replaying the moves from the root position.
+void TreeNode::GetFen(char *dest)
+{
+	int Path[MAXPATH];
+	int n = 0;
+	TreeNode *aux;
+	for(aux = this;aux->Parent;aux = aux->Parent)
+	{
+		assert(n < MAXPATH);
+		Path[n++] = aux->Move;
+	}
+	if(n == 0)
+	{
+		strcpy(dest,RootFen);
+		return;
+	}
+	Board board;
+	UndoData undo;
+	board.LoadFen(RootFen);
+	while(n > 0)
+		board.DoMove(Path[--n],undo);
+	board.SaveFEN(dest);
+}
+
+void TreeNode::GetMoveStr(char *dest)
+{
+	// MoveToAlgebra only looks at the move bits for the string
+	static Board board;
+	dest[0] = '\0';
+	if(Move)
+		board.MoveToAlgebra(Move,dest);
+}
+
 TreeNode *TreeNode::MoveTo(MoveMode mode)
 {
 	switch(mode)
@@ -128,6 +261,7 @@ void TreeNode::Add(TreeNode *New)
 		aux->NextSibbling = New;
 	}
 	New->Parent = this;
+	New->AddToIndex();
 }
 
 void TreeNode::Delete()
@@ -166,6 +300,7 @@ void TreeNode::Delete()
 		else
 			NextSibbling->Delete();
 	}
+	RemoveFromIndex();
 	Reset();
 	this->NextSibbling = FirstFree;
 	FirstFree = this;
@@ -287,7 +422,7 @@ TreeNode *TreeNode::SelectBestPess()
 	return Sel;
 }
 
-const int MATE = 30000;
+const int TREEMATE = 30000;	// Board.h MATE is 32000
 
 TreeNode *TreeNode::SelectBestOptPrb()
 {
@@ -324,7 +459,7 @@ TreeNode *TreeNode::SelectBestOptPrb()
 TreeNode *TreeNode::SelectBestOptPrbNotDraw()
 {
 	double Val;
-	int Real = -MATE;
+	int Real = -TREEMATE;
 	TreeNode *aux,*aux2;
 	TreeNode *BestReal = SelectBestReal();
 	int dpv = BestReal->PVDepth()+1;
@@ -17,9 +17,10 @@
 //
 
 #pragma once
+#include "zobrist.h"
 
 extern int Dithering;
-const int MAXNODES = 700000;
+const int NODECHUNK = 65536;	// nodes allocated each time the arena grows
 enum MoveMode {
 	PARENT,FIRSTCHILD,NEXTSIBBLING,LASTCHILD
 };
@@ -33,7 +34,11 @@ private:
 	TreeNode *Parent;
 	TreeNode *FirstChild;
 	TreeNode *NextSibbling;
+	TreeNode *NextInIndex;	// next node in the same hash index bucket
 	void Reset();
+	void AddToIndex();
+	void RemoveFromIndex();
+	static void GrowArena();
 
 public:
 	int Color;
@@ -50,8 +55,7 @@ public:
 	FlagsNode Flags;   // 0 normal 1 InCheck  2 Drawn (repetition ...)
 	int Move;
 	int IsRepetition;
-	char fen[92];
-	char MoveStr[6];
+	u64 Hash;		// zobrist key of the position, see Board::PositionKey
 	int SubtreeSize;
 	int Stopper;
 //	int fase;
@@ -73,9 +77,12 @@ public:
 	TreeNode *SelectBestPess();
 	
 	int PVDepth();
+	void GetFen(char *dest);
+	void GetMoveStr(char *dest);
 
 	static TreeNode *GetFree();
-	static void SetRootNode(TreeNode *New);
+	static TreeNode *Find(u64 hash);
+	static void SetRootNode(TreeNode *New,char *fen);
 	static TreeNode *GetRootNode();
 	static void InitTree();
 };
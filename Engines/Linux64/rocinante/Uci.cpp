@@ -569,8 +569,7 @@ void CUci::Position()
 		while(token)
 		{
 			board.DoMoveAlgebraic(token);
-			board.SaveFEN(&fen[0]);
-		    ThreeFold.Add(&fen[0]);
+		    ThreeFold.Add(board.PositionKey());
 
 			// get next move
 			token = GetNextToken();
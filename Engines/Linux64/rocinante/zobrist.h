@@ -15,6 +15,7 @@
 //    You should have received a copy of the GNU General Public License
 //    along with Simplex.  If not, see <http://www.gnu.org/licenses/>
 //
+#pragma once
 typedef unsigned long long u64;
 extern u64 Zobrist[1500];
 #define ZB_ENPASANT 1024
@@ -18,15 +18,25 @@
   along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include <cstdio>
+#include <algorithm>
 #include <fstream>
+#include <iomanip>
 #include <iostream>
 #include <istream>
+#include <sstream>
+#include <thread>
 #include <vector>
 
+#ifdef __linux__
+#include <unistd.h>
+#endif
+
 #include "misc.h"
 #include "position.h"
 #include "search.h"
 #include "thread.h"
+#include "tt.h"
 #include "uci.h"
 
 using namespace std;
@@ -86,17 +96,24 @@ const vector<string> Defaults = {
   "7k/7P/6K1/8/3B4/8/8/8 b - -"
 };
 
-} // namespace
+struct PositionResult {
+  uint64_t nodes;
+  TimePoint elapsed;
+  int depth, hashfull;
+  string fen;
+};
 
-/// benchmark() runs a simple benchmark by letting Stockfish analyze a set
-/// of positions for a given limit each. There are five parameters: the
-/// transposition table size, the number of search threads that should
-/// be used, the limit value spent for each position (optional, default is
-/// depth 13), an optional file name where to look for positions in FEN
-/// format (defaults are the positions defined above) and the type of the
-/// limit value: depth (default), time in millisecs or number of nodes.
+struct BenchResult {
+  uint64_t nodes;
+  TimePoint elapsed, hashSetup;
+  vector<PositionResult> positions;
+};
 
-void benchmark(const Position& current, istream& is) {
+
+/// run() does the work of benchmark(), reading the same parameters, and fills
+/// 'r' with the totals. Returns false if the positions could not be read.
+
+bool run(const Position& current, istream& is, BenchResult& r) {
 
   string token;
   vector<string> fens;
@@ -109,10 +126,14 @@ void benchmark(const Position& current, istream& is) {
   string fenFile   = (is >> token) ? token : "default";
   string limitType = (is >> token) ? token : "depth";
 
-  Options["Hash"]    = ttSize;
+  r.hashSetup = now();
+
   Options["Threads"] = threads;
+  Options["Hash"]    = ttSize;
   Search::clear();
 
+  r.hashSetup = now() - r.hashSetup;
+
   if (limitType == "time")
       limits.movetime = stoi(limit); // movetime is in millisecs
 
@@ -139,7 +160,7 @@ void benchmark(const Position& current, istream& is) {
       if (!file.is_open())
       {
           cerr << "Unable to open file " << fenFile << endl;
-          return;
+          return false;
       }
 
       while (getline(file, fen))
@@ -149,8 +170,9 @@ void benchmark(const Position& current, istream& is) {
       file.close();
   }
 
-  uint64_t nodes = 0;
-  TimePoint elapsed = now();
+  r.nodes = 0;
+  r.positions.clear();
+  r.elapsed = now();
   Position pos;
 
   for (size_t i = 0; i < fens.size(); ++i)
@@ -160,24 +182,328 @@ void benchmark(const Position& current, istream& is) {
 
       cerr << "\nPosition: " << i + 1 << '/' << fens.size() << endl;
 
+      PositionResult pr = { 0, now(), 0, 0, fens[i] };
+
       if (limitType == "perft")
-          nodes += Search::perft(pos, limits.depth * ONE_PLY);
+          pr.nodes = Search::perft(pos, limits.depth * ONE_PLY);
 
       else
       {
           limits.startTime = now();
           Threads.start_thinking(pos, states, limits);
           Threads.main()->wait_for_search_finished();
-          nodes += Threads.nodes_searched();
+          pr.nodes = Threads.nodes_searched();
+          pr.depth = Threads.main()->completedDepth / ONE_PLY;
+          pr.hashfull = TT.hashfull();
       }
+
+      pr.elapsed = now() - pr.elapsed;
+      r.nodes += pr.nodes;
+      r.positions.push_back(pr);
   }
 
-  elapsed = now() - elapsed + 1; // Ensure positivity to avoid a 'divide by zero'
+  r.elapsed = now() - r.elapsed + 1; // Ensure positivity to avoid a 'divide by zero'
+
+  return true;
+}
+
+} // namespace
+
+/// benchmark() runs a simple benchmark by letting Stockfish analyze a set
+/// of positions for a given limit each. There are five parameters: the
+/// transposition table size, the number of search threads that should
+/// be used, the limit value spent for each position (optional, default is
+/// depth 13), an optional file name where to look for positions in FEN
+/// format (defaults are the positions defined above) and the type of the
+/// limit value: depth (default), time in millisecs or number of nodes.
+/// The time spent allocating and clearing the hash is reported separately;
+/// run bench again after 'setoption name Large Pages value false' to compare
+/// huge page backed tables against normal pages, both for setup and NPS.
+
+void benchmark(const Position& current, istream& is) {
+
+  BenchResult r;
+
+  if (!run(current, is, r))
+      return;
 
   dbg_print(); // Just before exiting
 
   cerr << "\n==========================="
-       << "\nTotal time (ms) : " << elapsed
-       << "\nNodes searched  : " << nodes
-       << "\nNodes/second    : " << 1000 * nodes / elapsed << endl;
+       << "\nHash setup (ms) : " << r.hashSetup
+       << (Options["Large Pages"] ? " (large pages)" : "")
+       << "\nTotal time (ms) : " << r.elapsed
+       << "\nNodes searched  : " << r.nodes
+       << "\nNodes/second    : " << 1000 * r.nodes / r.elapsed << endl;
+}
+
+
+/// thread_benchmark() shows how the search scales with the number of threads.
+/// The bench positions are searched to a fixed depth with 1, 2, 4... threads
+/// up to 'maxThreads' (default: the number of logical processors), and total
+/// time, NPS and their ratio to the single threaded run are printed. Further
+/// parameters are the hash size in MB (default 128) and the depth (default
+/// 13). On multi-socket machines run it with "Bind Threads" off and on.
+
+void thread_benchmark(const Position& current, istream& is) {
+
+  string token;
+  int maxThreads = (is >> token) ? stoi(token) : max(int(thread::hardware_concurrency()), 1);
+  string ttSize  = (is >> token) ? token : "128";
+  string depth   = (is >> token) ? token : "13";
+
+  vector<pair<int, BenchResult>> results;
+
+  for (int threads = 1; ; threads = min(2 * threads, maxThreads))
+  {
+      stringstream ss(ttSize + " " + to_string(threads) + " " + depth);
+      BenchResult r;
+
+      if (!run(current, ss, r))
+          return;
+
+      results.emplace_back(threads, r);
+
+      if (threads >= maxThreads)
+          break;
+  }
+
+  const BenchResult& base = results[0].second;
+
+  cerr << "\n==========================="
+       << "\nBind Threads: " << (Options["Bind Threads"] ? "on" : "off")
+       << "\nThreads   Time (ms)     Nodes/second   Time speedup   NPS speedup" << endl;
+
+  for (const auto& t : results)
+  {
+      const BenchResult& r = t.second;
+
+      cerr << setw(7)  << t.first
+           << setw(12) << r.elapsed
+           << setw(17) << 1000 * r.nodes / r.elapsed
+           << setw(15) << fixed << setprecision(2) << double(base.elapsed) / r.elapsed
+           << setw(14) << double(r.nodes) / r.elapsed / (double(base.nodes) / base.elapsed)
+           << endl;
+  }
+}
+
+
+/// shared_benchmark() measures how much several processes gain from sharing a
+/// transposition table through the "Shared Hash" option. The bench positions
+/// are searched to a fixed depth first by this process alone and then again
+/// while 'procs' - 1 helper copies of the engine search the same list on the
+/// same segment. Parameters are the number of processes (default 4), the hash
+/// size in MB (default 128) and the depth (default 16). Each process uses one
+/// search thread, reported times are those of this process.
+
+void shared_benchmark(const Position& current, istream& is) {
+
+#ifdef __linux__
+
+  string token;
+  int procs      = (is >> token) ? max(stoi(token), 1) : 4;
+  string ttSize  = (is >> token) ? token : "128";
+  string depth   = (is >> token) ? token : "16";
+
+  char exe[4096];
+  ssize_t len = readlink("/proc/self/exe", exe, sizeof(exe) - 1);
+
+  if (len <= 0)
+  {
+      cerr << "Unable to locate the engine executable" << endl;
+      return;
+  }
+
+  exe[len] = '\0';
+
+  string oldName = Options["Shared Hash"];
+  TimePoint elapsed[2];
+
+  for (int run = 0; run < 2; ++run)
+  {
+      int helpers = run ? procs - 1 : 0;
+      string name = "stockfish-bench-" + to_string(getpid()) + "-" + to_string(run);
+      vector<FILE*> pipes;
+
+      // Create the segment before the helpers so that they all attach to it
+      Options["Threads"]     = string("1");
+      Options["Hash"]        = ttSize;
+      Options["Shared Hash"] = name;
+
+      for (int i = 0; i < helpers; ++i)
+      {
+          FILE* p = popen(("exec \"" + string(exe) + "\" > /dev/null 2>&1").c_str(), "w");
+
+          if (!p)
+              continue;
+
+          fprintf(p, "setoption name Hash value %s\n"
+                     "setoption name Shared Hash value %s\n"
+                     "bench %s 1 %s\nquit\n", ttSize.c_str(), name.c_str(),
+                     ttSize.c_str(), depth.c_str());
+          fflush(p);
+          pipes.push_back(p);
+      }
+
+      stringstream ss(ttSize + " 1 " + depth);
+
+      elapsed[run] = now();
+      benchmark(current, ss);
+      elapsed[run] = now() - elapsed[run] + 1;
+
+      for (FILE* p : pipes)
+          pclose(p);
+  }
+
+  Options["Shared Hash"] = oldName;
+
+  cerr << "\n==========================="
+       << "\nTime to depth " << depth << ", 1 process (ms) : " << elapsed[0]
+       << "\nTime to depth " << depth << ", " << procs << " processes (ms) : " << elapsed[1]
+       << "\nSpeedup                  : " << double(elapsed[0]) / elapsed[1] << endl;
+
+#else
+
+  (void)current; (void)is;
+  cerr << "sharedbench is only available on Linux" << endl;
+
+#endif
+}
+
+
+namespace {
+
+/// json_string() quotes 's' as a JSON string, escaping what JSON doesn't
+/// allow inside one.
+
+string json_string(const string& s) {
+
+  stringstream ss;
+  ss << '"';
+
+  for (unsigned char c : s)
+      if (c == '"' || c == '\\')
+          ss << '\\' << c;
+      else if (c < 0x20)
+          ss << "\\u" << hex << setw(4) << setfill('0') << int(c) << dec;
+      else
+          ss << c;
+
+  ss << '"';
+  return ss.str();
+}
+
+} // namespace
+
+
+/// json_benchmark() sweeps the standard bench over lists of thread counts and
+/// hash sizes, repeating each combination, and writes every result to a JSON
+/// file so that builds and machines can be compared. The parameters are a comma
+/// separated list of thread counts (default 1), a comma separated list of hash
+/// sizes in MB (default 16), the number of runs per combination (default 1),
+/// the depth (default 13), a file of FENs or "default" and the output file
+/// (default bench.json). Per position it records the FEN, the nodes, the time
+/// to reach the depth, the NPS, the completed depth and the hashfull permill.
+/// The file is written under a temporary name and only renamed to the output
+/// file when every run is done, so that a failed sweep leaves no partial JSON.
+
+void json_benchmark(const Position& current, istream& is) {
+
+  auto list = [](const string& s) {
+      vector<string> v;
+      stringstream ss(s);
+      for (string item; getline(ss, item, ','); )
+          if (!item.empty())
+              v.push_back(item);
+      return v;
+  };
+
+  string token;
+  vector<string> threads = list((is >> token) ? token : "1");
+  vector<string> hashes  = list((is >> token) ? token : "16");
+  int repeats     = (is >> token) ? max(stoi(token), 1) : 1;
+  string depth    = (is >> token) ? token : "13";
+  string fenFile  = (is >> token) ? token : "default";
+  string jsonFile = (is >> token) ? token : "bench.json";
+  string tmpFile  = jsonFile + ".tmp";
+
+  ofstream out(tmpFile);
+
+  if (!out.is_open())
+  {
+      cerr << "Unable to open file " << tmpFile << endl;
+      return;
+  }
+
+  out << "{\n"
+      << "  \"engine\": " << json_string(engine_info()) << ",\n"
+      << "  \"processors\": " << thread::hardware_concurrency() << ",\n"
+      << "  \"large_pages\": " << (Options["Large Pages"] ? "true" : "false") << ",\n"
+      << "  \"bind_threads\": " << (Options["Bind Threads"] ? "true" : "false") << ",\n"
+      << "  \"depth\": " << stoi(depth) << ",\n"
+      << "  \"positions\": " << json_string(fenFile) << ",\n"
+      << "  \"runs\": [";
+
+  bool first = true;
+
+  for (const string& th : threads)
+      for (const string& hash : hashes)
+          for (int rep = 0; rep < repeats; ++rep)
+          {
+              stringstream ss(hash + " " + th + " " + depth + " " + fenFile);
+              BenchResult r;
+
+              if (!run(current, ss, r))
+              {
+                  out.close();
+                  remove(tmpFile.c_str());
+                  return;
+              }
+
+              out << (first ? "\n" : ",\n")
+                  << "    { \"threads\": " << stoi(th)
+                  << ", \"hash\": " << stoi(hash)
+                  << ", \"repeat\": " << rep
+                  << ", \"hash_setup_ms\": " << r.hashSetup
+                  << ", \"time_ms\": " << r.elapsed
+                  << ", \"nodes\": " << r.nodes
+                  << ", \"nps\": " << 1000 * r.nodes / r.elapsed
+                  << ",\n      \"results\": [";
+
+              for (size_t i = 0; i < r.positions.size(); ++i)
+              {
+                  const PositionResult& p = r.positions[i];
+
+                  out << (i ? ",\n        " : "\n        ")
+                      << "{ \"position\": " << i + 1
+                      << ", \"fen\": " << json_string(p.fen)
+                      << ", \"nodes\": " << p.nodes
+                      << ", \"time_ms\": " << p.elapsed
+                      << ", \"nps\": " << 1000 * p.nodes / (p.elapsed + 1)
+                      << ", \"depth\": " << p.depth
+                      << ", \"hashfull\": " << p.hashfull << " }";
+              }
+
+              out << " ] }";
+              first = false;
+
+              cerr << "\nthreads " << th << " hash " << hash << " run " << rep + 1
+                   << ": " << r.nodes << " nodes, " << r.elapsed << " ms" << endl;
+          }
+
+  out << "\n  ]\n}" << endl;
+  out.close();
+
+#ifdef _WIN32
+  remove(jsonFile.c_str()); // rename() doesn't replace an existing file
+#endif
+
+  if (!out || rename(tmpFile.c_str(), jsonFile.c_str()))
+  {
+      cerr << "Unable to write file " << jsonFile << endl;
+      remove(tmpFile.c_str());
+      return;
+  }
+
+  cerr << "\nResults written to " << jsonFile << endl;
 }
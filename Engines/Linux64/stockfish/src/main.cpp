@@ -49,6 +49,7 @@ int main(int argc, char* argv[]) {
 
   UCI::loop(argc, argv);
 
+  Tablebases::exit();
   Threads.exit();
   return 0;
 }
@@ -18,11 +18,23 @@
   along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include <cstdlib>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
 #include <sstream>
 
+#if defined(__linux__) && !defined(__ANDROID__)
+#include <atomic>
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#define USE_MMAP_ALLOC
+#endif
+
 #include "misc.h"
 #include "thread.h"
 
@@ -185,3 +197,264 @@ void prefetch(void* addr) {
 }
 
 #endif
+
+
+#ifdef USE_MMAP_ALLOC
+
+namespace {
+
+const size_t HugePageSize = 2 * 1024 * 1024;
+
+/// online_nodes() returns the mask of online NUMA nodes as listed by the kernel
+/// in /sys, e.g. "0-1" or "0,2-3". Only the first 64 nodes are considered.
+
+uint64_t online_nodes() {
+
+  ifstream file("/sys/devices/system/node/online");
+  string list, range;
+  uint64_t mask = 0;
+
+  if (!getline(file, list))
+      return 1;
+
+  stringstream ss(list);
+
+  while (getline(ss, range, ','))
+  {
+      int first = atoi(range.c_str()), last = first;
+      size_t dash = range.find('-');
+
+      if (dash != string::npos)
+          last = atoi(range.c_str() + dash + 1);
+
+      for (int n = first; n <= last && n < 64; ++n)
+          mask |= uint64_t(1) << n;
+  }
+
+  return mask ? mask : 1;
+}
+
+} // namespace
+
+#endif
+
+
+/// large_mem_alloc() reserves 'size' bytes of zeroed memory for a big table such
+/// as the transposition table and returns it aligned to at least a cache line.
+/// On Linux the block is mmapped on a 2MB boundary, backed by explicit huge pages
+/// when some are reserved (vm.nr_hugepages) and otherwise advised for transparent
+/// huge pages, then interleaved over all NUMA nodes. Pages are not touched here,
+/// the caller is expected to clear the block in parallel. 'mem' receives the
+/// pointer to pass to large_mem_free(), or nullptr on failure.
+
+void* large_mem_alloc(size_t size, void*& mem, bool largePages) {
+
+#ifdef USE_MMAP_ALLOC
+
+  size = (size + HugePageSize - 1) & ~(HugePageSize - 1);
+
+  void* p = MAP_FAILED;
+
+#  ifdef MAP_HUGETLB
+  if (largePages)
+      p = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+               MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+#  endif
+
+  if (p == MAP_FAILED)
+  {
+      // Over-allocate, then trim head and tail so the block starts on a huge
+      // page boundary and the kernel can back it with transparent huge pages.
+      char* raw = (char*)mmap(nullptr, size + HugePageSize, PROT_READ | PROT_WRITE,
+                              MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      if (raw == MAP_FAILED)
+          return mem = nullptr;
+
+      char* aligned = (char*)((uintptr_t(raw) + HugePageSize - 1) & ~(HugePageSize - 1));
+
+      if (aligned != raw)
+          munmap(raw, aligned - raw);
+
+      munmap(aligned + size, raw + HugePageSize - aligned);
+
+      p = aligned;
+
+#  ifdef MADV_HUGEPAGE
+      if (largePages)
+          madvise(p, size, MADV_HUGEPAGE);
+#  endif
+  }
+
+#  ifdef SYS_mbind
+  uint64_t nodes = online_nodes();
+
+  if (nodes & (nodes - 1)) // More than one node
+      syscall(SYS_mbind, p, size, 3 /* MPOL_INTERLEAVE */, &nodes, 64, 0);
+#  endif
+
+  return mem = p;
+
+#else
+
+  (void)largePages;
+
+  const size_t CacheLineSize = 64;
+
+  mem = calloc(size + CacheLineSize - 1, 1);
+
+  return mem ? (void*)((uintptr_t(mem) + CacheLineSize - 1) & ~(CacheLineSize - 1))
+             : nullptr;
+#endif
+}
+
+
+/// large_mem_free() releases a block obtained with large_mem_alloc() for the
+/// same 'size'. A null pointer is ignored.
+
+void large_mem_free(void* mem, size_t size) {
+
+  if (!mem)
+      return;
+
+#ifdef USE_MMAP_ALLOC
+  munmap(mem, (size + HugePageSize - 1) & ~(HugePageSize - 1));
+#else
+  (void)size;
+  free(mem);
+#endif
+}
+
+
+#ifdef USE_MMAP_ALLOC
+
+namespace {
+
+/// Header stored in front of a shared memory segment. It keeps the segment
+/// large enough to hold a cache line, so the data that follows stays aligned.
+struct SharedMemHeader {
+  std::atomic<int> users;
+  char padding[64 - sizeof(std::atomic<int>)];
+};
+
+static_assert(sizeof(SharedMemHeader) == 64, "SharedMemHeader size incorrect");
+
+} // namespace
+
+#endif
+
+
+/// shared_mem_attach() maps the POSIX shared memory segment called 'name', so
+/// that several engine processes can work on the same table. If the segment
+/// does not exist yet it is created with 'size' zero filled bytes, otherwise
+/// the existing one is mapped and 'size' is set to its actual size. A count of
+/// attached processes is kept in the segment, see shared_mem_detach(). Returns
+/// nullptr on failure or where POSIX shared memory is not available.
+
+void* shared_mem_attach(const std::string& name, size_t& size) {
+
+#ifdef USE_MMAP_ALLOC
+
+  bool created = true;
+  int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+
+  if (fd == -1 && errno == EEXIST)
+  {
+      created = false;
+      fd = shm_open(name.c_str(), O_RDWR, 0600);
+  }
+
+  if (fd == -1)
+      return nullptr;
+
+  if (created)
+  {
+      if (ftruncate(fd, off_t(sizeof(SharedMemHeader) + size)) == -1)
+      {
+          close(fd);
+          shm_unlink(name.c_str());
+          return nullptr;
+      }
+  }
+  else
+  {
+      // Wait for the creator to set the size, it is a matter of microseconds
+      struct stat st;
+
+      while (true)
+      {
+          if (fstat(fd, &st) == -1)
+          {
+              close(fd);
+              return nullptr;
+          }
+
+          if (size_t(st.st_size) > sizeof(SharedMemHeader))
+              break;
+
+          usleep(1000);
+      }
+
+      size = size_t(st.st_size) - sizeof(SharedMemHeader);
+  }
+
+  void* p = mmap(nullptr, sizeof(SharedMemHeader) + size, PROT_READ | PROT_WRITE,
+                 MAP_SHARED, fd, 0);
+  close(fd);
+
+  if (p == MAP_FAILED)
+      return nullptr;
+
+  SharedMemHeader* header = (SharedMemHeader*)p;
+  header->users++;
+
+  return header + 1;
+
+#else
+
+  (void)name; (void)size;
+  return nullptr;
+
+#endif
+}
+
+
+/// shared_mem_detach() unmaps a segment obtained with shared_mem_attach(). The
+/// last process to detach removes its name, so the memory is given back to the
+/// system once nobody uses it. A crashed process leaves the count too high and
+/// the segment stays in /dev/shm until removed by hand.
+
+void shared_mem_detach(void* mem, size_t size, const std::string& name) {
+
+#ifdef USE_MMAP_ALLOC
+
+  if (!mem)
+      return;
+
+  SharedMemHeader* header = (SharedMemHeader*)mem - 1;
+
+  if (--header->users == 0)
+      shm_unlink(name.c_str());
+
+  munmap(header, sizeof(SharedMemHeader) + size);
+
+#else
+
+  (void)mem; (void)size; (void)name;
+
+#endif
+}
+
+
+#if !defined(__linux__) || defined(__ANDROID__)
+
+/// Thread binding is only implemented on Linux, see numa.cpp
+
+namespace WinProcGroup {
+
+bool configure(bool, int) { return true; }
+int generation() { return 0; }
+bool bindThisThread(size_t) { return false; }
+
+} // namespace WinProcGroup
+
+#endif
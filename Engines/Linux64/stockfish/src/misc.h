@@ -27,11 +27,16 @@
 #include <string>
 #include <vector>
 
+#include "numa.h"
 #include "types.h"
 
 const std::string engine_info(bool to_uci = false);
 void prefetch(void* addr);
 void start_logger(const std::string& fname);
+void* large_mem_alloc(size_t size, void*& mem, bool largePages);
+void large_mem_free(void* mem, size_t size);
+void* shared_mem_attach(const std::string& name, size_t& size);
+void shared_mem_detach(void* mem, size_t size, const std::string& name);
 
 void dbg_hit_on(bool b);
 void dbg_hit_on(bool c, bool b);
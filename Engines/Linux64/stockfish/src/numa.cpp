@@ -0,0 +1,202 @@
+/*
+  Stockfish, a UCI chess playing engine derived from Glaurung 2.1
+  Copyright (C) 2004-2008 Tord Romstad (Glaurung author)
+  Copyright (C) 2008-2015 Marco Costalba, Joona Kiiski, Tord Romstad
+  Copyright (C) 2015-2016 Marco Costalba, Joona Kiiski, Gary Linscott, Tord Romstad
+
+  Stockfish is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Stockfish is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#if defined(__linux__) && !defined(__ANDROID__)
+
+#include <atomic>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <pthread.h>
+#include <sched.h>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+#include "numa.h"
+
+using namespace std;
+
+namespace WinProcGroup {
+
+namespace {
+
+struct Cpu {
+  int id, node;
+  bool primary; // First logical processor of its core
+};
+
+atomic<int> Generation(0);
+mutex PolicyMutex; // Guards Enabled and CpuOrder, read by threads being created
+bool Enabled;
+vector<Cpu> CpuOrder;
+cpu_set_t ProcessMask;
+thread_local int BoundNode = -1;
+thread_local bool Pinned = false;
+
+
+/// read_topology() lists the online logical processors the process may run on,
+/// with their NUMA node and whether they are the first one of their core, as
+/// found under /sys/devices/system/cpu.
+
+vector<Cpu> read_topology() {
+
+  vector<Cpu> cpus;
+  string line;
+
+  for (int i = 0; i < CPU_SETSIZE; ++i)
+  {
+      string dir = "/sys/devices/system/cpu/cpu" + to_string(i);
+
+      if (access(dir.c_str(), F_OK) != 0)
+          break;
+
+      if (!CPU_ISSET(i, &ProcessMask))
+          continue;
+
+      ifstream online(dir + "/online"); // Missing for cpu0
+      if (getline(online, line) && line != "1")
+          continue;
+
+      Cpu cpu = { i, 0, true };
+
+      for (int n = 0; n < 64; ++n)
+          if (access((dir + "/node" + to_string(n)).c_str(), F_OK) == 0)
+          {
+              cpu.node = n;
+              break;
+          }
+
+      ifstream siblings(dir + "/topology/thread_siblings_list");
+      if (getline(siblings, line))
+          cpu.primary = atoi(line.c_str()) == i;
+
+      cpus.push_back(cpu);
+  }
+
+  return cpus;
+}
+
+
+/// cpu_order() returns the logical processors in the order threads are bound to
+/// them: the physical cores of a node, then those of the next node, and only
+/// then the second hyper-thread of each core, spread evenly across the nodes.
+/// With node >= 0 only the processors of that node are used.
+
+vector<Cpu> cpu_order(const vector<Cpu>& cpus, int node) {
+
+  map<int, vector<Cpu>> primaries, siblings; // By node
+  vector<Cpu> order;
+
+  for (const Cpu& c : cpus)
+      if (node < 0 || c.node == node)
+          (c.primary ? primaries : siblings)[c.node].push_back(c);
+
+  for (const auto& p : primaries)
+      order.insert(order.end(), p.second.begin(), p.second.end());
+
+  for (size_t i = 0, added = 1; added; ++i)
+  {
+      added = 0;
+      for (const auto& s : siblings)
+          if (i < s.second.size())
+              order.push_back(s.second[i]), added = 1;
+  }
+
+  return order;
+}
+
+} // namespace
+
+
+/// configure() sets the binding policy from the "Bind Threads" and "NUMA Node"
+/// options and returns false if binding is enabled but no processor is found on
+/// the node. Threads pick up the change at the start of their next search, see
+/// generation().
+
+bool configure(bool enable, int node) {
+
+  // Remember the affinity we were started with (e.g. by taskset) before any
+  // thread is pinned, both to restrict the binding and to restore it.
+  static bool init = (sched_getaffinity(0, sizeof(ProcessMask), &ProcessMask), true);
+  (void)init;
+
+  vector<Cpu> order = enable ? cpu_order(read_topology(), node) : vector<Cpu>();
+  bool found = !enable || !order.empty();
+
+  {
+      lock_guard<mutex> lk(PolicyMutex);
+      Enabled = enable;
+      CpuOrder.swap(order);
+  }
+
+  ++Generation;
+  return found;
+}
+
+
+/// generation() is increased at each call to configure()
+
+int generation() { return Generation; }
+
+
+/// bindThisThread() pins the current thread to the logical processor given by
+/// its index, or gives it back the process affinity when binding is disabled.
+/// Returns true when the thread has just been pinned to another NUMA node, so
+/// that the caller can allocate its tables again there.
+
+bool bindThisThread(size_t idx) {
+
+  Cpu cpu = { -1, -1, false };
+
+  {
+      lock_guard<mutex> lk(PolicyMutex);
+      if (Enabled && !CpuOrder.empty())
+          cpu = CpuOrder[idx % CpuOrder.size()];
+  }
+
+  if (cpu.id >= 0)
+  {
+      cpu_set_t set;
+
+      CPU_ZERO(&set);
+      CPU_SET(cpu.id, &set);
+
+      if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set) != 0)
+          return false;
+
+      bool moved = cpu.node != BoundNode;
+      BoundNode = cpu.node, Pinned = true;
+      return moved;
+  }
+
+  if (Pinned)
+  {
+      pthread_setaffinity_np(pthread_self(), sizeof(ProcessMask), &ProcessMask);
+      BoundNode = -1, Pinned = false;
+  }
+
+  return false;
+}
+
+} // namespace WinProcGroup
+
+#endif
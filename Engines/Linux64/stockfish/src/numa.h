@@ -0,0 +1,38 @@
+/*
+  Stockfish, a UCI chess playing engine derived from Glaurung 2.1
+  Copyright (C) 2004-2008 Tord Romstad (Glaurung author)
+  Copyright (C) 2008-2015 Marco Costalba, Joona Kiiski, Tord Romstad
+  Copyright (C) 2015-2016 Marco Costalba, Joona Kiiski, Gary Linscott, Tord Romstad
+
+  Stockfish is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Stockfish is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef NUMA_H_INCLUDED
+#define NUMA_H_INCLUDED
+
+#include <cstddef>
+
+/// Thread binding, following Texel by Peter Österlund. On Linux, when enabled
+/// by the "Bind Threads" option, each search thread is pinned to a logical
+/// processor read from the /sys topology. Elsewhere these functions do nothing.
+/// The namespace is named after the Windows processor group code of other
+/// forks. McBrain builds numa.cpp too, so it uses nothing else of the engine.
+
+namespace WinProcGroup {
+  bool configure(bool enable, int node);
+  int generation();
+  bool bindThisThread(size_t idx);
+}
+
+#endif // #ifndef NUMA_H_INCLUDED
@@ -13,6 +13,7 @@
 #include <string.h>
 #include <sys/stat.h>
 #include <fcntl.h>
+#include <atomic>
 #ifndef _WIN32
 #include <unistd.h>
 #include <sys/mman.h>
@@ -52,6 +53,12 @@ static struct TBHashEntry TB_hash[1 << TBHASHBITS][HSHMAX];
 
 static struct DTZTableEntry DTZ_table[DTZ_ENTRIES];
 
+// Residency bookkeeping: bytes currently mapped by WDL and DTZ tables and the
+// search clock used to stamp entries, so that the least recently probed ones
+// can be unmapped when the tables grow beyond the "SyzygyMaxMB" budget.
+static std::atomic<uint64> TBMapped(0);
+static uint32 TBClock = 1;
+
 static void init_indices(void);
 static uint64 calc_key_from_pcs(int *pcs, int mirror);
 static void free_wdl_entry(struct TBEntry *entry);
@@ -88,7 +95,7 @@ static void close_tb(FD fd)
 #endif
 }
 
-static char *map_file(const char *name, const char *suffix, uint64 *mapping)
+static char *map_file(const char *name, const char *suffix, uint64 *mapping, uint64 *size)
 {
   FD fd = open_tb(name, suffix);
   if (fd == FD_ERR)
@@ -97,16 +104,21 @@ static char *map_file(const char *name, const char *suffix, uint64 *mapping)
   struct stat statbuf;
   fstat(fd, &statbuf);
   *mapping = statbuf.st_size;
+  *size = statbuf.st_size;
   char *data = (char *)mmap(NULL, statbuf.st_size, PROT_READ,
                               MAP_SHARED, fd, 0);
   if (data == (char *)(-1)) {
     printf("Could not mmap() %s.\n", name);
     exit(1);
   }
+#ifdef MADV_RANDOM
+  // Probes hit scattered blocks, read-ahead only wastes page cache
+  madvise(data, statbuf.st_size, MADV_RANDOM);
+#endif
 #else
   DWORD size_low, size_high;
   size_low = GetFileSize(fd, &size_high);
-//  *size = ((uint64)size_high) << 32 | ((uint64)size_low);
+  *size = ((uint64)size_high) << 32 | ((uint64)size_low);
   HANDLE map = CreateFileMapping(fd, NULL, PAGE_READONLY, size_high, size_low,
                                   NULL);
   if (map == NULL) {
@@ -121,21 +133,24 @@ static char *map_file(const char *name, const char *suffix, uint64 *mapping)
   }
 #endif
   close_tb(fd);
+  TBMapped += *size;
   return data;
 }
 
 #ifndef _WIN32
-static void unmap_file(char *data, uint64 size)
+static void unmap_file(char *data, uint64 mapping, uint64 size)
 {
   if (!data) return;
-  munmap(data, size);
+  munmap(data, mapping);
+  TBMapped -= size;
 }
 #else
-static void unmap_file(char *data, uint64 mapping)
+static void unmap_file(char *data, uint64 mapping, uint64 size)
 {
   if (!data) return;
   UnmapViewOfFile(data);
   CloseHandle((HANDLE)mapping);
+  TBMapped -= size;
 }
 #endif
 
@@ -217,6 +232,8 @@ static void init_tb(char *str)
     entry = (struct TBEntry *)&TB_pawn[TBnum_pawn++];
   }
   entry->key = key;
+  entry->mapsize = 0;
+  entry->stamp = 0;
   entry->ready = 0;
   entry->num = 0;
   for (i = 0; i < 16; i++)
@@ -258,6 +275,9 @@ void Tablebases::init(const std::string& path)
   char str[16];
   int i, j, k, l;
 
+  if (Prefetcher.joinable())
+    Prefetcher.join();
+
   if (initialized) {
     free(path_string);
     free(paths);
@@ -309,8 +329,10 @@ void Tablebases::init(const std::string& path)
       TB_hash[i][j].ptr = NULL;
     }
 
-  for (i = 0; i < DTZ_ENTRIES; i++)
+  for (i = 0; i < DTZ_ENTRIES; i++) {
+    DTZ_table[i].key1 = DTZ_table[i].key2 = 0ULL;
     DTZ_table[i].entry = NULL;
+  }
 
   for (i = 1; i < 6; i++) {
     sprintf(str, "K%cvK", pchr[i]);
@@ -1018,7 +1040,7 @@ static int init_table_wdl(struct TBEntry *entry, char *str)
 
   // first mmap the table into memory
 
-  entry->data = map_file(str, WDLSUFFIX, &entry->mapping);
+  entry->data = map_file(str, WDLSUFFIX, &entry->mapping, &entry->mapsize);
   if (!entry->data) {
     printf("Could not find %s" WDLSUFFIX, str);
     return 0;
@@ -1030,7 +1052,7 @@ static int init_table_wdl(struct TBEntry *entry, char *str)
       data[2] != WDL_MAGIC[2] ||
       data[3] != WDL_MAGIC[3]) {
     printf("Corrupted table.\n");
-    unmap_file(entry->data, entry->mapping);
+    unmap_file(entry->data, entry->mapping, entry->mapsize);
     entry->data = 0;
     return 0;
   }
@@ -1320,7 +1342,9 @@ void load_dtz_table(char *str, uint64 key1, uint64 key2)
                                 ? sizeof(struct DTZEntry_pawn)
                                 : sizeof(struct DTZEntry_piece));
 
-  ptr3->data = map_file(str, DTZSUFFIX, &ptr3->mapping);
+  ptr3->mapsize = 0;
+  ptr3->stamp = TBClock;
+  ptr3->data = map_file(str, DTZSUFFIX, &ptr3->mapping, &ptr3->mapsize);
   ptr3->key = ptr->key;
   ptr3->num = ptr->num;
   ptr3->symmetric = ptr->symmetric;
@@ -1333,20 +1357,26 @@ void load_dtz_table(char *str, uint64 key1, uint64 key2)
     struct DTZEntry_piece *entry = (struct DTZEntry_piece *)ptr3;
     entry->enc_type = ((struct TBEntry_piece *)ptr)->enc_type;
   }
-  if (!init_table_dtz(ptr3))
+  if (!init_table_dtz(ptr3)) {
+    unmap_file(ptr3->data, ptr3->mapping, ptr3->mapsize);
     free(ptr3);
-  else
+  } else
     DTZ_table[0].entry = ptr3;
 }
 
+// Also resets the entry so that the table is mapped again on next probe
 static void free_wdl_entry(struct TBEntry *entry)
 {
-  unmap_file(entry->data, entry->mapping);
+  unmap_file(entry->data, entry->mapping, entry->mapsize);
+  entry->data = NULL;
+  entry->mapsize = 0;
+  entry->ready = 0;
   if (!entry->has_pawns) {
     struct TBEntry_piece *ptr = (struct TBEntry_piece *)entry;
     free(ptr->precomp[0]);
     if (ptr->precomp[1])
       free(ptr->precomp[1]);
+    ptr->precomp[0] = ptr->precomp[1] = NULL;
   } else {
     struct TBEntry_pawn *ptr = (struct TBEntry_pawn *)entry;
     int f;
@@ -1354,13 +1384,14 @@ static void free_wdl_entry(struct TBEntry *entry)
       free(ptr->file[f].precomp[0]);
       if (ptr->file[f].precomp[1])
         free(ptr->file[f].precomp[1]);
+      ptr->file[f].precomp[0] = ptr->file[f].precomp[1] = NULL;
     }
   }
 }
 
 static void free_dtz_entry(struct TBEntry *entry)
 {
-  unmap_file(entry->data, entry->mapping);
+  unmap_file(entry->data, entry->mapping, entry->mapsize);
   if (!entry->has_pawns) {
     struct DTZEntry_piece *ptr = (struct DTZEntry_piece *)entry;
     free(ptr->precomp);
@@ -1373,6 +1404,41 @@ static void free_dtz_entry(struct TBEntry *entry)
   free(entry);
 }
 
+// Unmap the least recently probed tables until the mapped size fits within
+// budget. Must be called with TB_mutex held and no search probing.
+static void evict_tables(uint64 budget)
+{
+  while (TBMapped > budget) {
+    struct TBEntry *victim = NULL;
+    int dtz_idx = -1;
+    int i;
+
+    for (i = 0; i < TBnum_piece + TBnum_pawn; i++) {
+      struct TBEntry *entry = i < TBnum_piece ? (struct TBEntry *)&TB_piece[i]
+                                              : (struct TBEntry *)&TB_pawn[i - TBnum_piece];
+      if (entry->data && (!victim || entry->stamp < victim->stamp))
+        victim = entry;
+    }
+    for (i = 0; i < DTZ_ENTRIES; i++) {
+      struct TBEntry *entry = DTZ_table[i].entry;
+      if (entry && entry->data && (!victim || entry->stamp < victim->stamp)) {
+        victim = entry;
+        dtz_idx = i;
+      }
+    }
+    if (!victim)
+      break;
+
+    if (dtz_idx < 0)
+      free_wdl_entry(victim);
+    else {
+      free_dtz_entry(victim);
+      DTZ_table[dtz_idx].key1 = DTZ_table[dtz_idx].key2 = 0ULL;
+      DTZ_table[dtz_idx].entry = NULL;
+    }
+  }
+}
+
 static int wdl_to_map[5] = { 1, 3, 0, 2, 0 };
 static ubyte pa_flags[5] = { 8, 0, 0, 0, 4 };
 
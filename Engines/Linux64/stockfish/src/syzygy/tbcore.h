@@ -74,6 +74,8 @@ struct TBEntry {
   char *data;
   uint64 key;
   uint64 mapping;
+  uint64 mapsize;
+  uint32 stamp;
   ubyte ready;
   ubyte num;
   ubyte symmetric;
@@ -88,6 +90,8 @@ struct TBEntry_piece {
   char *data;
   uint64 key;
   uint64 mapping;
+  uint64 mapsize;
+  uint32 stamp;
   ubyte ready;
   ubyte num;
   ubyte symmetric;
@@ -103,6 +107,8 @@ struct TBEntry_pawn {
   char *data;
   uint64 key;
   uint64 mapping;
+  uint64 mapsize;
+  uint32 stamp;
   ubyte ready;
   ubyte num;
   ubyte symmetric;
@@ -120,6 +126,8 @@ struct DTZEntry_piece {
   char *data;
   uint64 key;
   uint64 mapping;
+  uint64 mapsize;
+  uint32 stamp;
   ubyte ready;
   ubyte num;
   ubyte symmetric;
@@ -138,6 +146,8 @@ struct DTZEntry_pawn {
   char *data;
   uint64 key;
   uint64 mapping;
+  uint64 mapsize;
+  uint32 stamp;
   ubyte ready;
   ubyte num;
   ubyte symmetric;
@@ -10,15 +10,40 @@
 #define NOMINMAX
 
 #include <algorithm>
+#include <numeric>
+#include <chrono>
+#include <sstream>
+#include <thread>
 
 #include "../position.h"
 #include "../movegen.h"
 #include "../bitboard.h"
 #include "../search.h"
+#include "../thread.h"
+#include "../uci.h"
 
 #include "tbprobe.h"
 #include "tbcore.h"
 
+namespace {
+
+  typedef std::chrono::steady_clock Clock;
+
+  // Load statistics of the current search, reported by stats(). Probes are
+  // counted per thread and only one in ProbeSample is timed, so that the
+  // search threads share neither a counter nor the cost of reading the clock.
+  const uint64 ProbeSample = 64;
+  std::atomic<uint64> Loads(0), LoadNs(0);
+
+  std::thread Prefetcher;
+  std::atomic_bool PrefetchStop(false);
+
+  uint64 elapsed_ns(Clock::time_point start) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+  }
+
+}
+
 #include "tbcore.cpp"
 
 namespace Zobrist {
@@ -48,6 +73,24 @@ static void prt_str(Position& pos, char *str, int mirror)
   *str++ = 0;
 }
 
+// Same as prt_str() but starting from a piece count array indexed like the
+// one used by calc_key_from_pcs().
+static void prt_str_from_pcs(int *pcs, char *str, int mirror)
+{
+  int color, pt, i;
+
+  color = !mirror ? 0 : 8;
+  for (pt = TB_KING; pt >= TB_PAWN; --pt)
+    for (i = pcs[color | pt]; i > 0; i--)
+      *str++ = pchr[6 - pt];
+  *str++ = 'v';
+  color ^= 8;
+  for (pt = TB_KING; pt >= TB_PAWN; --pt)
+    for (i = pcs[color | pt]; i > 0; i--)
+      *str++ = pchr[6 - pt];
+  *str++ = 0;
+}
+
 // Given a position, produce a 64-bit material signature key.
 // If the engine supports such a key, it should equal the engine's key.
 static uint64 calc_key(Position& pos, int mirror)
@@ -108,6 +151,32 @@ static ubyte decompress_pairs(struct PairsData *d, uint64 idx)
                         : decompress_pairs<false>(d, idx);
 }
 
+// Map the WDL table of ptr on first use. Returns 0 if it can't be loaded.
+static int load_wdl_table(struct TBEntry *ptr, char *str)
+{
+  int ok = 1;
+
+  LOCK(TB_mutex);
+  if (!ptr->ready) {
+    Clock::time_point start = Clock::now();
+    if (!init_table_wdl(ptr, str))
+      ok = 0;
+    else {
+      // Memory barrier to ensure ptr->ready = 1 is not reordered.
+#ifdef _MSC_VER
+      _ReadWriteBarrier();
+#else
+      __asm__ __volatile__ ("" ::: "memory");
+#endif
+      ptr->ready = 1;
+      Loads++;
+      LoadNs += elapsed_ns(start);
+    }
+  }
+  UNLOCK(TB_mutex);
+  return ok;
+}
+
 // probe_wdl_table and probe_dtz_table require similar adaptations.
 static int probe_wdl_table(Position& pos, int *success)
 {
@@ -136,26 +205,15 @@ static int probe_wdl_table(Position& pos, int *success)
 
   ptr = ptr2[i].ptr;
   if (!ptr->ready) {
-    LOCK(TB_mutex);
-    if (!ptr->ready) {
-      char str[16];
-      prt_str(pos, str, ptr->key != key);
-      if (!init_table_wdl(ptr, str)) {
-        ptr2[i].key = 0ULL;
-        *success = 0;
-        UNLOCK(TB_mutex);
-        return 0;
-      }
-      // Memory barrier to ensure ptr->ready = 1 is not reordered.
-#ifdef _MSC_VER
-      _ReadWriteBarrier();
-#else
-      __asm__ __volatile__ ("" ::: "memory");
-#endif
-      ptr->ready = 1;
+    char str[16];
+    prt_str(pos, str, ptr->key != key);
+    if (!load_wdl_table(ptr, str)) {
+      ptr2[i].key = 0ULL;
+      *success = 0;
+      return 0;
     }
-    UNLOCK(TB_mutex);
   }
+  ptr->stamp = TBClock;
 
   int bside, mirror, cmirror;
   if (!ptr->symmetric) {
@@ -255,6 +313,7 @@ static int probe_dtz_table(Position& pos, int wdl, int *success)
     *success = 0;
     return 0;
   }
+  ptr->stamp = TBClock;
 
   int bside, mirror, cmirror;
   if (!ptr->symmetric) {
@@ -402,8 +461,16 @@ int Tablebases::probe_wdl(Position& pos, int *success)
 {
   int v;
 
+  Thread* th = pos.this_thread();
   *success = 1;
-  v = probe_ab(pos, -2, 2, success);
+  if (th->tbProbes++ % ProbeSample == 0)
+  {
+      Clock::time_point start = Clock::now();
+      v = probe_ab(pos, -2, 2, success);
+      th->tbProbeNs += elapsed_ns(start);
+  }
+  else
+      v = probe_ab(pos, -2, 2, success);
 
   // If en passant is not possible, we are done.
   if (pos.ep_square() == SQ_NONE)
@@ -822,3 +889,105 @@ bool Tablebases::root_probe_wdl(Position& pos, Search::RootMoves& rootMoves, Val
   return true;
 }
 
+
+// Called before each search, while no thread is probing. Unmaps the least
+// recently used tables when above the "SyzygyMaxMB" budget, resets the
+// statistics and, if "SyzygyPrefetch" is set, maps in the background the WDL
+// tables the search is about to need: the root material and every material
+// one capture away from it.
+void Tablebases::new_search(Position& pos)
+{
+  if (Prefetcher.joinable())
+      Prefetcher.join();
+
+  Loads = LoadNs = 0;
+  for (Thread* th : Threads)
+      th->tbProbes = th->tbProbeNs = 0;
+
+  if (!MaxCardinality)
+      return;
+
+  uint64 budget = uint64(int(Options["SyzygyMaxMB"])) << 20;
+
+  LOCK(TB_mutex);
+  ++TBClock;
+  if (budget)
+      evict_tables(budget);
+  UNLOCK(TB_mutex);
+
+  if (!Options["SyzygyPrefetch"] || popcount(pos.pieces()) > MaxCardinality + 1)
+      return;
+
+  std::vector<int> pcs(16, 0);
+  for (Color c = WHITE; c <= BLACK; ++c)
+      for (PieceType pt = PAWN; pt <= KING; ++pt)
+          pcs[(c == WHITE ? 0 : 8) | pt] = popcount(pos.pieces(c, pt));
+
+  Prefetcher = std::thread([pcs, budget]() {
+
+      std::vector<std::vector<int>> materials;
+      if (std::accumulate(pcs.begin(), pcs.end(), 0) <= MaxCardinality)
+          materials.push_back(pcs);
+
+      for (int i = 0; i < 16; ++i)
+          if ((i & 7) >= TB_PAWN && (i & 7) < TB_KING && pcs[i])
+          {
+              materials.push_back(pcs);
+              materials.back()[i]--;
+          }
+
+      for (auto& m : materials)
+      {
+          if (PrefetchStop)
+              break;
+
+          uint64 key = calc_key_from_pcs(m.data(), 0);
+          struct TBHashEntry *ptr2 = TB_hash[key >> (64 - TBHASHBITS)];
+          int i;
+          for (i = 0; i < HSHMAX; i++)
+            if (ptr2[i].key == key) break;
+          if (i == HSHMAX)
+              continue;
+
+          struct TBEntry *ptr = ptr2[i].ptr;
+          char str[16];
+          prt_str_from_pcs(m.data(), str, ptr->key != key);
+          if (!ptr->ready && !load_wdl_table(ptr, str))
+              continue;
+
+#if !defined(_WIN32) && defined(MADV_WILLNEED)
+          if (!budget || TBMapped <= budget)
+              madvise(ptr->data, ptr->mapsize, MADV_WILLNEED);
+#endif
+      }
+  });
+}
+
+// Returns a one line summary of the probes done since the last new_search(),
+// or an empty string if there were none.
+std::string Tablebases::stats()
+{
+  uint64 probes = 0, probeNs = 0;
+  for (Thread* th : Threads)
+      probes += th->tbProbes, probeNs += th->tbProbeNs;
+  if (!probes)
+      return std::string();
+
+  std::stringstream ss;
+  ss << "tbstats probes " << probes
+     << " avgns " << probeNs / ((probes + ProbeSample - 1) / ProbeSample)
+     << " loads " << Loads
+     << " loadms " << LoadNs / 1000000
+     << " mappedmb " << (TBMapped >> 20);
+  return ss.str();
+}
+
+// Called on exit: stops a prefetch still running, so that its thread is not
+// destroyed while joinable.
+void Tablebases::exit()
+{
+  PrefetchStop = true;
+  if (Prefetcher.joinable())
+      Prefetcher.join();
+  PrefetchStop = false;
+}
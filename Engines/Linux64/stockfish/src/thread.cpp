@@ -36,7 +36,8 @@ Thread::Thread() {
 
   resetCalls = exit = false;
   maxPly = callsCnt = 0;
-  tbHits = 0;
+  bindGeneration = -1;
+  tbHits = tbProbes = tbProbeNs = 0;
   history.clear();
   counterMoves.clear();
   idx = Threads.size(); // Start from 0
@@ -111,7 +112,28 @@ void Thread::idle_loop() {
       lk.unlock();
 
       if (!exit)
+      {
+          if (bindGeneration != WinProcGroup::generation())
+              bind();
+
           search();
+      }
+  }
+}
+
+
+/// Thread::bind() applies the current thread binding policy. Once pinned to
+/// another NUMA node the thread allocates its pawn and material tables again,
+/// so that their pages are first touched, and placed, in its local memory.
+
+void Thread::bind() {
+
+  bindGeneration = WinProcGroup::generation();
+
+  if (WinProcGroup::bindThisThread(idx))
+  {
+      pawnsTable = Pawns::Table();
+      materialTable = Material::Table();
   }
 }
 
@@ -196,6 +218,8 @@ void ThreadPool::start_thinking(Position& pos, StateListPtr& states,
           || std::count(limits.searchmoves.begin(), limits.searchmoves.end(), m))
           rootMoves.push_back(Search::RootMove(m));
 
+  Tablebases::new_search(pos);
+
   if (!rootMoves.empty())
       Tablebases::filter_root_moves(pos, rootMoves);
 
@@ -53,6 +53,7 @@ public:
   virtual ~Thread();
   virtual void search();
   void idle_loop();
+  void bind();
   void start_searching(bool resume = false);
   void wait_for_search_finished();
   void wait(std::atomic_bool& b);
@@ -61,8 +62,8 @@ public:
   Material::Table materialTable;
   Endgames endgames;
   size_t idx, PVIdx;
-  int maxPly, callsCnt;
-  uint64_t tbHits;
+  int maxPly, callsCnt, bindGeneration;
+  uint64_t tbHits, tbProbes, tbProbeNs;
 
   Position rootPos;
   Search::RootMoves rootMoves;
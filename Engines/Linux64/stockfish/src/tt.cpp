@@ -18,30 +18,89 @@
   along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include <algorithm> // For std::max
 #include <cstring>   // For std::memset
+#include <fstream>
 #include <iostream>
+#include <thread>
+#include <vector>
 
 #include "bitboard.h"
 #include "tt.h"
+#include "uci.h"
 
 TranspositionTable TT; // Our global transposition table
 
+namespace {
+
+  // Header of a hash file written by TranspositionTable::save()
+  struct HashFileHeader {
+    char magic[8];
+    uint64_t clusterCount;
+    uint64_t clusterSize;
+    uint64_t usedClusters;
+    uint8_t generation;
+    char padding[7];
+  };
+
+  const char HashFileMagic[8] = { 'S', 'F', 'H', 'A', 'S', 'H', '0', '1' };
+
+} // namespace
+
 
 /// TranspositionTable::resize() sets the size of the transposition table,
 /// measured in megabytes. Transposition table consists of a power of 2 number
 /// of clusters and each cluster consists of ClusterSize number of TTEntry.
+/// The table is also reallocated when the "Large Pages" or "Shared Hash"
+/// options change. When "Shared Hash" names a segment already created by
+/// another process, that segment is used with its own size. Entries are
+/// accessed without locks in both cases, a torn entry is harmless because
+/// moves are validated before use.
 
 void TranspositionTable::resize(size_t mbSize) {
 
   size_t newClusterCount = size_t(1) << msb((mbSize * 1024 * 1024) / sizeof(Cluster));
+  bool useLargePages = Options["Large Pages"];
+  std::string shmName = Options["Shared Hash"];
+
+  if (shmName == "<empty>")
+      shmName.clear();
 
-  if (newClusterCount == clusterCount)
+  else if (shmName[0] != '/')
+      shmName = "/" + shmName;
+
+  if (   newClusterCount == clusterCount
+      && useLargePages == largePages
+      && shmName == sharedName)
       return;
 
+  release();
+
   clusterCount = newClusterCount;
+  largePages = useLargePages;
+  memSize = clusterCount * sizeof(Cluster);
+
+  if (!shmName.empty())
+  {
+      // A new segment is zero filled and an existing one holds the work of the
+      // other processes, so in both cases there is nothing to clear.
+      table = (Cluster*)shared_mem_attach(shmName, memSize);
 
-  free(mem);
-  mem = calloc(clusterCount * sizeof(Cluster) + CacheLineSize - 1, 1);
+      if (table)
+      {
+          mem = table;
+          sharedName = shmName;
+          clusterCount = size_t(1) << msb(memSize / sizeof(Cluster));
+          return;
+      }
+
+      sync_cout << "info string Could not attach shared hash " << shmName
+                << ", using a private one" << sync_endl;
+
+      memSize = clusterCount * sizeof(Cluster);
+  }
+
+  table = (Cluster*)large_mem_alloc(memSize, mem, largePages);
 
   if (!mem)
   {
@@ -50,17 +109,53 @@ void TranspositionTable::resize(size_t mbSize) {
       exit(EXIT_FAILURE);
   }
 
-  table = (Cluster*)((uintptr_t(mem) + CacheLineSize - 1) & ~(CacheLineSize - 1));
+  clear(); // First touch of the pages, done in parallel
+}
+
+
+/// TranspositionTable::release() frees the table memory, or detaches from the
+/// shared segment.
+
+void TranspositionTable::release() {
+
+  if (is_shared())
+      shared_mem_detach(mem, memSize, sharedName);
+  else
+      large_mem_free(mem, memSize);
+
+  mem = nullptr;
+  memSize = 0;
+  sharedName.clear();
 }
 
 
 /// TranspositionTable::clear() overwrites the entire transposition table
 /// with zeros. It is called whenever the table is resized, or when the
-/// user asks the program to clear the table (from the UCI interface).
+/// user asks the program to clear the table (from the UCI interface). The
+/// work is split over one helper thread per search thread, so that clearing
+/// a big table does not stall 'ucinewgame' and pages are faulted in by many
+/// cores at once. A shared table is left alone, other processes rely on it.
 
 void TranspositionTable::clear() {
 
-  std::memset(table, 0, clusterCount * sizeof(Cluster));
+  if (is_shared())
+      return;
+
+  const size_t threadCount = std::max(int(Options["Threads"]), 1);
+  std::vector<std::thread> threads;
+
+  for (size_t idx = 0; idx < threadCount; ++idx)
+      threads.emplace_back([this, idx, threadCount]() {
+
+          const size_t stride = clusterCount / threadCount,
+                       start  = stride * idx,
+                       len    = idx != threadCount - 1 ? stride : clusterCount - start;
+
+          std::memset(&table[start], 0, len * sizeof(Cluster));
+      });
+
+  for (std::thread& th : threads)
+      th.join();
 }
 
 
@@ -115,3 +210,124 @@ int TranspositionTable::hashfull() const {
   }
   return cnt;
 }
+
+
+/// TranspositionTable::save() dumps the non-empty clusters of the table to a
+/// file, each one preceded by its index, so that a restarted engine can reload
+/// the work of a long analysis. Data is written in native byte order, files
+/// are meant to be reloaded on the same machine.
+
+bool TranspositionTable::save(const std::string& fname) const {
+
+  std::ofstream file(fname, std::ios::binary);
+
+  if (!file)
+      return false;
+
+  HashFileHeader header = {};
+
+  std::memcpy(header.magic, HashFileMagic, sizeof(HashFileMagic));
+  header.clusterCount = clusterCount;
+  header.clusterSize = sizeof(Cluster);
+  header.generation = generation8;
+
+  file.write((const char*)&header, sizeof(header)); // usedClusters is patched below
+
+  for (size_t i = 0; i < clusterCount; ++i)
+  {
+      const TTEntry* tte = &table[i].entry[0];
+
+      if (!tte[0].key16 && !tte[1].key16 && !tte[2].key16)
+          continue;
+
+      uint64_t idx = i;
+      file.write((const char*)&idx, sizeof(idx));
+      file.write((const char*)&table[i], sizeof(Cluster));
+      header.usedClusters++;
+  }
+
+  file.seekp(0);
+  file.write((const char*)&header, sizeof(header));
+
+  return bool(file);
+}
+
+
+/// TranspositionTable::load() reads back a file written by save(). When the
+/// table has the same size as when it was saved, clusters are restored in
+/// place. A file from a bigger table is folded into the current one, keeping
+/// the deepest entries, while a file from a smaller table can't be mapped
+/// because the index bits of the missing keys are lost, and is rejected. The
+/// whole file is checked before the table is touched, so that a truncated or
+/// corrupted file leaves it as it was.
+
+bool TranspositionTable::load(const std::string& fname) {
+
+  std::ifstream file(fname, std::ios::binary);
+  HashFileHeader header;
+
+  if (   !file.read((char*)&header, sizeof(header))
+      || std::memcmp(header.magic, HashFileMagic, sizeof(HashFileMagic))
+      || header.clusterSize != sizeof(Cluster)
+      || header.clusterCount < clusterCount)
+      return false;
+
+  const bool sameSize = header.clusterCount == clusterCount;
+  const std::streampos records = file.tellg();
+  uint64_t idx;
+  Cluster c;
+
+  for (uint64_t n = 0; n < header.usedClusters; ++n)
+      if (   !file.read((char*)&idx, sizeof(idx))
+          || !file.read((char*)&c, sizeof(Cluster))
+          || idx >= header.clusterCount)
+          return false;
+
+  file.seekg(records);
+
+  for (uint64_t n = 0; n < header.usedClusters; ++n)
+  {
+      // The file changed under us after being checked: don't keep half of it
+      if (   !file.read((char*)&idx, sizeof(idx))
+          || !file.read((char*)&c, sizeof(Cluster))
+          || idx >= header.clusterCount)
+      {
+          clear();
+          return false;
+      }
+
+      if (sameSize)
+      {
+          table[idx] = c;
+          continue;
+      }
+
+      TTEntry* tte = &table[idx & (clusterCount - 1)].entry[0];
+
+      for (const TTEntry& e : c.entry)
+      {
+          if (!e.key16)
+              continue;
+
+          // Take the slot of the same position, an empty one or the shallowest
+          TTEntry* replace = tte;
+          for (int i = 0; i < ClusterSize; ++i)
+          {
+              if (!tte[i].key16 || tte[i].key16 == e.key16)
+              {
+                  replace = &tte[i];
+                  break;
+              }
+              if (tte[i].depth8 < replace->depth8)
+                  replace = &tte[i];
+          }
+
+          if (!replace->key16 || replace->depth8 <= e.depth8)
+              *replace = e;
+      }
+  }
+
+  generation8 = header.generation;
+
+  return true;
+}
@@ -21,6 +21,8 @@
 #ifndef TT_H_INCLUDED
 #define TT_H_INCLUDED
 
+#include <string>
+
 #include "misc.h"
 #include "types.h"
 
@@ -96,13 +98,16 @@ class TranspositionTable {
   static_assert(CacheLineSize % sizeof(Cluster) == 0, "Cluster size incorrect");
 
 public:
- ~TranspositionTable() { free(mem); }
+ ~TranspositionTable() { release(); }
   void new_search() { generation8 += 4; } // Lower 2 bits are used by Bound
   uint8_t generation() const { return generation8; }
   TTEntry* probe(const Key key, bool& found) const;
   int hashfull() const;
   void resize(size_t mbSize);
   void clear();
+  bool save(const std::string& fname) const;
+  bool load(const std::string& fname);
+  bool is_shared() const { return !sharedName.empty(); }
 
   // The lowest order bits of the key are used to get the index of the cluster
   TTEntry* first_entry(const Key key) const {
@@ -110,9 +115,14 @@ public:
   }
 
 private:
+  void release();
+
   size_t clusterCount;
   Cluster* table;
   void* mem;
+  size_t memSize;
+  bool largePages;
+  std::string sharedName;
   uint8_t generation8; // Size must be not bigger than TTEntry::genBound8
 };
 
@@ -18,9 +18,12 @@
   along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include <atomic>
 #include <iostream>
 #include <sstream>
 #include <string>
+#include <thread>
+#include <vector>
 
 #include "evaluate.h"
 #include "movegen.h"
@@ -28,11 +31,15 @@
 #include "search.h"
 #include "thread.h"
 #include "timeman.h"
+#include "tt.h"
 #include "uci.h"
 
 using namespace std;
 
 extern void benchmark(const Position& pos, istream& is);
+extern void json_benchmark(const Position& pos, istream& is);
+extern void shared_benchmark(const Position& pos, istream& is);
+extern void thread_benchmark(const Position& pos, istream& is);
 
 namespace {
 
@@ -135,6 +142,118 @@ namespace {
     Threads.start_thinking(pos, States, limits);
   }
 
+
+  // analysegame() is called when engine receives the "analysegame" command,
+  // a non-UCI extension to analyse a whole game in one go. The syntax is
+  //
+  //   analysegame [depth <x>] [nodes <x>] [movetime <x>] startpos|fen <fen> moves <m1> ... <mn>
+  //
+  // The positions before each move are searched from the last one back to the
+  // start position. Transposition table and history tables are not cleared in
+  // between, so each search starts with the results of the later plies of the
+  // game, much as when searching forward to the same depth. Before each search
+  // "info string ply <n> move <m>" is sent, followed by the usual info lines
+  // and "bestmove". Like "go", the command returns at once: the plies are fed
+  // one by one to the main search thread by the Analyser thread, that gives up
+  // at the first "stop" or "quit", or at a command that needs the engine idle.
+
+  std::thread Analyser;
+  std::atomic_bool AnalyserStop(false);
+
+  void analysegame(Position& pos, istringstream& is) {
+
+    Search::LimitsType limits;
+    string token, fen;
+    vector<Move> moves;
+
+    while (is >> token && token != "startpos" && token != "fen")
+        if (token == "depth")          is >> limits.depth;
+        else if (token == "nodes")     is >> limits.nodes;
+        else if (token == "movetime")  is >> limits.movetime;
+
+    if (token == "startpos")
+    {
+        fen = StartFEN;
+        is >> token; // Consume "moves" token if any
+    }
+    else if (token == "fen")
+        while (is >> token && token != "moves")
+            fen += token + " ";
+    else
+        return;
+
+    if (!limits.depth && !limits.nodes && !limits.movetime)
+        limits.depth = 20;
+
+    // Validate the move list once, stopping at the first illegal move. As
+    // with "position", the game is left set up for the commands that follow.
+    States = StateListPtr(new std::deque<StateInfo>(1));
+    bool chess960 = Options["UCI_Chess960"];
+    pos.set(fen, chess960, &States->back(), Threads.main());
+
+    for (Move m; is >> token && (m = UCI::to_move(pos, token)) != MOVE_NONE; )
+    {
+        moves.push_back(m);
+        States->push_back(StateInfo());
+        pos.do_move(m, States->back(), pos.gives_check(m));
+    }
+
+    AnalyserStop = false;
+    Analyser = std::thread([fen, moves, limits, chess960]() mutable {
+
+        Position p;
+
+        for (int ply = int(moves.size()) - 1; ply >= 0 && !AnalyserStop; --ply)
+        {
+            StateListPtr plyStates(new std::deque<StateInfo>(1));
+            p.set(fen, chess960, &plyStates->back(), Threads.main());
+
+            for (int i = 0; i < ply; ++i)
+            {
+                plyStates->push_back(StateInfo());
+                p.do_move(moves[i], plyStates->back(), p.gives_check(moves[i]));
+            }
+
+            sync_cout << "info string ply " << ply + 1 << " move "
+                      << UCI::move(moves[ply], chess960) << sync_endl;
+
+            limits.startTime = now();
+            Threads.start_thinking(p, plyStates, limits);
+
+            // A "stop" sent while start_thinking() was clearing the signals
+            if (AnalyserStop)
+                Search::Signals.stop = true;
+
+            Threads.main()->wait_for_search_finished();
+        }
+
+        sync_cout << "info string analysegame " << (AnalyserStop ? "stopped" : "done") << sync_endl;
+    });
+  }
+
+
+  // hashfile() is called when engine receives the "savehash" or "loadhash"
+  // command, followed by a file name (can contain spaces). The transposition
+  // table is written to or read from that file, so that the analysis built up
+  // by an engine instance is not lost when the GUI restarts it.
+
+  void hashfile(const string& cmd, istringstream& is) {
+
+    string token, fname;
+
+    while (is >> token)
+        fname += string(" ", fname.empty() ? 0 : 1) + token;
+
+    Threads.main()->wait_for_search_finished();
+
+    TimePoint elapsed = now();
+    bool ok = cmd == "savehash" ? TT.save(fname) : TT.load(fname);
+
+    sync_cout << "info string " << cmd << " " << fname
+              << (ok ? " done in " + std::to_string(now() - elapsed) + " ms" : " failed")
+              << sync_endl;
+  }
+
 } // namespace
 
 
@@ -163,6 +282,18 @@ void UCI::loop(int argc, char* argv[]) {
       token.clear(); // getline() could return empty or blank line
       is >> skipws >> token;
 
+      // While a game is being analysed only the commands that don't start a
+      // search or touch the search tables are served at once. The others
+      // stop the analysis first, as "stop" does, and wait for it to end.
+      if (   Analyser.joinable()
+          && token != "quit" && token != "stop" && token != "isready"
+          && token != "uci"  && token != "position" && token != "d")
+      {
+          AnalyserStop = true;
+          Search::Signals.stop = true;
+          Analyser.join();
+      }
+
       // The GUI sends 'ponderhit' to tell us to ponder on the same move the
       // opponent has played. In case Signals.stopOnPonderhit is set we are
       // waiting for 'ponderhit' to stop the search (for instance because we
@@ -172,6 +303,8 @@ void UCI::loop(int argc, char* argv[]) {
           ||  token == "stop"
           || (token == "ponderhit" && Search::Signals.stopOnPonderhit))
       {
+          if (token != "ponderhit")
+              AnalyserStop = true;
           Search::Signals.stop = true;
           Threads.main()->start_searching(true); // Could be sleeping
       }
@@ -191,11 +324,16 @@ void UCI::loop(int argc, char* argv[]) {
       else if (token == "isready")    sync_cout << "readyok" << sync_endl;
       else if (token == "go")         go(pos, is);
       else if (token == "position")   position(pos, is);
+      else if (token == "analysegame") analysegame(pos, is);
       else if (token == "setoption")  setoption(is);
+      else if (token == "savehash" || token == "loadhash") hashfile(token, is);
 
       // Additional custom non-UCI commands, useful for debugging
       else if (token == "flip")       pos.flip();
       else if (token == "bench")      benchmark(pos, is);
+      else if (token == "benchjson")  json_benchmark(pos, is);
+      else if (token == "sharedbench") shared_benchmark(pos, is);
+      else if (token == "threadbench") thread_benchmark(pos, is);
       else if (token == "d")          sync_cout << pos << sync_endl;
       else if (token == "eval")       sync_cout << Eval::trace(pos) << sync_endl;
       else if (token == "perft")
@@ -214,6 +352,9 @@ void UCI::loop(int argc, char* argv[]) {
 
   } while (token != "quit" && argc == 1); // Passed args have one-shot behaviour
 
+  if (Analyser.joinable())
+      Analyser.join();
+
   Threads.main()->wait_for_search_finished();
 }
 
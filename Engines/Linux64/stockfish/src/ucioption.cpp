@@ -20,6 +20,7 @@
 
 #include <algorithm>
 #include <cassert>
+#include <iostream>
 #include <ostream>
 
 #include "misc.h"
@@ -38,8 +39,13 @@ namespace UCI {
 /// 'On change' actions, triggered by an option's value change
 void on_clear_hash(const Option&) { Search::clear(); }
 void on_hash_size(const Option& o) { TT.resize(o); }
+void on_tt_memory(const Option&) { TT.resize(Options["Hash"]); }
 void on_logger(const Option& o) { start_logger(o); }
 void on_threads(const Option&) { Threads.read_uci_options(); }
+void on_binding(const Option&) {
+  if (!WinProcGroup::configure(Options["Bind Threads"], Options["NUMA Node"]))
+      sync_cout << "info string No processor found on NUMA node " << int(Options["NUMA Node"]) << sync_endl;
+}
 void on_tb_path(const Option& o) { Tablebases::init(o); }
 
 
@@ -60,8 +66,12 @@ void init(OptionsMap& o) {
   o["Debug Log File"]        << Option("", on_logger);
   o["Contempt"]              << Option(0, -100, 100);
   o["Threads"]               << Option(1, 1, 128, on_threads);
+  o["Bind Threads"]          << Option(false, on_binding);
+  o["NUMA Node"]             << Option(-1, -1, 63, on_binding);
   o["Hash"]                  << Option(16, 1, MaxHashMB, on_hash_size);
   o["Clear Hash"]            << Option(on_clear_hash);
+  o["Large Pages"]           << Option(true, on_tt_memory);
+  o["Shared Hash"]           << Option("<empty>", on_tt_memory);
   o["Ponder"]                << Option(false);
   o["MultiPV"]               << Option(1, 1, 500);
   o["Skill Level"]           << Option(20, 0, 20);
@@ -74,6 +84,8 @@ void init(OptionsMap& o) {
   o["SyzygyProbeDepth"]      << Option(1, 1, 100);
   o["Syzygy50MoveRule"]      << Option(true);
   o["SyzygyProbeLimit"]      << Option(6, 0, 6);
+  o["SyzygyMaxMB"]           << Option(0, 0, 1048576);
+  o["SyzygyPrefetch"]        << Option(false);
 }
 
 
@@ -297,6 +297,7 @@ static int GTB_scheme = 4;
 \*************************************************/
 
 #define EGTB_MAXBLOCKSIZE 65536
+#define GTB_ENTRIES_PER_BLOCK (16 * 1024) /* fixed, needed for the compression schemes */
 
 static int GTB_MAXOPEN = 4;
 
@@ -329,7 +330,26 @@ static size_t			WDL_cache_size = 0;
 static unsigned int		TB_AVAILABILITY = 0;
 
 /* LOCKS */
-static mythread_mutex_t	Egtb_lock;
+static mythread_mutex_t	Egtb_lock; /* file handles, drive counters */
+
+struct general_counters {
+	/* counters */
+	uint64_t		hits;
+	uint64_t		miss;
+	uint64_t		waits;
+};
+
+static struct general_counters Drive = {0,0,0};
+
+static void
+counted_lock (mythread_mutex_t *m, uint64_t *waits)
+/* lock and count the times another thread was holding it */
+{
+	if (!mythread_mutex_trylock (m)) {
+		mythread_mutex_lock (m);
+		(*waits)++;
+	}
+}
 
 
 /****************************************************************************\
@@ -631,7 +651,11 @@ biggest_memory_needed (void) {
 mySHARED bool_t		get_dtm (tbkey_t key, unsigned side, index_t idx, dtm_t *out, bool_t probe_hard);
 #endif
 
-static bool_t	 	get_dtm_from_cache (tbkey_t key, unsigned side, index_t idx, dtm_t *out);
+struct cache_table;
+struct WDL_CACHE;
+static bool_t	 	get_dtm_from_cache (struct cache_table *c, tbkey_t key, unsigned side, index_t idx, dtm_t *out);
+static void			cache_locks_init (void);
+static void			cache_locks_done (void);
 
 
 /*--------------------------------*\
@@ -1058,8 +1082,8 @@ static void 		wdl_cache_flush (void);
 static void			wdl_cache_reset_counters (void);
 static void			wdl_cache_done (void);
 
-static bool_t		get_WDL_from_cache (tbkey_t key, unsigned side, index_t idx, unsigned int *out);
-static bool_t		wdl_preload_cache (tbkey_t key, unsigned side, index_t idx);
+static bool_t		get_WDL_from_cache (struct WDL_CACHE *w, tbkey_t key, unsigned side, index_t idx, unsigned int *out);
+static bool_t		wdl_preload_cache (struct WDL_CACHE *w, tbkey_t key, unsigned side, index_t idx);
 #endif
 
 #ifdef GTB_SHARE
@@ -1197,6 +1221,7 @@ tb_init (int verbosity, int decoding_sch, const char **paths)
 	Bytes_read = 0;
 
 	mythread_mutex_init (&Egtb_lock);
+	cache_locks_init();
 
 	TB_INITIALIZED = TRUE;
 
@@ -1224,6 +1249,7 @@ tb_done (void)
 	zipinfo_done();
 	path_system_done();
 	mythread_mutex_destroy (&Egtb_lock);
+	cache_locks_done();
 	TB_INITIALIZED = FALSE;
 
 	/*
@@ -1800,13 +1826,9 @@ egtb_get_dtm (tbkey_t k, unsigned stm, const SQUARE *wS, const SQUARE *bS, bool_
 		if (idxavail) {
 			bool_t success;
 
-			/*
-			|		LOCK
-			*-------------------------------*/
-			mythread_mutex_lock (&Egtb_lock);
-
 			if (dtm_cache_is_on()) {
 
+				/* locks the cache shard and the files as needed */
 				success = get_dtm       (k, stm, idx, dtm, probe_hard_flag);
 
 				FOLLOW_LU("get_dtm (succ)",success)
@@ -1820,7 +1842,9 @@ egtb_get_dtm (tbkey_t k, unsigned stm, const SQUARE *wS, const SQUARE *bS, bool_
 
 						assert (decoding_scheme() == 0 && GTB_scheme == 0);
 
+						mythread_mutex_lock (&Egtb_lock);
 						success2 = egtb_filepeek (k, stm, idx, &dtm_temp);
+						mythread_mutex_unlock (&Egtb_lock);
 						ok =  (success == success2) && (!success || *dtm == dtm_temp);
 						if (!ok) {
 							printf ("\nERROR\nsuccess1=%d sucess2=%d\n"
@@ -1833,17 +1857,14 @@ egtb_get_dtm (tbkey_t k, unsigned stm, const SQUARE *wS, const SQUARE *bS, bool_
 
 			} else {
 				assert(Uncompressed);
-				if (probe_hard_flag && Uncompressed)
+				if (probe_hard_flag && Uncompressed) {
+					counted_lock (&Egtb_lock, &Drive.waits);
 					success = egtb_filepeek (k, stm, idx, dtm);
-				else
+					mythread_mutex_unlock (&Egtb_lock);
+				} else
 					success = FALSE;
 			}
 
-			mythread_mutex_unlock (&Egtb_lock);
-			/*------------------------------*\
-			|		UNLOCK
-			*/
-
 
 			if (success) {
 				return TRUE;
@@ -2403,6 +2424,8 @@ struct wdl_block {
 };
 
 struct WDL_CACHE {
+	mythread_mutex_t lock;
+
 	/* defined at init */
 	bool_t			cached;
 	size_t			max_blocks;
@@ -2427,11 +2450,19 @@ struct WDL_CACHE {
 	uint64_t		hits;
 	uint64_t		softmisses;
 	uint64_t 		comparisons;
+	uint64_t		waits;
 };
 
-struct WDL_CACHE 	wdl_cache = {FALSE,0,0,NULL,
-								 NULL,NULL,0,NULL,
-								 0,0,0,0,0,0};
+/*
+|	Both caches are split in shards, each one with its own lock, LRU list,
+|	lookup table and counters. The shard of a block is given by its key,
+|	side and offset, so threads probing different blocks rarely wait on
+|	each other. Egtb_lock is only taken to read from the files.
+*/
+#define GTB_CACHE_SHARDS 16 /* maximum, power of 2 */
+
+static struct WDL_CACHE	wdl_cache [GTB_CACHE_SHARDS];
+static size_t			WDL_shards = 0;
 
 
 /*---------------------------------------------------------------------*\
@@ -2452,6 +2483,8 @@ struct dtm_block {
 };
 
 struct cache_table {
+	mythread_mutex_t lock;
+
 	/* defined at init */
 	bool_t			cached;
 	size_t			max_blocks;
@@ -2476,33 +2509,76 @@ struct cache_table {
 	uint64_t		hits;
 	uint64_t		softmisses;
 	unsigned long	comparisons;
+	uint64_t		waits;
 };
 
-struct cache_table 	dtm_cache = {FALSE,0,0,NULL,
-								NULL,NULL,0,NULL,
-								0,0,0,0,0,0};
+static struct cache_table	dtm_cache [GTB_CACHE_SHARDS];
+static size_t				DTM_shards = 0;
 
-struct general_counters {
-	/* counters */
-	uint64_t		hits;
-	uint64_t		miss;
-};
+static void
+cache_locks_init (void)
+{
+	int i;
+	for (i = 0; i < GTB_CACHE_SHARDS; i++) {
+		mythread_mutex_init (&dtm_cache[i].lock);
+		mythread_mutex_init (&wdl_cache[i].lock);
+	}
+}
+
+static void
+cache_locks_done (void)
+{
+	int i;
+	for (i = 0; i < GTB_CACHE_SHARDS; i++) {
+		mythread_mutex_destroy (&dtm_cache[i].lock);
+		mythread_mutex_destroy (&wdl_cache[i].lock);
+	}
+}
+
+static size_t
+cache_shards (size_t max_blocks)
+/* largest power of 2 that leaves at least one block per shard */
+{
+	size_t n = 1;
+	while (n < GTB_CACHE_SHARDS && 2 * n <= max_blocks)
+		n *= 2;
+	return n;
+}
+
+static size_t
+shard_of (tbkey_t key, unsigned side, index_t offset, size_t n_shards)
+{
+	/* hash_func_1 bits are used inside the shard, take others */
+	return (hash_func_2 (key, side, offset) >> 1) & (n_shards - 1);
+}
 
-static struct general_counters Drive = {0,0};
+static struct cache_table *
+dtm_shard (tbkey_t key, unsigned side, index_t idx)
+{
+	index_t offset = idx - idx % (index_t) GTB_ENTRIES_PER_BLOCK;
+	return &dtm_cache[shard_of (key, side, offset, DTM_shards)];
+}
+
+static struct WDL_CACHE *
+wdl_shard (tbkey_t key, unsigned side, index_t idx)
+{
+	index_t offset = idx - idx % (index_t) GTB_ENTRIES_PER_BLOCK;
+	return &wdl_cache[shard_of (key, side, offset, WDL_shards)];
+}
 
 
 static void 		split_index (size_t entries_per_block, index_t i, index_t *o, index_t *r);
-static dtm_block_t *point_block_to_replace (void);
-static bool_t 		preload_cache (tbkey_t key, unsigned side, index_t idx);
-static void			movetotop (dtm_block_t *t);
+static dtm_block_t *point_block_to_replace (struct cache_table *c);
+static bool_t 		preload_cache (struct cache_table *c, tbkey_t key, unsigned side, index_t idx, dtm_t *out);
+static void			movetotop (struct cache_table *c, dtm_block_t *t);
 
 /*--cache prototypes--------------------------------------------------------*/
 
 /*- WDL --------------------------------------------------------------------*/
 #ifdef WDL_PROBE
 static unsigned int		wdl_extract (unit_t *uarr, index_t x);
-static wdl_block_t *	wdl_point_block_to_replace (void);
-static void				wdl_movetotop (wdl_block_t *t);
+static wdl_block_t *	wdl_point_block_to_replace (struct WDL_CACHE *w);
+static void				wdl_movetotop (struct WDL_CACHE *w, wdl_block_t *t);
 
 #if 0
 static bool_t			wdl_cache_init (size_t cache_mem);
@@ -2514,10 +2590,10 @@ static bool_t			wdl_cache_is_on (void);
 static void				wdl_cache_reset_counters (void);
 static void				wdl_cache_done (void);
 
-static wdl_block_t *	wdl_point_block_to_replace (void);
-static bool_t			get_WDL_from_cache (tbkey_t key, unsigned side, index_t idx, unsigned int *out);
-static void				wdl_movetotop (wdl_block_t *t);
-static bool_t			wdl_preload_cache (tbkey_t key, unsigned side, index_t idx);
+static wdl_block_t *	wdl_point_block_to_replace (struct WDL_CACHE *w);
+static bool_t			get_WDL_from_cache (struct WDL_CACHE *w, tbkey_t key, unsigned side, index_t idx, unsigned int *out);
+static void				wdl_movetotop (struct WDL_CACHE *w, wdl_block_t *t);
+static bool_t			wdl_preload_cache (struct WDL_CACHE *w, tbkey_t key, unsigned side, index_t idx);
 #endif
 /*--------------------------------------------------------------------------*/
 /*- DTM --------------------------------------------------------------------*/
@@ -2532,132 +2608,174 @@ static void				dtm_cache_flush (void);
 static bool_t
 dtm_cache_is_on (void)
 {
-	return dtm_cache.cached;
+	return DTM_shards > 0 && dtm_cache[0].cached;
 }
 
 static void
 dtm_cache_reset_counters (void)
 {
-	dtm_cache.hard = 0;
-	dtm_cache.soft = 0;
-	dtm_cache.hardmisses = 0;
-	dtm_cache.hits = 0;
-	dtm_cache.softmisses = 0;
-	dtm_cache.comparisons = 0;
+	size_t i;
+	struct cache_table *c;
+
+	for (i = 0; i < GTB_CACHE_SHARDS; i++) {
+		c = &dtm_cache[i];
+		c->hard = 0;
+		c->soft = 0;
+		c->hardmisses = 0;
+		c->hits = 0;
+		c->softmisses = 0;
+		c->comparisons = 0;
+		c->waits = 0;
+	}
 	return;
 }
 
+static void dtm_shard_done (struct cache_table *c);
+
 
 static size_t
-dtm_cache_init (size_t cache_mem)
+dtm_shard_init (struct cache_table *c, size_t max_blocks)
 {
 	unsigned int 	i;
 	dtm_block_t 	*p;
-	size_t 			entries_per_block;
-	size_t 			max_blocks;
-	size_t 			block_mem;
-
-	if (DTM_CACHE_INITIALIZED)
-		dtm_cache_done();
-
-	entries_per_block 	= 16 * 1024;  /* fixed, needed for the compression schemes */
-
-	block_mem 			= entries_per_block * sizeof(dtm_t);
-
-	max_blocks 			= cache_mem / block_mem;
-	if (!Uncompressed && 1 > max_blocks)
-		max_blocks = 1;
-	cache_mem 			= max_blocks * block_mem;
-
-
-	dtm_cache_reset_counters ();
-
-	dtm_cache.entries_per_block	= entries_per_block;
-	dtm_cache.max_blocks 		= max_blocks;
-	dtm_cache.cached 			= TRUE;
-	dtm_cache.top 				= NULL;
-	dtm_cache.bot 				= NULL;
-	dtm_cache.n 				= 0;
-
-	if (0 == cache_mem || NULL == (dtm_cache.buffer = (dtm_t *)  malloc (cache_mem))) {
-		dtm_cache.cached = FALSE;
-		dtm_cache.buffer = NULL;
-		dtm_cache.entry = NULL;
+	size_t 			entries_per_block = GTB_ENTRIES_PER_BLOCK;
+	size_t 			cache_mem = max_blocks * entries_per_block * sizeof(dtm_t);
+
+	c->entries_per_block	= entries_per_block;
+	c->max_blocks 		= max_blocks;
+	c->cached 			= TRUE;
+	c->top 				= NULL;
+	c->bot 				= NULL;
+	c->n 				= 0;
+
+	if (0 == cache_mem || NULL == (c->buffer = (dtm_t *)  malloc (cache_mem))) {
+		c->cached = FALSE;
+		c->buffer = NULL;
+		c->entry = NULL;
 		return 0;
 	}
 
-	if (0 == max_blocks|| NULL == (dtm_cache.entry  = (dtm_block_t *) malloc (max_blocks * sizeof(dtm_block_t)))) {
-		dtm_cache.cached = FALSE;
-		dtm_cache.entry = NULL;
-		free (dtm_cache.buffer);
-		dtm_cache.buffer = NULL;
+	if (0 == max_blocks|| NULL == (c->entry  = (dtm_block_t *) malloc (max_blocks * sizeof(dtm_block_t)))) {
+		c->cached = FALSE;
+		c->entry = NULL;
+		free (c->buffer);
+		c->buffer = NULL;
 		return 0;
 	}
 
 	for (i = 0; i < max_blocks; i++) {
-		p = &dtm_cache.entry[i];
+		p = &c->entry[i];
 		p->key  	= -1;
 		p->side 	= gtbNOSIDE;
 		p->offset 	= gtbNOINDEX;
-		p->p_arr 	= dtm_cache.buffer + i * entries_per_block;
+		p->p_arr 	= c->buffer + i * entries_per_block;
 		p->prev 	= NULL;
 		p->next 	= NULL;
 	}
 
-	dtm_cache.ht_size = 1;
-	while (dtm_cache.ht_size < max_blocks * 4)
-		dtm_cache.ht_size *= 2;
-	dtm_cache.ht_used = 0;
-	dtm_cache.hash_table = (dtm_block_t**) malloc (dtm_cache.ht_size * sizeof(dtm_block_t*));;
-	if (dtm_cache.hash_table == NULL) {
-		dtm_cache.cached = FALSE;
-		free (dtm_cache.entry);
-		dtm_cache.entry = NULL;
-		free (dtm_cache.buffer);
-		dtm_cache.buffer = NULL;
+	c->ht_size = 1;
+	while (c->ht_size < max_blocks * 4)
+		c->ht_size *= 2;
+	c->ht_used = 0;
+	c->hash_table = (dtm_block_t**) malloc (c->ht_size * sizeof(dtm_block_t*));;
+	if (c->hash_table == NULL) {
+		c->cached = FALSE;
+		free (c->entry);
+		c->entry = NULL;
+		free (c->buffer);
+		c->buffer = NULL;
 		return 0;
 	}
 
-	for (i = 0; i < dtm_cache.ht_size; i++) {
-		dtm_cache.hash_table[i] = NULL;
+	for (i = 0; i < c->ht_size; i++) {
+		c->hash_table[i] = NULL;
+	}
+
+	return cache_mem;
+}
+
+static size_t
+dtm_cache_init (size_t cache_mem)
+{
+	size_t 			i;
+	size_t 			max_blocks;
+	size_t 			block_mem;
+	size_t 			allocated;
+
+	if (DTM_CACHE_INITIALIZED)
+		dtm_cache_done();
+
+	block_mem 			= GTB_ENTRIES_PER_BLOCK * sizeof(dtm_t);
+
+	max_blocks 			= cache_mem / block_mem;
+	if (!Uncompressed && 1 > max_blocks)
+		max_blocks = 1;
+
+	dtm_cache_reset_counters ();
+
+	DTM_shards = cache_shards (max_blocks);
+
+	for (i = 0, allocated = 0; i < DTM_shards; i++) {
+		size_t blocks = max_blocks / DTM_shards + (i < max_blocks % DTM_shards ? 1 : 0);
+		size_t mem = dtm_shard_init (&dtm_cache[i], blocks);
+		if (0 == mem && 0 != blocks) {
+			/* all shards on or none */
+			for (; i > 0; i--)
+				dtm_shard_done (&dtm_cache[i-1]);
+			DTM_shards = 0;
+			return 0;
+		}
+		allocated += mem;
 	}
 
 	DTM_CACHE_INITIALIZED = TRUE;
 
-	return cache_mem;
+	return allocated;
 }
 
 
 static void
-dtm_cache_done (void)
-{
-	assert(DTM_CACHE_INITIALIZED);
-
-	dtm_cache.cached = FALSE;
-	dtm_cache.hard = 0;
-	dtm_cache.soft = 0;
-	dtm_cache.hardmisses = 0;
-	dtm_cache.hits = 0;
-	dtm_cache.softmisses = 0;
-	dtm_cache.comparisons = 0;
-	dtm_cache.max_blocks = 0;
-	dtm_cache.entries_per_block = 0;
+dtm_shard_done (struct cache_table *c)
+{
+	c->cached = FALSE;
+	c->hard = 0;
+	c->soft = 0;
+	c->hardmisses = 0;
+	c->hits = 0;
+	c->softmisses = 0;
+	c->comparisons = 0;
+	c->max_blocks = 0;
+	c->entries_per_block = 0;
+
+	c->top = NULL;
+	c->bot = NULL;
+	c->n = 0;
+
+	if (c->buffer != NULL)
+		free (c->buffer);
+	c->buffer = NULL;
+
+	if (c->entry != NULL)
+		free (c->entry);
+	c->entry = NULL;
+
+	if (c->hash_table != NULL)
+		free (c->hash_table);
+	c->hash_table = NULL;
 
-	dtm_cache.top = NULL;
-	dtm_cache.bot = NULL;
-	dtm_cache.n = 0;
+	return;
+}
 
-	if (dtm_cache.buffer != NULL)
-		free (dtm_cache.buffer);
-	dtm_cache.buffer = NULL;
+static void
+dtm_cache_done (void)
+{
+	size_t i;
 
-	if (dtm_cache.entry != NULL)
-		free (dtm_cache.entry);
-	dtm_cache.entry = NULL;
+	assert(DTM_CACHE_INITIALIZED);
 
-	if (dtm_cache.hash_table != NULL)
-		free (dtm_cache.hash_table);
-	dtm_cache.hash_table = NULL;
+	for (i = 0; i < DTM_shards; i++)
+		dtm_shard_done (&dtm_cache[i]);
+	DTM_shards = 0;
 
 	DTM_CACHE_INITIALIZED = FALSE;
 
@@ -2668,23 +2786,27 @@ static void
 dtm_cache_flush (void)
 {
 	unsigned int 	i;
+	size_t			k;
 	dtm_block_t 	*p;
-	size_t entries_per_block = dtm_cache.entries_per_block;
-	size_t max_blocks = dtm_cache.max_blocks;
+	struct cache_table *c;
 
-	dtm_cache.top 				= NULL;
-	dtm_cache.bot 				= NULL;
-	dtm_cache.n 				= 0;
+	for (k = 0; k < DTM_shards; k++) {
+	c = &dtm_cache[k];
 
-	for (i = 0; i < max_blocks; i++) {
-		p = &dtm_cache.entry[i];
+	c->top 				= NULL;
+	c->bot 				= NULL;
+	c->n 				= 0;
+
+	for (i = 0; i < c->max_blocks; i++) {
+		p = &c->entry[i];
 		p->key  	= -1;
 		p->side 	= gtbNOSIDE;
 		p->offset 	= gtbNOINDEX;
-		p->p_arr 	= dtm_cache.buffer + i * entries_per_block;
+		p->p_arr 	= c->buffer + i * c->entries_per_block;
 		p->prev 	= NULL;
 		p->next 	= NULL;
 	}
+	}
 	dtm_cache_reset_counters ();
 	return;
 }
@@ -2706,50 +2828,74 @@ tbstats_get (struct TB_STATS *x)
 {
 	long unsigned mask = 0xfffffffflu;
 	uint64_t memory_hits, total_hits;
+	uint64_t wdl_hits = 0, wdl_hard = 0, wdl_soft = 0, wdl_waits = 0;
+	uint64_t dtm_hits = 0, dtm_hard = 0, dtm_soft = 0, dtm_waits = 0;
+	size_t wdl_n = 0, wdl_max = 0, dtm_n = 0, dtm_max = 0;
+	size_t i;
 
+	/* counters are read without locking, approximate while probing */
+	for (i = 0; i < WDL_shards; i++) {
+		struct WDL_CACHE *w = &wdl_cache[i];
+		wdl_hits  += w->hits;
+		wdl_hard  += w->hard;
+		wdl_soft  += w->soft;
+		wdl_waits += w->waits;
+		wdl_n     += w->n;
+		wdl_max   += w->max_blocks;
+	}
+
+	for (i = 0; i < DTM_shards; i++) {
+		struct cache_table *c = &dtm_cache[i];
+		dtm_hits  += c->hits;
+		dtm_hard  += c->hard;
+		dtm_soft  += c->soft;
+		dtm_waits += c->waits;
+		dtm_n     += c->n;
+		dtm_max   += c->max_blocks;
+	}
 
 	/*
 	|	WDL CACHE
 	\*---------------------------------------------------*/
 
-	x->wdl_easy_hits[0] = (long unsigned)(wdl_cache.hits & mask);
-	x->wdl_easy_hits[1] = (long unsigned)(wdl_cache.hits >> 32);
+	x->wdl_easy_hits[0] = (long unsigned)(wdl_hits & mask);
+	x->wdl_easy_hits[1] = (long unsigned)(wdl_hits >> 32);
 
-	x->wdl_hard_prob[0] = (long unsigned)(wdl_cache.hard & mask);
-	x->wdl_hard_prob[1] = (long unsigned)(wdl_cache.hard >> 32);
+	x->wdl_hard_prob[0] = (long unsigned)(wdl_hard & mask);
+	x->wdl_hard_prob[1] = (long unsigned)(wdl_hard >> 32);
 
-	x->wdl_soft_prob[0] = (long unsigned)(wdl_cache.soft & mask);
-	x->wdl_soft_prob[1] = (long unsigned)(wdl_cache.soft >> 32);
+	x->wdl_soft_prob[0] = (long unsigned)(wdl_soft & mask);
+	x->wdl_soft_prob[1] = (long unsigned)(wdl_soft >> 32);
 
 	x->wdl_cachesize    = WDL_cache_size;
 
 	/* occupancy */
-	x->wdl_occupancy = wdl_cache.max_blocks==0? 0:(double)100.0*(double)wdl_cache.n/(double)wdl_cache.max_blocks;
+	x->wdl_occupancy = wdl_max==0? 0:(double)100.0*(double)wdl_n/(double)wdl_max;
 
 	/*
 	|	DTM CACHE
 	\*---------------------------------------------------*/
 
-	x->dtm_easy_hits[0] = (long unsigned)(dtm_cache.hits & mask);
-	x->dtm_easy_hits[1] = (long unsigned)(dtm_cache.hits >> 32);
+	x->dtm_easy_hits[0] = (long unsigned)(dtm_hits & mask);
+	x->dtm_easy_hits[1] = (long unsigned)(dtm_hits >> 32);
 
-	x->dtm_hard_prob[0] = (long unsigned)(dtm_cache.hard & mask);
-	x->dtm_hard_prob[1] = (long unsigned)(dtm_cache.hard >> 32);
+	x->dtm_hard_prob[0] = (long unsigned)(dtm_hard & mask);
+	x->dtm_hard_prob[1] = (long unsigned)(dtm_hard >> 32);
 
-	x->dtm_soft_prob[0] = (long unsigned)(dtm_cache.soft & mask);
-	x->dtm_soft_prob[1] = (long unsigned)(dtm_cache.soft >> 32);
+	x->dtm_soft_prob[0] = (long unsigned)(dtm_soft & mask);
+	x->dtm_soft_prob[1] = (long unsigned)(dtm_soft >> 32);
 
 	x->dtm_cachesize    = DTM_cache_size;
 
 	/* occupancy */
-	x->dtm_occupancy = dtm_cache.max_blocks==0? 0:(double)100.0*(double)dtm_cache.n/(double)dtm_cache.max_blocks;
+	x->dtm_occupancy = dtm_max==0? 0:(double)100.0*(double)dtm_n/(double)dtm_max;
 
 	/*
 	|	GENERAL
 	\*---------------------------------------------------*/
 
 	/* memory */
-	memory_hits = wdl_cache.hits + dtm_cache.hits;
+	memory_hits = wdl_hits + dtm_hits;
 	x->memory_hits[0] = (long unsigned)(memory_hits & mask);
 	x->memory_hits[1] = (long unsigned)(memory_hits >> 32);
 
@@ -2774,6 +2920,16 @@ tbstats_get (struct TB_STATS *x)
 	{ uint64_t denominator = memory_hits + Drive.hits + Drive.miss;
 	x->memory_efficiency = 0==denominator? 0: 100.0 * (double)(memory_hits) / (double)(denominator);
 	}
+
+	/* lock contention */
+	x->wdl_lock_waits[0] = (long unsigned)(wdl_waits & mask);
+	x->wdl_lock_waits[1] = (long unsigned)(wdl_waits >> 32);
+
+	x->dtm_lock_waits[0] = (long unsigned)(dtm_waits & mask);
+	x->dtm_lock_waits[1] = (long unsigned)(dtm_waits >> 32);
+
+	x->drive_lock_waits[0] = (long unsigned)(Drive.waits & mask);
+	x->drive_lock_waits[1] = (long unsigned)(Drive.waits >> 32);
 }
 
 
@@ -2840,43 +2996,44 @@ tbstats_reset (void)
 	eg_was_open_reset();
 	Drive.hits = 0;
 	Drive.miss = 0;
+	Drive.waits = 0;
 	return;
 }
 
-static void dtm_hash_insert (dtm_block_t * e);
+static void dtm_hash_insert (struct cache_table *c, dtm_block_t * e);
 
 static void
-dtm_hash_rebuild (void)
+dtm_hash_rebuild (struct cache_table *c)
 {
 	dtm_block_t	* p;
 	size_t i;
 
-	for (i = 0; i < dtm_cache.ht_size; i++)
-		dtm_cache.hash_table[i] = NULL;
-	dtm_cache.ht_used = 0;
+	for (i = 0; i < c->ht_size; i++)
+		c->hash_table[i] = NULL;
+	c->ht_used = 0;
 
-	for (p = dtm_cache.top; p != NULL; p = p->prev)
-		dtm_hash_insert (p);
+	for (p = c->top; p != NULL; p = p->prev)
+		dtm_hash_insert (c, p);
 }
 
 static void
-dtm_hash_insert (dtm_block_t * e)
+dtm_hash_insert (struct cache_table *c, dtm_block_t * e)
 {
 	size_t h1, h2;
 
-	if (dtm_cache.ht_used > dtm_cache.ht_size * 3 / 4)
-		dtm_hash_rebuild();
+	if (c->ht_used + 1 > c->ht_size * 3 / 4) /* keep an empty slot to end lookups */
+		dtm_hash_rebuild (c);
 
-    h1 = hash_func_1 (e->key, e->side, e->offset) & (dtm_cache.ht_size - 1);
+    h1 = hash_func_1 (e->key, e->side, e->offset) & (c->ht_size - 1);
     h2 = hash_func_2 (e->key, e->side, e->offset);
-    while (dtm_cache.hash_table[h1])
-        h1 = (h1 + h2) & (dtm_cache.ht_size - 1);
-    dtm_cache.hash_table[h1] = e;
-    dtm_cache.ht_used++;
+    while (c->hash_table[h1])
+        h1 = (h1 + h2) & (c->ht_size - 1);
+    c->hash_table[h1] = e;
+    c->ht_used++;
 }
 
 static dtm_block_t	*
-dtm_cache_pointblock (tbkey_t key, unsigned side, index_t idx)
+dtm_cache_pointblock (struct cache_table *c, tbkey_t key, unsigned side, index_t idx)
 {
 	index_t 		offset;
 	index_t			remainder;
@@ -2887,25 +3044,25 @@ dtm_cache_pointblock (tbkey_t key, unsigned side, index_t idx)
 	if (!dtm_cache_is_on())
 		return NULL;
 
-	split_index (dtm_cache.entries_per_block, idx, &offset, &remainder);
+	split_index (c->entries_per_block, idx, &offset, &remainder);
 
 	ret   = NULL;
 
-	h1 = hash_func_1 (key, side, offset) & (dtm_cache.ht_size - 1);
+	h1 = hash_func_1 (key, side, offset) & (c->ht_size - 1);
 	h2 = hash_func_2 (key, side, offset);
 	while (1) {
-		p = dtm_cache.hash_table[h1];
+		p = c->hash_table[h1];
 		if (!p)
 			break;
 
-		dtm_cache.comparisons++;
+		c->comparisons++;
 
 		if (key == p->key && side == p->side && offset  == p->offset) {
 			ret = p;
 			break;
 		}
 
-		h1 = (h1 + h2) & (dtm_cache.ht_size - 1);
+		h1 = (h1 + h2) & (c->ht_size - 1);
 	}
 
 	FOLLOW_LU("point_to_dtm_block ok?",(ret!=NULL))
@@ -3146,7 +3303,7 @@ egtb_block_uncompressed_to_index (tbkey_t key, index_t b)
 	index_t idx;
 
 	max = egkey[key].maxindex;
-	blocks_per_side = 1 + (max-1) / (index_t)dtm_cache.entries_per_block;
+	blocks_per_side = 1 + (max-1) / (index_t)GTB_ENTRIES_PER_BLOCK;
 
 	if (b < blocks_per_side) {
 		idx = 0;
@@ -3154,7 +3311,7 @@ egtb_block_uncompressed_to_index (tbkey_t key, index_t b)
 		b -= blocks_per_side;
 		idx = max;
 	}
-	idx += b * (index_t)dtm_cache.entries_per_block;
+	idx += b * (index_t)GTB_ENTRIES_PER_BLOCK;
 	return idx;
 }
 
@@ -3166,8 +3323,8 @@ egtb_block_getnumber (tbkey_t key, unsigned side, index_t idx)
 	index_t block_in_side;
 	index_t max = egkey[key].maxindex;
 
-	blocks_per_side = 1 + (max-1) / (index_t)dtm_cache.entries_per_block;
-	block_in_side   = idx         / (index_t)dtm_cache.entries_per_block;
+	blocks_per_side = 1 + (max-1) / (index_t)GTB_ENTRIES_PER_BLOCK;
+	block_in_side   = idx         / (index_t)GTB_ENTRIES_PER_BLOCK;
 
 	return (index_t)side * blocks_per_side + block_in_side; /* block */
 }
@@ -3176,11 +3333,11 @@ egtb_block_getnumber (tbkey_t key, unsigned side, index_t idx)
 static index_t
 egtb_block_getsize (tbkey_t key, index_t idx)
 {
-	index_t blocksz = (index_t) dtm_cache.entries_per_block;
+	index_t blocksz = (index_t) GTB_ENTRIES_PER_BLOCK;
 	index_t maxindex  = egkey[key].maxindex;
 	index_t block, offset, x;
 
-	assert (dtm_cache.entries_per_block <= MAXINDEX_T);
+	assert (GTB_ENTRIES_PER_BLOCK <= MAXINDEX_T);
 	assert (0 <= idx && idx < maxindex);
 	assert (key < MAX_EGKEYS);
 
@@ -3283,14 +3440,19 @@ egtb_block_unpack (unsigned side, index_t n, const unsigned char *bp, dtm_t *out
 }
 
 static bool_t
-preload_cache (tbkey_t key, unsigned side, index_t idx)
-/* output to the least used block of the cache */
+preload_cache (struct cache_table *c, tbkey_t key, unsigned side, index_t idx, dtm_t *out)
+/* output to the least used block of the shard */
 {
 	dtm_block_t 	*pblock;
-	dtm_t 			*p;
 	bool_t 			ok;
-    unsigned char    Buffer_zipped [EGTB_MAXBLOCKSIZE];
-    unsigned char    Buffer_packed [EGTB_MAXBLOCKSIZE];
+	index_t 		block = 0;
+	index_t			n = 0;
+	index_t			z = 0;
+	index_t 		offset;
+	index_t			remainder;
+	/* per thread buffers, decoding is done without holding any lock */
+	unsigned char	Buffer_zipped [EGTB_MAXBLOCKSIZE];
+	unsigned char	Buffer_packed [EGTB_MAXBLOCKSIZE];
 
 	FOLLOW_label("preload_cache starts")
 
@@ -3299,88 +3461,75 @@ preload_cache (tbkey_t key, unsigned side, index_t idx)
 		return FALSE;
 	}
 
-	/* find aged blocked in cache */
-	pblock = point_block_to_replace();
-
-	if (NULL == pblock)
-		return FALSE;
-
-	p = pblock->p_arr;
-
-	if (Uncompressed) {
-
-		index_t block = egtb_block_getnumber (key, side, idx);
-		index_t n     = egtb_block_getsize   (key, idx);
-
-		ok =	   egtb_file_beready (key)
-				&& egtb_block_park   (key, block)
-				&& egtb_block_read   (key, n, Buffer_packed)
-				&& egtb_block_unpack (side, n, Buffer_packed, p);
+	/*
+	|	READ (file handles are shared)
+	*-------------------------------*/
+	counted_lock (&Egtb_lock, &Drive.waits);
 
-		FOLLOW_LULU("preload_cache", __LINE__, ok)
+	ok =	   egtb_file_beready (key);
 
-		assert (decoding_scheme() == 0 && GTB_scheme == 0);
+	FOLLOW_LULU("preload_cache", __LINE__, ok)
 
-		if (ok) { Bytes_read = Bytes_read + (uint64_t) n; }
+	if (ok) {
+		block = egtb_block_getnumber (key, side, idx);
+		n     = egtb_block_getsize   (key, idx);
+		z     = Uncompressed? n: egtb_block_getsize_zipped (key, block);
+	}
 
-	} else {
+	ok =	   ok
+			&& egtb_block_park   (key, block)
+			&& egtb_block_read   (key, z, Uncompressed? Buffer_packed: Buffer_zipped);
 
-        index_t block = 0;
-		index_t n = 0;
-		index_t z = 0;
+	FOLLOW_LULU("preload_cache", __LINE__, ok)
 
-		ok =	   egtb_file_beready (key);
+	if (ok) { Bytes_read = Bytes_read + (uint64_t) z; }
 
-		FOLLOW_LULU("preload_cache", __LINE__, ok)
-
-		if (ok) {
-			block = egtb_block_getnumber (key, side, idx);
-			n     = egtb_block_getsize   (key, idx);
-			z     = egtb_block_getsize_zipped (key, block);
-		}
-
-		ok =	   ok
-				&& egtb_block_park   (key, block);
-		FOLLOW_LULU("preload_cache", __LINE__, ok)
+	mythread_mutex_unlock (&Egtb_lock);
 
+	/*
+	|	DECODE
+	*-------------------------------*/
+	if (!Uncompressed) {
 		ok =	   ok
-				&& egtb_block_read   (key, z, Buffer_zipped);
+				&& egtb_block_decode (key, z, Buffer_zipped, n, Buffer_packed);
 		FOLLOW_LULU("preload_cache", __LINE__, ok)
+	} else {
+		assert (decoding_scheme() == 0 && GTB_scheme == 0);
+	}
 
-        mythread_mutex_unlock (&Egtb_lock);
+	if (!ok)
+		return FALSE;
 
-		ok =	   ok
-				&& egtb_block_decode (key, z, Buffer_zipped, n, Buffer_packed);
-		FOLLOW_LULU("preload_cache", __LINE__, ok)
+	/*
+	|	STORE
+	*-------------------------------*/
+	split_index (GTB_ENTRIES_PER_BLOCK, idx, &offset, &remainder);
 
-        mythread_mutex_lock (&Egtb_lock);
-	    pblock = point_block_to_replace();
-	    p = pblock->p_arr;
+	counted_lock (&c->lock, &c->waits);
 
-		ok =	   ok
-				&& egtb_block_unpack (side, n, Buffer_packed, p);
-		FOLLOW_LULU("preload_cache", __LINE__, ok)
+	/* another thread may have loaded the same block in the meantime */
+	pblock = dtm_cache_pointblock (c, key, side, idx);
 
-		if (ok) { Bytes_read = Bytes_read + (uint64_t) z; }
+	if (NULL == pblock) {
+		/* find aged blocked in cache */
+		pblock = point_block_to_replace (c);
+		ok = NULL != pblock;
+		if (ok) {
+			egtb_block_unpack (side, n, Buffer_packed, pblock->p_arr);
+			pblock->key    = key;
+			pblock->side   = side;
+			pblock->offset = offset;
+			dtm_hash_insert (c, pblock);
+		}
 	}
 
 	if (ok) {
-
-		index_t 		offset;
-		index_t			remainder;
-		split_index (dtm_cache.entries_per_block, idx, &offset, &remainder);
-
-		pblock->key    = key;
-		pblock->side   = side;
-		pblock->offset = offset;
-		dtm_hash_insert (pblock);
-	} else {
-		/* make it unusable */
-		pblock->key    = -1;
-		pblock->side   = gtbNOSIDE;
-		pblock->offset = gtbNOINDEX;
+		*out = pblock->p_arr[remainder];
+		movetotop (c, pblock);
 	}
 
+	mythread_mutex_unlock (&c->lock);
+
 	FOLLOW_LU("preload_cache?", ok)
 
 	return ok;
@@ -3414,39 +3563,52 @@ egtb_freemem (int i)
 mySHARED bool_t
 get_dtm (tbkey_t key, unsigned side, index_t idx, dtm_t *out, bool_t probe_hard_flag)
 {
+	struct cache_table *c;
 	bool_t found;
 
+	if (!dtm_cache_is_on())
+		return FALSE;
+
+	c = dtm_shard (key, side, idx);
+
+	counted_lock (&c->lock, &c->waits);
+
 	if (probe_hard_flag) {
-		dtm_cache.hard++;
+		c->hard++;
 	} else {
-		dtm_cache.soft++;
+		c->soft++;
 	}
 
-	if (get_dtm_from_cache (key, side, idx, out)) {
-		dtm_cache.hits++;
-		found = TRUE;
+	found = get_dtm_from_cache (c, key, side, idx, out);
+
+	if (found) {
+		c->hits++;
 	} else if (probe_hard_flag) {
-		dtm_cache.hardmisses++;
-		found = preload_cache (key, side, idx) &&
-				get_dtm_from_cache (key, side, idx, out);
+		c->hardmisses++;
+	} else {
+		c->softmisses++;
+	}
+
+	mythread_mutex_unlock (&c->lock);
+
+	if (!found && probe_hard_flag) {
+
+		found = preload_cache (c, key, side, idx, out);
 
+		counted_lock (&Egtb_lock, &Drive.waits);
 		if (found) {
 			Drive.hits++;
 		} else {
 			Drive.miss++;
 		}
-
-
-	} else {
-		dtm_cache.softmisses++;
-		found = FALSE;
+		mythread_mutex_unlock (&Egtb_lock);
 	}
 	return found;
 }
 
 
 static bool_t
-get_dtm_from_cache (tbkey_t key, unsigned side, index_t idx, dtm_t *out)
+get_dtm_from_cache (struct cache_table *c, tbkey_t key, unsigned side, index_t idx, dtm_t *out)
 {
 	index_t 	offset;
 	index_t		remainder;
@@ -3456,13 +3618,13 @@ get_dtm_from_cache (tbkey_t key, unsigned side, index_t idx, dtm_t *out)
 	if (!dtm_cache_is_on())
 		return FALSE;
 
-	split_index (dtm_cache.entries_per_block, idx, &offset, &remainder);
+	split_index (c->entries_per_block, idx, &offset, &remainder);
 
-	found = NULL != (p = dtm_cache_pointblock (key, side, idx));
+	found = NULL != (p = dtm_cache_pointblock (c, key, side, idx));
 
 	if (found) {
 		*out = p->p_arr[remainder];
-		movetotop(p);
+		movetotop (c, p);
 	}
 
 	FOLLOW_LU("get_dtm_from_cache ok?",found)
@@ -3483,74 +3645,74 @@ split_index (size_t entries_per_block, index_t i, index_t *o, index_t *r)
 
 
 static dtm_block_t *
-point_block_to_replace (void)
+point_block_to_replace (struct cache_table *c)
 {
 	dtm_block_t *p, *t, *s;
 
-	assert (0 == dtm_cache.n || dtm_cache.top != NULL);
-	assert (0 == dtm_cache.n || dtm_cache.bot != NULL);
-	assert (0 == dtm_cache.n || dtm_cache.bot->prev == NULL);
-	assert (0 == dtm_cache.n || dtm_cache.top->next == NULL);
+	assert (0 == c->n || c->top != NULL);
+	assert (0 == c->n || c->bot != NULL);
+	assert (0 == c->n || c->bot->prev == NULL);
+	assert (0 == c->n || c->top->next == NULL);
 
 	/* no cache is being used */
-	if (dtm_cache.max_blocks == 0)
+	if (c->max_blocks == 0)
 		return NULL;
 
-	if (dtm_cache.n > 0 && -1 == dtm_cache.top->key) {
+	if (c->n > 0 && -1 == c->top->key) {
 
 		/* top entry is unusable, should be the one to replace*/
-		p = dtm_cache.top;
+		p = c->top;
 
 	} else
-	if (dtm_cache.n == 0) {
+	if (c->n == 0) {
 
-		assert (NULL != dtm_cache.entry);
-		p = &dtm_cache.entry[dtm_cache.n++];
-		dtm_cache.top = p;
-		dtm_cache.bot = p;
+		assert (NULL != c->entry);
+		p = &c->entry[c->n++];
+		c->top = p;
+		c->bot = p;
 
 		assert (NULL != p);
 		p->prev = NULL;
 		p->next = NULL;
 
 	} else
-	if (dtm_cache.n < dtm_cache.max_blocks) { /* add */
+	if (c->n < c->max_blocks) { /* add */
 
-		assert (NULL != dtm_cache.entry);
-		s = dtm_cache.top;
-		p = &dtm_cache.entry[dtm_cache.n++];
-		dtm_cache.top = p;
+		assert (NULL != c->entry);
+		s = c->top;
+		p = &c->entry[c->n++];
+		c->top = p;
 
 		assert (NULL != p && NULL != s);
 		s->next = p;
 		p->prev = s;
 		p->next = NULL;
 
-	} else if (1 < dtm_cache.max_blocks) { /* replace*/
+	} else if (1 < c->max_blocks) { /* replace*/
 
-		assert (NULL != dtm_cache.bot && NULL != dtm_cache.top);
-		t = dtm_cache.bot;
-		s = dtm_cache.top;
+		assert (NULL != c->bot && NULL != c->top);
+		t = c->bot;
+		s = c->top;
 
-		dtm_cache.bot = t->next;
-		dtm_cache.top = t;
+		c->bot = t->next;
+		c->top = t;
 
 		s->next = t;
 		t->prev = s;
 
-		assert (dtm_cache.top);
-		dtm_cache.top->next = NULL;
+		assert (c->top);
+		c->top->next = NULL;
 
-		assert (dtm_cache.bot);
-		dtm_cache.bot->prev = NULL;
+		assert (c->bot);
+		c->bot->prev = NULL;
 
 		p = t;
 
 	} else {
 
-		assert (1 == dtm_cache.max_blocks);
-		p =	dtm_cache.top;
-		assert (p == dtm_cache.bot && p == dtm_cache.entry);
+		assert (1 == c->max_blocks);
+		p =	c->top;
+		assert (p == c->bot && p == c->entry);
 	}
 
 	/* make the information content unusable, it will be replaced */
@@ -3562,7 +3724,7 @@ point_block_to_replace (void)
 }
 
 static void
-movetotop (dtm_block_t *t)
+movetotop (struct cache_table *c, dtm_block_t *t)
 {
 	dtm_block_t *s, *nx, *pv;
 
@@ -3576,26 +3738,26 @@ movetotop (dtm_block_t *t)
 	nx = t->next;
 
 	if (pv == NULL)  /* at the bottom */
-		dtm_cache.bot = nx;
+		c->bot = nx;
 	else
 		pv->next = nx;
 
 	if (nx == NULL) /* at the top */
-		dtm_cache.top = pv;
+		c->top = pv;
 	else
 		nx->prev = pv;
 
 	/* relocate */
-	s = dtm_cache.top;
+	s = c->top;
 	assert (s != NULL);
 	if (s == NULL)
-		dtm_cache.bot = t;
+		c->bot = t;
 	else
 		s->next = t;
 
 	t->next = NULL;
 	t->prev = s;
-	dtm_cache.top = t;
+	c->top = t;
 
 	return;
 }
@@ -7516,8 +7678,8 @@ list_index (void)
 
 /*--------------------------------------------------------------------------*/
 static unsigned int		wdl_extract (unit_t *uarr, index_t x);
-static wdl_block_t *	wdl_point_block_to_replace (void);
-static void				wdl_movetotop (wdl_block_t *t);
+static wdl_block_t *	wdl_point_block_to_replace (struct WDL_CACHE *w);
+static void				wdl_movetotop (struct WDL_CACHE *w, wdl_block_t *t);
 
 #if 0
 static bool_t			wdl_cache_init (size_t cache_mem);
@@ -7529,10 +7691,10 @@ static bool_t			wdl_cache_is_on (void);
 static void				wdl_cache_reset_counters (void);
 static void				wdl_cache_done (void);
 
-static wdl_block_t *	wdl_point_block_to_replace (void);
-static bool_t			get_WDL_from_cache (tbkey_t key, unsigned side, index_t idx, unsigned int *out);
-static void				wdl_movetotop (wdl_block_t *t);
-static bool_t			wdl_preload_cache (tbkey_t key, unsigned side, index_t idx);
+static wdl_block_t *	wdl_point_block_to_replace (struct WDL_CACHE *w);
+static bool_t			get_WDL_from_cache (struct WDL_CACHE *w, tbkey_t key, unsigned side, index_t idx, unsigned int *out);
+static void				wdl_movetotop (struct WDL_CACHE *w, wdl_block_t *t);
+static bool_t			wdl_preload_cache (struct WDL_CACHE *w, tbkey_t key, unsigned side, index_t idx);
 
 /*--------------------------------------------------------------------------*/
 
@@ -7540,112 +7702,146 @@ static bool_t			wdl_preload_cache (tbkey_t key, unsigned side, index_t idx);
 |			WDL CACHE Maintainance
 \*---------------------------------------------------------------------*/
 
+static void wdl_shard_done (struct WDL_CACHE *w);
 
 static size_t
-wdl_cache_init (size_t cache_mem)
+wdl_shard_init (struct WDL_CACHE *w, size_t max_blocks)
 {
 	unsigned int 	i;
 	wdl_block_t 	*p;
-	size_t 			entries_per_block;
-	size_t 			max_blocks;
-	size_t 			block_mem;
-
-	if (WDL_CACHE_INITIALIZED)
-		wdl_cache_done();
-
-	entries_per_block 	= 16 * 1024;  /* fixed, needed for the compression schemes */
-
-	WDL_units_per_block	= entries_per_block / WDL_entries_per_unit;
-	block_mem			= WDL_units_per_block * sizeof(unit_t);
-
-	max_blocks 			= cache_mem / block_mem;
-	cache_mem 			= max_blocks * block_mem;
-
-
-	wdl_cache_reset_counters ();
-
-	wdl_cache.entries_per_block = entries_per_block;
-	wdl_cache.max_blocks 		= max_blocks;
-	wdl_cache.cached 			= TRUE;
-	wdl_cache.top 				= NULL;
-	wdl_cache.bot 				= NULL;
-	wdl_cache.n 				= 0;
-
-	if (0 == cache_mem || NULL == (wdl_cache.buffer = (unit_t *) malloc (cache_mem))) {
-		wdl_cache.cached = FALSE;
+	size_t 			entries_per_block = GTB_ENTRIES_PER_BLOCK;
+	size_t 			cache_mem = max_blocks * WDL_units_per_block * sizeof(unit_t);
+
+	w->entries_per_block = entries_per_block;
+	w->max_blocks 		= max_blocks;
+	w->cached 			= TRUE;
+	w->top 				= NULL;
+	w->bot 				= NULL;
+	w->n 				= 0;
+
+	if (0 == cache_mem || NULL == (w->buffer = (unit_t *) malloc (cache_mem))) {
+		w->cached = FALSE;
 		return 0;
 	}
 
-	if (0 == max_blocks|| NULL == (wdl_cache.blocks = (wdl_block_t *) malloc (max_blocks * sizeof(wdl_block_t)))) {
-		wdl_cache.cached = FALSE;
-		free (wdl_cache.buffer);
+	if (0 == max_blocks|| NULL == (w->blocks = (wdl_block_t *) malloc (max_blocks * sizeof(wdl_block_t)))) {
+		w->cached = FALSE;
+		free (w->buffer);
 		return 0;
 	}
 
 	for (i = 0; i < max_blocks; i++) {
-		p = &wdl_cache.blocks[i];
+		p = &w->blocks[i];
 		p->key  	= -1;
 		p->side 	= gtbNOSIDE;
 		p->offset 	= gtbNOINDEX;
-		p->p_arr 	= wdl_cache.buffer + i * WDL_units_per_block;
+		p->p_arr 	= w->buffer + i * WDL_units_per_block;
 		p->prev 	= NULL;
 		p->next 	= NULL;
 	}
 
-	wdl_cache.ht_size = 1;
-	while (wdl_cache.ht_size < max_blocks * 4)
-		wdl_cache.ht_size *= 2;
-	wdl_cache.ht_used = 0;
-	wdl_cache.hash_table = (wdl_block_t**) malloc (wdl_cache.ht_size * sizeof(wdl_block_t*));;
-	if (wdl_cache.hash_table == NULL) {
-		wdl_cache.cached = FALSE;
-		free (wdl_cache.blocks);
-		wdl_cache.blocks = NULL;
-		free (wdl_cache.buffer);
-		wdl_cache.buffer = NULL;
+	w->ht_size = 1;
+	while (w->ht_size < max_blocks * 4)
+		w->ht_size *= 2;
+	w->ht_used = 0;
+	w->hash_table = (wdl_block_t**) malloc (w->ht_size * sizeof(wdl_block_t*));;
+	if (w->hash_table == NULL) {
+		w->cached = FALSE;
+		free (w->blocks);
+		w->blocks = NULL;
+		free (w->buffer);
+		w->buffer = NULL;
 		return 0;
 	}
 
-	for (i = 0; i < wdl_cache.ht_size; i++) {
-		wdl_cache.hash_table[i] = NULL;
+	for (i = 0; i < w->ht_size; i++) {
+		w->hash_table[i] = NULL;
+	}
+
+	return cache_mem;
+}
+
+static size_t
+wdl_cache_init (size_t cache_mem)
+{
+	size_t 			i;
+	size_t 			max_blocks;
+	size_t 			block_mem;
+	size_t 			allocated;
+
+	if (WDL_CACHE_INITIALIZED)
+		wdl_cache_done();
+
+	WDL_units_per_block	= GTB_ENTRIES_PER_BLOCK / WDL_entries_per_unit;
+	block_mem			= WDL_units_per_block * sizeof(unit_t);
+
+	max_blocks 			= cache_mem / block_mem;
+
+	wdl_cache_reset_counters ();
+
+	WDL_shards = cache_shards (max_blocks);
+
+	for (i = 0, allocated = 0; i < WDL_shards; i++) {
+		size_t blocks = max_blocks / WDL_shards + (i < max_blocks % WDL_shards ? 1 : 0);
+		size_t mem = wdl_shard_init (&wdl_cache[i], blocks);
+		if (0 == mem) {
+			/* all shards on or none */
+			for (; i > 0; i--)
+				wdl_shard_done (&wdl_cache[i-1]);
+			WDL_shards = 0;
+			return 0;
+		}
+		allocated += mem;
 	}
 
 	WDL_CACHE_INITIALIZED = TRUE;
 
-	return cache_mem;
+	return allocated;
 }
 
 
 static void
-wdl_cache_done (void)
-{
-	assert(WDL_CACHE_INITIALIZED);
-
-	wdl_cache.cached = FALSE;
-	wdl_cache.hard = 0;
-	wdl_cache.soft = 0;
-	wdl_cache.hardmisses = 0;
-	wdl_cache.hits = 0;
-	wdl_cache.softmisses = 0;
-	wdl_cache.comparisons = 0;
-	wdl_cache.max_blocks = 0;
-	wdl_cache.entries_per_block = 0;
+wdl_shard_done (struct WDL_CACHE *w)
+{
+	w->cached = FALSE;
+	w->hard = 0;
+	w->soft = 0;
+	w->hardmisses = 0;
+	w->hits = 0;
+	w->softmisses = 0;
+	w->comparisons = 0;
+	w->max_blocks = 0;
+	w->entries_per_block = 0;
+
+	w->top = NULL;
+	w->bot = NULL;
+	w->n = 0;
+
+	if (w->buffer != NULL)
+		free (w->buffer);
+	w->buffer = NULL;
+
+	if (w->blocks != NULL)
+		free (w->blocks);
+	w->blocks = NULL;
+
+	if (w->hash_table != NULL)
+		free (w->hash_table);
+	w->hash_table = NULL;
 
-	wdl_cache.top = NULL;
-	wdl_cache.bot = NULL;
-	wdl_cache.n = 0;
+	return;
+}
 
-	if (wdl_cache.buffer != NULL)
-		free (wdl_cache.buffer);
-	wdl_cache.buffer = NULL;
+static void
+wdl_cache_done (void)
+{
+	size_t i;
 
-	if (wdl_cache.blocks != NULL)
-		free (wdl_cache.blocks);
-	wdl_cache.blocks = NULL;
+	assert(WDL_CACHE_INITIALIZED);
 
-	if (wdl_cache.hash_table != NULL)
-		free (wdl_cache.hash_table);
-	wdl_cache.hash_table = NULL;
+	for (i = 0; i < WDL_shards; i++)
+		wdl_shard_done (&wdl_cache[i]);
+	WDL_shards = 0;
 
 	WDL_CACHE_INITIALIZED = FALSE;
 	return;
@@ -7656,22 +7852,27 @@ static void
 wdl_cache_flush (void)
 {
 	unsigned int 	i;
+	size_t			k;
 	wdl_block_t 	*p;
-	size_t max_blocks = wdl_cache.max_blocks;
+	struct WDL_CACHE *w;
 
-	wdl_cache.top 				= NULL;
-	wdl_cache.bot 				= NULL;
-	wdl_cache.n 				= 0;
+	for (k = 0; k < WDL_shards; k++) {
+	w = &wdl_cache[k];
 
-	for (i = 0; i < max_blocks; i++) {
-		p = &wdl_cache.blocks[i];
+	w->top 				= NULL;
+	w->bot 				= NULL;
+	w->n 				= 0;
+
+	for (i = 0; i < w->max_blocks; i++) {
+		p = &w->blocks[i];
 		p->key  	= -1;
 		p->side 	= gtbNOSIDE;
 		p->offset 	= gtbNOINDEX;
-		p->p_arr 	= wdl_cache.buffer + i * WDL_units_per_block;
+		p->p_arr 	= w->buffer + i * WDL_units_per_block;
 		p->prev 	= NULL;
 		p->next 	= NULL;
 	}
+	}
 
 	wdl_cache_reset_counters  ();
 
@@ -7682,12 +7883,19 @@ wdl_cache_flush (void)
 static void
 wdl_cache_reset_counters (void)
 {
-	wdl_cache.hard = 0;
-	wdl_cache.soft = 0;
-	wdl_cache.hardmisses = 0;
-	wdl_cache.hits = 0;
-	wdl_cache.softmisses = 0;
-	wdl_cache.comparisons = 0;
+	size_t i;
+	struct WDL_CACHE *w;
+
+	for (i = 0; i < GTB_CACHE_SHARDS; i++) {
+		w = &wdl_cache[i];
+		w->hard = 0;
+		w->soft = 0;
+		w->hardmisses = 0;
+		w->hits = 0;
+		w->softmisses = 0;
+		w->comparisons = 0;
+		w->waits = 0;
+	}
 	return;
 }
 
@@ -7695,7 +7903,7 @@ wdl_cache_reset_counters (void)
 static bool_t
 wdl_cache_is_on (void)
 {
-	return wdl_cache.cached;
+	return WDL_shards > 0 && wdl_cache[0].cached;
 }
 
 /****************************************************************************\
@@ -7703,36 +7911,36 @@ wdl_cache_is_on (void)
 \****************************************************************************/
 
 static wdl_block_t *
-wdl_point_block_to_replace (void)
+wdl_point_block_to_replace (struct WDL_CACHE *w)
 {
 	wdl_block_t *p, *t, *s;
 
-	assert (0 == wdl_cache.n || wdl_cache.top != NULL);
-	assert (0 == wdl_cache.n || wdl_cache.bot != NULL);
-	assert (0 == wdl_cache.n || wdl_cache.bot->prev == NULL);
-	assert (0 == wdl_cache.n || wdl_cache.top->next == NULL);
+	assert (0 == w->n || w->top != NULL);
+	assert (0 == w->n || w->bot != NULL);
+	assert (0 == w->n || w->bot->prev == NULL);
+	assert (0 == w->n || w->top->next == NULL);
 
-	if (wdl_cache.n > 0 && -1 == wdl_cache.top->key) {
+	if (w->n > 0 && -1 == w->top->key) {
 
 		/* top blocks is unusable, should be the one to replace*/
-		p = wdl_cache.top;
+		p = w->top;
 
 	} else
-	if (wdl_cache.n == 0) {
+	if (w->n == 0) {
 
-		p = &wdl_cache.blocks[wdl_cache.n++];
-		wdl_cache.top = p;
-		wdl_cache.bot = p;
+		p = &w->blocks[w->n++];
+		w->top = p;
+		w->bot = p;
 
 		p->prev = NULL;
 		p->next = NULL;
 
 	} else
-	if (wdl_cache.n < wdl_cache.max_blocks) { /* add */
+	if (w->n < w->max_blocks) { /* add */
 
-		s = wdl_cache.top;
-		p = &wdl_cache.blocks[wdl_cache.n++];
-		wdl_cache.top = p;
+		s = w->top;
+		p = &w->blocks[w->n++];
+		w->top = p;
 
 		s->next = p;
 		p->prev = s;
@@ -7740,15 +7948,15 @@ wdl_point_block_to_replace (void)
 
 	} else {                       /* replace*/
 
-		t = wdl_cache.bot;
-		s = wdl_cache.top;
-		wdl_cache.bot = t->next;
-		wdl_cache.top = t;
+		t = w->bot;
+		s = w->top;
+		w->bot = t->next;
+		w->top = t;
 
 		s->next = t;
 		t->prev = s;
-		wdl_cache.top->next = NULL;
-		wdl_cache.bot->prev = NULL;
+		w->top->next = NULL;
+		w->bot->prev = NULL;
 
 		p = t;
 	}
@@ -7768,82 +7976,98 @@ wdl_point_block_to_replace (void)
 \****************************************************************************/
 
 static unsigned int	wdl_extract (unit_t *uarr, index_t x);
-static bool_t		get_WDL_from_cache (tbkey_t key, unsigned side, index_t idx, unsigned int *info_out);
+static bool_t		get_WDL_from_cache (struct WDL_CACHE *w, tbkey_t key, unsigned side, index_t idx, unsigned int *info_out);
 static unsigned 	dtm2WDL(dtm_t dtm);
-static void			wdl_movetotop (wdl_block_t *t);
-static bool_t		wdl_preload_cache (tbkey_t key, unsigned side, index_t idx);
-static void			dtm_block_2_wdl_block(dtm_block_t *g, wdl_block_t *w, size_t n);
+static void			wdl_movetotop (struct WDL_CACHE *w, wdl_block_t *t);
+static bool_t		wdl_preload_cache (struct WDL_CACHE *w, tbkey_t key, unsigned side, index_t idx);
+static void			dtm_block_2_wdl_block(const dtm_t *s, unit_t *d, size_t n);
 
 static bool_t
 get_WDL (tbkey_t key, unsigned side, index_t idx, unsigned int *info_out, bool_t probe_hard_flag)
 {
+	struct WDL_CACHE *w;
 	dtm_t dtm;
 	bool_t found;
 
-	found = get_WDL_from_cache (key, side, idx, info_out);
+	if (!wdl_cache_is_on()) {
+		found = get_dtm (key, side, idx, &dtm, probe_hard_flag);
+		if (found)
+			*info_out = dtm2WDL(dtm);
+		return found;
+	}
+
+	w = wdl_shard (key, side, idx);
+
+	counted_lock (&w->lock, &w->waits);
+
+	found = get_WDL_from_cache (w, key, side, idx, info_out);
 
 	if (found) {
-		wdl_cache.hits++;
+		w->hits++;
+	}
+	if (probe_hard_flag) {
+		w->hard++;
 	} else {
+		w->soft++;
+	}
+
+	mythread_mutex_unlock (&w->lock);
+
+	if (!found) {
 		/* may probe soft */
 		found = get_dtm (key, side, idx, &dtm, probe_hard_flag);
 		if (found) {
 			*info_out = dtm2WDL(dtm);
 			/* move cache info from dtm_cache to WDL_cache */
-			if (wdl_cache_is_on())
-				wdl_preload_cache (key, side, idx);
-		}
-	}
-
-	if (probe_hard_flag) {
-		wdl_cache.hard++;
-		if (!found) {
-			wdl_cache.hardmisses++;
-		}
-	} else {
-		wdl_cache.soft++;
-		if (!found) {
-			wdl_cache.softmisses++;
+			wdl_preload_cache (w, key, side, idx);
+		} else {
+			counted_lock (&w->lock, &w->waits);
+			if (probe_hard_flag) {
+				w->hardmisses++;
+			} else {
+				w->softmisses++;
+			}
+			mythread_mutex_unlock (&w->lock);
 		}
 	}
 
 	return found;
 }
 
-static void wdl_hash_insert (wdl_block_t * e);
+static void wdl_hash_insert (struct WDL_CACHE *w, wdl_block_t * e);
 
 static void
-wdl_hash_rebuild (void)
+wdl_hash_rebuild (struct WDL_CACHE *w)
 {
 	wdl_block_t	* p;
 	size_t i;
 
-	for (i = 0; i < wdl_cache.ht_size; i++)
-		wdl_cache.hash_table[i] = NULL;
-	wdl_cache.ht_used = 0;
+	for (i = 0; i < w->ht_size; i++)
+		w->hash_table[i] = NULL;
+	w->ht_used = 0;
 
-	for (p = wdl_cache.top; p != NULL; p = p->prev)
-		wdl_hash_insert (p);
+	for (p = w->top; p != NULL; p = p->prev)
+		wdl_hash_insert (w, p);
 }
 
 static void
-wdl_hash_insert (wdl_block_t * e)
+wdl_hash_insert (struct WDL_CACHE *w, wdl_block_t * e)
 {
 	size_t h1, h2;
 
-	if (wdl_cache.ht_used > wdl_cache.ht_size * 3 / 4)
-		wdl_hash_rebuild();
+	if (w->ht_used + 1 > w->ht_size * 3 / 4) /* keep an empty slot to end lookups */
+		wdl_hash_rebuild (w);
 
-    h1 = hash_func_1 (e->key, e->side, e->offset) & (wdl_cache.ht_size - 1);
+    h1 = hash_func_1 (e->key, e->side, e->offset) & (w->ht_size - 1);
     h2 = hash_func_2 (e->key, e->side, e->offset);
-    while (wdl_cache.hash_table[h1])
-        h1 = (h1 + h2) & (wdl_cache.ht_size - 1);
-    wdl_cache.hash_table[h1] = e;
-    wdl_cache.ht_used++;
+    while (w->hash_table[h1])
+        h1 = (h1 + h2) & (w->ht_size - 1);
+    w->hash_table[h1] = e;
+    w->ht_used++;
 }
 
-static bool_t
-get_WDL_from_cache (tbkey_t key, unsigned side, index_t idx, unsigned int *out)
+static wdl_block_t *
+wdl_cache_pointblock (struct WDL_CACHE *w, tbkey_t key, unsigned side, index_t idx)
 {
 	index_t 	offset;
 	index_t		remainder;
@@ -7851,33 +8075,47 @@ get_WDL_from_cache (tbkey_t key, unsigned side, index_t idx, unsigned int *out)
 	wdl_block_t	*ret;
 	size_t		h1, h2;
 
-	if (!wdl_cache_is_on())
-		return FALSE;
-
-	split_index (wdl_cache.entries_per_block, idx, &offset, &remainder);
+	split_index (w->entries_per_block, idx, &offset, &remainder);
 
 	ret = NULL;
 
-	h1 = hash_func_1 (key, side, offset) & (wdl_cache.ht_size - 1);
+	h1 = hash_func_1 (key, side, offset) & (w->ht_size - 1);
 	h2 = hash_func_2 (key, side, offset);
 	while (1) {
-		p = wdl_cache.hash_table[h1];
+		p = w->hash_table[h1];
 		if (!p)
 			break;
 
-		wdl_cache.comparisons++;
+		w->comparisons++;
 
 		if (key == p->key && side == p->side && offset  == p->offset) {
 			ret = p;
 			break;
 		}
 
-		h1 = (h1 + h2) & (wdl_cache.ht_size - 1);
+		h1 = (h1 + h2) & (w->ht_size - 1);
 	}
 
+	return ret;
+}
+
+static bool_t
+get_WDL_from_cache (struct WDL_CACHE *w, tbkey_t key, unsigned side, index_t idx, unsigned int *out)
+{
+	index_t 	offset;
+	index_t		remainder;
+	wdl_block_t	*ret;
+
+	if (!wdl_cache_is_on())
+		return FALSE;
+
+	split_index (w->entries_per_block, idx, &offset, &remainder);
+
+	ret = wdl_cache_pointblock (w, key, side, idx);
+
 	if (ret != NULL) {
 		*out = wdl_extract (ret->p_arr, remainder);
-		wdl_movetotop(ret);
+		wdl_movetotop (w, ret);
 	}
 
 	FOLLOW_LU("get_wdl_from_cache ok?",(ret != NULL))
@@ -7895,7 +8133,7 @@ wdl_extract (unit_t *uarr, index_t x)
 }
 
 static void
-wdl_movetotop (wdl_block_t *t)
+wdl_movetotop (struct WDL_CACHE *w, wdl_block_t *t)
 {
 	wdl_block_t *s, *nx, *pv;
 
@@ -7909,26 +8147,26 @@ wdl_movetotop (wdl_block_t *t)
 	nx = t->next;
 
 	if (pv == NULL)  /* at the bottom */
-		wdl_cache.bot = nx;
+		w->bot = nx;
 	else
 		pv->next = nx;
 
 	if (nx == NULL) /* at the top */
-		wdl_cache.top = pv;
+		w->top = pv;
 	else
 		nx->prev = pv;
 
 	/* relocate */
-	s = wdl_cache.top;
+	s = w->top;
 	assert (s != NULL);
 	if (s == NULL)
-		wdl_cache.bot = t;
+		w->bot = t;
 	else
 		s->next = t;
 
 	t->next = NULL;
 	t->prev = s;
-	wdl_cache.top = t;
+	w->top = t;
 
 	return;
 }
@@ -7936,12 +8174,15 @@ wdl_movetotop (wdl_block_t *t)
 /****************************************************************************************************/
 
 static bool_t
-wdl_preload_cache (tbkey_t key, unsigned side, index_t idx)
-/* output to the least used block of the cache */
+wdl_preload_cache (struct WDL_CACHE *w, tbkey_t key, unsigned side, index_t idx)
+/* output to the least used block of the shard */
 {
+	struct cache_table *c;
 	dtm_block_t		*dtm_block;
 	wdl_block_t 	*to_modify;
-	bool_t 			ok;
+	index_t 		offset;
+	index_t			remainder;
+	unit_t			units [GTB_ENTRIES_PER_BLOCK / WDL_entries_per_unit];
 
 	FOLLOW_label("wdl preload_cache starts")
 
@@ -7950,53 +8191,52 @@ wdl_preload_cache (tbkey_t key, unsigned side, index_t idx)
 		return FALSE;
 	}
 
-	/* find fresh block in dtm cache */
-	dtm_block = dtm_cache_pointblock (key, side, idx);
+	/* find fresh block in dtm cache and transform it */
+	c = dtm_shard (key, side, idx);
+	counted_lock (&c->lock, &c->waits);
+	dtm_block = dtm_cache_pointblock (c, key, side, idx);
+	if (NULL != dtm_block)
+		dtm_block_2_wdl_block (dtm_block->p_arr, units, c->entries_per_block);
+	mythread_mutex_unlock (&c->lock);
 
-	/* find aged blocked in wdl cache */
-	to_modify = wdl_point_block_to_replace ();
+	if (NULL == dtm_block)
+		return FALSE;
 
-	ok = !(NULL == dtm_block || NULL == to_modify);
+	split_index (w->entries_per_block, idx, &offset, &remainder);
 
-	if (!ok)
-		return FALSE;
+	counted_lock (&w->lock, &w->waits);
 
-	/* transform and move a block */
-	dtm_block_2_wdl_block(dtm_block, to_modify, dtm_cache.entries_per_block);
+	/* may have been stored by another thread in the meantime */
+	if (NULL == wdl_cache_pointblock (w, key, side, idx)) {
 
-	if (ok) {
-		index_t 		offset;
-		index_t			remainder;
-		split_index (wdl_cache.entries_per_block, idx, &offset, &remainder);
+		/* find aged blocked in wdl cache */
+		to_modify = wdl_point_block_to_replace (w);
+
+		memcpy (to_modify->p_arr, units, WDL_units_per_block * sizeof(unit_t));
 
 		to_modify->key    = key;
 		to_modify->side   = side;
 		to_modify->offset = offset;
-		wdl_hash_insert (to_modify);
-	} else {
-		/* make it unusable */
-		to_modify->key    = -1;
-		to_modify->side   = gtbNOSIDE;
-		to_modify->offset = gtbNOINDEX;
+		wdl_hash_insert (w, to_modify);
 	}
 
-	FOLLOW_LU("wdl preload_cache?", ok)
+	mythread_mutex_unlock (&w->lock);
 
-	return ok;
+	FOLLOW_LU("wdl preload_cache?", TRUE)
+
+	return TRUE;
 }
 
 /****************************************************************************************************/
 
 static void
-dtm_block_2_wdl_block(dtm_block_t *g, wdl_block_t *w, size_t n)
+dtm_block_2_wdl_block(const dtm_t *s, unit_t *d, size_t n)
 {
 	int width = 2;
 	int shifting;
 	size_t i;
 	int j;
 	unsigned int x ,y;
-	 dtm_t *s = g->p_arr;
-	unit_t *d = w->p_arr;
 
 	for (i = 0, y = 0; i < n; i++) {
 		j =  i & 3; /* modulo WDL_entries_per_unit */
@@ -8202,11 +8442,7 @@ egtb_get_wdl (tbkey_t k, unsigned stm, const SQUARE *wS, const SQUARE *bS, bool_
 		if (idxavail) {
 			bool_t success;
 
-			/*
-			|		LOCK
-			*-------------------------------*/
-			mythread_mutex_lock (&Egtb_lock);
-
+			/* locks the cache shards and the files as needed */
 			success = get_WDL (k, stm, idx, wdl, probe_hard_flag);
 			FOLLOW_LU("get_wld (succ)",success)
 			FOLLOW_LU("get_wld (wdl )",*wdl)
@@ -8217,7 +8453,9 @@ egtb_get_wdl (tbkey_t k, unsigned stm, const SQUARE *wS, const SQUARE *bS, bool_
 				unsigned res, ply;
 				if (probe_hard_flag && Uncompressed) {
 					assert(Uncompressed);
+					counted_lock (&Egtb_lock, &Drive.waits);
 					success = egtb_filepeek (k, stm, idx, &dtm);
+					mythread_mutex_unlock (&Egtb_lock);
 					unpackdist (dtm, &res, &ply);
 					*wdl = res;
 				}
@@ -8225,11 +8463,6 @@ egtb_get_wdl (tbkey_t k, unsigned stm, const SQUARE *wS, const SQUARE *bS, bool_
 					success = FALSE;
 			}
 
-			mythread_mutex_unlock (&Egtb_lock);
-			/*------------------------------*\
-			|		UNLOCK
-			*/
-
 			if (success) {
 				return TRUE;
 			} else {
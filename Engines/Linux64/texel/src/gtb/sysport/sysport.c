@@ -130,6 +130,7 @@ extern void mythread_mutex_init		(mythread_mutex_t *m) { pthread_mutex_init   (m
 extern void mythread_mutex_destroy	(mythread_mutex_t *m) { pthread_mutex_destroy(m)     ;}
 extern void mythread_mutex_lock     (mythread_mutex_t *m) { pthread_mutex_lock   (m)     ;}
 extern void mythread_mutex_unlock   (mythread_mutex_t *m) { pthread_mutex_unlock (m)     ;}
+extern int  mythread_mutex_trylock  (mythread_mutex_t *m) { return 0 == pthread_mutex_trylock (m);}
 
 #ifdef SPINLOCKS
 extern void mythread_spinx_init		(mythread_spinx_t *m) { pthread_spin_init   (m,0);} /**/
@@ -218,6 +219,7 @@ extern void mythread_mutex_init		(mythread_mutex_t *m) { *m = CreateMutex(0, FAL
 extern void mythread_mutex_destroy	(mythread_mutex_t *m) { CloseHandle(*m)                    ;}
 extern void mythread_mutex_lock     (mythread_mutex_t *m) { WaitForSingleObject(*m, INFINITE)  ;}
 extern void mythread_mutex_unlock   (mythread_mutex_t *m) { ReleaseMutex(*m)                   ;}
+extern int  mythread_mutex_trylock  (mythread_mutex_t *m) { return WAIT_OBJECT_0 == WaitForSingleObject(*m, 0);}
 
 extern void mythread_spinx_init		(mythread_spinx_t *m) { InitializeCriticalSection(m)  ;} /**/
 extern void mythread_spinx_destroy	(mythread_spinx_t *m) { DeleteCriticalSection(m)  ;} /**/
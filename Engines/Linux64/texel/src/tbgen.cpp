@@ -28,6 +28,18 @@
 #include "textio.hpp"
 #include "constants.hpp"
 #include "transpositionTable.hpp"
+#include "chessParseError.hpp"
+
+#include <fstream>
+#include <thread>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
 
 
 static StaticInitializer<TBIndex> tbIdxInit;
@@ -475,120 +487,181 @@ TBGenerator<TBStorage>::TBGenerator(TBStorage& storage, const PieceCount& pc)
     table.resize(tbPos.nPositions());
 }
 
+/** Call func(begin, end) for consecutive index ranges covering [0,nPos),
+ * using nThreads threads. Each range is a multiple of 64 positions, so
+ * threads never share a byte in the newMated/oldMated vectors. */
+template <typename Func>
+static void
+parallelFor(int nThreads, U32 nPos, Func func) {
+    const U32 chunkSize = 1 << 16;
+    std::atomic<U32> next(0);
+    auto worker = [&]() {
+        while (true) {
+            U32 begin = next.fetch_add(chunkSize);
+            if (begin >= nPos)
+                break;
+            func(begin, std::min(begin + chunkSize, nPos));
+        }
+    };
+    std::vector<std::thread> threads;
+    for (int i = 1; i < nThreads; i++)
+        threads.push_back(std::thread(worker));
+    worker();
+    for (auto& t : threads)
+        t.join();
+}
+
 template <typename TBStorage>
 bool
-TBGenerator<TBStorage>::generate(RelaxedShared<S64>& maxTimeMillis, bool verbose) {
+TBGenerator<TBStorage>::generate(RelaxedShared<S64>& maxTimeMillis, bool verbose, int nThreads) {
     double t0 = currentTime();
+    nThreads = std::max(nThreads, 1);
 
-    TBPosition tbPos(pieceCount);
-    const U32 nPos = tbPos.nPositions();
-    std::vector<U8> newMated, oldMated;
+    const U32 nPos = TBPosition(pieceCount).nPositions();
     size_t bitSize = nPos / 64;
-    newMated.resize(bitSize);
-    oldMated.resize(bitSize);
-
-    // Classify positions into INVALID, MATE_IN_0 and UNKNOWN
-    PositionValue pv;
-    for (U32 idx = 0; idx < nPos; idx++) {
-        if (((idx & 0xffff) == 0) && (maxTimeMillis >= 0)) {
+    std::unique_ptr<std::atomic<U8>[]> newMated(new std::atomic<U8>[bitSize]);
+    std::unique_ptr<std::atomic<U8>[]> oldMated(new std::atomic<U8>[bitSize]);
+    for (size_t i = 0; i < bitSize; i++)
+        newMated[i].store(0, std::memory_order_relaxed);
+
+    std::atomic<bool> timeout(false);
+    auto checkTime = [&]() -> bool {
+        if (maxTimeMillis >= 0) {
             double t = currentTime();
             if (t - t0 > 0.3e-3 * maxTimeMillis)
-                return false;
+                timeout = true;
         }
-        tbPos.setIndex(idx);
-        if (!tbPos.indexValid()) {
-            pv.setInvalid();
-        } else if (tbPos.canTakeKing()) {
-            pv.setMateInN(0);
-        } else {
-            pv.setUnknown();
+        return timeout;
+    };
+
+    // Classify positions into INVALID, MATE_IN_0 and UNKNOWN
+    parallelFor(nThreads, nPos, [&](U32 begin, U32 end) {
+        if (checkTime())
+            return;
+        TBPosition tbPos(pieceCount);
+        PositionValue pv;
+        for (U32 idx = begin; idx < end; idx++) {
+            tbPos.setIndex(idx);
+            if (!tbPos.indexValid()) {
+                pv.setInvalid();
+            } else if (tbPos.canTakeKing()) {
+                pv.setMateInN(0);
+            } else {
+                pv.setUnknown();
+            }
+            table.store(idx, pv);
         }
-        table.store(idx, pv);
-    }
+    });
+    if (timeout)
+        return false;
 
     // Classify positions into MATED_IN_0, DRAW (stalemate), and REMAINING_N
-    for (U32 idx = 0; idx < nPos; idx++) {
-        if (((idx & 0xffff) == 0) && (maxTimeMillis >= 0)) {
-            double t = currentTime();
-            if (t - t0 > 0.3e-3 * maxTimeMillis)
-                return false;
-        }
-        if (!table[idx].isUnknown())
-            continue;
-        tbPos.setIndex(idx);
-        TbMoveList moves;
-        tbPos.getMoves(moves);
-        int nLegal = 0;
-        for (int m = 0; m < moves.getSize(); m++) {
-            if (m > 0 && moves[m] == moves[m-1])
-                continue; // Skip duplicated moves
-            int idx2 = moves[m];
-            if (!table[idx2].isMateInN(0))
-                nLegal++;
-        }
-        if (nLegal > 0) {
-            pv.setRemaining(nLegal);
-        } else {
-            tbPos.swapSide();
-            int idx2 = tbPos.getIndex();
-            if (table[idx2].isMateInN(0)) {
-                pv.setMatedInN(0);
-                newMated[idx>>6] = 1;
+    parallelFor(nThreads, nPos, [&](U32 begin, U32 end) {
+        if (checkTime())
+            return;
+        TBPosition tbPos(pieceCount);
+        PositionValue pv;
+        for (U32 idx = begin; idx < end; idx++) {
+            if (!table[idx].isUnknown())
+                continue;
+            tbPos.setIndex(idx);
+            TbMoveList moves;
+            tbPos.getMoves(moves);
+            int nLegal = 0;
+            for (int m = 0; m < moves.getSize(); m++) {
+                if (m > 0 && moves[m] == moves[m-1])
+                    continue; // Skip duplicated moves
+                int idx2 = moves[m];
+                if (!table[idx2].isMateInN(0))
+                    nLegal++;
+            }
+            if (nLegal > 0) {
+                pv.setRemaining(nLegal);
             } else {
-                pv.setDraw();
+                tbPos.swapSide();
+                int idx2 = tbPos.getIndex();
+                if (table[idx2].isMateInN(0)) {
+                    pv.setMatedInN(0);
+                    newMated[idx>>6].store(1, std::memory_order_relaxed);
+                } else {
+                    pv.setDraw();
+                }
             }
+            table.store(idx, pv);
         }
-        table.store(idx, pv);
-    }
+    });
+    if (timeout)
+        return false;
 
     double t1 = currentTime();
 
-    // Find all MATE_IN_N and MATED_IN_N positions
+    // Find all MATE_IN_N and MATED_IN_N positions. A position can be reached
+    // from several MATED_IN_N-1 positions handled by different threads, so
+    // setting MATE_IN_N and decrementing the remaining move count must be
+    // done with compareExchange().
     for (int n = 1; ; n++) {
         if (maxTimeMillis == 0)
             return false; // Cancelled by UCI stop command
         double t2 = currentTime();
-        int modified = 0;
-        int handled = 0;
+        std::atomic<int> modified(0);
+        std::atomic<int> handled(0);
         oldMated.swap(newMated);
-        for (size_t i = 0; i < bitSize; i++) newMated[i] = 0;
-        for (U32 idx = 0; idx < nPos; idx++) {
-            if (((idx & 63) == 0) && !oldMated[idx>>6]) {
-                idx += 63;
-                continue;
-            }
-            if (!table[idx].isMatedInN(n-1))
-                continue;
-            tbPos.setIndex(idx);
-            handled++;
-            TbMoveList lst;
-            tbPos.getUnMoves(lst);
-            for (int m1 = 0; m1 < lst.getSize(); m1++) {
-                if (m1 > 0 && lst[m1] == lst[m1-1])
-                    continue; // Skip duplicated moves
-                int idx2 = lst[m1];
-                tbPos.setIndex(idx2);
-                if (!table[idx2].isComputed()) {
-                    modified++;
-                    pv.setMateInN(n); table.store(idx2, pv);
+        for (size_t i = 0; i < bitSize; i++)
+            newMated[i].store(0, std::memory_order_relaxed);
+        parallelFor(nThreads, nPos, [&](U32 begin, U32 end) {
+            TBPosition tbPos(pieceCount);
+            PositionValue mateN;
+            mateN.setMateInN(n);
+            int nModified = 0;
+            int nHandled = 0;
+            for (U32 idx = begin; idx < end; idx++) {
+                if (((idx & 63) == 0) && !oldMated[idx>>6].load(std::memory_order_relaxed)) {
+                    idx += 63;
+                    continue;
+                }
+                if (!table[idx].isMatedInN(n-1))
+                    continue;
+                tbPos.setIndex(idx);
+                nHandled++;
+                TbMoveList lst;
+                tbPos.getUnMoves(lst);
+                for (int m1 = 0; m1 < lst.getSize(); m1++) {
+                    if (m1 > 0 && lst[m1] == lst[m1-1])
+                        continue; // Skip duplicated moves
+                    int idx2 = lst[m1];
+                    PositionValue pv = table[idx2];
+                    while (!pv.isComputed() && !table.compareExchange(idx2, pv, mateN))
+                        pv = table[idx2];
+                    if (pv.isComputed())
+                        continue;
+                    nModified++;
+                    tbPos.setIndex(idx2);
                     TbMoveList lst2;
                     tbPos.getUnMoves(lst2);
                     for (int m2 = 0; m2 < lst2.getSize(); m2++) {
                         if (m2 > 0 && lst2[m2] == lst2[m2-1])
                             continue; // Skip duplicated moves
                         int idx3 = lst2[m2];
-                        pv = table[idx3];
-                        if (pv.isRemainingN()) {
-                            if (pv.decRemaining()) {
+                        while (true) {
+                            PositionValue oldPv = table[idx3];
+                            if (!oldPv.isRemainingN())
+                                break;
+                            pv = oldPv;
+                            bool mated = pv.decRemaining();
+                            if (mated)
                                 pv.setMatedInN(n);
-                                newMated[idx3>>6] = 1;
+                            if (table.compareExchange(idx3, oldPv, pv)) {
+                                if (mated)
+                                    newMated[idx3>>6].store(1, std::memory_order_relaxed);
+                                break;
                             }
-                            table.store(idx3, pv);
                         }
                     }
                 }
             }
-        }
+            modified += nModified;
+            handled += nHandled;
+        });
         double t3 = currentTime();
         if (verbose)
             std::cout << "n: " << std::setw(2) << n << " handled: " << std::setw(8) << handled
@@ -602,11 +675,13 @@ TBGenerator<TBStorage>::generate(RelaxedShared<S64>& maxTimeMillis, bool verbose
     }
 
     // Remaining positions are DRAW
-    for (U32 idx = 0; idx < nPos; idx++) {
-        if (table[idx].isRemainingN()) {
-            pv.setDraw(); table.store(idx, pv);
-        }
-    }
+    parallelFor(nThreads, nPos, [&](U32 begin, U32 end) {
+        PositionValue pv;
+        pv.setDraw();
+        for (U32 idx = begin; idx < end; idx++)
+            if (table[idx].isRemainingN())
+                table.store(idx, pv);
+    });
 
     return true;
 }
@@ -634,4 +709,75 @@ TBGenerator<TBStorage>::probeDTM(const Position& pos, int ply, int& score) {
 }
 
 template class TBGenerator<VectorStorage>;
+template class TBGenerator<FileStorage>;
 template class TBGenerator<TTStorage>;
+
+// --------------------------------------------------------------------------------
+
+FileStorage::FileStorage(const std::string& fileName0)
+    : fileName(fileName0) {
+}
+
+FileStorage::~FileStorage() {
+    unmap();
+}
+
+void
+FileStorage::resize(U32 size0) {
+    unmap();
+#ifdef _WIN32
+    HANDLE fh = CreateFile(fileName.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr,
+                           CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (fh == INVALID_HANDLE_VALUE)
+        throw ChessParseError("Can not create file: " + fileName);
+    HANDLE mh = CreateFileMapping(fh, nullptr, PAGE_READWRITE, 0, size0, nullptr);
+    void* data = mh ? MapViewOfFile(mh, FILE_MAP_ALL_ACCESS, 0, 0, size0) : nullptr;
+    if (!data) {
+        if (mh)
+            CloseHandle(mh);
+        CloseHandle(fh);
+        throw ChessParseError("Can not map file: " + fileName);
+    }
+    fileHandle = fh;
+    mapHandle = mh;
+#else
+    int fd = open(fileName.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+        throw ChessParseError("Can not create file: " + fileName);
+    if (ftruncate(fd, size0) != 0) {
+        close(fd);
+        throw ChessParseError("Can not resize file: " + fileName);
+    }
+    void* data = mmap(nullptr, size0, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED)
+        throw ChessParseError("Can not map file: " + fileName);
+#endif
+    table = static_cast<std::atomic<U8>*>(data);
+    size = size0;
+}
+
+void
+FileStorage::unmap() {
+    if (!table)
+        return;
+#ifdef _WIN32
+    UnmapViewOfFile(table);
+    CloseHandle((HANDLE)mapHandle);
+    CloseHandle((HANDLE)fileHandle);
+    mapHandle = fileHandle = nullptr;
+#else
+    munmap(table, size);
+#endif
+    table = nullptr;
+    size = 0;
+}
+
+// --------------------------------------------------------------------------------
+
+bool
+PackedWDLTable::save(const std::string& fileName) const {
+    std::ofstream os(fileName, std::ios::binary);
+    os.write((const char*)data.data(), data.size());
+    return (bool)os;
+}
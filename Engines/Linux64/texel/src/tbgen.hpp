@@ -29,7 +29,11 @@
 #include "util/util.hpp"
 
 #include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <memory>
+#include <string>
+#include <vector>
 
 
 class Position;
@@ -252,14 +256,74 @@ private:
 };
 
 
-/** TB storage type that stores data in a private vector. */
+/** TB storage type that stores data in a private vector.
+ * A TB storage type must provide resize(), operator[](), store() and
+ * compareExchange(). The generator calls resize() once, then uses the other
+ * methods concurrently from several threads. compareExchange() atomically
+ * replaces the value at idx with newVal if it is equal to oldVal. */
 class VectorStorage {
 public:
-    void resize(U32 size) { table.resize(size); }
-    const PositionValue operator[](U32 idx) const { return table[idx]; }
-    void store(U32 idx, PositionValue pv) { table[idx] = pv; }
+    void resize(U32 size);
+    const PositionValue operator[](U32 idx) const;
+    void store(U32 idx, PositionValue pv);
+    bool compareExchange(U32 idx, PositionValue oldVal, PositionValue newVal);
+    U64 byteSize() const { return size; }
 private:
-    std::vector<PositionValue> table;
+    std::unique_ptr<std::atomic<U8>[]> table;
+    U32 size = 0;
+};
+
+
+/** TB storage type that stores data in a memory mapped file. The operating
+ * system moves pages between RAM and disk as needed, so tables larger than the
+ * available memory can be generated. The file is kept after generation. */
+class FileStorage {
+public:
+    explicit FileStorage(const std::string& fileName);
+    ~FileStorage();
+    FileStorage(const FileStorage&) = delete;
+    FileStorage& operator=(const FileStorage&) = delete;
+
+    /** Create or truncate the file to size bytes and map it.
+     * Throws ChessParseError if the file can not be created or mapped. */
+    void resize(U32 size);
+    const PositionValue operator[](U32 idx) const;
+    void store(U32 idx, PositionValue pv);
+    bool compareExchange(U32 idx, PositionValue oldVal, PositionValue newVal);
+    U64 byteSize() const { return size; }
+private:
+    void unmap();
+
+    std::string fileName;
+    std::atomic<U8>* table = nullptr;
+    U32 size = 0;
+    void* fileHandle = nullptr; // Windows only
+    void* mapHandle = nullptr;  // Windows only
+};
+
+
+/** Win/draw/loss information for a generated tablebase, using two bits per
+ * position. The generator needs a full byte per position while working, so
+ * this is a compact representation of the final result, suitable for keeping
+ * in memory or on disk when distance to mate is not needed. */
+class PackedWDLTable {
+public:
+    enum Value { INVALID = 0, DRAW = 1, WIN = 2, LOSS = 3 };
+
+    /** Pack the first size values of a generated TB storage. */
+    template <typename TBStorage>
+    void pack(const TBStorage& table, U32 size);
+
+    /** Get value for the side to move at index idx. */
+    Value get(U32 idx) const;
+
+    U64 byteSize() const { return data.size(); }
+
+    /** Write packed data to a file. Return false on failure. */
+    bool save(const std::string& fileName) const;
+
+private:
+    std::vector<U8> data;
 };
 
 
@@ -272,8 +336,10 @@ public:
      * rooks, bishops and knights. Pawns are not supported. */
     TBGenerator(TBStorage& storage, const PieceCount& pc);
 
-    /** Generate the tablebase. */
-    bool generate(RelaxedShared<S64>& maxTimeMillis, bool verbose);
+    /** Generate the tablebase using nThreads worker threads. Each thread
+     * processes ranges of table indices, so all storage updates that can
+     * conflict are done using compareExchange(). */
+    bool generate(RelaxedShared<S64>& maxTimeMillis, bool verbose, int nThreads = 1);
 
     /** Probe tablebase.
      * @param pos  The position to probe.
@@ -404,6 +470,72 @@ PieceCount::nPieces() const {
 }
 
 
+inline void
+VectorStorage::resize(U32 size0) {
+    table.reset(new std::atomic<U8>[size0]);
+    size = size0;
+}
+
+inline const PositionValue
+VectorStorage::operator[](U32 idx) const {
+    return PositionValue(table[idx].load(std::memory_order_relaxed));
+}
+
+inline void
+VectorStorage::store(U32 idx, PositionValue pv) {
+    table[idx].store((U8)pv.getState(), std::memory_order_relaxed);
+}
+
+inline bool
+VectorStorage::compareExchange(U32 idx, PositionValue oldVal, PositionValue newVal) {
+    U8 expected = (U8)oldVal.getState();
+    return table[idx].compare_exchange_strong(expected, (U8)newVal.getState(),
+                                              std::memory_order_relaxed);
+}
+
+
+inline const PositionValue
+FileStorage::operator[](U32 idx) const {
+    return PositionValue(table[idx].load(std::memory_order_relaxed));
+}
+
+inline void
+FileStorage::store(U32 idx, PositionValue pv) {
+    table[idx].store((U8)pv.getState(), std::memory_order_relaxed);
+}
+
+inline bool
+FileStorage::compareExchange(U32 idx, PositionValue oldVal, PositionValue newVal) {
+    U8 expected = (U8)oldVal.getState();
+    return table[idx].compare_exchange_strong(expected, (U8)newVal.getState(),
+                                              std::memory_order_relaxed);
+}
+
+
+template <typename TBStorage>
+void
+PackedWDLTable::pack(const TBStorage& table, U32 size) {
+    data.assign((size + 3) / 4, 0);
+    for (U32 idx = 0; idx < size; idx++) {
+        PositionValue pv = table[idx];
+        int n;
+        Value v = INVALID;
+        if (pv.getMateInN(n))
+            v = WIN;
+        else if (pv.getMatedInN(n))
+            v = LOSS;
+        else if (pv.isDraw())
+            v = DRAW;
+        data[idx / 4] |= v << (2 * (idx % 4));
+    }
+}
+
+inline PackedWDLTable::Value
+PackedWDLTable::get(U32 idx) const {
+    return (Value)((data[idx / 4] >> (2 * (idx % 4))) & 3);
+}
+
+
 inline
 TbMoveList::TbMoveList()
     : size(0) {
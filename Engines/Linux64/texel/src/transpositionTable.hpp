@@ -48,6 +48,7 @@ public:
 
     const PositionValue operator[](U32 idx) const;
     void store(U32 idx, PositionValue pv);
+    bool compareExchange(U32 idx, PositionValue oldVal, PositionValue newVal);
 
 private:
     TranspositionTable& table;
@@ -178,6 +179,8 @@ public:
     /** Low-level methods to read/write a single byte in the table. Used by TB generator code. */
     U8 getByte(U64 idx);
     void putByte(U64 idx, U8 value);
+    /** Atomically replace byte at idx with newVal if it is equal to oldVal. */
+    bool compareExchangeByte(U64 idx, U8 oldVal, U8 newVal);
     U64 byteSize() const;
 
 private:
@@ -223,6 +226,11 @@ TTStorage::store(U32 idx, PositionValue pv) {
     table.putByte(idx0 + idx, (U8)pv.getState());
 }
 
+inline bool
+TTStorage::compareExchange(U32 idx, PositionValue oldVal, PositionValue newVal) {
+    return table.compareExchangeByte(idx0 + idx, (U8)oldVal.getState(), (U8)newVal.getState());
+}
+
 
 inline
 TranspositionTable::TTEntryStorage::TTEntryStorage() {
@@ -460,6 +468,22 @@ TranspositionTable::putByte(U64 idx, U8 value) {
     }
 }
 
+inline bool
+TranspositionTable::compareExchangeByte(U64 idx, U8 oldVal, U8 newVal) {
+    U64 ent = idx / 16;
+    int offs = idx & 0xf;
+    std::atomic<U64>& a = (offs < 8) ? table[ent].key : table[ent].data;
+    offs &= 0x07;
+    U64 data = a.load(std::memory_order_relaxed);
+    while (true) {
+        if (((data >> (offs * 8)) & 0xff) != oldVal)
+            return false;
+        U64 newData = (data & ~(0xffULL << (offs * 8))) | (((U64)newVal) << (offs * 8));
+        if (a.compare_exchange_weak(data, newData, std::memory_order_relaxed))
+            return true;
+    }
+}
+
 inline U64
 TranspositionTable::byteSize() const {
     return table.size() * 16;
@@ -34,6 +34,10 @@
 #include "constants.hpp"
 
 #include "syzygy/rtb-probe.hpp"
+#include "gtb/gtb-probe.h"
+
+#include <thread>
+#include <atomic>
 
 #include "cute.h"
 
@@ -649,6 +653,79 @@ TBTest::testMaxSubMate() {
     ASSERT_EQUAL(TBProbe::getMaxDTZ(MI::WQ), maxSub);
 }
 
+void
+TBTest::gtbConcurrentTest() {
+    struct Item {
+        int piece, sq, wk, bk;
+        bool wtm;
+        int dtm, wdl;
+    };
+    auto getPos = [](const Item& it) -> Position {
+        Position pos;
+        pos.setPiece(it.sq, it.piece);
+        pos.setPiece(it.wk, Piece::WKING);
+        pos.setPiece(it.bk, Piece::BKING);
+        pos.setWhiteMove(it.wtm);
+        return pos;
+    };
+
+    // Reference values using a cache large enough to hold all 3-men tables
+    initTB(gtbDefaultPath, gtbDefaultCacheMB, "");
+    const int ply = 0;
+    std::vector<Item> items;
+    for (int piece : { Piece::WQUEEN, Piece::WROOK, Piece::WPAWN }) {
+        int sq0 = piece == Piece::WPAWN ? A2 : 0;
+        int sq1 = piece == Piece::WPAWN ? H7 : 63;
+        for (int sq = sq0; sq <= sq1; sq += 3) {
+            for (int wk = 0; wk < 64; wk++) {
+                for (int bk = 0; bk < 64; bk++) {
+                    if (wk == sq || bk == sq || bk == wk)
+                        continue;
+                    Item it { piece, sq, wk, bk, ((sq + wk + bk) & 1) != 0, 0, 0 };
+                    Position pos = getPos(it);
+                    if (MoveGen::canTakeKing(pos))
+                        continue;
+                    ASSERT(TBProbe::gtbProbeDTM(pos, ply, it.dtm));
+                    ASSERT(TBProbe::gtbProbeWDL(pos, ply, it.wdl));
+                    items.push_back(it);
+                }
+            }
+        }
+    }
+    ASSERT(items.size() > 100000);
+
+    // Probe from several threads with a cache smaller than the tables,
+    // so that blocks are constantly evicted and reloaded.
+    initTB(gtbDefaultPath, 1, "");
+    const int nThreads = 4;
+    std::atomic<int> errors(0);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < nThreads; t++) {
+        threads.emplace_back([&items,&errors,&getPos,t,nThreads]() {
+            const size_t n = items.size();
+            for (size_t i = 0; i < n; i++) {
+                const Item& it = items[(i * 7919 + t * n / nThreads) % n];
+                Position pos = getPos(it);
+                int dtm, wdl;
+                if (!TBProbe::gtbProbeDTM(pos, ply, dtm) || dtm != it.dtm)
+                    errors++;
+                if (!TBProbe::gtbProbeWDL(pos, ply, wdl) || wdl != it.wdl)
+                    errors++;
+            }
+        });
+    }
+    for (auto& th : threads)
+        th.join();
+    ASSERT_EQUAL(0, errors.load());
+
+    TB_STATS stats;
+    tbstats_get(&stats);
+    ASSERT(stats.drive_hits[0] > 0 || stats.drive_hits[1] > 0);
+    ASSERT(stats.dtm_easy_hits[0] > 0 || stats.dtm_easy_hits[1] > 0);
+
+    initTB(gtbDefaultPath, gtbDefaultCacheMB, rtbDefaultPath);
+}
+
 cute::suite
 TBTest::getSuite() const {
     cute::suite s;
@@ -658,5 +735,6 @@ TBTest::getSuite() const {
     s.push_back(CUTE(tbTest));
     s.push_back(CUTE(testMissingTables));
     s.push_back(CUTE(testMaxSubMate));
+    s.push_back(CUTE(gtbConcurrentTest));
     return s;
 }
@@ -51,6 +51,7 @@ private:
     static void tbTest();
     static void testMissingTables();
     static void testMaxSubMate();
+    static void gtbConcurrentTest();
 };
 
 #endif /* TBTEST_HPP_ */
@@ -302,6 +302,57 @@ TBGenTest::testGenerate() {
     }
 }
 
+void
+TBGenTest::testParallelGenerate() {
+    auto test = [](const PieceCount& pc) {
+        RelaxedShared<S64> maxTimeMillis(-1);
+        TBPosition tbPos(pc);
+        const U32 nPos = tbPos.nPositions();
+
+        VectorStorage vs1;
+        TBGenerator<VectorStorage> tbGen1(vs1, pc);
+        ASSERT(tbGen1.generate(maxTimeMillis, false, 1));
+
+        VectorStorage vs4;
+        TBGenerator<VectorStorage> tbGen4(vs4, pc);
+        ASSERT(tbGen4.generate(maxTimeMillis, false, 4));
+
+        std::string fileName = "tbgentest.tmp";
+        FileStorage fs(fileName);
+        TBGenerator<FileStorage> tbGenF(fs, pc);
+        ASSERT(tbGenF.generate(maxTimeMillis, false, 3));
+
+        TranspositionTable tt(19);
+        TTStorage tts(tt);
+        TBGenerator<TTStorage> tbGenT(tts, pc);
+        ASSERT(tbGenT.generate(maxTimeMillis, false, 2));
+
+        PackedWDLTable wdl;
+        wdl.pack(vs1, nPos);
+        ASSERT_EQUAL((nPos + 3) / 4, wdl.byteSize());
+
+        for (U32 idx = 0; idx < nPos; idx++) {
+            PositionValue pv = vs1[idx];
+            ASSERT(pv.isComputed());
+            ASSERT_EQUAL((int)pv.getState(), (int)vs4[idx].getState());
+            ASSERT_EQUAL((int)pv.getState(), (int)fs[idx].getState());
+            ASSERT_EQUAL((int)pv.getState(), (int)tts[idx].getState());
+            int n;
+            if (pv.getMateInN(n))
+                ASSERT_EQUAL(PackedWDLTable::WIN, wdl.get(idx));
+            else if (pv.getMatedInN(n))
+                ASSERT_EQUAL(PackedWDLTable::LOSS, wdl.get(idx));
+            else if (pv.isDraw())
+                ASSERT_EQUAL(PackedWDLTable::DRAW, wdl.get(idx));
+            else
+                ASSERT_EQUAL(PackedWDLTable::INVALID, wdl.get(idx));
+        }
+        std::remove(fileName.c_str());
+    };
+    test(pieceCount(0,1,0,0, 0,0,0,0));
+    test(pieceCount(0,0,1,1, 0,0,0,0));
+}
+
 cute::suite
 TBGenTest::getSuite() const {
     cute::suite s;
@@ -310,5 +361,6 @@ TBGenTest::getSuite() const {
     s.push_back(CUTE(testTBPosition));
     s.push_back(CUTE(testMoveGen));
     s.push_back(CUTE(testGenerate));
+    s.push_back(CUTE(testParallelGenerate));
     return s;
 }
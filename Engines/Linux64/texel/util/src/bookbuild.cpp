@@ -30,6 +30,19 @@
 #include "search.hpp"
 #include "textio.hpp"
 
+#ifndef _WIN32
+#include <cerrno>
+#include <unistd.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/wait.h>
+#else
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#endif
+
 namespace BookBuild {
 
 void
@@ -308,8 +321,9 @@ private:
 
 void
 Book::improve(const std::string& bookFile, int searchTime, int numThreads,
-              const std::string& startMoves) {
+              int numProcesses, const std::string& startMoves) {
     readFromFile(bookFile);
+    openJournal(bookFile);
 
     Position startPos = TextIO::readFEN(TextIO::startPosFEN);
     UndoInfo ui;
@@ -324,7 +338,7 @@ Book::improve(const std::string& bookFile, int searchTime, int numThreads,
     std::atomic<bool> stopFlag(false);
     DropoutSelector selector(*this, mutex, startHash, stopFlag);
     TranspositionTable tt(27);
-    extendBook(selector, searchTime, numThreads, tt);
+    extendBook(selector, searchTime, numThreads, numProcesses, tt);
 }
 
 void
@@ -333,7 +347,7 @@ Book::interactiveExtendBook(int searchTime, int numThreads,
                             const std::atomic<U64>& startHash,
                             const std::atomic<bool>& stopFlag) {
     DropoutSelector selector(*this, mutex, startHash, stopFlag);
-    extendBook(selector, searchTime, numThreads, tt);
+    extendBook(selector, searchTime, numThreads, 0, tt);
 }
 
 void
@@ -661,12 +675,55 @@ Book::readFromFile(const std::string& filename) {
     hashToParent.clear();
     bookData.clearPending();
 
-    // Read all book entries
+    // Read all book entries, followed by changes made after the file was written
+    std::set<U64> zeroTime;
+    readNodes(filename, zeroTime);
+    journalRecords = readNodes(journalFileName(filename), zeroTime);
+    {
+        std::ifstream is(journalFileName(filename).c_str(), std::ios_base::in |
+                                                            std::ios_base::binary |
+                                                            std::ios_base::ate);
+        journalDamaged = is && ((U64)is.tellg() % sizeof(BookNode::BookSerializeData) != 0);
+    }
+    if (journalRecords > 0)
+        std::cout << "Journal records:" << journalRecords << std::endl;
+
+    // Find positions for all book entries by exploring moves from the starting position
+    Position pos = TextIO::readFEN(TextIO::startPosFEN);
+    initPositions(pos);
+    addRootNode();
+
+    // Initialize all negamax scores
+    getBookNode(startPosHash)->updateScores(bookData);
+
+    if (!backupFile.empty())
+        writeToFile(backupFile);
+
+    std::cout << "nZeroTime:" << zeroTime.size() << std::endl;
+}
+
+void
+Book::writeToFile(const std::string& filename) {
+    std::lock_guard<std::mutex> L(mutex);
+    writeNodes(filename);
+    std::remove(journalFileName(filename).c_str());
+    if (filename == journalBookFile) {
+        journalRecords = 0;
+        journalDamaged = false;
+    }
+}
+
+std::string
+Book::journalFileName(const std::string& bookFile) {
+    return bookFile + ".journal";
+}
+
+S64
+Book::readNodes(const std::string& filename, std::set<U64>& zeroTime) {
     std::ifstream is;
     is.open(filename.c_str(), std::ios_base::in |
                               std::ios_base::binary);
-
-    std::set<U64> zeroTime;
+    S64 nRead = 0;
     while (true) {
         BookNode::BookSerializeData bsd;
         is.read((char*)&bsd.data[0], sizeof(bsd.data));
@@ -682,26 +739,13 @@ Book::readFromFile(const std::string& filename) {
         if (bn->getHashKey() == startPosHash)
             bn->setRootNode();
         bookNodes[bn->getHashKey()] = bn;
+        nRead++;
     }
-    is.close();
-
-    // Find positions for all book entries by exploring moves from the starting position
-    Position pos = TextIO::readFEN(TextIO::startPosFEN);
-    initPositions(pos);
-    addRootNode();
-
-    // Initialize all negamax scores
-    getBookNode(startPosHash)->updateScores(bookData);
-
-    if (!backupFile.empty())
-        writeToFile(backupFile);
-
-    std::cout << "nZeroTime:" << zeroTime.size() << std::endl;
+    return nRead;
 }
 
 void
-Book::writeToFile(const std::string& filename) {
-    std::lock_guard<std::mutex> L(mutex);
+Book::writeNodes(const std::string& filename) {
     std::ofstream os;
     os.open(filename.c_str(), std::ios_base::out |
                               std::ios_base::binary |
@@ -716,9 +760,71 @@ Book::writeToFile(const std::string& filename) {
     }
 }
 
+void
+Book::openJournal(const std::string& bookFile) {
+    std::lock_guard<std::mutex> L(mutex);
+    journalBookFile = bookFile;
+    // A partial record can only be removed by rewriting the journal. A large
+    // journal is merged into the book file to keep restart time short.
+    if (journalDamaged || (journalRecords > (S64)bookNodes.size()))
+        checkpoint();
+}
+
+/** Flush a file, or a directory entry list, to stable storage. */
+static void
+syncFile(const std::string& fileName, bool directory) {
+#ifndef _WIN32
+    int fd = open(fileName.c_str(), O_RDONLY | (directory ? O_DIRECTORY : 0));
+    if (fd < 0 || fsync(fd) != 0) {
+        if (fd >= 0)
+            close(fd);
+        throw ChessParseError("Failed to sync " + fileName);
+    }
+    close(fd);
+#else
+    if (directory) // MoveFileEx(MOVEFILE_WRITE_THROUGH) covers the directory
+        return;
+    HANDLE h = CreateFileA(fileName.c_str(), GENERIC_WRITE, FILE_SHARE_READ, NULL,
+                           OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    bool ok = h != INVALID_HANDLE_VALUE && FlushFileBuffers(h);
+    if (h != INVALID_HANDLE_VALUE)
+        CloseHandle(h);
+    if (!ok)
+        throw ChessParseError("Failed to sync " + fileName);
+#endif
+}
+
+void
+Book::checkpoint() {
+    // Replaying the journal is idempotent, so a crash after the rename
+    // but before the journal is emptied does not lose or corrupt data.
+    // The new book must be on disk before it replaces the old one and
+    // before the journal that could rebuild it is emptied.
+    std::string tmpFile = journalBookFile + ".tmp";
+    writeNodes(tmpFile);
+    syncFile(tmpFile, false);
+#ifdef _WIN32
+    if (!MoveFileExA(tmpFile.c_str(), journalBookFile.c_str(),
+                     MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH))
+        throw ChessParseError("Failed to rename " + tmpFile + " to " + journalBookFile);
+#else
+    if (std::rename(tmpFile.c_str(), journalBookFile.c_str()) != 0)
+        throw ChessParseError("Failed to rename " + tmpFile + " to " + journalBookFile);
+    std::string::size_type slash = journalBookFile.rfind('/');
+    syncFile(slash == std::string::npos ? "." : journalBookFile.substr(0, slash + 1), true);
+#endif
+    std::ofstream os;
+    os.open(journalFileName(journalBookFile).c_str(), std::ios_base::out |
+                                                      std::ios_base::binary |
+                                                      std::ios_base::trunc);
+    os.exceptions(std::ifstream::failbit | std::ifstream::badbit);
+    journalRecords = 0;
+    journalDamaged = false;
+}
+
 void
 Book::extendBook(PositionSelector& selector, int searchTime, int numThreads,
-                 TranspositionTable& tt) {
+                 int numProcesses, TranspositionTable& tt) {
     std::shared_ptr<SearchScheduler> scheduler;
     {
         std::lock_guard<std::mutex> L(mutex);
@@ -728,11 +834,20 @@ Book::extendBook(PositionSelector& selector, int searchTime, int numThreads,
             auto sr = make_unique<SearchRunner>(i, tt);
             scheduler->addWorker(std::move(sr));
         }
+        for (int i = 0; i < numProcesses; i++) {
+#ifdef _WIN32
+            // Worker processes are not implemented on Windows, search in threads instead
+            auto pr = make_unique<SearchRunner>(numThreads + i, tt);
+#else
+            auto pr = make_unique<ProcessRunner>(numThreads + i);
+#endif
+            scheduler->addWorker(std::move(pr));
+        }
     }
     scheduler->startWorkers();
 
     int numPending = 0;
-    const int desiredQueueLen = numThreads + 1;
+    const int desiredQueueLen = numThreads + numProcesses + 1;
     int workId = 0;   // Work unit ID number
     int commitId = 0; // Next work unit to be stored in opening book
     std::set<SearchScheduler::WorkUnit> completed; // Completed but not yet committed to book
@@ -1023,16 +1138,23 @@ Book::setChildRefs(Position& pos) {
 
 void
 Book::writeBackup(const BookNode& bookNode) {
-    if (backupFile.empty())
-        return;
-    std::ofstream os;
-    os.open(backupFile.c_str(), std::ios_base::out |
-                                std::ios_base::binary |
-                                std::ios_base::app);
-    os.exceptions(std::ifstream::failbit | std::ifstream::badbit);
     BookNode::BookSerializeData bsd;
     bookNode.serialize(bsd);
-    os.write((const char*)&bsd.data[0], sizeof(bsd.data));
+    auto append = [&bsd](const std::string& filename) {
+        std::ofstream os;
+        os.open(filename.c_str(), std::ios_base::out |
+                                  std::ios_base::binary |
+                                  std::ios_base::app);
+        os.exceptions(std::ifstream::failbit | std::ifstream::badbit);
+        os.write((const char*)&bsd.data[0], sizeof(bsd.data));
+    };
+    if (!backupFile.empty())
+        append(backupFile);
+    if (!journalBookFile.empty()) {
+        append(journalFileName(journalBookFile));
+        if (++journalRecords > std::max((S64)bookNodes.size(), (S64)100000))
+            checkpoint();
+    }
 }
 
 void
@@ -1436,6 +1558,190 @@ SearchRunner::abort() {
         sc->timeLimit(0, 0);
 }
 
+ProcessRunner::ProcessRunner(int instanceNo0)
+    : instanceNo(instanceNo0), pid(-1), toChild(-1), fromChild(-1),
+      aborted(false) {
+}
+
+ProcessRunner::~ProcessRunner() {
+    stopProcess();
+}
+
+Move
+ProcessRunner::analyze(const std::vector<Move>& gameMoves,
+                       const std::vector<Move>& movesToSearch,
+                       int searchTime) {
+    std::string req = "search " + num2Str(searchTime);
+    for (const std::vector<Move>* moves : { &gameMoves, &movesToSearch }) {
+        req += ' ' + num2Str(moves->size());
+        for (const Move& m : *moves)
+            req += ' ' + TextIO::moveToUCIString(m);
+    }
+    req += '\n';
+
+    for (int attempt = 0; ; attempt++) {
+        {
+            std::lock_guard<std::mutex> L(mutex);
+            if (aborted)
+                return Move();
+            if ((pid < 0) && !startProcess())
+                throw ChessParseError("Failed to start book worker process");
+        }
+        std::string reply;
+        if (request(req, reply)) {
+            std::vector<std::string> fields;
+            splitString(reply, fields);
+            int score;
+            if ((fields.size() == 3) && str2Num(fields[2], score)) {
+                Move bestMove = TextIO::uciStringToMove(fields[1]);
+                bestMove.setScore(score);
+                return bestMove;
+            }
+        }
+        // Worker process died or sent garbage. Restart it, unless it was killed by abort().
+        std::lock_guard<std::mutex> L(mutex);
+        stopProcess();
+        if (aborted)
+            return Move();
+        if (attempt >= 2)
+            throw ChessParseError("Book worker process failed");
+    }
+}
+
+void
+ProcessRunner::abort() {
+    std::lock_guard<std::mutex> L(mutex);
+    aborted = true;
+#ifndef _WIN32
+    if (pid > 0)
+        kill(pid, SIGKILL);
+#endif
+}
+
+void
+ProcessRunner::serve(std::istream& is, std::ostream& os) {
+    TranspositionTable tt(24);
+    SearchRunner sr(0, tt);
+    std::string line;
+    while (std::getline(is, line)) {
+        std::vector<std::string> fields;
+        splitString(line, fields);
+        if (fields.size() < 2 || fields[0] != "search")
+            continue;
+        int searchTime;
+        if (!str2Num(fields[1], searchTime))
+            continue;
+        size_t idx = 2;
+        auto getMoves = [&fields,&idx](std::vector<Move>& moves) -> bool {
+            int n;
+            if (idx >= fields.size() || !str2Num(fields[idx++], n) ||
+                (n < 0) || (idx + n > fields.size()))
+                return false;
+            for (int i = 0; i < n; i++)
+                moves.push_back(TextIO::uciStringToMove(fields[idx++]));
+            return true;
+        };
+        std::vector<Move> gameMoves, movesToSearch;
+        if (!getMoves(gameMoves) || !getMoves(movesToSearch))
+            continue;
+        Move bestMove = sr.analyze(gameMoves, movesToSearch, searchTime);
+        os << "bestmove " << (bestMove.isEmpty() ? "-" : TextIO::moveToUCIString(bestMove))
+           << ' ' << bestMove.score() << std::endl;
+    }
+}
+
+bool
+ProcessRunner::startProcess() {
+#ifdef _WIN32
+    return false;
+#else
+    signal(SIGPIPE, SIG_IGN); // Detect a dead worker from write() errors instead
+    int in[2], out[2];
+    if (pipe2(in, O_CLOEXEC) != 0)
+        return false;
+    if (pipe2(out, O_CLOEXEC) != 0) {
+        close(in[0]);
+        close(in[1]);
+        return false;
+    }
+    const char* exe = "/proc/self/exe";
+    int p = fork();
+    if (p == 0) {
+        dup2(in[0], 0);
+        dup2(out[1], 1);
+        execl(exe, exe, "bookworker", (char*)nullptr);
+        _exit(1);
+    }
+    close(in[0]);
+    close(out[1]);
+    if (p < 0) {
+        close(in[1]);
+        close(out[0]);
+        return false;
+    }
+    pid = p;
+    toChild = in[1];
+    fromChild = out[0];
+    readBuf.clear();
+    return true;
+#endif
+}
+
+void
+ProcessRunner::stopProcess() {
+#ifndef _WIN32
+    if (pid < 0)
+        return;
+    close(toChild); // Worker exits when its input is closed
+    close(fromChild);
+    if (aborted)
+        kill(pid, SIGKILL);
+    int status;
+    waitpid(pid, &status, 0);
+    pid = -1;
+    toChild = -1;
+    fromChild = -1;
+#endif
+}
+
+bool
+ProcessRunner::request(const std::string& req, std::string& reply) {
+#ifdef _WIN32
+    return false;
+#else
+    const char* buf = req.c_str();
+    size_t left = req.length();
+    while (left > 0) {
+        ssize_t n = write(toChild, buf, left);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return false;
+        buf += n;
+        left -= n;
+    }
+    while (true) {
+        size_t nl = readBuf.find('\n');
+        if (nl != std::string::npos) {
+            reply = readBuf.substr(0, nl);
+            readBuf.erase(0, nl + 1);
+            if (startsWith(reply, "bestmove "))
+                return true;
+            continue; // Ignore other output from the worker
+        }
+        char tmp[4096];
+        ssize_t n = read(fromChild, tmp, sizeof(tmp));
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return false;
+        readBuf.append(tmp, n);
+    }
+#endif
+}
+
+// ----------------------------------------------------------------------------
+
 SearchScheduler::SearchScheduler()
     : stopped(false) {
 }
@@ -1446,14 +1752,14 @@ SearchScheduler::~SearchScheduler() {
 }
 
 void
-SearchScheduler::addWorker(std::unique_ptr<SearchRunner> sr) {
+SearchScheduler::addWorker(std::unique_ptr<SearchWorker> sr) {
     workers.push_back(std::move(sr));
 }
 
 void
 SearchScheduler::startWorkers() {
     for (auto& w : workers) {
-        SearchRunner& sr = *w;
+        SearchWorker& sr = *w;
         auto thread = make_unique<std::thread>([this,&sr]() {
             workerLoop(sr);
         });
@@ -1547,7 +1853,7 @@ SearchScheduler::reportResult(const WorkUnit& wu) const {
 }
 
 void
-SearchScheduler::workerLoop(SearchRunner& sr) {
+SearchScheduler::workerLoop(SearchWorker& sr) {
     while (true) {
         WorkUnit wu;
         QueueItem item;
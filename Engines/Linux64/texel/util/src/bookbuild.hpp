@@ -277,10 +277,13 @@ public:
 
     /** Improve the opening book. If startMoves is a non-empty string, only improve the part
      * of the book rooted at the position obtained after playing those moves.
+     * Searches run in numThreads threads in this process and in numProcesses
+     * single threaded worker processes. All book changes are appended to the
+     * journal for bookFile, so the work is not lost if the program is stopped.
      * This function does not return until no more book moves can be added, which in
      * practice never happens unless startMoves leads to a position not in the book. */
     void improve(const std::string& bookFile, int searchTime, int numThreads,
-                 const std::string& startMoves);
+                 int numProcesses, const std::string& startMoves);
 
     /** Improve the opening book. It is possible to dynamically change which
      * subtree of the book to improve. */
@@ -309,12 +312,17 @@ public:
     void statistics(const std::string& bookFile);
 
 
-    /** Read opening book from file. */
+    /** Read opening book from file. Book changes stored in the journal
+     *  for the file are also read. */
     void readFromFile(const std::string& filename);
 
-    /** Write opening book to file. */
+    /** Write opening book to file. Removes the journal for the file,
+     *  since the file now contains all book changes. */
     void writeToFile(const std::string& filename);
 
+    /** Name of the journal file for a book file. */
+    static std::string journalFileName(const std::string& bookFile);
+
 
     /** Given a hash key, retrieve the corresponding book position,
      * the best moves leading to the position, and the best continuation
@@ -375,7 +383,7 @@ private:
 
     /** Extend book using positions provided by the selector. */
     void extendBook(PositionSelector& selector, int searchTime, int numThreads,
-                    TranspositionTable& tt);
+                    int numProcesses, TranspositionTable& tt);
 
     /** Get the list of legal moves to include in the search. */
     std::vector<Move> getMovesToSearch(Position& pos);
@@ -409,9 +417,24 @@ private:
     /** Find all children of pos in book and update parent/child pointers. */
     void setChildRefs(Position& pos);
 
-    /** Write a book node to the backup file. */
+    /** Write a book node to the backup file and to the journal. */
     void writeBackup(const BookNode& bookNode);
 
+    /** Read book node records from a file and add them to bookNodes.
+     *  Records for already present nodes replace the old node.
+     *  Return the number of records read. */
+    S64 readNodes(const std::string& filename, std::set<U64>& zeroTime);
+
+    /** Write all book nodes to a file. Caller must hold mutex. */
+    void writeNodes(const std::string& filename);
+
+    /** Start appending book changes to the journal for bookFile. */
+    void openJournal(const std::string& bookFile);
+
+    /** Replace the journal book file with the current book contents and
+     *  empty the journal. Caller must hold mutex. */
+    void checkpoint();
+
     struct BookWeight {
         BookWeight(double wW = 0.0, double wB = 0.0) : weightWhite(wW), weightBlack(wB) {}
         BookWeight& operator+=(const BookWeight& bw) {
@@ -455,6 +478,13 @@ private:
      * The backup file is a valid book file at all times. */
     std::string backupFile;
 
+    /** If not empty, incremental improvements are also appended to the
+     * journal for this book file. The book file followed by the journal
+     * records is a valid book file at all times. */
+    std::string journalBookFile;
+    S64 journalRecords = 0;     // Number of records in the journal
+    bool journalDamaged = false; // True if journal ends with a partial record
+
     /** All positions in the opening book. */
     std::unordered_map<U64, std::shared_ptr<BookNode>> bookNodes;
 
@@ -483,8 +513,24 @@ private:
     std::unique_ptr<Listener> listener;
 };
 
+/** Interface for objects that analyze positions for the SearchScheduler. */
+class SearchWorker {
+public:
+    virtual ~SearchWorker() {}
+
+    /** Analyze position and return the best move and score. */
+    virtual Move analyze(const std::vector<Move>& gameMoves,
+                         const std::vector<Move>& movesToSearch,
+                         int searchTime) = 0;
+
+    /** Stop search as soon as possible. */
+    virtual void abort() = 0;
+
+    virtual int instNo() const = 0;
+};
+
 /** Calls Search::iterativeDeepening() to analyze a position. */
-class SearchRunner {
+class SearchRunner : public SearchWorker {
 public:
     /** Constructor. */
     SearchRunner(int instanceNo, TranspositionTable& tt);
@@ -492,15 +538,13 @@ public:
     SearchRunner(const SearchRunner& other) = delete;
     SearchRunner& operator=(const SearchRunner& other) = delete;
 
-    /** Analyze position and return the best move and score. */
     Move analyze(const std::vector<Move>& gameMoves,
                  const std::vector<Move>& movesToSearch,
-                 int searchTime);
+                 int searchTime) override;
 
-    /** Stop search as soon as possible. */
-    void abort();
+    void abort() override;
 
-    int instNo() const { return instanceNo; }
+    int instNo() const override { return instanceNo; }
 
 private:
     int instanceNo;
@@ -516,6 +560,56 @@ private:
     bool aborted;
 };
 
+/** Analyzes positions in a separate "texelutil bookworker" process. Each worker
+ *  process runs single threaded searches with its own transposition table.
+ *  Requests and replies are text lines sent over pipes:
+ *    search searchTime nGameMoves move1 ... nMovesToSearch move1 ...
+ *    bestmove move score
+ *  where moves use UCI notation and "-" means no move. */
+class ProcessRunner : public SearchWorker {
+public:
+    /** Constructor. The process is started when the first search request is made. */
+    explicit ProcessRunner(int instanceNo);
+
+    /** Destructor. Terminates the worker process. */
+    ~ProcessRunner();
+
+    ProcessRunner(const ProcessRunner& other) = delete;
+    ProcessRunner& operator=(const ProcessRunner& other) = delete;
+
+    Move analyze(const std::vector<Move>& gameMoves,
+                 const std::vector<Move>& movesToSearch,
+                 int searchTime) override;
+
+    void abort() override;
+
+    int instNo() const override { return instanceNo; }
+
+    /** Worker process main loop. Read search requests from "is" and write
+     *  replies to "os" until end of input. */
+    static void serve(std::istream& is, std::ostream& os);
+
+private:
+    /** Start the worker process. Return false on failure. */
+    bool startProcess();
+
+    /** Close the pipes and wait for the worker process to terminate. */
+    void stopProcess();
+
+    /** Send a request and wait for the reply. Return false if the
+     *  worker process terminated. */
+    bool request(const std::string& req, std::string& reply);
+
+    int instanceNo;
+    int pid;        // Worker process ID, -1 if not running
+    int toChild;    // Pipe connected to the worker's standard input
+    int fromChild;  // Pipe connected to the worker's standard output
+    std::string readBuf;
+
+    std::mutex mutex;
+    bool aborted;
+};
+
 /** Handles work distribution to the search threads. */
 class SearchScheduler {
 public:
@@ -525,10 +619,10 @@ public:
     /** Destructor. Waits for all threads to terminate. */
     ~SearchScheduler();
 
-    /** Add a SearchRunner. */
-    void addWorker(std::unique_ptr<SearchRunner> sr);
+    /** Add a SearchWorker. */
+    void addWorker(std::unique_ptr<SearchWorker> sr);
 
-    /** Start the worker threads. Creates one thread for each SearchRunner object. */
+    /** Start the worker threads. Creates one thread for each SearchWorker object. */
     void startWorkers();
 
     /** Stop worker threads as soon as possible. */
@@ -567,7 +661,7 @@ public:
 
 private:
     /** Worker thread main loop. */
-    void workerLoop(SearchRunner& sr);
+    void workerLoop(SearchWorker& sr);
 
     /** Wait for all WorkUnits to finish and then stops all threads. */
     void waitWorkers();
@@ -575,7 +669,7 @@ private:
     bool stopped;
     mutable std::mutex mutex;
 
-    std::vector<std::unique_ptr<SearchRunner>> workers;
+    std::vector<std::unique_ptr<SearchWorker>> workers;
     std::vector<std::unique_ptr<std::thread>> threads;
 
     std::deque<WorkUnit> pending;
@@ -34,6 +34,7 @@
 
 #include <queue>
 #include <unordered_set>
+#include <fstream>
 #include <unistd.h>
 
 
@@ -1509,6 +1510,45 @@ ChessTool::qEval(std::vector<PositionInfo>& positions) {
 
 void
 ChessTool::qEval(std::vector<PositionInfo>& positions, const int beg, const int end) {
+    if (!leafCacheFile.empty() && !optimizeMoveOrdering) {
+        updateLeafCache(positions);
+        const std::vector<LeafInfo>& leafVec = leaves;
+        std::shared_ptr<Evaluate::EvalHashTables> et;
+        std::vector<int> searchPositions;
+        Position pos;
+#pragma omp parallel for default(none) shared(positions,leafVec,searchPositions) private(et,pos)
+        for (int i = beg; i < end; i++) {
+            const LeafInfo& li = leafVec[i];
+            if (!li.exact) {
+#pragma omp critical
+                searchPositions.push_back(i);
+                continue;
+            }
+            if (!et)
+                et = Evaluate::getEvalHashTables();
+            Evaluate eval(*et);
+            pos.deSerialize(li.leafData);
+            int score = eval.evalPos(pos);
+            if (!pos.isWhiteMove())
+                score = -score;
+            positions[i].qScore = score;
+        }
+        if (!searchPositions.empty()) {
+            std::vector<PositionInfo> tmp;
+            tmp.reserve(searchPositions.size());
+            for (int i : searchPositions)
+                tmp.push_back(positions[i]);
+            qEvalSearch(tmp, 0, tmp.size());
+            for (size_t j = 0; j < searchPositions.size(); j++)
+                positions[searchPositions[j]].qScore = tmp[j].qScore;
+        }
+    } else {
+        qEvalSearch(positions, beg, end);
+    }
+}
+
+void
+ChessTool::qEvalSearch(std::vector<PositionInfo>& positions, const int beg, const int end) {
     TranspositionTable tt(19);
     ParallelData pd(tt);
 
@@ -1545,6 +1585,168 @@ ChessTool::qEval(std::vector<PositionInfo>& positions, const int beg, const int
     }
 }
 
+void
+ChessTool::setLeafCache(const std::string& fileName) {
+    leafCacheFile = fileName;
+    leaves.clear();
+    leafPosData = nullptr;
+}
+
+std::vector<int>
+ChessTool::searchStructurePars() {
+    // Piece values also steer move ordering, SEE and delta pruning, but they are
+    // tuned values. A leaf found with slightly different piece values is still a
+    // quiet position reached from the root, so it is kept.
+    return { quiesceMaxSortMoves, deltaPruningMargin };
+}
+
+// Each step searches the children using the same depth and check rules as
+// Search::quiesce() and follows the first child whose score equals the parent
+// score. No such child can exist because of delta pruning, mate scores or
+// window dependent pruning.
+bool
+ChessTool::findQLeaf(Search& sc, Evaluate& eval, const Position& pos0,
+                     const std::vector<U64>& nullHist, Position::SerializeData& leafData) {
+    const int mate0 = SearchConst::MATE0;
+    Position pos(pos0);
+    bool inCheck = MoveGen::inCheck(pos);
+    sc.init(pos, nullHist, 0);
+    sc.q0Eval = UNKNOWN_SCORE;
+    int score = sc.quiesce(-mate0, mate0, 0, 0, inCheck);
+    for (int depth = 0, ply = 0; ply < 64; depth--, ply++) {
+        if (!inCheck && (eval.evalPos(pos) == score)) {
+            pos.serialize(leafData);
+            return true;
+        }
+        MoveList moves;
+        if (inCheck)
+            MoveGen::checkEvasions(pos, moves);
+        else if (depth > -1)
+            MoveGen::pseudoLegalCapturesAndChecks(pos, moves);
+        else
+            MoveGen::pseudoLegalCaptures(pos, moves);
+        MoveGen::removeIllegal(pos, moves);
+        bool found = false;
+        UndoInfo ui;
+        for (int mi = 0; mi < moves.size; mi++) {
+            Position child(pos);
+            child.makeMove(moves[mi], ui);
+            const bool childInCheck = (depth - 1 > -2) ? MoveGen::inCheck(child) : false;
+            sc.init(child, nullHist, 0);
+            int childScore = -sc.quiesce(-mate0, mate0, ply + 1, depth - 1, childInCheck);
+            if (childScore == score) {
+                pos = child;
+                score = -score;
+                inCheck = childInCheck;
+                found = true;
+                break;
+            }
+        }
+        if (!found)
+            return false;
+    }
+    return false;
+}
+
+void
+ChessTool::updateLeafCache(std::vector<PositionInfo>& positions) {
+    const int nPos = positions.size();
+    const std::vector<int> searchPars = searchStructurePars();
+
+    // Positions are not modified while a data set is being tuned, so they are
+    // only hashed when a new data set is seen.
+    if ((leafPosData != positions.data()) || (leafNPos != nPos)) {
+        U64 posHash = 0xcbf29ce484222325ULL;
+        for (const PositionInfo& pi : positions)
+            for (int k = 0; k < 5; k++)
+                posHash = (posHash ^ pi.posData.v[k]) * 0x100000001b3ULL;
+        leafPosData = positions.data();
+        leafNPos = nPos;
+        if (posHash != leafPosHash) {
+            leafPosHash = posHash;
+            leaves.clear();
+        }
+    }
+    const U64 posHash = leafPosHash;
+
+    if (((int)leaves.size() == nPos) && (leafSearchPars == searchPars))
+        return;
+
+    // Try the cache file
+    const U64 magic = 0x314641454c515854ULL; // "TXQLEAF1"
+    std::ifstream is(leafCacheFile, std::ios::binary);
+    if (is) {
+        U64 header[3];
+        U64 nPars = 0;
+        is.read((char*)header, sizeof(header));
+        is.read((char*)&nPars, sizeof(nPars));
+        std::vector<int> filePars(nPars < 64 ? nPars : 0);
+        is.read((char*)filePars.data(), filePars.size() * sizeof(int));
+        if (is && header[0] == magic && header[1] == (U64)nPos && header[2] == posHash &&
+            filePars == searchPars) {
+            leaves.resize(nPos);
+            for (LeafInfo& li : leaves) {
+                U8 exact = 0;
+                is.read((char*)li.leafData.v, sizeof(li.leafData.v));
+                is.read((char*)&exact, 1);
+                li.exact = exact != 0;
+            }
+            if (is) {
+                leafSearchPars = searchPars;
+                return;
+            }
+        }
+    }
+
+    // Compute leaves using full q-search
+    double t0 = currentTime();
+    std::cout << "Computing q-search leaves for " << nPos << " positions" << std::endl;
+    leaves.resize(nPos);
+    TranspositionTable tt(19);
+    ParallelData pd(tt);
+    std::vector<U64> nullHist(200);
+    KillerTable kt;
+    History ht;
+    std::shared_ptr<Evaluate::EvalHashTables> et;
+    TreeLogger treeLog;
+    Position pos;
+    std::vector<LeafInfo>& leafVec = leaves;
+    std::atomic<int> nExact(0);
+    const int chunkSize = 5000;
+
+#pragma omp parallel for default(none) shared(positions,leafVec,tt,pd,nExact) private(kt,ht,et,treeLog,pos) firstprivate(nullHist)
+    for (int c = 0; c < nPos; c += chunkSize) {
+        if (!et)
+            et = Evaluate::getEvalHashTables();
+        Search::SearchTables st(tt, kt, ht, *et);
+        Search sc(pos, nullHist, 0, st, pd, nullptr, treeLog);
+        Evaluate eval(*et);
+        for (int i = c; i < std::min(c + chunkSize, nPos); i++) {
+            pos.deSerialize(positions[i].posData);
+            LeafInfo& li = leafVec[i];
+            li.exact = findQLeaf(sc, eval, pos, nullHist, li.leafData);
+            if (li.exact)
+                nExact++;
+        }
+    }
+    leafSearchPars = searchPars;
+    std::cout << "Exact leaves: " << nExact << " time: " << (currentTime() - t0) << std::endl;
+
+    std::ofstream os(leafCacheFile, std::ios::binary);
+    U64 header[3] = { magic, (U64)nPos, posHash };
+    U64 nPars = searchPars.size();
+    os.write((const char*)header, sizeof(header));
+    os.write((const char*)&nPars, sizeof(nPars));
+    os.write((const char*)searchPars.data(), searchPars.size() * sizeof(int));
+    for (const LeafInfo& li : leaves) {
+        U8 exact = li.exact ? 1 : 0;
+        os.write((const char*)li.leafData.v, sizeof(li.leafData.v));
+        os.write((const char*)&exact, 1);
+    }
+    if (!os)
+        std::cerr << "Failed to write leaf cache file: " << leafCacheFile << std::endl;
+}
+
 double
 ChessTool::computeAvgError(std::vector<PositionInfo>& positions, const ScoreToProb& sp,
                            const std::vector<ParamDomain>& pdVec, arma::mat& pdVal) {
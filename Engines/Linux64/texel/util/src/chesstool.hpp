@@ -34,6 +34,7 @@
 
 class Evaluate;
 class MoveList;
+class Search;
 
 /** Convert evaluation score to win probability using logistic model. */
 class ScoreToProb {
@@ -85,6 +86,12 @@ public:
     /** Setup tablebase directory paths. */
     static void setupTB();
 
+    /** Compute q-search scores from cached q-search leaf positions. The leaf of
+     * each position is found once, using a full q-search, and stored in fileName.
+     * Later score computations only evaluate the leaf positions. The leaves are
+     * recomputed when a parameter that affects the q-search tree changes. */
+    void setLeafCache(const std::string& fileName);
+
     /** Read a file into a string vector. */
     static std::vector<std::string> readFile(const std::string& fname);
 
@@ -190,6 +197,29 @@ private:
     void qEval(std::vector<PositionInfo>& positions);
     /** Recompute all qScore values between indices beg and end. */
     void qEval(std::vector<PositionInfo>& positions, const int beg, const int end);
+    /** Recompute qScore values between indices beg and end using full q-search. */
+    void qEvalSearch(std::vector<PositionInfo>& positions, const int beg, const int end);
+
+    /** Q-search leaf for a position. If exact is false, the q-search score
+     * could not be attributed to a single leaf and a full q-search is used. */
+    struct LeafInfo {
+        Position::SerializeData leafData;
+        bool exact;
+    };
+
+    /** Make sure the leaf cache corresponds to positions and to the current
+     * values of the search structure parameters. Reads or recomputes and
+     * writes the cache file as needed. Tuning evaluation parameters, piece
+     * values included, keeps the leaves. */
+    void updateLeafCache(std::vector<PositionInfo>& positions);
+
+    /** Values of the q-search parameters the leaves are keyed on. */
+    static std::vector<int> searchStructurePars();
+
+    /** Follow the q-search tree from pos0 to the position whose static evaluation
+     * determines the q-search score. Return false if there is no such position. */
+    static bool findQLeaf(Search& sc, Evaluate& eval, const Position& pos0,
+                          const std::vector<U64>& nullHist, Position::SerializeData& leafData);
 
     /** Compute average evaluation corresponding to a set of parameter values. */
     double computeAvgError(std::vector<PositionInfo>& positions, const ScoreToProb& sp,
@@ -206,6 +236,13 @@ private:
 
     bool useEntropyErrorFunction;
     bool optimizeMoveOrdering;
+
+    std::string leafCacheFile;
+    std::vector<LeafInfo> leaves;
+    U64 leafPosHash = 0;             // Hash of positions the leaves belong to
+    const PositionInfo* leafPosData = nullptr; // Data set leafPosHash was computed for,
+    int leafNPos = 0;                          // compared to avoid hashing it again
+    std::vector<int> leafSearchPars; // Search structure parameters used for leaves
 };
 
 
@@ -38,7 +38,8 @@ PgnToken::PgnToken(int type0, const std::string& token0)
 
 PgnScanner::PgnScanner(std::istream& is0)
     : is(is0), col0(true), eofReached(false),
-      hasReturnedChar(false), returnedChar(0) {
+      hasReturnedChar(false), returnedChar(0),
+      buf(65536), bufPos(0), bufLen(0) {
 }
 
 void
@@ -46,13 +47,21 @@ PgnScanner::putBack(const PgnToken& tok) {
     savedTokens.push_back(tok);
 }
 
+bool
+PgnScanner::fillBuffer() {
+    if (!is)
+        return false;
+    is.read(&buf[0], buf.size());
+    bufPos = 0;
+    bufLen = is.gcount();
+    return bufLen > 0;
+}
+
 char
 PgnScanner::getNextChar() {
-    int c;
-    c = is.get();
-    if (eofReached || (c == EOF))
+    if (eofReached || ((bufPos >= bufLen) && !fillBuffer()))
         throw std::out_of_range("");
-    return c;
+    return buf[bufPos++];
 }
 
 char
@@ -91,6 +100,18 @@ PgnScanner::returnTokenChar(char c) {
     returnedChar = c;
 }
 
+/** Return true if c ends a SYMBOL token. */
+static inline bool
+isSymbolTerminator(char c) {
+    switch (c) {
+    case '.': case '*': case '[': case ']': case '(': case ')':
+    case '{': case ';': case '"': case '$':
+        return true;
+    default:
+        return false;
+    }
+}
+
 PgnToken
 PgnScanner::nextToken() {
     if (savedTokens.size() > 0) {
@@ -126,25 +147,20 @@ PgnScanner::nextToken() {
                 break;
             } else if (c == '{') {
                 ret.type = PgnToken::COMMENT;
-                std::string sb;
                 while ((c = getTokenChar()) != '}')
-                    sb += c;
-                ret.token = sb;
+                    ret.token += c;
                 break;
             } else if (c == ';') {
                 ret.type = PgnToken::COMMENT;
-                std::string sb;
                 while (true) {
                     c = getTokenChar();
                     if ((c == '\n') || (c == '\r'))
                         break;
-                    sb += c;
+                    ret.token += c;
                 }
-                ret.token = sb;
                 break;
             } else if (c == '"') {
                 ret.type = PgnToken::STRING;
-                std::string sb;
                 while (true) {
                     c = getTokenChar();
                     if (c == '"') {
@@ -152,47 +168,42 @@ PgnScanner::nextToken() {
                     } else if (c == '\\') {
                         c = getTokenChar();
                     }
-                    sb += c;
+                    ret.token += c;
                 }
-                ret.token = sb;
                 break;
             } else if (c == '$') {
                 ret.type = PgnToken::NAG;
-                std::string sb;
                 while (true) {
                     c = getTokenChar();
                     if (!isdigit(c)) {
                         returnTokenChar(c);
                         break;
                     }
-                    sb += c;
+                    ret.token += c;
                 }
-                ret.token = sb;
                 break;
             } else { // Start of symbol or integer
                 ret.type = PgnToken::SYMBOL;
-                std::string sb;
-                sb += c;
+                ret.token += c;
                 bool onlyDigits = isdigit(c);
-                const std::string term = ".*[](){;\"$";
                 while (true) {
                     c = getTokenChar();
-                    if (isspace(c) || (term.find_first_of(c) != std::string::npos)) {
+                    if (isspace(c) || isSymbolTerminator(c)) {
                         returnTokenChar(c);
                         break;
                     }
-                    sb += c;
+                    ret.token += c;
                     if (!isdigit(c))
                         onlyDigits = false;
                 }
                 if (onlyDigits)
                     ret.type = PgnToken::INTEGER;
-                ret.token = sb;
                 break;
             }
         }
     } catch (const std::out_of_range& e) {
         ret.type = PgnToken::END;
+        ret.token.clear();
     }
     return ret;
 }
@@ -208,34 +219,92 @@ PgnScanner::nextTokenDropComments() {
 
 // --------------------------------------------------------------------------------
 
-Node::Node(const std::shared_ptr<Node>& parent0, const Move& m, const UndoInfo& ui0, int nag0,
-           const std::string& preComment0, const std::string& postComment0)
-    : move(m), ui(ui0), nag(nag0), preComment(preComment0),
-      postComment(postComment0), parent(parent0) {
+std::shared_ptr<Node>
+Node::getParent() const {
+    if (parent < 0)
+        return nullptr;
+    return std::shared_ptr<Node>(arena->shared_from_this(), &(*arena)[parent]);
+}
+
+std::vector<std::shared_ptr<Node>>
+Node::getChildren() const {
+    std::vector<std::shared_ptr<Node>> ret;
+    ret.reserve(nChild);
+    std::shared_ptr<NodeArena> a = arena->shared_from_this();
+    for (int c = firstChild; c >= 0; c = (*arena)[c].nextSibling)
+        ret.push_back(std::shared_ptr<Node>(a, &(*arena)[c]));
+    return ret;
+}
+
+int
+NodeArena::newNode() {
+    if (nNodes >= (int)chunks.size() * chunkSize)
+        chunks.push_back(std::unique_ptr<Node[]>(new Node[chunkSize]));
+    Node& n = (*this)[nNodes];
+    n.move = Move();
+    n.nag = 0;
+    n.preComment.clear();
+    n.postComment.clear();
+    n.arena = this;
+    n.index = nNodes;
+    n.parent = -1;
+    n.firstChild = -1;
+    n.lastChild = -1;
+    n.nextSibling = -1;
+    n.nChild = 0;
+    return nNodes++;
 }
 
 void
-Node::insertMove(Position& pos, std::shared_ptr<Node>& node, const Move& move) {
-    std::shared_ptr<Node> child(std::make_shared<Node>());
-    child->parent = node;
-    node->children.push_back(child);
-    child->move = move;
-    pos.makeMove(move, child->ui);
-    pos.unMakeMove(move, child->ui);
+NodeArena::appendChild(int parent, int child) {
+    Node& p = (*this)[parent];
+    Node& c = (*this)[child];
+    c.parent = parent;
+    if (p.lastChild >= 0)
+        (*this)[p.lastChild].nextSibling = child;
+    else
+        p.firstChild = child;
+    p.lastChild = child;
+    p.nChild++;
 }
 
 void
-Node::addChild(Position& pos, std::shared_ptr<Node>& node, std::shared_ptr<Node>& child) {
-    child->parent = node;
-    node->children.push_back(child);
-    node = child;
-    child = std::make_shared<Node>();
-    pos.makeMove(node->getMove(), node->ui);
+NodeArena::clear() {
+    nNodes = 0;
+}
+
+// --------------------------------------------------------------------------------
+
+void
+Node::insertMove(Position& pos, NodeArena& arena, int node, const Move& move) {
+    int c = arena.newNode();
+    arena.appendChild(node, c);
+    Node& child = arena[c];
+    child.move = move;
+    pos.makeMove(move, child.ui);
+    pos.unMakeMove(move, child.ui);
+}
+
+void
+Node::addChild(Position& pos, NodeArena& arena, int& node, Node& nodeToAdd) {
+    int c = arena.newNode();
+    arena.appendChild(node, c);
+    Node& child = arena[c];
+    child.move = nodeToAdd.move;
+    child.nag = nodeToAdd.nag;
+    child.preComment.swap(nodeToAdd.preComment);
+    child.postComment.swap(nodeToAdd.postComment);
+    nodeToAdd.move = Move();
+    nodeToAdd.nag = 0;
+    nodeToAdd.preComment.clear();
+    nodeToAdd.postComment.clear();
+    node = c;
+    pos.makeMove(child.move, child.ui);
 }
 
 void
-Node::parsePgn(PgnScanner& scanner, Position pos, std::shared_ptr<Node> node) {
-    std::shared_ptr<Node> nodeToAdd(std::make_shared<Node>());
+Node::parsePgn(PgnScanner& scanner, Position pos, NodeArena& arena, int node) {
+    Node nodeToAdd;
     bool moveAdded = false;
     while (true) {
         PgnToken tok = scanner.nextToken();
@@ -245,13 +314,14 @@ Node::parsePgn(PgnScanner& scanner, Position pos, std::shared_ptr<Node> node) {
             break;
         case PgnToken::LEFT_PAREN:
             if (moveAdded) {
-                addChild(pos, node, nodeToAdd);
+                addChild(pos, arena, node, nodeToAdd);
                 moveAdded = false;
             }
-            if (node->getParent()) {
+            if (arena[node].parent >= 0) {
+                const Node& n = arena[node];
                 Position pos2(pos);
-                pos2.unMakeMove(node->getMove(), node->getUndoInfo());
-                parsePgn(scanner, pos2, node->getParent());
+                pos2.unMakeMove(n.move, n.ui);
+                parsePgn(scanner, pos2, arena, n.parent);
             } else {
                 int nestLevel = 1;
                 while (nestLevel > 0) {
@@ -265,15 +335,15 @@ Node::parsePgn(PgnScanner& scanner, Position pos, std::shared_ptr<Node> node) {
             break;
         case PgnToken::NAG:
             if (moveAdded) { // NAG must be after move
-                if (!str2Num(tok.token, nodeToAdd->nag))
-                    nodeToAdd->nag = 0;
+                if (!str2Num(tok.token, nodeToAdd.nag))
+                    nodeToAdd.nag = 0;
             }
             break;
         case PgnToken::SYMBOL: {
             if ((tok.token =="1-0") || (tok.token == "0-1") ||
                 (tok.token == "1/2-1/2") || (tok.token == "*")) {
                 if (moveAdded)
-                    addChild(pos, node, nodeToAdd);
+                    addChild(pos, arena, node, nodeToAdd);
                 return;
             }
             char lastChar = tok.token[tok.token.length() - 1];
@@ -302,11 +372,11 @@ Node::parsePgn(PgnScanner& scanner, Position pos, std::shared_ptr<Node> node) {
             }
             if (tok.token.length() > 0) {
                 if (moveAdded) {
-                    addChild(pos, node, nodeToAdd);
+                    addChild(pos, arena, node, nodeToAdd);
                     moveAdded = false;
                 }
-                nodeToAdd->move = TextIO::stringToMove(pos, tok.token);
-                if (nodeToAdd->move.isEmpty()) {
+                nodeToAdd.move = TextIO::stringToMove(pos, tok.token);
+                if (nodeToAdd.move.isEmpty()) {
                     std::cerr << TextIO::asciiBoard(pos) << " wtm:" << (pos.isWhiteMove()?1:0) << " move:" << tok.token << std::endl;
                     throw ChessParseError("Invalid move");
                 }
@@ -316,9 +386,9 @@ Node::parsePgn(PgnScanner& scanner, Position pos, std::shared_ptr<Node> node) {
         }
         case PgnToken::COMMENT:
             if (moveAdded)
-                nodeToAdd->postComment += tok.token;
+                nodeToAdd.postComment += tok.token;
             else
-                nodeToAdd->preComment += tok.token;
+                nodeToAdd.preComment += tok.token;
             break;
         case PgnToken::ASTERISK:
         case PgnToken::LEFT_BRACKET:
@@ -327,7 +397,7 @@ Node::parsePgn(PgnScanner& scanner, Position pos, std::shared_ptr<Node> node) {
         case PgnToken::RIGHT_PAREN:
         case PgnToken::END:
             if (moveAdded)
-                addChild(pos, node, nodeToAdd);
+                addChild(pos, arena, node, nodeToAdd);
             return;
         }
     }
@@ -335,13 +405,8 @@ Node::parsePgn(PgnScanner& scanner, Position pos, std::shared_ptr<Node> node) {
 
 // --------------------------------------------------------------------------------
 
-GameNode::GameNode(const Position& pos, const std::shared_ptr<Node>& root)
-    : rootNode(root), currPos(pos), currNode(root) {
-}
-
-GameNode::GameNode(const Position& pos, const std::shared_ptr<Node>& root,
-                   const std::shared_ptr<Node>& node)
-    : rootNode(root), currPos(pos), currNode(node) {
+GameNode::GameNode(const Position& pos, const std::shared_ptr<NodeArena>& arena0, int node)
+    : arena(arena0), currPos(pos), currNode(node) {
 }
 
 const Position&
@@ -349,20 +414,21 @@ GameNode::getPos() const {
     return currPos;
 }
 
-const std::shared_ptr<Node>&
+std::shared_ptr<Node>
 GameNode::getNode() const {
-    return currNode;
+    return std::shared_ptr<Node>(arena, &(*arena)[currNode]);
 }
 
 const Move&
 GameNode::getMove() const {
-    return currNode->getMove();
+    return (*arena)[currNode].getMove();
 }
 
 std::string
 GameNode::getComment() const {
-    std::string pre = currNode->getPreComment();
-    std::string post = currNode->getPostComment();
+    const Node& node = (*arena)[currNode];
+    std::string pre = node.getPreComment();
+    const std::string& post = node.getPostComment();
     if ((pre.length() > 0) && (post.length() > 0))
         pre += " ";
     return pre + post;
@@ -370,30 +436,32 @@ GameNode::getComment() const {
 
 bool
 GameNode::goBack() {
-    std::shared_ptr<Node> parent = currNode->getParent();
-    if (!parent)
+    const Node& node = (*arena)[currNode];
+    if (node.getParentIndex() < 0)
         return false;
-    currPos.unMakeMove(currNode->getMove(), currNode->getUndoInfo());
-    currNode = parent;
+    currPos.unMakeMove(node.getMove(), node.getUndoInfo());
+    currNode = node.getParentIndex();
     return true;
 }
 
 int
 GameNode::nChildren() const {
-    return currNode->getChildren().size();
+    return (*arena)[currNode].nChildren();
 }
 
 void
 GameNode::goForward(int i) {
-    std::shared_ptr<Node> next = currNode->getChildren()[i];
+    int next = (*arena)[currNode].getFirstChildIndex();
+    for ( ; i > 0; i--)
+        next = (*arena)[next].getNextSiblingIndex();
     UndoInfo ui;
-    currPos.makeMove(next->getMove(), ui);
+    currPos.makeMove((*arena)[next].getMove(), ui);
     currNode = next;
 }
 
 void
 GameNode::insertMove(const Move& move) {
-    Node::insertMove(currPos, currNode, move);
+    Node::insertMove(currPos, *arena, currNode, move);
 }
 
 // --------------------------------------------------------------------------------
@@ -413,7 +481,11 @@ GameTree::setStartPos(const Position& pos) {
     result = "?";
     startPos = pos;
     tagPairs.clear();
-    rootNode = std::make_shared<Node>();
+    if (arena && arena.use_count() == 1)
+        arena->clear(); // Reuse node memory when no GameNode refers to the old tree
+    else
+        arena = std::make_shared<NodeArena>();
+    rootNode = arena->newNode();
 }
 
 void
@@ -445,11 +517,6 @@ GameTree::setTagPairs(const std::vector<GameTree::TagPair>& tPairs) {
     }
 }
 
-void
-GameTree::setRootNode(const std::shared_ptr<Node>& gameRoot) {
-    rootNode = gameRoot;
-}
-
 void
 GameTree::insertMoves(const std::vector<Move>& moves) {
     GameNode dstNode = getRootNode();
@@ -526,19 +593,20 @@ GameTree::getHeaders(std::map<std::string, std::string>& headers) {
 
 GameNode
 GameTree::getRootNode() const {
-    return GameNode(startPos, rootNode);
+    return GameNode(startPos, arena, rootNode);
 }
 
 GameNode
 GameTree::getNode(const std::shared_ptr<Node>& node) {
     std::vector<Move> moves;
-    std::shared_ptr<Node> n = node;
+    int n = node->getIndex();
     while (true) {
-        Move m = n->getMove();
+        const Node& nd = (*arena)[n];
+        const Move& m = nd.getMove();
         if (m.isEmpty())
             break;
         moves.push_back(m);
-        n = n->getParent();
+        n = nd.getParentIndex();
     }
     std::reverse(moves.begin(), moves.end());
 
@@ -547,7 +615,7 @@ GameTree::getNode(const std::shared_ptr<Node>& node) {
     for (const Move& m : moves)
         pos.makeMove(m, ui);
 
-    return GameNode(pos, rootNode, node);
+    return GameNode(pos, arena, node->getIndex());
 }
 
 void
@@ -638,14 +706,12 @@ PgnReader::readPGN(GameTree& tree) {
     tree.setStartPos(startPos);
 
     // Parse move section
-    std::shared_ptr<Node> gameRoot(std::make_shared<Node>());
-    Node::parsePgn(scanner, startPos, gameRoot);
+    Node::parsePgn(scanner, startPos, *tree.arena, tree.rootNode);
 
-    if ((tPairs.size() == 0) && (gameRoot->getChildren().size() == 0))
+    if ((tPairs.size() == 0) && ((*tree.arena)[tree.rootNode].nChildren() == 0))
         return false;
 
     tree.setTagPairs(tPairs);
-    tree.setRootNode(gameRoot);
 
     return true;
 }
@@ -62,6 +62,8 @@ public:
 };
 
 
+/** Tokenizer for PGN data. Input is read from the stream in large blocks,
+ *  so the stream position is undefined after the scanner has been used. */
 class PgnScanner {
 public:
     PgnScanner(std::istream& is);
@@ -77,65 +79,123 @@ public:
     void returnTokenChar(char c);
 
 private:
+    /** Read next block of data from the stream. Return false at end of file. */
+    bool fillBuffer();
+
     std::istream& is;
     bool col0;
     bool eofReached;
     bool hasReturnedChar;
     char returnedChar;
     std::vector<PgnToken> savedTokens;
+
+    std::vector<char> buf;      // Buffered stream data
+    int bufPos;                 // Next character to return from buf
+    int bufLen;                 // Number of valid characters in buf
 };
 
 
+class NodeArena;
+
 /**
  *  A node object represents a position in the game tree.
  *  The position is defined by the move that leads to the position from the parent position.
  *  The root node is special in that it doesn't have a move.
+ *  Nodes are owned by a NodeArena and refer to each other using arena indices.
  */
 class Node {
 public:
-    Node() : nag(0) { }
-    Node(const std::shared_ptr<Node>& parent, const Move& m, const UndoInfo& ui, int nag,
-         const std::string& preComment, const std::string& postComment);
-
-    std::shared_ptr<Node> getParent() const { return parent.lock(); }
-    const std::vector<std::shared_ptr<Node>>& getChildren() const { return children; }
+    Node() = default;
+
+    /** Parent node, null if root node. The returned pointer keeps the node arena alive. */
+    std::shared_ptr<Node> getParent() const;
+    /** Child nodes. The returned pointers keep the node arena alive. */
+    std::vector<std::shared_ptr<Node>> getChildren() const;
+
+    int getIndex() const { return index; }
+    int getParentIndex() const { return parent; }
+    int getFirstChildIndex() const { return firstChild; }
+    int getNextSiblingIndex() const { return nextSibling; }
+    int nChildren() const { return nChild; }
     const Move& getMove() const { return move; }
     const UndoInfo& getUndoInfo() const { return ui; }
     const std::string& getPreComment() const { return preComment; }
     const std::string& getPostComment() const { return postComment; }
 
     /** Add a child node given by move. */
-    static void insertMove(Position& pos, std::shared_ptr<Node>& node, const Move& move);
+    static void insertMove(Position& pos, NodeArena& arena, int node, const Move& move);
 
-    static void parsePgn(PgnScanner& scanner, Position pos, std::shared_ptr<Node> node);
+    static void parsePgn(PgnScanner& scanner, Position pos, NodeArena& arena, int node);
 
 private:
-    static void addChild(Position& pos, std::shared_ptr<Node>& node,
-                         std::shared_ptr<Node>& child);
+    friend class NodeArena;
+
+    /** Move data from nodeToAdd to a new child of node, make the move and
+     *  set node to the new child. */
+    static void addChild(Position& pos, NodeArena& arena, int& node, Node& nodeToAdd);
 
     Move move;                  // Move leading to this node. Empty in root node.
     UndoInfo ui;                // UndoInfo needed to get to parent position.
-    int nag;                    // Numeric annotation glyph
+    int nag = 0;                // Numeric annotation glyph
     std::string preComment;     // Comment before move
     std::string postComment;    // Comment after move
 
-    std::weak_ptr<Node> parent; // Null if root node
-    std::vector<std::shared_ptr<Node>> children;
+    NodeArena* arena = nullptr; // Arena owning this node
+    int index = -1;             // Index of this node in the arena
+    int parent = -1;            // -1 if root node
+    int firstChild = -1;
+    int lastChild = -1;
+    int nextSibling = -1;
+    int nChild = 0;
+};
+
+
+/** Storage for the nodes in a game tree. Nodes are allocated in fixed size
+ *  chunks, so node addresses do not change when the arena grows. Clearing
+ *  the arena keeps the chunks, so that reading many games into the same
+ *  GameTree does not allocate memory for each node. An arena is always
+ *  owned by a shared_ptr. */
+class NodeArena : public std::enable_shared_from_this<NodeArena> {
+public:
+    NodeArena() = default;
+    NodeArena(const NodeArena&) = delete;
+    NodeArena& operator=(const NodeArena&) = delete;
+
+    /** Allocate a node without parent and children. Return its index. */
+    int newNode();
+
+    /** Make child the last child of parent. */
+    void appendChild(int parent, int child);
+
+    /** Remove all nodes. Invalidates all node indices. */
+    void clear();
+
+    /** Number of allocated nodes. */
+    int size() const { return nNodes; }
+
+    Node& operator[](int idx);
+    const Node& operator[](int idx) const;
+
+private:
+    static const int chunkBits = 10;
+    static const int chunkSize = 1 << chunkBits;
+
+    std::vector<std::unique_ptr<Node[]>> chunks;
+    int nNodes = 0;
 };
 
 
 /** A GameNode acts as a tree iterator. */
 class GameNode {
 public:
-    GameNode(const Position& pos, const std::shared_ptr<Node>& root);
-    GameNode(const Position& pos, const std::shared_ptr<Node>& root,
-             const std::shared_ptr<Node>& node);
+    GameNode(const Position& pos, const std::shared_ptr<NodeArena>& arena, int node);
 
     /** Get current position. */
     const Position& getPos() const;
 
-    /** Get the Node corresponding to the current position. */
-    const std::shared_ptr<Node>& getNode() const;
+    /** Get the Node corresponding to the current position. The returned
+     *  pointer keeps the node arena alive. */
+    std::shared_ptr<Node> getNode() const;
 
     /** Get the move leading to this position. */
     const Move& getMove() const;
@@ -160,9 +220,9 @@ public:
     void insertMove(const Move& move);
 
 private:
-    std::shared_ptr<Node> rootNode; // To prevent tree from being deleted too early
+    std::shared_ptr<NodeArena> arena; // To prevent tree from being deleted too early
     Position currPos;
-    std::shared_ptr<Node> currNode;
+    int currNode;
 };
 
 
@@ -189,9 +249,6 @@ public:
     /** Set PGN tag pairs. */
     void setTagPairs(const std::vector<TagPair>& tPairs);
 
-    /** Set the tree root node. */
-    void setRootNode(const std::shared_ptr<Node>& gameRoot);
-
     /** Insert a sequence of moves in this tree. Moves already present
      *  in the three are not duplicated. The first move must correspond
      *  to the start position of this tree. */
@@ -239,8 +296,11 @@ private:
     // Non-standard tags
     std::vector<TagPair> tagPairs;
 
+    friend class PgnReader;
+
     Position startPos;
-    std::shared_ptr<Node> rootNode;
+    std::shared_ptr<NodeArena> arena;
+    int rootNode;
 };
 
 
@@ -255,4 +315,15 @@ private:
     PgnScanner scanner;
 };
 
+
+inline Node&
+NodeArena::operator[](int idx) {
+    return chunks[idx >> chunkBits][idx & (chunkSize - 1)];
+}
+
+inline const Node&
+NodeArena::operator[](int idx) const {
+    return chunks[idx >> chunkBits][idx & (chunkSize - 1)];
+}
+
 #endif /* GAMETREE_HPP_ */
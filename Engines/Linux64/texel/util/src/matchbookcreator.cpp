@@ -389,6 +389,35 @@ MatchBookCreator::pgnStat(const std::string& pgnFile, bool pairMode, std::ostrea
     }
 }
 
+void
+MatchBookCreator::pgnBench(const std::string& pgnFile, std::ostream& os) {
+    std::ifstream is(pgnFile);
+    PgnReader reader(is);
+    GameTree gt;
+    int nGames = 0;
+    S64 nMoves = 0;
+    double t0 = currentTime();
+    try {
+        while (reader.readPGN(gt)) {
+            nGames++;
+            GameNode gn = gt.getRootNode();
+            while (gn.nChildren() > 0) {
+                gn.goForward(0);
+                nMoves++;
+            }
+        }
+    } catch (...) {
+        std::cerr << "Error parsing game " << nGames << std::endl;
+        throw;
+    }
+    double t = currentTime() - t0;
+
+    std::stringstream ss;
+    ss.precision(3);
+    ss << std::fixed << "time: " << t << " games/s: " << (t > 0 ? nGames / t : 0.0);
+    os << "nGames: " << nGames << " nMoves: " << nMoves << ' ' << ss.str() << std::endl;
+}
+
 bool
 MatchBookCreator::getCommentDepth(const std::string& comment, int& depth) {
     if (startsWith(comment, "+M") || startsWith(comment, "-M"))
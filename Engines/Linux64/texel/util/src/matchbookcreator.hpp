@@ -54,6 +54,9 @@ public:
     /** Print statistics about all games in pgnFile. */
     void pgnStat(const std::string& pgnFile, bool pairMode, std::ostream& os);
 
+    /** Measure how fast games in pgnFile can be parsed and traversed. */
+    void pgnBench(const std::string& pgnFile, std::ostream& os);
+
 private:
     struct BookLine {
         BookLine() = default;
@@ -594,7 +594,7 @@ BookBuildTest::testSelector() {
         TestSelector selector(book);
         int searchTime = 10;
         int nThreads = 1;
-        book.extendBook(selector, searchTime, nThreads, tt);
+        book.extendBook(selector, searchTime, nThreads, 0, tt);
         ASSERT_EQUAL(1, selector.nCalls);
         ASSERT_EQUAL(1, book.bookNodes.size());
 
@@ -631,12 +631,99 @@ BookBuildTest::testSelector() {
         TestSelector selector(book);
         int searchTime = 10;
         int nThreads = 1;
-        book.extendBook(selector, searchTime, nThreads, tt);
+        book.extendBook(selector, searchTime, nThreads, 0, tt);
         ASSERT(selector.nCalls >= 9);
         ASSERT_EQUAL(9, book.bookNodes.size());
     }
 }
 
+void
+BookBuildTest::testJournal() {
+    TranspositionTable tt(27);
+    auto system = [](const std::string& cmd) { ::system(cmd.c_str()); };
+    std::string tmpDir = "/tmp/booktest";
+    system("mkdir -p " + tmpDir);
+    system("rm " + tmpDir + "/* 2>/dev/null");
+    std::string bookFile = tmpDir + "/book.tbin";
+    std::string journalFile = Book::journalFileName(bookFile);
+
+    class TestSelector : public Book::PositionSelector {
+    public:
+        bool getNextPosition(Position& pos, Move& move) override {
+            if (idx < (int)bookLine.size()) {
+                Move m = TextIO::stringToMove(currPos, bookLine[idx]);
+                pos = currPos;
+                move = m;
+                UndoInfo ui;
+                currPos.makeMove(m, ui);
+                idx++;
+                return true;
+            }
+            return false;
+        }
+    private:
+        Position currPos = TextIO::readFEN(TextIO::startPosFEN);
+        std::vector<std::string> bookLine { "e4", "e5", "Nf3" };
+        int idx = 0;
+    };
+
+    auto fileSize = [](const std::string& fileName) -> S64 {
+        std::ifstream is(fileName, std::ios_base::in | std::ios_base::binary | std::ios_base::ate);
+        return is ? (S64)is.tellg() : -1;
+    };
+    const int recSize = sizeof(BookNode::BookSerializeData);
+
+    Book book("");
+    book.writeToFile(bookFile);
+    ASSERT_EQUAL(recSize, fileSize(bookFile));
+    book.readFromFile(bookFile);
+    book.openJournal(bookFile);
+    TestSelector selector;
+    book.extendBook(selector, 10, 1, 0, tt);
+    ASSERT_EQUAL(4, book.bookNodes.size());
+
+    // Book changes are only appended to the journal
+    ASSERT_EQUAL(recSize, fileSize(bookFile));
+    ASSERT(fileSize(journalFile) > 0);
+    ASSERT_EQUAL(0, fileSize(journalFile) % recSize);
+    {
+        Book book2("");
+        book2.readFromFile(bookFile);
+        ASSERT_EQUAL(4, book2.bookNodes.size());
+        ASSERT_EQUAL(fileSize(journalFile) / recSize, book2.journalRecords);
+        ASSERT(!book2.journalDamaged);
+        for (const auto& e : book.bookNodes) {
+            BookNode* bn2 = book2.getBookNode(e.first);
+            ASSERT(bn2);
+            ASSERT_EQUAL(e.second->getSearchScore(), bn2->getSearchScore());
+            ASSERT_EQUAL(e.second->getNegaMaxScore(), bn2->getNegaMaxScore());
+        }
+    }
+
+    // A partial record at the end of the journal is ignored, and
+    // the journal is merged into the book file when it is reopened
+    system("printf abc >> " + journalFile);
+    {
+        Book book2("");
+        book2.readFromFile(bookFile);
+        ASSERT_EQUAL(4, book2.bookNodes.size());
+        ASSERT(book2.journalDamaged);
+        book2.openJournal(bookFile);
+        ASSERT_EQUAL(4 * recSize, fileSize(bookFile));
+        ASSERT_EQUAL(0, fileSize(journalFile));
+    }
+    {
+        Book book2("");
+        book2.readFromFile(bookFile);
+        ASSERT_EQUAL(4, book2.bookNodes.size());
+        ASSERT_EQUAL(0, book2.journalRecords);
+    }
+
+    // Writing the book file removes the journal
+    book.writeToFile(bookFile);
+    ASSERT_EQUAL(-1, fileSize(journalFile));
+}
+
 cute::suite
 BookBuildTest::getSuite() const {
     cute::suite s;
@@ -646,5 +733,6 @@ BookBuildTest::getSuite() const {
     s.push_back(CUTE(testAddPosToBook));
     s.push_back(CUTE(testAddPosToBookConnectToChild));
     s.push_back(CUTE(testSelector));
+    s.push_back(CUTE(testJournal));
     return s;
 }
@@ -39,6 +39,7 @@ private:
     static void testAddPosToBook();
     static void testAddPosToBookConnectToChild();
     static void testSelector();
+    static void testJournal();
 };
 
 #endif /* BOOKBUILDTEST_HPP_ */
@@ -176,9 +176,73 @@ d4 Nc6 c4 d6 *
     }
 }
 
+void
+GameTreeTest::testNodeReuse() {
+    std::string pgn = R"raw(
+[Event "event01"]
+[Result "1-0"]
+
+e4 {c1} e5 Nf3 $1 (Nc3 {c2} Nf6) Nc6 1-0
+
+[Event "event02"]
+[Result "0-1"]
+
+d4 d5 {c3} c4 0-1
+
+[Event "event03"]
+[Result "*"]
+
+c4 (d4) e5 *
+)raw";
+    std::stringstream is(pgn);
+    PgnReader reader(is);
+    GameTree gt;
+    bool result = reader.readPGN(gt);
+    ASSERT(result);
+    std::string str;
+    std::set<GameTree::RangeToNode> posToNodes;
+    gt.getGameTreeString(str, posToNodes);
+    ASSERT_EQUAL("e4 e5 Nf3 (Nc3 Nf6) Nc6", str);
+
+    {
+        // A GameNode keeps the old tree alive when a new game is read
+        GameNode gn = gt.getRootNode();
+        gn.goForward(0);
+        ASSERT_EQUAL("c1", gn.getComment());
+        gn.goForward(0);
+        gn.goForward(1);
+        ASSERT_EQUAL("c2", gn.getComment());
+
+        result = reader.readPGN(gt);
+        ASSERT(result);
+        gt.getGameTreeString(str, posToNodes);
+        ASSERT_EQUAL("d4 d5 c4", str);
+        ASSERT_EQUAL("c2", gn.getComment());
+        ASSERT(gn.goBack());
+        ASSERT(gn.goBack());
+        ASSERT(gn.goBack());
+        ASSERT(!gn.goBack());
+        ASSERT_EQUAL(TextIO::startPosFEN, TextIO::toFEN(gn.getPos()));
+    }
+
+    // Without outstanding references, node storage is reused
+    posToNodes.clear();
+    result = reader.readPGN(gt);
+    ASSERT(result);
+    gt.getGameTreeString(str, posToNodes);
+    ASSERT_EQUAL("c4 (d4) e5", str);
+    GameNode gn2 = gt.getNode(posToNodes.rbegin()->node);
+    ASSERT_EQUAL("e5", TextIO::moveToString(TextIO::readFEN("rnbqkbnr/pppppppp/8/8/2P5/8/PP1PPPPP/RNBQKBNR b KQkq - 0 1"),
+                                           gn2.getMove(), false));
+
+    result = reader.readPGN(gt);
+    ASSERT(!result);
+}
+
 cute::suite
 GameTreeTest::getSuite() const {
     cute::suite s;
     s.push_back(CUTE(testReadInsert));
+    s.push_back(CUTE(testNodeReuse));
     return s;
 }
@@ -34,6 +34,7 @@ class GameTreeTest : public UtilSuiteBase {
     cute::suite getSuite() const override;
 private:
     static void testReadInsert();
+    static void testNodeReuse();
 };
 
 #endif /* GAMETREETEST_HPP_ */
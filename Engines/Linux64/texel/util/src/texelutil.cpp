@@ -34,6 +34,7 @@
 #include "chessParseError.hpp"
 #include "computerPlayer.hpp"
 #include "textio.hpp"
+#include "util/timeUtil.hpp"
 
 #include "cute.h"
 #include "ide_listener.h"
@@ -78,10 +79,11 @@ setInitialValues(const std::string& fname) {
 
 void
 usage() {
-    std::cerr << "Usage: texelutil [-iv file] [-e] [-moveorder] cmd params\n";
+    std::cerr << "Usage: texelutil [-iv file] [-e] [-moveorder] [-leafcache file] cmd params\n";
     std::cerr << " -iv file : Set initial parameter values\n";
     std::cerr << " -e : Use cross entropy error function\n";
     std::cerr << " -moveorder : Optimize static move ordering\n";
+    std::cerr << " -leafcache file : Evaluate cached q-search leaves instead of searching\n";
     std::cerr << "cmd is one of:\n";
     std::cerr << " test : Run CUTE tests\n";
     std::cerr << "\n";
@@ -126,21 +128,30 @@ usage() {
     std::cerr << " spsasim nSimul nIter gamesPerIter a c param1 ... : Simulate SPSA optimization\n";
     std::cerr << " spsa spsafile.conf : Run SPSA optimization using the given configuration file\n";
     std::cerr << "\n";
-    std::cerr << " tbgen wq wr wb wn bq br bb bn : Generate pawn-less tablebase in memory\n";
+    std::cerr << " tbgen [-t n] [-f file] [-w wdlFile] wq wr wb wn bq br bb bn\n";
+    std::cerr << "                               : Generate pawn-less tablebase using n threads,\n";
+    std::cerr << "                                 in memory or in a memory mapped file. Optionally\n";
+    std::cerr << "                                 save 2-bit WDL data to wdlFile\n";
     std::cerr << " tbgentest type1 [type2 ...]   : Compare pawnless tablebase against GTB\n";
     std::cerr << "\n";
-    std::cerr << " book improve bookFile searchTime nThreads \"startmoves\" [c1 c2 c3]\n";
-    std::cerr << "                                            : Improve opening book\n";
+    std::cerr << " book improve bookFile searchTime nThreads[:nProcs] \"startmoves\" [c1 c2 c3]\n";
+    std::cerr << "                                            : Improve opening book, using nThreads\n";
+    std::cerr << "                                              search threads and nProcs worker\n";
+    std::cerr << "                                              processes (threads on Windows).\n";
+    std::cerr << "                                              Changes are appended to\n";
+    std::cerr << "                                              bookFile.journal\n";
     std::cerr << " book import bookFile pgnFile [maxPly]      : Import moves from PGN file\n";
     std::cerr << " book export bookFile polyglotFile maxErrSelf errOtherExpConst\n";
     std::cerr << "                                            : Export as polyglot book\n";
     std::cerr << " book query bookFile maxErrSelf errOtherExpConst : Interactive query mode\n";
     std::cerr << " book stats bookFile                        : Print book statistics\n";
+    std::cerr << " bookworker : Search worker process used by book improve\n";
     std::cerr << "\n";
     std::cerr << " creatematchbook depth searchTime : Analyze  positions in perft(depth)\n";
     std::cerr << " countuniq pgnFile : Count number of unique positions as function of depth\n";
     std::cerr << " pgnstat pgnFile [-p] : Print statistics for games in a PGN file.\n";
     std::cerr << "           -p : Consider game pairs when computing standard deviation.\n";
+    std::cerr << " pgnbench pgnFile : Measure PGN parsing speed in games/second\n";
     std::cerr << "\n";
     std::cerr << " proofgame [-w a:b] [-i \"initFen\"] \"goalFen\"\n";
     std::cerr << std::flush;
@@ -216,6 +227,30 @@ getParams(int argc, char* argv[], std::vector<ParamDomain>& params) {
         throw ChessParseError("Unexpected second set of parameters");
 }
 
+/** Generate a tablebase and report time and memory usage. */
+template <typename TBStorage>
+static void
+tbGenerate(TBStorage& storage, const PieceCount& pc, int nThreads, const std::string& wdlFile) {
+    double t0 = currentTime();
+    TBGenerator<TBStorage> tbGen(storage, pc);
+    RelaxedShared<S64> maxTimeMillis(-1);
+    tbGen.generate(maxTimeMillis, true, nThreads);
+    double t1 = currentTime();
+
+    TBPosition tbPos(pc);
+    const U32 nPos = tbPos.nPositions();
+    PackedWDLTable wdl;
+    wdl.pack(storage, nPos);
+    if (!wdlFile.empty() && !wdl.save(wdlFile))
+        throw ChessParseError("Failed to write file: " + wdlFile);
+
+    std::cout << "positions: " << nPos << " threads: " << nThreads
+              << " time: " << (t1 - t0)
+              << " storage: " << storage.byteSize() / (1024.0 * 1024.0) << "MB"
+              << " work: " << nPos / 64 * 2 / (1024.0 * 1024.0) << "MB"
+              << " wdl: " << wdl.byteSize() / (1024.0 * 1024.0) << "MB" << std::endl;
+}
+
 static void
 runTests() {
     auto runSuite = [](const UtilSuiteBase& suite) {
@@ -238,6 +273,7 @@ main(int argc, char* argv[]) {
         ComputerPlayer::initEngine();
         bool useEntropyErrorFunction = false;
         bool optimizeMoveOrdering = false;
+        std::string leafCacheFile;
         while (true) {
             if ((argc >= 3) && (std::string(argv[1]) == "-iv")) {
                 setInitialValues(argv[2]);
@@ -251,6 +287,10 @@ main(int argc, char* argv[]) {
                 optimizeMoveOrdering = true;
                 argc -= 1;
                 argv += 1;
+            } else if ((argc >= 3) && (std::string(argv[1]) == "-leafcache")) {
+                leafCacheFile = argv[2];
+                argc -= 2;
+                argv += 2;
             } else
                 break;
         }
@@ -259,6 +299,8 @@ main(int argc, char* argv[]) {
 
         std::string cmd = argv[1];
         ChessTool chessTool(useEntropyErrorFunction, optimizeMoveOrdering);
+        if (!leafCacheFile.empty())
+            chessTool.setLeafCache(leafCacheFile);
         if (cmd == "test") {
             testMode = true;
         } else if (cmd == "p2f") {
@@ -496,28 +538,40 @@ main(int argc, char* argv[]) {
             std::string filename = argv[2];
             Spsa::spsa(filename);
         } else if (cmd == "tbgen") {
-            if (argc != 10)
+            int nThreads = 1;
+            std::string tbFile, wdlFile;
+            int a = 2;
+            for ( ; a + 1 < argc && argv[a][0] == '-'; a += 2) {
+                std::string opt = argv[a];
+                if (opt == "-t") {
+                    if (!str2Num(argv[a+1], nThreads) || (nThreads < 1))
+                        usage();
+                } else if (opt == "-f") {
+                    tbFile = argv[a+1];
+                } else if (opt == "-w") {
+                    wdlFile = argv[a+1];
+                } else
+                    usage();
+            }
+            if (argc != a + 8)
                 usage();
             PieceCount pc;
-            if (!str2Num(argv[2], pc.nwq) ||
-                !str2Num(argv[3], pc.nwr) ||
-                !str2Num(argv[4], pc.nwb) ||
-                !str2Num(argv[5], pc.nwn) ||
-                !str2Num(argv[6], pc.nbq) ||
-                !str2Num(argv[7], pc.nbr) ||
-                !str2Num(argv[8], pc.nbb) ||
-                !str2Num(argv[9], pc.nbn))
-                usage();
-#if 1
+            if (!str2Num(argv[a], pc.nwq) ||
+                !str2Num(argv[a+1], pc.nwr) ||
+                !str2Num(argv[a+2], pc.nwb) ||
+                !str2Num(argv[a+3], pc.nwn) ||
+                !str2Num(argv[a+4], pc.nbq) ||
+                !str2Num(argv[a+5], pc.nbr) ||
+                !str2Num(argv[a+6], pc.nbb) ||
+                !str2Num(argv[a+7], pc.nbn))
+                usage();
+            if (tbFile.empty()) {
                 VectorStorage vs;
-                TBGenerator<VectorStorage> tbGen(vs, pc);
-#else
-                TranspositionTable tt(19);
-                TTStorage tts(tt);
-                TBGenerator<TTStorage> tbGen(tts, pc);
-#endif
-                RelaxedShared<S64> maxTimeMillis(-1);
-                tbGen.generate(maxTimeMillis, true);
+                tbGenerate(vs, pc, nThreads, wdlFile);
+            } else {
+                FileStorage fs(tbFile);
+                tbGenerate(fs, pc, nThreads, wdlFile);
+            }
         } else if (cmd == "tbgentest") {
             if (argc < 3)
                 usage();
@@ -538,9 +592,14 @@ main(int argc, char* argv[]) {
                 std::string startMoves;
                 if (argc >= 7)
                     startMoves = argv[6];
-                int searchTime, numThreads;
+                int searchTime, numThreads, numProcesses = 0;
+                std::string threadSpec = argv[5];
+                size_t colon = threadSpec.find(':');
                 if (!str2Num(argv[4], searchTime) || (searchTime <= 0) ||
-                    !str2Num(argv[5], numThreads) || (numThreads <= 0))
+                    !str2Num(threadSpec.substr(0, colon), numThreads) || (numThreads < 0) ||
+                    ((colon != std::string::npos) &&
+                     (!str2Num(threadSpec.substr(colon + 1), numProcesses) || (numProcesses < 0))) ||
+                    (numThreads + numProcesses <= 0))
                     usage();
                 std::shared_ptr<BookBuild::Book> book;
                 if (argc == 10) {
@@ -549,12 +608,12 @@ main(int argc, char* argv[]) {
                         !str2Num(argv[8], ownPErrCost)   || (ownPErrCost   <= 0) ||
                         !str2Num(argv[9], otherPErrCost) || (otherPErrCost <= 0))
                         usage();
-                    book = std::make_shared<BookBuild::Book>(logFile, bookDepthCost,
+                    book = std::make_shared<BookBuild::Book>("", bookDepthCost,
                                                              ownPErrCost, otherPErrCost);
                 } else {
-                    book = std::make_shared<BookBuild::Book>(logFile);
+                    book = std::make_shared<BookBuild::Book>("");
                 }
-                book->improve(bookFile, searchTime, numThreads, startMoves);
+                book->improve(bookFile, searchTime, numThreads, numProcesses, startMoves);
             } else if (bookCmd == "import") {
                 if (argc < 5 || argc > 6)
                     usage();
@@ -593,6 +652,11 @@ main(int argc, char* argv[]) {
             } else {
                 usage();
             }
+        } else if (cmd == "bookworker") {
+            if (argc != 2)
+                usage();
+            ChessTool::setupTB();
+            BookBuild::ProcessRunner::serve(std::cin, std::cout);
         } else if (cmd == "creatematchbook") {
             if (argc != 4)
                 usage();
@@ -621,6 +685,12 @@ main(int argc, char* argv[]) {
             std::string pgnFile = argv[2];
             MatchBookCreator mbc;
             mbc.pgnStat(pgnFile, pairMode, std::cout);
+        } else if (cmd == "pgnbench") {
+            if (argc != 3)
+                usage();
+            std::string pgnFile = argv[2];
+            MatchBookCreator mbc;
+            mbc.pgnBench(pgnFile, std::cout);
         } else if (cmd == "proofgame") {
             std::string initFen, goalFen;
             int a = 1, b = 1;
@@ -1,10 +1,22 @@
 cimport cython
+from libc.stdlib cimport malloc, free
+
+import sys
 
 
 cdef extern from "irina.h":
     ctypedef struct Move:
         pass
 
+    enum: ENGINE_PV_SIZE
+    ctypedef struct EngineInfo:
+        int multipv
+        int depth, seldepth, time
+        long long nodes, nps
+        int score_type, score
+        char pv[ENGINE_PV_SIZE]
+        unsigned seq
+
     void init_board()
     void fen_board(char *fen)
     char *board_fen(char *fen)
@@ -23,6 +35,26 @@ cdef extern from "irina.h":
     char inCheck()
     void set_level(int lv)
 
+    int unmake_nummove()
+    int board_full()
+    char *getSquares(char *squares)
+    int getColor()
+    int getCastle()
+    int getEp()
+    int getFifty()
+    int getFullMove()
+    unsigned long long getPositionKey()
+    int ipv_encode(char *pv, char *ipv)
+    int ipv_decode(char *ipv, char *pv, char *san, int depth)
+    int ipv_numfens()
+    char *ipv_fen(int num)
+    int knight_paths(int sfrom, int sto, unsigned long long occupied, unsigned char *paths, int maxpaths, int *numpaths)
+    void jumps_table(char piece, unsigned char *table)
+
+    int mate_solve(char *fen, int maxmate, int ms)
+    int mate_nummoves()
+    char *mate_move(int num, char *pv)
+
     void pgn_start(char * fich, int depth)
     void pgn_stop()
     int pgn_read( )
@@ -35,7 +67,28 @@ cdef extern from "irina.h":
     int pgn_numfens()
     char * pgn_fen(int num)
 
+    void *engine_open(char *folder, char *command, int priority)
+    int engine_close(void *engine)
+    int engine_pid(void *engine)
+    void engine_put(void *engine, char *line)
+    int engine_pending(void *engine)
+    int engine_numlines(void *engine)
+    char *engine_getline(void *engine, int num)
+    unsigned engine_lineseq(void *engine, int num)
+    int engine_numinfos(void *engine)
+    EngineInfo *engine_getinfo(void *engine, int num)
+    void engine_take(void *engine, int *nlines, int *ninfos)
+    void engine_reset(void *engine)
+    void engine_coalesce(void *engine, int coalesce)
+
 
+# Checked by Lucas.py against VarGen.LCENGINE_VERSION, raise both when Code/ needs something new from the module
+VERSION = 1
+
+# irina has only one board: Position objects share it, the one whose moves are there is _boardOwner
+# (0 = board used by the module functions or by nobody)
+cdef long _lastPositionId = 0
+cdef long _boardOwner = 0
 
 
 class PGNreader:
@@ -44,6 +97,8 @@ class PGNreader:
         self.depth = depth
 
     def __enter__(self):
+        global _boardOwner
+        _boardOwner = 0
         pgn_start(self.fich, self.depth)
         return self
 
@@ -185,9 +240,14 @@ def liP(npos, siW):
 
     return tuple(liM), tuple(liX)
 
-dicK = {}
-for i in range(64):
-    dicK[i] = liK(i)
+def dicJumps(piece):
+    # Casillas a las que salta un caballo o un rey desde cada casilla, de las tablas de irina
+    cdef unsigned char table[64*9]
+    cdef int i
+    jumps_table(ord(piece), table)
+    return {i: tuple([table[i*9+1+j] for j in range(table[i*9])]) for i in range(64)}
+
+dicK = dicJumps("K")
 
 dicQ = {}
 for i in range(64):
@@ -216,9 +276,7 @@ for i in range(64):
             li.append(lin)
     dicR[i] = tuple(li)
 
-dicN = {}
-for i in range(64):
-    dicN[i] = liN(i)
+dicN = dicJumps("N")
 
 dicPW = {}
 for i in range(8, 56):
@@ -228,55 +286,22 @@ dicPB = {}
 for i in range(8, 56):
     dicPB[i] = liP(i, False)
 
-def knightmoves(a, b, no, nv, mx):
-    if nv > mx:
-        return []
-    lia = liN(a)
-    if b in lia:
-        return [[a, b]]
-    lib = liN(b)
-    li = []
-    for x in lia:
-        if x not in no and x in lib:
-            li.append([a, x, b])
-    if li:
-        return li
-
-    li = []
-
-    for x in lia:
-        for y in lib:
-            if x not in no and y not in no:
-                nx = no[:]
-                nx.append(x)
-                nx.append(y)
-                f = knightmoves(x, y, nx, nv + 1, mx)
-                if f:
-                    li.extend(f)
-    if not li:
-        return li
-    xmin = 9999
-    for x in li:
-        nx = len(x)
-        if nx < xmin:
-            xmin = nx
-    lidef = []
-    for x in li:
-        if len(x) == xmin:
-            x.insert(0, a)
-            x.append(b)
-            lidef.append(x)
-    return lidef
-
 def liNMinimo(x, y, celdas_ocupadas):
-    cdef int nv
-    ot = celdas_ocupadas[:]
-    ot.extend([x, y])
-    nv = 1
-    li = knightmoves(x, y, ot, 0, nv)
-    while len(li) == 0:
-        nv += 1
-        li = knightmoves(x, y, ot, 0, nv)
+    # Todos los caminos mas cortos de un caballo de x a y sin pasar por celdas_ocupadas, [] si no se puede llegar
+    cdef unsigned long long occupied = 0
+    cdef int nmoves, npaths, num, pos
+    cdef unsigned char *paths
+    for pos in celdas_ocupadas:
+        occupied |= 1ULL << pos
+    nmoves = knight_paths(x, y, occupied, NULL, 0, &npaths)
+    if nmoves == 0:
+        return []
+    paths = <unsigned char *>malloc(npaths * (nmoves + 1))
+    if paths == NULL:
+        raise MemoryError()
+    knight_paths(x, y, occupied, paths, npaths, &npaths)
+    li = [[paths[num * (nmoves + 1) + j] for j in range(nmoves + 1)] for num in range(npaths)]
+    free(paths)
     return li
 
 def xpv2pv(xpv):
@@ -311,13 +336,92 @@ def pv2xpv(pv):
     else:
         return ""
 
+# ipv: compact code of the games of the databases, one char by move (its index in the legal moves of irina), see lc.c
+# The code of a line is the start of the code of its continuations, as with xpv.
+
+def pv2ipv(pv):
+    """
+    Code of pv (moves a1h8 from the initial position), until the first move that is not legal
+    """
+    return pvs2ipvs([pv])[0]
+
+def pvs2ipvs(liPV):
+    global _boardOwner
+    cdef char *ipv
+    _boardOwner = 0
+    liPV = [pv.encode("ascii", "ignore") if isinstance(pv, unicode) else pv for pv in liPV]
+    ipv = <char *>malloc(max([len(pv) for pv in liPV] + [0]) + 2)
+    try:
+        li = []
+        for pv in liPV:
+            if pv:
+                ipv_encode(pv, ipv)
+                li.append(ipv)
+            else:
+                li.append("")
+    finally:
+        free(ipv)
+    return li
+
+def ipv2game(ipv, depth=0, siSAN=False):
+    """
+    Decodes ipv: returns pv (moves a1h8), the moves in SAN (if siSAN, else None) and the list of fenM2 of the
+    positions after each one of the first depth moves
+    """
+    global _boardOwner
+    cdef char *pv
+    cdef char *san = NULL
+    cdef int num
+    cdef object x, xsan
+    _boardOwner = 0
+    if isinstance(ipv, unicode):
+        ipv = ipv.encode("ascii", "ignore")
+    pv = <char *>malloc(len(ipv) * 6 + 1)
+    if siSAN:
+        san = <char *>malloc(len(ipv) * 8 + 1)
+    try:
+        ipv_decode(ipv, pv, san, depth)
+        x = pv
+        liSAN = None
+        if siSAN:
+            xsan = san
+            liSAN = xsan.split(" ") if xsan else []
+        liFens = [ipv_fen(num) for num in range(ipv_numfens())]
+    finally:
+        free(pv)
+        if san != NULL:
+            free(san)
+    return x, liSAN, liFens
+
+def ipv2pv(ipv):
+    return ipvs2pvs([ipv])[0]
+
+def ipvs2pvs(liIPV):
+    global _boardOwner
+    cdef char *pv
+    _boardOwner = 0
+    liIPV = [ipv.encode("ascii", "ignore") if isinstance(ipv, unicode) else ipv for ipv in liIPV]
+    pv = <char *>malloc(max([len(ipv) for ipv in liIPV] + [0]) * 6 + 1)
+    try:
+        li = []
+        for ipv in liIPV:
+            ipv_decode(ipv, pv, NULL, 0)
+            li.append(pv)
+    finally:
+        free(pv)
+    return li
+
 def runFen( fen, depth, ms, level ):
+    global _boardOwner
+    _boardOwner = 0
     set_level(level)
     x = playFen(fen, depth, ms)
     set_level(0)
     return x
 
 def setFen(fen):
+    global _boardOwner
+    _boardOwner = 0
     fen_board(fen)
     return movegen()
 
@@ -415,6 +519,9 @@ class InfoMove(object):
     def isEnPassant(self):
         return self._ep
 
+    def san(self):
+        return self._san
+
 def getExMoves():
     nmoves = numMoves()
 
@@ -426,6 +533,8 @@ def getExMoves():
     return li
 
 def moveExPV(desde, hasta, coronacion):
+    global _boardOwner
+    _boardOwner = 0
     if not coronacion:
         coronacion = ""
 
@@ -439,6 +548,8 @@ def moveExPV(desde, hasta, coronacion):
     return infoMove
 
 def movePV(desde, hasta, coronacion):
+    global _boardOwner
+    _boardOwner = 0
     if not coronacion:
         coronacion = ""
 
@@ -451,6 +562,8 @@ def movePV(desde, hasta, coronacion):
     return True
 
 def makeMove(move):
+    global _boardOwner
+    _boardOwner = 0
     desde = move[:2]
     hasta = move[2:4]
     coronacion = move[4:]
@@ -501,3 +614,345 @@ def fenOB(fen):
 def fenTerminado(fen):
     return setFen(fen) == 0
 
+
+cdef class Position:
+    """
+    Position kept alive in the irina board, moves are made and unmade in place without building or
+    parsing a FEN on every move.
+    If the board has been used in the meantime (module functions, other Position), it is restored
+    from the FEN of the current position; popping beyond that point replays the moves pushed from the
+    initial FEN.
+    A Position can follow a whole game: when irina's line of moves is full, the current position
+    becomes the initial one and the moves pushed before can no longer be popped.
+    """
+    cdef long _id
+    cdef object _fen, _current
+    cdef list _moves
+    cdef int _nmoves, _inline
+
+    def __init__(self, fen=None):
+        global _lastPositionId
+        _lastPositionId += 1
+        self._id = _lastPositionId
+        self.setFen(fen if fen else "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1")
+
+    cdef _sync(self):
+        global _boardOwner
+        if _boardOwner == self._id:
+            return
+        fen_board(self._current)
+        self._nmoves = movegen()
+        self._inline = 0  # moves of self._moves that can be unmade in irina
+        _boardOwner = self._id
+
+    cdef _replay(self):
+        # board from the initial FEN with all the moves pushed in irina's line
+        global _boardOwner
+        cdef int num
+        fen_board(self._fen)
+        self._nmoves = movegen()
+        for desde, hasta, coronacion in self._moves:
+            num = searchMove(desde, hasta, coronacion)
+            self._nmoves = make_nummove(num)
+        self._inline = len(self._moves)
+        _boardOwner = self._id
+
+    cdef _setCurrent(self):
+        cdef char fen[100]
+        board_fen(fen)
+        x = fen
+        self._current = x
+
+    def setFen(self, fen):
+        global _boardOwner
+        self._fen = self._current = fen
+        self._moves = []
+        _boardOwner = 0
+        self._sync()
+        return self._nmoves
+
+    def fen(self):
+        self._sync()
+        return self._current
+
+    def push(self, desde, hasta, coronacion=None):
+        coronacion = coronacion.lower() if coronacion else ""
+        self._sync()
+        num = searchMove(desde, hasta, coronacion)
+        if num == -1:
+            return None
+
+        infoMove = InfoMove(num)
+        self._nmoves = make_nummove(num)
+        self._moves.append((desde, hasta, coronacion))
+        self._inline += 1
+        self._setCurrent()
+        if board_full():
+            self._fen = self._current
+            self._moves = []
+            fen_board(self._current)
+            self._nmoves = movegen()
+            self._inline = 0
+
+        return infoMove
+
+    def pushPV(self, pv):
+        return self.push(pv[:2], pv[2:4], pv[4:])
+
+    def pop(self):
+        if not self._moves:
+            return False
+        self._sync()
+        if self._inline == 0:
+            self._replay()
+        self._nmoves = unmake_nummove()
+        self._moves.pop()
+        self._inline -= 1
+        self._setCurrent()
+        return True
+
+    def numMoves(self):
+        return self._nmoves
+
+    def getExMoves(self):
+        self._sync()
+        return getExMoves()
+
+    def isCheck(self):
+        self._sync()
+        return inCheck()
+
+    @property
+    def ply(self):
+        return len(self._moves)
+
+    @property
+    def squares(self):
+        # same as ControlPosicion.casillas: "a1".."h8" -> piece or None
+        cdef char pz[65]
+        cdef int pos
+        self._sync()
+        getSquares(pz)
+        d = {}
+        for pos in range(64):
+            d[posA1(pos)] = None if pz[pos] == c'.' else chr(pz[pos])
+        return d
+
+    @property
+    def whiteToMove(self):
+        self._sync()
+        return getColor() == 0
+
+    @property
+    def castling(self):
+        self._sync()
+        castle = getCastle()
+        x = ""
+        if castle & 1:
+            x += "K"
+        if castle & 4:
+            x += "Q"
+        if castle & 2:
+            x += "k"
+        if castle & 8:
+            x += "q"
+        return x if x else "-"
+
+    @property
+    def ep(self):
+        self._sync()
+        ep = getEp()
+        return posA1(ep) if ep else "-"
+
+    @property
+    def fifty(self):
+        self._sync()
+        return getFifty()
+
+    @property
+    def fullmove(self):
+        self._sync()
+        return getFullMove()
+
+
+# ECO classifier: key of the final position of each opening -> a1h8 of the opening, keys of the positions
+# with some opening still ahead, and length of the longest opening
+cdef object _ecoSignature = None
+cdef dict _ecoPos = {}
+cdef set _ecoCont = set()
+cdef int _ecoMaxPly = 0
+
+def ecoBuild(liA1H8):
+    """
+    Table of the openings liA1H8 (moves a1h8 from the initial position) by position, to be kept by the caller
+    and loaded with ecoSet: returns dicPos, setCont, maxPly
+    """
+    global _boardOwner
+    cdef int num, maxPly = 0
+    _boardOwner = 0
+    dicPos = {}
+    setCont = set()
+    for a1h8 in sorted(liA1H8):
+        fen_board("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1")
+        movegen()
+        liKeys = []
+        moves = a1h8.split(" ")
+        for move in moves:
+            liKeys.append(getPositionKey())
+            num = searchMove(move[:2], move[2:4], move[4:])
+            if num == -1:
+                break
+            make_nummove(num)
+        else:
+            setCont.update(liKeys)
+            key = getPositionKey()
+            if key not in dicPos:
+                dicPos[key] = a1h8
+            if len(moves) > maxPly:
+                maxPly = len(moves)
+    return dicPos, setCont, maxPly
+
+def ecoSet(signature, dicPos, setCont, maxPly):
+    global _ecoSignature, _ecoPos, _ecoCont, _ecoMaxPly
+    _ecoSignature = signature
+    _ecoPos = dicPos
+    _ecoCont = setCont
+    _ecoMaxPly = maxPly
+
+def ecoSignature():
+    return _ecoSignature
+
+def ecoClassify(pv):
+    """
+    Deepest opening of the table reached by pv (moves a1h8 from the initial position), transpositions included:
+    returns a1h8 of the opening (None if none), number of moves of pv until it, and if pv can still reach
+    another opening
+    """
+    global _boardOwner
+    cdef int num, ply = 0, nply = 0
+    _boardOwner = 0
+    fen_board("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1")
+    movegen()
+    a1h8 = None
+    siFin = True
+    if pv:
+        for move in pv.split(" "):
+            if ply == _ecoMaxPly:
+                siFin = False
+                break
+            num = searchMove(move[:2], move[2:4], move[4:])
+            if num == -1:
+                siFin = False
+                break
+            make_nummove(num)
+            ply += 1
+            x = _ecoPos.get(getPositionKey())
+            if x is not None:
+                a1h8 = x
+                nply = ply
+    return a1h8, nply, siFin and getPositionKey() in _ecoCont
+
+
+def mateSolve(fen, maxMate, ms=0):
+    """
+    Shortest mate of the side to move of fen in maxMate moves or less: returns its length (0 if there is none, -1 if
+    the ms are over first, 0 = no limit) and the list of all the first moves a1h8 that mate in it
+    """
+    global _boardOwner
+    cdef char pv[10]
+    cdef int num, mate
+    _boardOwner = 0
+    mate = mate_solve(fen, maxMate, ms)
+    return mate, [mate_move(num, pv) for num in range(mate_nummoves())]
+
+
+cdef class EngineSession:
+    """
+    UCI engine run by irina (engine.c), the output is read by a C thread: the info lines with pv or score are
+    parsed there and Python only receives the last ones, with the rest of lines in the order they came, with
+    getOutput.
+    """
+    cdef void *engine
+
+    def __init__(self, liArgs, folder, priority):
+        cdef bytes command, bfolder
+        fsenc = sys.getfilesystemencoding()
+        command = b"\n".join([arg.encode(fsenc) if isinstance(arg, unicode) else arg for arg in liArgs])
+        bfolder = folder.encode(fsenc) if isinstance(folder, unicode) else folder
+        self.engine = engine_open(bfolder, command, priority)
+        if self.engine == NULL:
+            raise OSError("%s can not be started" % liArgs[0])
+
+    def __dealloc__(self):
+        if self.engine != NULL:
+            engine_close(self.engine)
+
+    @property
+    def pid(self):
+        return engine_pid(self.engine) if self.engine != NULL else None
+
+    def close(self):
+        # False if it has not finished with quit and it has been killed
+        if self.engine == NULL:
+            return True
+        ok = engine_close(self.engine)
+        self.engine = NULL
+        return ok == 1
+
+    def putLine(self, line):
+        if self.engine != NULL:
+            engine_put(self.engine, line)
+
+    def pending(self):
+        return engine_pending(self.engine) if self.engine != NULL else 0
+
+    def getLines(self):
+        cdef int num
+        if self.engine == NULL:
+            return []
+        return [engine_getline(self.engine, num) for num in range(engine_numlines(self.engine))]
+
+    def getInfos(self):
+        cdef int num
+        if self.engine == NULL:
+            return []
+        return [self.info(num) for num in range(engine_numinfos(self.engine))]
+
+    def getOutput(self):
+        # lines and infos not read yet, taken at once and in the order they came: the lines as str and the infos
+        # as tuples
+        cdef int nlines, ninfos, nl = 0, ni = 0
+        li = []
+        if self.engine == NULL:
+            return li
+        engine_take(self.engine, &nlines, &ninfos)
+        while nl < nlines or ni < ninfos:
+            if ni == ninfos or (nl < nlines and engine_lineseq(self.engine, nl) < engine_getinfo(self.engine, ni).seq):
+                li.append(engine_getline(self.engine, nl))
+                nl += 1
+            else:
+                li.append(self.info(ni))
+                ni += 1
+        return li
+
+    cdef info(self, int num):
+        # (multipv, depth, seldepth, time, nodes, nps, cp, mate, pv), None in what the engine has not sent
+        cdef EngineInfo *info = engine_getinfo(self.engine, num)
+        return (info.multipv if info.multipv >= 0 else None,
+                info.depth if info.depth >= 0 else None,
+                info.seldepth if info.seldepth >= 0 else None,
+                info.time if info.time >= 0 else None,
+                info.nodes if info.nodes >= 0 else None,
+                info.nps if info.nps >= 0 else None,
+                info.score if info.score_type == 1 else None,
+                info.score if info.score_type == 2 else None,
+                info.pv)
+
+    def reset(self):
+        if self.engine != NULL:
+            engine_reset(self.engine)
+
+    def coalesce(self, siCoalesce):
+        # with False the info lines are received by getLines as they come
+        if self.engine != NULL:
+            engine_coalesce(self.engine, 1 if siCoalesce else 0)
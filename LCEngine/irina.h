@@ -13,6 +13,20 @@ typedef struct
    unsigned is_castle : 2;
 } Move;
 
+// UCI engine run by LCEngine (engine.c): an info line already parsed, -1 in what the engine has not sent
+#define ENGINE_MAX_MULTIPV  256
+#define ENGINE_PV_SIZE      1024
+
+typedef struct
+{
+   int       multipv;
+   int       depth, seldepth, time;
+   long long nodes, nps;
+   int       score_type, score;       // score_type 0 = none, 1 = cp, 2 = mate
+   char      pv[ENGINE_PV_SIZE];
+   unsigned  seq;
+} EngineInfo;
+
 void init_board();
 void fen_board(char *fen);
 int movegen(void);
@@ -31,6 +45,22 @@ char * toSan(int num, char *sanMove);
 char inCheck(void);
 void set_level(int lv);
 
+int unmake_nummove(void);
+int board_full(void);
+char *getSquares(char *squares);
+int getColor(void);
+int getCastle(void);
+int getEp(void);
+int getFifty(void);
+int getFullMove(void);
+unsigned long long getPositionKey(void);
+int ipv_encode(char *pv, char *ipv);
+int ipv_decode(char *ipv, char *pv, char *san, int depth);
+int ipv_numfens(void);
+char *ipv_fen(int num);
+int knight_paths(int from, int to, unsigned long long occupied, unsigned char *paths, int maxpaths, int *numpaths);
+void jumps_table(char piece, unsigned char *table);
+
 void pgn_start(char * fich, int depth);
 void pgn_stop( void );
 int pgn_read( void );
@@ -43,5 +73,23 @@ int pgn_raw(void);
 int pgn_numfens(void);
 char * pgn_fen(int num);
 
+int mate_solve(char *fen, int maxmate, int ms);
+int mate_nummoves(void);
+char *mate_move(int num, char *pv);
+
+void *engine_open(char *folder, char *command, int priority);
+int engine_close(void *engine);
+int engine_pid(void *engine);
+void engine_put(void *engine, char *line);
+int engine_pending(void *engine);
+int engine_numlines(void *engine);
+char *engine_getline(void *engine, int num);
+unsigned engine_lineseq(void *engine, int num);
+int engine_numinfos(void *engine);
+EngineInfo *engine_getinfo(void *engine, int num);
+void engine_take(void *engine, int *nlines, int *ninfos);
+void engine_reset(void *engine);
+void engine_coalesce(void *engine, int coalesce);
+
 
 #endif
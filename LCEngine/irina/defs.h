@@ -104,4 +104,19 @@ typedef struct
 #define H8          63
 
 #define INFINITE9    9999999
+
+// UCI engine run by LCEngine (engine.c): an info line already parsed, -1 in what the engine has not sent
+#define ENGINE_MAX_MULTIPV  256
+#define ENGINE_PV_SIZE      1024
+
+typedef struct
+{
+   int       multipv;
+   int       depth, seldepth, time;
+   long long nodes, nps;
+   int       score_type, score;       // score_type 0 = none, 1 = cp, 2 = mate
+   char      pv[ENGINE_PV_SIZE];
+   unsigned  seq;
+} EngineInfo;
+
 #endif
@@ -0,0 +1,696 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+#include "defs.h"
+#include "protos.h"
+
+/*
+ * UCI engine run by the GUI (LCEngine.EngineSession), the process is created as in polyglot's engine.cpp.
+ * A reader thread owns the output of the engine: the info lines with pv or score are parsed and, as the GUI
+ * only needs the last one, each one replaces the previous of its multipv (the last one of each depth is kept
+ * if the GUI has not read it yet). The rest of lines are queued as they come.
+ * Lines and infos share the sequence number, engine_take gives both at once so they can be read in order.
+ */
+
+#define ENGINE_BUFFER       16384
+#define ENGINE_MAX_ARGS     64
+
+#ifdef _WIN32
+#define LOCK(e)     EnterCriticalSection(&(e)->mutex)
+#define UNLOCK(e)   LeaveCriticalSection(&(e)->mutex)
+#ifdef _MSC_VER
+#define atoll       _atoi64
+#endif
+#else
+#define LOCK(e)     pthread_mutex_lock(&(e)->mutex)
+#define UNLOCK(e)   pthread_mutex_unlock(&(e)->mutex)
+#endif
+
+typedef struct
+{
+    char *text;
+    unsigned seq;
+} EngineLine;
+
+typedef struct
+{
+#ifdef _WIN32
+    HANDLE process, thread, in, out;
+    DWORD pid;
+    CRITICAL_SECTION mutex;
+#else
+    pid_t pid;
+    int in, out;
+    pthread_t thread;
+    pthread_mutex_t mutex;
+#endif
+    volatile int stop;                          // the reader thread has to finish
+    int coalesce;
+
+    EngineLine *lines;                          // lines not read yet
+    int nlines, maxlines;
+    EngineLine *read_lines;                     // lines returned by engine_numlines/engine_take
+    int nread_lines, maxread_lines;
+
+    EngineInfo last[ENGINE_MAX_MULTIPV + 1];    // last info with pv of each multipv
+    EngineInfo score[ENGINE_MAX_MULTIPV + 1];   // last info with score but without pv
+    bool new_last[ENGINE_MAX_MULTIPV + 1], new_score[ENGINE_MAX_MULTIPV + 1];
+    int nnew;
+    EngineInfo *done;                           // last info of previous depths, not read yet
+    int ndone, maxdone;
+    EngineInfo *read_infos;                     // infos returned by engine_numinfos/engine_take
+    int nread_infos, maxread_infos;
+    unsigned seq;
+
+    EngineInfo parsed;
+    char buffer[ENGINE_BUFFER];
+    int nbuffer;
+} Engine;
+
+static void *grow(void *array, int *max, int num, size_t size)
+{
+    if (num < *max) return array;
+    *max = *max ? *max * 2 : 64;
+    return realloc(array, *max * size);
+}
+
+static void add_line(Engine *e, char *line)
+{
+    e->lines = grow(e->lines, &e->maxlines, e->nlines, sizeof(EngineLine));
+    e->lines[e->nlines].text = strdup(line);
+    e->lines[e->nlines++].seq = ++e->seq;
+}
+
+static char *next_word(char **c)
+{
+    char *word;
+
+    while (**c == ' ' || **c == '\t') (*c)++;
+    if (!**c) return NULL;
+    word = *c;
+    while (**c && **c != ' ' && **c != '\t') (*c)++;
+    if (**c) *(*c)++ = '\0';
+    return word;
+}
+
+static bool is_key(char *word)
+{
+    static const char *keys[] = {"multipv", "depth", "seldepth", "score", "time", "nodes", "pv", "hashfull", "tbhits",
+                                 "nps", "currmove", "currmovenumber", "cpuload", "string", "refutation", "currline",
+                                 NULL};
+    const char **key;
+
+    for (key = keys; *key; key++) {
+        if (strcmp(word, *key) == 0) return true;
+    }
+    return false;
+}
+
+// info line (modified) -> info, false if it has neither pv nor score, or it is a bound
+static bool parse_info(char *line, EngineInfo *info)
+{
+    char *c, *word, *key = "";
+    int lpv = 0, len;
+
+    if (strstr(line, "lowerbound") || strstr(line, "upperbound")) return false;
+
+    info->multipv = info->depth = info->seldepth = info->time = -1;
+    info->nodes = info->nps = -1;
+    info->score_type = info->score = 0;
+    info->pv[0] = '\0';
+
+    c = line + 5;
+    while ((word = next_word(&c)) != NULL) {
+        if (is_key(word)) {
+            key = word;
+            if (strcmp(key, "score") == 0) {
+                word = next_word(&c);
+                if (word == NULL) break;
+                if (strcmp(word, "cp") == 0) info->score_type = 1;
+                else if (strcmp(word, "mate") == 0) info->score_type = 2;
+                word = next_word(&c);
+                if (word == NULL) break;
+                info->score = atoi(word);
+            }
+        }
+        else if (strcmp(key, "pv") == 0) {
+            len = (int) strlen(word);
+            if (lpv + len + 2 < ENGINE_PV_SIZE) {
+                if (lpv) info->pv[lpv++] = ' ';
+                strcpy(info->pv + lpv, word);
+                lpv += len;
+            }
+        }
+        else if (strcmp(key, "depth") == 0) info->depth = atoi(word);
+        else if (strcmp(key, "seldepth") == 0) info->seldepth = atoi(word);
+        else if (strcmp(key, "time") == 0) info->time = atoi(word);
+        else if (strcmp(key, "multipv") == 0) info->multipv = atoi(word);
+        else if (strcmp(key, "nodes") == 0) info->nodes = atoll(word);
+        else if (strcmp(key, "nps") == 0) info->nps = atoll(word);
+    }
+    return info->pv[0] || info->score_type;
+}
+
+static void add_info(Engine *e, EngineInfo *info)
+{
+    int k = info->multipv > 0 ? info->multipv : 1;
+
+    if (k > ENGINE_MAX_MULTIPV) return;
+
+    info->seq = ++e->seq;
+    if (info->pv[0]) {
+        if (e->new_last[k]) {
+            if (e->last[k].depth != info->depth) {  // the last one of its depth, the GUI keeps them
+                e->done = grow(e->done, &e->maxdone, e->ndone, sizeof(EngineInfo));
+                e->done[e->ndone++] = e->last[k];
+            }
+        }
+        else {
+            e->new_last[k] = true;
+            e->nnew++;
+        }
+        e->last[k] = *info;
+    }
+    else {
+        if (!e->new_score[k]) {
+            e->new_score[k] = true;
+            e->nnew++;
+        }
+        e->score[k] = *info;
+    }
+}
+
+static void new_line(Engine *e, char *line)
+{
+    if (e->coalesce && strncmp(line, "info ", 5) == 0 && strncmp(line, "info string", 11) != 0) {
+        // the rest of info lines (currmove...) are not used by the GUI
+        if (parse_info(line, &e->parsed)) add_info(e, &e->parsed);
+    }
+    else add_line(e, line);
+}
+
+static void received(Engine *e, char *data, int n)
+{
+    int i;
+    char c;
+
+    LOCK(e);
+    for (i = 0; i < n; i++) {
+        c = data[i];
+        if (c == '\n' || c == '\r') {
+            if (e->nbuffer) {
+                e->buffer[e->nbuffer] = '\0';
+                new_line(e, e->buffer);
+                e->nbuffer = 0;
+            }
+        }
+        else if (e->nbuffer < ENGINE_BUFFER - 1) e->buffer[e->nbuffer++] = c;
+    }
+    UNLOCK(e);
+}
+
+static void free_lines(EngineLine *lines, int num)
+{
+    int i;
+
+    for (i = 0; i < num; i++) free(lines[i].text);
+}
+
+#ifdef _WIN32
+
+static DWORD WINAPI reader(LPVOID arg)
+{
+    Engine *e = (Engine *) arg;
+    char data[4096];
+    DWORD n, avail;
+
+    // peeking, a blocking read could not be stopped if a child of the engine keeps the pipe open
+    while (!e->stop) {
+        if (!PeekNamedPipe(e->in, NULL, 0, NULL, &avail, NULL)) break;
+        if (avail == 0) {
+            Sleep(5);
+            continue;
+        }
+        if (!ReadFile(e->in, data, avail < sizeof(data) ? avail : sizeof(data), &n, NULL) || n == 0) break;
+        received(e, data, (int) n);
+    }
+    return 0;
+}
+
+static bool start(Engine *e, char *folder, char *command, int priority)
+{
+    char cmdline[4096], *c, *arg;
+    int len = 0, larg;
+    HANDLE child_in, child_out;
+    SECURITY_ATTRIBUTES sa;
+    STARTUPINFO si;
+    PROCESS_INFORMATION pi;
+
+    // arguments separated by \n -> command line, each one quoted
+    cmdline[0] = '\0';
+    for (arg = command; *arg; arg = c) {
+        c = strchr(arg, '\n');
+        larg = c ? (int) (c - arg) : (int) strlen(arg);
+        if (len + larg + 4 >= (int) sizeof(cmdline)) return false;
+        if (len) cmdline[len++] = ' ';
+        cmdline[len++] = '"';
+        memcpy(cmdline + len, arg, larg);
+        len += larg;
+        cmdline[len++] = '"';
+        cmdline[len] = '\0';
+        c = c ? c + 1 : arg + larg;
+    }
+
+    sa.nLength = sizeof(SECURITY_ATTRIBUTES);
+    sa.bInheritHandle = TRUE;
+    sa.lpSecurityDescriptor = NULL;
+    if (!CreatePipe(&child_in, &e->out, &sa, 0)) return false;
+    if (!CreatePipe(&e->in, &child_out, &sa, 0)) {
+        CloseHandle(child_in);
+        CloseHandle(e->out);
+        return false;
+    }
+    SetHandleInformation(e->out, HANDLE_FLAG_INHERIT, 0);
+    SetHandleInformation(e->in, HANDLE_FLAG_INHERIT, 0);
+
+    memset(&si, 0, sizeof(si));
+    si.cb = sizeof(STARTUPINFO);
+    si.dwFlags = STARTF_USESTDHANDLES | STARTF_USESHOWWINDOW;
+    si.wShowWindow = SW_HIDE;
+    si.hStdInput = child_in;
+    si.hStdOutput = child_out;
+    si.hStdError = GetStdHandle(STD_ERROR_HANDLE);
+    if (!CreateProcess(NULL, cmdline, NULL, NULL, TRUE, CREATE_NO_WINDOW | priority, NULL,
+                       folder[0] ? folder : NULL, &si, &pi)) {
+        CloseHandle(child_in);
+        CloseHandle(child_out);
+        CloseHandle(e->in);
+        CloseHandle(e->out);
+        return false;
+    }
+    CloseHandle(pi.hThread);
+    CloseHandle(child_in);
+    CloseHandle(child_out);
+    e->process = pi.hProcess;
+    e->pid = pi.dwProcessId;
+
+    InitializeCriticalSection(&e->mutex);
+    e->thread = CreateThread(NULL, 0, reader, e, 0, NULL);
+    return true;
+}
+
+static bool finish(Engine *e)
+{
+    bool ok;
+
+    CloseHandle(e->out);  // some engines only finish with the end of input
+    ok = WaitForSingleObject(e->process, 2000) == WAIT_OBJECT_0;
+    if (!ok) TerminateProcess(e->process, 0);
+    e->stop = 1;
+    WaitForSingleObject(e->thread, INFINITE);
+    CloseHandle(e->thread);
+    CloseHandle(e->in);
+    CloseHandle(e->process);
+    return ok;
+}
+
+static void free_mutex(Engine *e)
+{
+    DeleteCriticalSection(&e->mutex);
+}
+
+static void send_data(Engine *e, char *data, int n)
+{
+    DWORD written;
+
+    WriteFile(e->out, data, n, &written, NULL);
+}
+
+#else
+
+static void *reader(void *arg)
+{
+    Engine *e = (Engine *) arg;
+    char data[4096];
+    ssize_t n;
+    struct pollfd pfd;
+
+    // polling, a blocking read could not be stopped if a child of the engine (wine) keeps the pipe open
+    pfd.fd = e->in;
+    pfd.events = POLLIN;
+    while (!e->stop) {
+        if (poll(&pfd, 1, 100) <= 0) continue;
+        n = read(e->in, data, sizeof(data));
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        received(e, data, (int) n);
+    }
+    return NULL;
+}
+
+static bool start(Engine *e, char *folder, char *command, int priority)
+{
+    char *argv[ENGINE_MAX_ARGS + 1], *args, *c;
+    int argc = 0, err;
+    int from_engine[2], to_engine[2], exec_error[2];
+
+    // arguments separated by \n, prepared before fork: the child only execs
+    args = strdup(command);
+    for (c = args; argc < ENGINE_MAX_ARGS; c++) {
+        argv[argc++] = c;
+        c = strchr(c, '\n');
+        if (c == NULL) break;
+        *c = '\0';
+    }
+    argv[argc] = NULL;
+
+    if (pipe(from_engine) == -1) {
+        free(args);
+        return false;
+    }
+    if (pipe(to_engine) == -1) {
+        close(from_engine[0]);
+        close(from_engine[1]);
+        free(args);
+        return false;
+    }
+    // errno of execvp if it fails, closed by a successful exec
+    if (pipe(exec_error) == -1) {
+        close(from_engine[0]);
+        close(from_engine[1]);
+        close(to_engine[0]);
+        close(to_engine[1]);
+        free(args);
+        return false;
+    }
+    // no other engine started later has to inherit our ends
+    fcntl(from_engine[0], F_SETFD, FD_CLOEXEC);
+    fcntl(to_engine[1], F_SETFD, FD_CLOEXEC);
+    fcntl(exec_error[0], F_SETFD, FD_CLOEXEC);
+    fcntl(exec_error[1], F_SETFD, FD_CLOEXEC);
+
+    e->pid = fork();
+    if (e->pid == 0) {
+        // child = engine
+        dup2(to_engine[0], STDIN_FILENO);
+        dup2(from_engine[1], STDOUT_FILENO);
+        close(to_engine[0]);
+        close(to_engine[1]);
+        close(from_engine[0]);
+        close(from_engine[1]);
+        if (priority && nice(priority) == -1) {
+            // not allowed, normal priority
+        }
+        if (folder[0] == '\0' || chdir(folder) == 0) execvp(argv[0], argv);
+        err = errno;
+        if (write(exec_error[1], &err, sizeof(err)) == -1) {
+            // nothing else to do
+        }
+        _exit(127);
+    }
+
+    free(args);
+    close(from_engine[1]);
+    close(to_engine[0]);
+    close(exec_error[1]);
+    if (e->pid != -1 && read(exec_error[0], &err, sizeof(err)) > 0) {
+        waitpid(e->pid, NULL, 0);
+        e->pid = -1;
+    }
+    close(exec_error[0]);
+    if (e->pid == -1) {
+        close(from_engine[0]);
+        close(to_engine[1]);
+        return false;
+    }
+    e->in = from_engine[0];
+    e->out = to_engine[1];
+
+    pthread_mutex_init(&e->mutex, NULL);
+    if (pthread_create(&e->thread, NULL, reader, e) != 0) {
+        kill(e->pid, SIGKILL);
+        waitpid(e->pid, NULL, 0);
+        close(e->in);
+        close(e->out);
+        pthread_mutex_destroy(&e->mutex);
+        return false;
+    }
+    return true;
+}
+
+static bool finish(Engine *e)
+{
+    int wait;
+    bool ok = false;
+
+    close(e->out);  // some engines only finish with the end of input
+    for (wait = 0; wait < 40; wait++) {  // 2 seconds
+        if (waitpid(e->pid, NULL, WNOHANG) == e->pid) {
+            ok = true;
+            break;
+        }
+        usleep(50000);
+    }
+    if (!ok) {
+        kill(e->pid, SIGKILL);
+        waitpid(e->pid, NULL, 0);
+    }
+    e->stop = 1;
+    pthread_join(e->thread, NULL);
+    close(e->in);
+    return ok;
+}
+
+static void free_mutex(Engine *e)
+{
+    pthread_mutex_destroy(&e->mutex);
+}
+
+static void send_data(Engine *e, char *data, int n)
+{
+    ssize_t written;
+
+    while (n > 0) {
+        written = write(e->out, data, n);
+        if (written < 0 && errno == EINTR) continue;
+        if (written <= 0) break;  // the engine is not running
+        data += written;
+        n -= (int) written;
+    }
+}
+
+#endif
+
+// command: program and arguments separated by \n, priority: nice value (Linux) or priority class (Windows)
+void *engine_open(char *folder, char *command, int priority)
+{
+    Engine *e = (Engine *) calloc(1, sizeof(Engine));
+
+    if (e == NULL) return NULL;
+    e->coalesce = 1;
+    if (!start(e, folder, command, priority)) {
+        free(e);
+        return NULL;
+    }
+    return e;
+}
+
+// 0 if the engine has not finished after quit and it has been killed
+int engine_close(void *engine)
+{
+    Engine *e = (Engine *) engine;
+    int ok;
+
+    engine_put(e, "quit");
+    ok = finish(e);
+    engine_reset(e);
+    engine_numlines(e);
+    free_lines(e->read_lines, e->nread_lines);
+    free_mutex(e);
+    free(e->lines);
+    free(e->read_lines);
+    free(e->done);
+    free(e->read_infos);
+    free(e);
+    return ok;
+}
+
+int engine_pid(void *engine)
+{
+    return (int) ((Engine *) engine)->pid;
+}
+
+void engine_put(void *engine, char *line)
+{
+    Engine *e = (Engine *) engine;
+    int len = (int) strlen(line);
+    char *data = (char *) malloc(len + 1);
+
+    memcpy(data, line, len);
+    data[len] = '\n';
+    send_data(e, data, len + 1);
+    free(data);
+}
+
+// lines and infos not read yet
+int engine_pending(void *engine)
+{
+    Engine *e = (Engine *) engine;
+    int num;
+
+    LOCK(e);
+    num = e->nlines + e->ndone + e->nnew;
+    UNLOCK(e);
+    return num;
+}
+
+// lines not read yet -> read_lines, with the lock
+static int take_lines(Engine *e)
+{
+    EngineLine *lines;
+    int max;
+
+    lines = e->read_lines;
+    max = e->maxread_lines;
+    e->read_lines = e->lines;
+    e->nread_lines = e->nlines;
+    e->maxread_lines = e->maxlines;
+    e->lines = lines;
+    e->nlines = 0;
+    e->maxlines = max;
+    return e->nread_lines;
+}
+
+// takes the lines not read yet, available with engine_getline until the next call
+int engine_numlines(void *engine)
+{
+    Engine *e = (Engine *) engine;
+    int num;
+
+    free_lines(e->read_lines, e->nread_lines);
+    LOCK(e);
+    num = take_lines(e);
+    UNLOCK(e);
+    return num;
+}
+
+char *engine_getline(void *engine, int num)
+{
+    return ((Engine *) engine)->read_lines[num].text;
+}
+
+unsigned engine_lineseq(void *engine, int num)
+{
+    return ((Engine *) engine)->read_lines[num].seq;
+}
+
+static int cmp_seq(const void *a, const void *b)
+{
+    unsigned sa = ((const EngineInfo *) a)->seq, sb = ((const EngineInfo *) b)->seq;
+
+    return sa < sb ? -1 : sa > sb;
+}
+
+// infos not read yet -> read_infos, with the lock, sorted by engine_numinfos/engine_take after releasing it
+static int take_infos(Engine *e)
+{
+    int k, num;
+
+    num = e->ndone + e->nnew;
+    if (num > e->maxread_infos) {
+        e->maxread_infos = num;
+        e->read_infos = realloc(e->read_infos, num * sizeof(EngineInfo));
+    }
+    memcpy(e->read_infos, e->done, e->ndone * sizeof(EngineInfo));
+    num = e->ndone;
+    e->ndone = 0;
+    for (k = 1; e->nnew && k <= ENGINE_MAX_MULTIPV; k++) {
+        if (e->new_last[k]) {
+            e->read_infos[num++] = e->last[k];
+            e->new_last[k] = false;
+            e->nnew--;
+        }
+        if (e->new_score[k]) {
+            e->read_infos[num++] = e->score[k];
+            e->new_score[k] = false;
+            e->nnew--;
+        }
+    }
+    e->nread_infos = num;
+    return num;
+}
+
+// takes the infos not read yet in the order they came, available with engine_getinfo until the next call
+int engine_numinfos(void *engine)
+{
+    Engine *e = (Engine *) engine;
+    int num;
+
+    LOCK(e);
+    num = take_infos(e);
+    UNLOCK(e);
+
+    qsort(e->read_infos, num, sizeof(EngineInfo), cmp_seq);
+    return num;
+}
+
+// takes at once the lines and the infos not read yet, both available until the next call: a line and an info
+// with a lower seq (engine_lineseq, EngineInfo.seq) came before
+void engine_take(void *engine, int *nlines, int *ninfos)
+{
+    Engine *e = (Engine *) engine;
+
+    free_lines(e->read_lines, e->nread_lines);
+    LOCK(e);
+    *nlines = take_lines(e);
+    *ninfos = take_infos(e);
+    UNLOCK(e);
+
+    qsort(e->read_infos, *ninfos, sizeof(EngineInfo), cmp_seq);
+}
+
+EngineInfo *engine_getinfo(void *engine, int num)
+{
+    return ((Engine *) engine)->read_infos + num;
+}
+
+// discards everything not read yet
+void engine_reset(void *engine)
+{
+    Engine *e = (Engine *) engine;
+    int k;
+
+    LOCK(e);
+    free_lines(e->lines, e->nlines);
+    e->nlines = 0;
+    e->ndone = 0;
+    for (k = 0; k <= ENGINE_MAX_MULTIPV; k++) {
+        e->new_last[k] = e->new_score[k] = false;
+    }
+    e->nnew = 0;
+    UNLOCK(e);
+}
+
+// with coalesce 0 all the lines are queued, also the info lines
+void engine_coalesce(void *engine, int coalesce)
+{
+    Engine *e = (Engine *) engine;
+
+    LOCK(e);
+    e->coalesce = coalesce;
+    UNLOCK(e);
+}
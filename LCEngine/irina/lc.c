@@ -181,6 +181,13 @@ int make_nummove(int num)
     return movegen();
 }
 
+int unmake_nummove(void)
+{
+    // the moves of the previous ply are still in board.moves
+    unmake_move();
+    return numMoves();
+}
+
 char * playFen( char * fen, int depth, int time )
 {
     fen_board( fen );
@@ -321,3 +328,267 @@ char * toSan(int num, char *sanMove)
     unmake_move();
     return sanMove;
 }
+
+// Position state, read directly by LCEngine.Position (no FEN round-trip)
+
+char *getSquares(char *squares)
+{
+    int pos;
+
+    for (pos = 0; pos < 64; pos++) {
+        squares[pos] = board.pz[pos] ? NAMEPZ[board.pz[pos]] : '.';
+    }
+    squares[64] = 0;
+    return squares;
+}
+
+int getColor(void)
+{
+    return board.color;
+}
+
+int getCastle(void)
+{
+    return board.castle;
+}
+
+int getEp(void)
+{
+    return board.ep;
+}
+
+int getFifty(void)
+{
+    return board.fifty;
+}
+
+int getFullMove(void)
+{
+    return board.fullmove;
+}
+
+// Key of the position independent of the move order and stable between runs (HASH_keys are random):
+// pieces, side to move and castling, ep is left out so 1.e4 e6 2.d4 and 1.d4 e6 2.e4 are the same
+Bitmap getPositionKey(void)
+{
+    int pos;
+    Bitmap key = 14695981039346656037ULL;
+
+    for (pos = 0; pos < 64; pos++) {
+        key = (key ^ board.pz[pos]) * 1099511628211ULL;
+    }
+    key = (key ^ board.color) * 1099511628211ULL;
+    key = (key ^ board.castle) * 1099511628211ULL;
+    return key;
+}
+
+// Compact code of a game from the initial position, used as key by the games databases: each move is its
+// index in the list of legal moves of movegen, one char of IPV_DIGITS if it is one of the first IPV_BASE moves,
+// or a char of IPV_ESCAPES (IPV_BASE moves each one) and then the char of the rest.
+// Only letters, digits and !#$, so the code is plain text, can be searched with GLOB and the code of a line is
+// the start of the code of all its continuations.
+// The order of movegen is part of the code, the games already stored could not be read if it changes.
+
+#define IPV_BASE        62
+#define IPV_MAX_FENS    256
+
+static const char IPV_DIGITS[] = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz";
+static const char IPV_ESCAPES[] = "!#$";
+
+static int ipv_values[256];
+static char ipv_fens[IPV_MAX_FENS][128];
+static int ipv_nfens = 0;
+
+static void ipv_start(void)
+{
+    int i;
+
+    if( !ipv_values['1'] ) {
+        for (i = 0; i < 256; i++) ipv_values[i] = -1;
+        for (i = 0; i < IPV_BASE; i++) ipv_values[(unsigned char)IPV_DIGITS[i]] = i;
+        for (i = 0; IPV_ESCAPES[i]; i++) ipv_values[(unsigned char)IPV_ESCAPES[i]] = IPV_BASE * (i + 1);
+    }
+    init_board();
+    movegen();
+}
+
+// true when board.moves/ply_moves have no room for the moves of another ply
+int board_full(void)
+{
+    return board.ply >= MAX_GAMELINE - 1 || board.idx_moves >= MAX_MOVES - 256;
+}
+
+static void ipv_move(int num)
+{
+    make_move(board.moves[num]);
+    // the line of the game is not needed, long games start it again before filling board.moves/ply_moves
+    if( board_full() ) board_reset();
+    movegen();
+}
+
+// pv: moves a1h8 separated by spaces, until the first one that is not legal, returns the number coded
+int ipv_encode(char *pv, char *ipv)
+{
+    char *c = pv, *p = ipv;
+    char promotion[2];
+    int num, idx, n = 0;
+
+    ipv_start();
+    while( true ) {
+        while( *c == ' ' ) c++;
+        if( !c[0] || !c[1] || !c[2] || !c[3] ) break;
+        promotion[0] = c[4] != ' ' ? c[4] : 0;
+        promotion[1] = 0;
+        num = searchMove(c, c + 2, promotion);
+        if( num == -1 ) break;
+        idx = num - board.ply_moves[board.ply - 1];
+        if( idx >= IPV_BASE ) *p++ = IPV_ESCAPES[idx / IPV_BASE - 1];
+        *p++ = IPV_DIGITS[idx % IPV_BASE];
+        c += promotion[0] ? 5 : 4;
+        ipv_move(num);
+        n++;
+    }
+    *p = 0;
+    return n;
+}
+
+// pv gets the moves a1h8 and san (if not NULL) the moves in SAN, separated by spaces, the fenM2 of the positions
+// after the first depth moves are kept for ipv_fen, returns the number of moves decoded
+int ipv_decode(char *ipv, char *pv, char *san, int depth)
+{
+    unsigned char *c = (unsigned char *)ipv;
+    char *p = pv, *s = san;
+    int num, idx, x, n = 0;
+    Move move;
+
+    ipv_start();
+    ipv_nfens = 0;
+    if( depth > IPV_MAX_FENS ) depth = IPV_MAX_FENS;
+    *p = 0;
+    if( s ) *s = 0;
+    while( *c ) {
+        idx = ipv_values[*c++];
+        if( idx >= IPV_BASE ) {
+            x = ipv_values[*c++];
+            if( x < 0 || x >= IPV_BASE ) break;
+            idx += x;
+        }
+        if( idx < 0 || idx >= numMoves() ) break;
+        num = board.ply_moves[board.ply - 1] + idx;
+
+        move = board.moves[num];
+        if( n ) *p++ = ' ';
+        strcpy(p, POS_AH[move.from]);
+        strcpy(p + 2, POS_AH[move.to]);
+        p += 4;
+        if( move.promotion ) *p++ = tolower(NAMEPZ[move.promotion]);
+        *p = 0;
+        if( s ) {
+            if( n ) *s++ = ' ';
+            toSan(num, s);
+            s += strlen(s);
+        }
+
+        ipv_move(num);
+        if( ipv_nfens < depth ) board_fenM2(ipv_fens[ipv_nfens++]);
+        n++;
+    }
+    return n;
+}
+
+int ipv_numfens(void)
+{
+    return ipv_nfens;
+}
+
+char *ipv_fen(int num)
+{
+    return ipv_fens[num];
+}
+
+// Squares for the board exercises (horses trainer)
+
+static int path_dist[64];
+static unsigned char path_line[64];
+static Bitmap path_free;
+static unsigned char *path_dest;
+static int path_max, path_num;
+
+static void knight_paths_from(int pos, int d)
+{
+    Bitmap next;
+    int sq;
+
+    path_line[path_dist[path_line[0]] - d] = pos;
+    if( d == 0 ) {
+        if( path_num < path_max ) memcpy(path_dest + path_num * (path_dist[path_line[0]] + 1), path_line, path_dist[path_line[0]] + 1);
+        path_num++;
+        return;
+    }
+    next = KNIGHT_ATTACKS[pos] & path_free;
+    while( next ) {
+        sq = first_one(next);
+        next ^= BITSET[sq];
+        if( path_dist[sq] == d - 1 ) knight_paths_from(sq, d - 1);
+    }
+}
+
+// All the shortest routes of a knight from -> to not passing through occupied: returns the number of moves (0 if to can
+// not be reached), numpaths gets how many routes there are and paths the squares of the first maxpaths, one after
+// another (moves + 1 squares each)
+int knight_paths(int from, int to, Bitmap occupied, unsigned char *paths, int maxpaths, int *numpaths)
+{
+    int queue[64], ini, end, pos, sq;
+    Bitmap next;
+
+    if( !KNIGHT_ATTACKS[0] ) init_data();
+
+    *numpaths = 0;
+    for (pos = 0; pos < 64; pos++) path_dist[pos] = -1;
+    path_free = (~occupied | BITSET[from] | BITSET[to]);
+
+    // distances to to
+    path_dist[to] = 0;
+    queue[0] = to;
+    for (ini = 0, end = 1; ini < end && path_dist[from] < 0; ini++) {
+        pos = queue[ini];
+        next = KNIGHT_ATTACKS[pos] & path_free;
+        while( next ) {
+            sq = first_one(next);
+            next ^= BITSET[sq];
+            if( path_dist[sq] < 0 ) {
+                path_dist[sq] = path_dist[pos] + 1;
+                queue[end++] = sq;
+            }
+        }
+    }
+    if( from == to || path_dist[from] < 0 ) return 0;
+
+    path_line[0] = from;
+    path_dest = paths;
+    path_max = maxpaths;
+    path_num = 0;
+    knight_paths_from(from, path_dist[from]);
+    *numpaths = path_num;
+    return path_dist[from];
+}
+
+// Squares that a knight ('N') or a king ('K') reaches from each square: table[pos*9] how many and after them the squares
+void jumps_table(char piece, unsigned char *table)
+{
+    int pos, sq, n;
+    Bitmap next;
+
+    if( !KNIGHT_ATTACKS[0] ) init_data();
+
+    for (pos = 0; pos < 64; pos++) {
+        next = piece == 'N' ? KNIGHT_ATTACKS[pos] : KING_ATTACKS[pos];
+        n = 0;
+        while( next ) {
+            sq = first_one(next);
+            next ^= BITSET[sq];
+            table[pos * 9 + 1 + n++] = sq;
+        }
+        table[pos * 9] = n;
+    }
+}
@@ -0,0 +1,203 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "defs.h"
+#include "protos.h"
+#include "globals.h"
+
+// Mate search for the mate trainers: can the side to move mate in n moves whatever the defence?
+// Depth-first with iterative deepening on n, all the moves of the attacker (only checks in its last move), a table
+// of the positions already solved, kept between searches, and the defence that refuted last at each ply tried
+// first.
+
+#define MATE_HASH_SIZE  (1 << 20)
+#define MATE_TEST_TIME  4096
+
+typedef struct
+{
+    Bitmap hashkey;
+    int    mate;        // the attacker mates in mate moves or less (0 = not known)
+    int    nomate;      // the attacker does not mate in nomate moves or less
+} MATE_reg;
+
+static MATE_reg *mate_hash = NULL;
+static Move mate_killer[MAX_PLY];
+static Move mate_moves[256];
+static int mate_nmoves = 0;
+static Bitmap mate_end;
+static int mate_test;
+static bool mate_timeout;
+
+static bool mate_attack(int n);
+
+static bool same_move(Move a, Move b)
+{
+    return a.from == b.from && a.to == b.to && a.promotion == b.promotion;
+}
+
+static void mate_store(int mate, int nomate)
+{
+    MATE_reg *reg = &mate_hash[board.hashkey & (MATE_HASH_SIZE - 1)];
+
+    if( reg->hashkey != board.hashkey ) {
+        reg->hashkey = board.hashkey;
+        reg->mate = 0;
+        reg->nomate = 0;
+    }
+    if( mate ) reg->mate = mate;
+    if( nomate > reg->nomate ) reg->nomate = nomate;
+}
+
+// the move that worked last time at this ply goes first
+static void mate_first_killer(int from, int to)
+{
+    int k;
+    Move move;
+
+    for (k = from; k < to; k++) {
+        if( same_move(board.moves[k], mate_killer[board.ply]) ) {
+            move = board.moves[k];
+            board.moves[k] = board.moves[from];
+            board.moves[from] = move;
+            break;
+        }
+    }
+}
+
+// the attacker has just moved, n moves left counting this one
+static bool mate_defend(int n)
+{
+    int from, to, k;
+    Move move;
+
+    if( !movegen() ) return inCheck();
+    if( n == 1 ) return false;
+
+    from = board.ply_moves[board.ply - 1];
+    to = board.ply_moves[board.ply];
+    mate_first_killer(from, to);
+
+    for (k = from; k < to; k++) {
+        move = board.moves[k];
+        make_move(move);
+        if( !mate_attack(n - 1) ) {
+            unmake_move();
+            mate_killer[board.ply] = move;
+            return false;
+        }
+        unmake_move();
+    }
+    return true;
+}
+
+// checks first and then captures, the other moves can only mate later
+static void mate_order(int from, int to)
+{
+    int k, first = from;
+    Move move;
+
+    for (k = from; k < to; k++) {
+        make_move(board.moves[k]);
+        if( inCheck() ) {
+            unmake_move();
+            move = board.moves[k];
+            board.moves[k] = board.moves[first];
+            board.moves[first++] = move;
+        }
+        else unmake_move();
+    }
+    for (k = first; k < to; k++) {
+        if( board.moves[k].capture ) {
+            move = board.moves[k];
+            board.moves[k] = board.moves[first];
+            board.moves[first++] = move;
+        }
+    }
+}
+
+// the attacker to move, n moves left
+static bool mate_attack(int n)
+{
+    int from, to, k;
+    MATE_reg *reg;
+
+    if( --mate_test == 0 ) {
+        mate_test = MATE_TEST_TIME;
+        if( mate_end && get_ms() > mate_end ) mate_timeout = true;
+    }
+    if( mate_timeout ) return false;
+
+    reg = &mate_hash[board.hashkey & (MATE_HASH_SIZE - 1)];
+    if( reg->hashkey == board.hashkey ) {
+        if( reg->mate && reg->mate <= n ) return true;
+        if( reg->nomate >= n ) return false;
+    }
+
+    movegen();
+    from = board.ply_moves[board.ply - 1];
+    to = board.ply_moves[board.ply];
+    if( n > 1 ) mate_order(from, to);
+    mate_first_killer(from, to);
+    for (k = from; k < to; k++) {
+        make_move(board.moves[k]);
+        if( (n > 1 || inCheck()) && mate_defend(n) ) {
+            unmake_move();
+            mate_killer[board.ply] = board.moves[k];
+            mate_store(n, 0);
+            return true;
+        }
+        unmake_move();
+    }
+    if( !mate_timeout ) mate_store(0, n);
+    return false;
+}
+
+// Shortest mate of the side to move of fen in maxmate moves or less: returns its length, 0 if there is none and -1 if
+// ms (0 = no limit) is over first. All the first moves that mate in it are read with mate_nummoves/mate_move.
+int mate_solve(char *fen, int maxmate, int ms)
+{
+    int n, from, to, k;
+    Move move;
+
+    if( !mate_hash ) {
+        mate_hash = (MATE_reg *) calloc(MATE_HASH_SIZE, sizeof(MATE_reg));
+        if( !mate_hash ) return -1;
+    }
+    memset(mate_killer, 0, sizeof(mate_killer));
+    mate_nmoves = 0;
+    mate_end = ms ? get_ms() + ms : 0;
+    mate_test = MATE_TEST_TIME;
+    mate_timeout = false;
+
+    fen_board(fen);
+    movegen();
+    from = board.ply_moves[board.ply - 1];
+    to = board.ply_moves[board.ply];
+    if( maxmate > MAX_PLY / 2 - 2 ) maxmate = MAX_PLY / 2 - 2;
+    for (n = 1; n <= maxmate; n++) {
+        for (k = from; k < to; k++) {
+            move = board.moves[k];
+            make_move(move);
+            if( (n > 1 || inCheck()) && mate_defend(n) ) mate_moves[mate_nmoves++] = move;
+            unmake_move();
+            if( mate_timeout ) {
+                mate_nmoves = 0;
+                return -1;
+            }
+        }
+        if( mate_nmoves ) return n;
+    }
+    return 0;
+}
+
+int mate_nummoves(void)
+{
+    return mate_nmoves;
+}
+
+char *mate_move(int num, char *pv)
+{
+    move2str(mate_moves[num], pv);
+    return pv;
+}
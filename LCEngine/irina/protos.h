@@ -92,5 +92,40 @@ int numBaseMove( void );
 int searchMove( char *desde, char *hasta, char * promotion );
 void getMoveEx( int num, char * info );
 char * toSan(int num, char *sanMove);
+int unmake_nummove(void);
+int board_full(void);
+char *getSquares(char *squares);
+int getColor(void);
+int getCastle(void);
+int getEp(void);
+int getFifty(void);
+int getFullMove(void);
+Bitmap getPositionKey(void);
+int ipv_encode(char *pv, char *ipv);
+int ipv_decode(char *ipv, char *pv, char *san, int depth);
+int ipv_numfens(void);
+char *ipv_fen(int num);
+int knight_paths(int from, int to, Bitmap occupied, unsigned char *paths, int maxpaths, int *numpaths);
+void jumps_table(char piece, unsigned char *table);
+
+// mate.c
+int mate_solve(char *fen, int maxmate, int ms);
+int mate_nummoves(void);
+char *mate_move(int num, char *pv);
+
+// engine.c
+void *engine_open(char *folder, char *command, int priority);
+int engine_close(void *engine);
+int engine_pid(void *engine);
+void engine_put(void *engine, char *line);
+int engine_pending(void *engine);
+int engine_numlines(void *engine);
+char *engine_getline(void *engine, int num);
+unsigned engine_lineseq(void *engine, int num);
+int engine_numinfos(void *engine);
+EngineInfo *engine_getinfo(void *engine, int num);
+void engine_take(void *engine, int *nlines, int *ninfos);
+void engine_reset(void *engine);
+void engine_coalesce(void *engine, int coalesce);
 
 #endif
@@ -4,5 +4,5 @@ from distutils.extension import Extension
 from Cython.Build import cythonize
 
 setup(
-    ext_modules = cythonize([Extension("LCEngine", ["LCEngine.pyx"], libraries=["irina"])])
+    ext_modules = cythonize([Extension("LCEngine", ["LCEngine.pyx"], libraries=["irina"])], force=True)
 )
@@ -53,6 +53,12 @@ import Code.VarGen
 sys.path.append(os.path.join(current_dir, "Code"))
 sys.path.append(os.path.join(current_dir, Code.VarGen.folder_engines, "_tools"))
 
+# LCEngine se compila aparte (LCEngine/xcython_*), uno anterior a estos fuentes no tiene lo que se usa en Code
+import LCEngine
+if getattr(LCEngine, "VERSION", 0) != Code.VarGen.LCENGINE_VERSION:
+    sys.exit("%s is out of date, it must be rebuilt from LCEngine/LCEngine.pyx with %s" %
+             (LCEngine.__file__, "xcython_linux.sh" if Code.VarGen.isLinux else "xcython_VC.bat"))
+
 import Code.Traducir as Traducir
 Traducir.install()
 